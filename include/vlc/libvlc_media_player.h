@@ -444,6 +444,34 @@ typedef unsigned (*libvlc_video_format_cb)(void **opaque, char *chroma,
  */
 typedef void (*libvlc_video_cleanup_cb)(void *opaque);
 
+/**
+ * Callback prototype to get an application picture buffer.
+ *
+ * This callback is invoked once for each of the picture buffers announced by
+ * @ref libvlc_video_format_cb, right after it. The video decoder or converter
+ * then renders directly into those buffers, so that no copy is needed when
+ * the decoded format matches the configured one.
+ *
+ * When a picture is rendered into one of those buffers, the lock and unlock
+ * callbacks are not invoked for it, and the display callback is passed the
+ * pointer returned by this callback. The application owns the buffer content
+ * only for the duration of the display callback: the buffer may be written
+ * again afterwards.
+ *
+ * The buffers must remain valid until the cleanup callback is invoked, which
+ * happens once LibVLC no longer references any of them.
+ *
+ * \param[in] opaque private pointer as passed to libvlc_video_set_callbacks()
+ *               (and possibly modified by @ref libvlc_video_format_cb)
+ * \param[in] index buffer index, from 0 to the number of buffers minus one
+ * \param[out] planes start address of the pixel planes (LibVLC allocates the
+ *             array of void pointers, this callback must initialize the array)
+ * \return a private pointer for the display callback to identify the buffer
+ * \version LibVLC 4.0.0 or later
+ */
+typedef void *(*libvlc_video_buffer_cb)(void *opaque, unsigned index,
+                                        void **planes);
+
 
 /**
  * Set callbacks and private data to render decoded video to a custom area
@@ -524,6 +552,25 @@ void libvlc_video_set_format_callbacks( libvlc_media_player_t *mp,
                                         libvlc_video_format_cb setup,
                                         libvlc_video_cleanup_cb cleanup );
 
+/**
+ * Provide the picture buffers to render decoded video into.
+ *
+ * This only works in combination with libvlc_video_set_callbacks() and
+ * libvlc_video_set_format_callbacks(). The number of buffers is the value
+ * returned by the format callback, 64 at most: with more buffers, pictures
+ * are copied as without this callback. The lock callback is still used for
+ * pictures that cannot be rendered into the application buffers, e.g. if
+ * there are not enough of them for the video decoder.
+ *
+ * \param mp the media player
+ * \param buffer callback to get the picture buffers (or NULL to copy each
+ *               picture into the buffer returned by the lock callback)
+ * \version LibVLC 4.0.0 or later
+ */
+LIBVLC_API
+void libvlc_video_set_buffer_callback( libvlc_media_player_t *mp,
+                                       libvlc_video_buffer_cb buffer );
+
 
 typedef struct libvlc_video_setup_device_cfg_t
 {
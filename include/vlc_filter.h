@@ -54,6 +54,8 @@ struct filter_audio_callbacks
         void (*on_changed)(filter_t *,
                            const struct vlc_audio_loudness *loudness);
     } meter_loudness;
+
+    block_t *(*buffer_new)(filter_t *, size_t size);
 };
 
 struct filter_subpicture_callbacks
@@ -139,6 +141,21 @@ struct vlc_filter_operations
     int (*video_mouse)(filter_t *, struct vlc_mouse_t *,
                        const struct vlc_mouse_t *p_old);
 
+    /** Describe the filter as lookup tables (video filter).
+     *
+     * If non-NULL, the filter may fill one table per plane of its input
+     * format, such that filtering a picture is the same as replacing every
+     * byte of the visible area of each plane by its entry in the table of
+     * that plane. This lets the filter chain run consecutive such filters
+     * in a single pass, without calling filter_video.
+     *
+     * Only used with software chromas whose pixels are made of whole bytes,
+     * when the input and output formats are the same.
+     *
+     * \return VLC_SUCCESS, or VLC_EGENERIC if the current settings of the
+     * filter cannot be described this way */
+    int (*video_point_op)(filter_t *, uint8_t lut[][256]);
+
     /** Close the filter and release its resources. */
     void (*close)(filter_t *);
 };
@@ -225,6 +242,9 @@ struct filter_t
     vlc_video_context   *vctx_out; // video filter, handled by the filter
     bool                b_allow_fmt_out_change;
 
+    /* Audio filter returning its input block, set by the filter when opened */
+    bool                b_inplace;
+
     /* Name of the "video filter" shortcut that is requested, can be NULL */
     const char *        psz_name;
     /* Filter configuration */
@@ -271,6 +291,28 @@ static inline picture_t *filter_NewPicture( filter_t *p_filter )
     return pic;
 }
 
+/**
+ * This function will return a new block usable by p_filter as an output
+ * audio buffer. You have to release it using block_Release or by returning
+ * it to the caller as a ops->filter_audio return value.
+ *
+ * Filters that can process their input in place should rather return the
+ * input block, not allocate any output buffer, and set b_inplace.
+ *
+ * \param p_filter filter_t object
+ * \param size payload size in bytes
+ * \return new block on success or NULL on failure
+ */
+static inline block_t *filter_NewAudioBuffer( filter_t *p_filter, size_t size )
+{
+    block_t *block = NULL;
+    if ( p_filter->owner.audio != NULL && p_filter->owner.audio->buffer_new != NULL )
+        block = p_filter->owner.audio->buffer_new( p_filter, size );
+    if ( block == NULL )
+        block = block_Alloc( size );
+    return block;
+}
+
 /**
  * Flush a filter
  *
@@ -426,6 +468,9 @@ VLC_API void filter_DeleteBlend( vlc_blender_t * );
  * Currently used by the chroma video filters
  */
 #define VIDEO_FILTER_WRAPPER_CLOSE_FILT( name, close_cb )               \
+    VIDEO_FILTER_WRAPPER_POINT_OP_FILT( name, close_cb, NULL )
+
+#define VIDEO_FILTER_WRAPPER_POINT_OP_FILT( name, close_cb, point_op )  \
     static picture_t *name ## _Filter ( filter_t *p_filter,             \
                                         picture_t *p_pic )              \
     {                                                                   \
@@ -439,7 +484,8 @@ VLC_API void filter_DeleteBlend( vlc_blender_t * );
         return p_outpic;                                                \
     }                                                                   \
     static const struct vlc_filter_operations name ## _ops = {          \
-        .filter_video = name ## _Filter, .close = close_cb,             \
+        .filter_video = name ## _Filter, .video_point_op = point_op,    \
+        .close = close_cb,                                              \
     };
 
 #define VIDEO_FILTER_WRAPPER_CLOSE( name, close_cb )                    \
@@ -451,6 +497,21 @@ VLC_API void filter_DeleteBlend( vlc_blender_t * );
     static void name (filter_t *, picture_t *, picture_t *);            \
     VIDEO_FILTER_WRAPPER_CLOSE_FILT( name, NULL )
 
+/**
+ * Wrapper for filters which can also describe themselves as lookup tables,
+ * see vlc_filter_operations::video_point_op
+ */
+#define VIDEO_FILTER_WRAPPER_POINT_OP( name, point_op )                 \
+    static void name (filter_t *, picture_t *, picture_t *);            \
+    static int point_op (filter_t *, uint8_t [][256]);                  \
+    VIDEO_FILTER_WRAPPER_POINT_OP_FILT( name, NULL, point_op )
+
+#define VIDEO_FILTER_WRAPPER_CLOSE_POINT_OP( name, close_cb, point_op ) \
+    static void name (filter_t *, picture_t *, picture_t *);            \
+    static void close_cb (filter_t *);                                  \
+    static int point_op (filter_t *, uint8_t [][256]);                  \
+    VIDEO_FILTER_WRAPPER_POINT_OP_FILT( name, close_cb, point_op )
+
 /**
  * Wrappers to use when the filter function is not a static function
  */
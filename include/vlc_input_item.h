@@ -572,6 +572,11 @@ struct input_stats_t
     /* Aout */
     uint64_t i_played_abuffers;
     uint64_t i_lost_abuffers;
+
+    /* Buffered data, for all the inputs of the instance */
+    uint64_t i_buffered_demux;
+    uint64_t i_buffered_decoder;
+    uint64_t i_buffered_sout;
 };
 
 /**
@@ -0,0 +1,92 @@
+/*****************************************************************************
+ * vlc_membudget.h: accounting of buffered media data
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_MEMBUDGET_H
+#define VLC_MEMBUDGET_H 1
+
+/**
+ * \defgroup membudget Memory budget
+ * \ingroup input
+ *
+ * Every LibVLC instance keeps the count of the bytes of media data buffered
+ * by its inputs, whatever the input they belong to. Components holding
+ * potentially large queues report them here, and check whether the instance
+ * is over its budget (see the "input-memory-budget" option) before growing
+ * them further.
+ *
+ * All functions are thread-safe and lock-free.
+ * @{
+ * \file
+ */
+
+/**
+ * Kind of buffer reported to the memory budget
+ */
+enum vlc_membudget_source
+{
+    VLC_MEMBUDGET_DEMUX, /**< stream and demux caches */
+    VLC_MEMBUDGET_DECODER, /**< decoder input FIFOs */
+    VLC_MEMBUDGET_SOUT, /**< stream output muxer queues */
+};
+
+#define VLC_MEMBUDGET_SOURCE_COUNT (VLC_MEMBUDGET_SOUT + 1)
+
+/**
+ * Reports data being buffered.
+ *
+ * \param obj any object of the LibVLC instance
+ * \param source kind of buffer holding the data
+ * \param bytes size of the data
+ */
+VLC_API void vlc_membudget_Add(vlc_object_t *obj,
+                               enum vlc_membudget_source source, size_t bytes);
+#define vlc_membudget_Add(o, s, b) vlc_membudget_Add(VLC_OBJECT(o), s, b)
+
+/**
+ * Reports buffered data being released.
+ *
+ * This must match previous vlc_membudget_Add() calls for the same source.
+ */
+VLC_API void vlc_membudget_Remove(vlc_object_t *obj,
+                                  enum vlc_membudget_source source,
+                                  size_t bytes);
+#define vlc_membudget_Remove(o, s, b) vlc_membudget_Remove(VLC_OBJECT(o), s, b)
+
+/**
+ * Gets the amount of data currently buffered by a kind of buffers.
+ *
+ * \return the size in bytes
+ */
+VLC_API size_t vlc_membudget_GetUsage(vlc_object_t *obj,
+                                      enum vlc_membudget_source source);
+#define vlc_membudget_GetUsage(o, s) vlc_membudget_GetUsage(VLC_OBJECT(o), s)
+
+/**
+ * Checks whether the instance buffers more than its budget.
+ *
+ * Callers should stop filling their buffers, or wait for them to be consumed,
+ * when this returns true. It always returns false if there is no budget.
+ */
+VLC_API bool vlc_membudget_IsExceeded(vlc_object_t *obj);
+#define vlc_membudget_IsExceeded(o) vlc_membudget_IsExceeded(VLC_OBJECT(o))
+
+/** @} */
+
+#endif
@@ -155,6 +155,17 @@ struct vlc_logger_operations
 {
     vlc_log_cb log;
     void (*destroy)(void *data);
+    /**
+     * Gets the verbosity of the log (optional).
+     *
+     * Messages of types above the verbosity are discarded before they are
+     * formatted. If this callback is NULL, all messages are passed.
+     *
+     * \param data data pointer as provided to vlc_LogSet()
+     * \return the most verbose message type (VLC_MSG_*) that the log keeps,
+     *         or -1 if it keeps no messages
+     */
+    int (*verbosity)(void *data);
 };
 
 /**
@@ -72,6 +72,9 @@ enum access_out_query_e
 {
     ACCESS_OUT_CONTROLS_PACE, /* arg1=bool *, can fail (assume true) */
     ACCESS_OUT_CAN_SEEK, /* arg1=bool *, can fail (assume false) */
+    ACCESS_OUT_MOVE_RANGE, /* arg1=uint64_t source offset, arg2=uint64_t
+                              destination offset, arg3=uint64_t length,
+                              can fail (see sout_AccessOutMoveRange) */
 };
 
 VLC_API sout_access_out_t * sout_AccessOutNew( vlc_object_t *, const char *psz_access, const char *psz_name ) VLC_USED;
@@ -91,6 +94,23 @@ static inline bool sout_AccessOutCanControlPace( sout_access_out_t *p_ao )
     return b;
 }
 
+/**
+ * Moves data within the output, like memmove() would.
+ *
+ * The current position is left unspecified: callers must seek afterwards.
+ *
+ * \retval VLC_SUCCESS if the whole range was moved
+ * \retval VLC_EGENERIC if the output cannot move data (nothing was moved)
+ * \return another error code if moving failed midway
+ */
+static inline int sout_AccessOutMoveRange( sout_access_out_t *p_ao,
+                                           uint64_t i_src, uint64_t i_dst,
+                                           uint64_t i_length )
+{
+    return sout_AccessOutControl( p_ao, ACCESS_OUT_MOVE_RANGE,
+                                  i_src, i_dst, i_length );
+}
+
 /**
  * @}
  * \defgroup sout_mux Multiplexer
@@ -323,6 +323,21 @@ struct vlc_display_operations
      */
     int (*update_format)(vout_display_t *, const video_format_t *fmt,
                          vlc_video_context *ctx);
+
+    /**
+     * Gets a pool of pictures to render into (optional).
+     *
+     * The video decoder or the format converter renders directly into those
+     * pictures, which are in the display format (\ref vout_display_t.fmt).
+     * This saves a copy in \ref vlc_display_operations.prepare, if the
+     * pictures are backed by display memory.
+     *
+     * May be NULL. The pictures may outlive the display.
+     *
+     * \param count minimum number of pictures in the pool
+     * \return a picture pool, or NULL if none is available
+     */
+    struct picture_pool_t *(*pool)(vout_display_t *, unsigned count);
 };
 
 struct vout_display_t {
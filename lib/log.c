@@ -77,7 +77,7 @@ static void libvlc_logf (void *data, int level, const vlc_log_t *item,
 }
 
 static const struct vlc_logger_operations libvlc_log_ops = {
-    libvlc_logf, NULL
+    libvlc_logf, NULL, NULL
 };
 
 void libvlc_log_unset (libvlc_instance_t *inst)
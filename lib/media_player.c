@@ -653,6 +653,7 @@ libvlc_media_player_new( libvlc_instance_t *instance )
     var_Create (mp, "vmem-data", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-setup", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-cleanup", VLC_VAR_ADDRESS);
+    var_Create (mp, "vmem-buffer", VLC_VAR_ADDRESS);
     var_Create (mp, "vmem-chroma", VLC_VAR_STRING);
     var_Create (mp, "vmem-width", VLC_VAR_INTEGER);
     var_Create (mp, "vmem-height", VLC_VAR_INTEGER);
@@ -1089,6 +1090,12 @@ void libvlc_video_set_format_callbacks( libvlc_media_player_t *mp,
     var_SetAddress( mp, "vmem-cleanup", cleanup );
 }
 
+void libvlc_video_set_buffer_callback( libvlc_media_player_t *mp,
+                                       libvlc_video_buffer_cb buffer )
+{
+    var_SetAddress( mp, "vmem-buffer", buffer );
+}
+
 void libvlc_video_set_format( libvlc_media_player_t *mp, const char *chroma,
                               unsigned width, unsigned height, unsigned pitch )
 {
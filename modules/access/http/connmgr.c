@@ -25,6 +25,9 @@
 #include <assert.h>
 #include <vlc_common.h>
 #include <vlc_network.h>
+#include <vlc_strings.h>
+#include <vlc_threads.h>
+#include <vlc_list.h>
 #include <vlc_tls.h>
 #include <vlc_url.h>
 #include "transport.h"
@@ -96,50 +99,124 @@ static char *vlc_http_proxy_find(const char *hostname, unsigned port,
 }
 
 
+/** Maximum number of pooled connections */
+#define VLC_HTTP_MGR_MAX_CONNS 8
+/** Delay after which an unused connection is closed */
+#define VLC_HTTP_MGR_IDLE_TIMEOUT VLC_TICK_FROM_SEC(30)
+
+struct vlc_http_mgr_conn
+{
+    struct vlc_list node;
+    struct vlc_http_conn *conn;
+    bool https;
+    unsigned port;
+    vlc_tick_t last_used;
+    char host[];
+};
+
 struct vlc_http_mgr
 {
     struct vlc_logger *logger;
     vlc_object_t *obj;
     vlc_tls_client_t *creds;
     struct vlc_http_cookie_jar_t *jar;
-    struct vlc_http_conn *conn;
+    struct vlc_list conns; /**< most recently used first */
+    unsigned count;
+    struct vlc_http_mgr_stats stats;
 };
 
-static struct vlc_http_conn *vlc_http_mgr_find(struct vlc_http_mgr *mgr,
-                                               const char *host, unsigned port)
+static unsigned vlc_http_port(bool https, unsigned port)
 {
-    (void) host; (void) port;
-    return mgr->conn;
+    if (port == 0)
+        port = https ? 443 : 80;
+    return port;
 }
 
 static void vlc_http_mgr_release(struct vlc_http_mgr *mgr,
-                                 struct vlc_http_conn *conn)
+                                 struct vlc_http_mgr_conn *entry)
 {
-    assert(mgr->conn == conn);
-    mgr->conn = NULL;
+    assert(mgr->count > 0);
+    vlc_list_remove(&entry->node);
+    mgr->count--;
+    mgr->stats.closed++;
 
-    vlc_http_conn_release(conn);
+    vlc_http_conn_release(entry->conn);
+    free(entry);
+}
+
+/** Closes the connections that have not been used for too long. */
+static void vlc_http_mgr_expire(struct vlc_http_mgr *mgr)
+{
+    const vlc_tick_t deadline = vlc_tick_now() - VLC_HTTP_MGR_IDLE_TIMEOUT;
+    struct vlc_http_mgr_conn *entry;
+
+    vlc_list_foreach(entry, &mgr->conns, node)
+        if (entry->last_used < deadline)
+            vlc_http_mgr_release(mgr, entry);
+}
+
+static int vlc_http_mgr_add(struct vlc_http_mgr *mgr, bool https,
+                            const char *host, unsigned port,
+                            struct vlc_http_conn *conn)
+{
+    size_t len = strlen(host) + 1;
+    struct vlc_http_mgr_conn *entry = malloc(sizeof (*entry) + len);
+    if (unlikely(entry == NULL))
+        return -1;
+
+    if (mgr->count >= VLC_HTTP_MGR_MAX_CONNS)
+    {   /* Evict the least recently used connection */
+        struct vlc_http_mgr_conn *lru =
+            vlc_list_last_entry_or_null(&mgr->conns, struct vlc_http_mgr_conn,
+                                        node);
+        vlc_http_mgr_release(mgr, lru);
+    }
+
+    entry->conn = conn;
+    entry->https = https;
+    entry->port = vlc_http_port(https, port);
+    entry->last_used = vlc_tick_now();
+    memcpy(entry->host, host, len);
+    vlc_list_prepend(&entry->node, &mgr->conns);
+    mgr->count++;
+    mgr->stats.opened++;
+    return 0;
 }
 
 static
-struct vlc_http_msg *vlc_http_mgr_reuse(struct vlc_http_mgr *mgr,
+struct vlc_http_msg *vlc_http_mgr_reuse(struct vlc_http_mgr *mgr, bool https,
                                         const char *host, unsigned port,
                                         const struct vlc_http_msg *req,
                                         bool payload)
 {
-    struct vlc_http_conn *conn = vlc_http_mgr_find(mgr, host, port);
-    if (conn == NULL)
-        return NULL;
+    struct vlc_http_mgr_conn *entry;
 
-    struct vlc_http_stream *stream = vlc_http_stream_open(conn, req, payload);
-    if (stream != NULL)
+    port = vlc_http_port(https, port);
+    vlc_http_mgr_expire(mgr);
+
+    vlc_list_foreach(entry, &mgr->conns, node)
     {
-        struct vlc_http_msg *m = vlc_http_msg_get_initial(stream);
-        if (m != NULL)
-            return m;
+        if (entry->https != https || entry->port != port
+         || vlc_ascii_strcasecmp(entry->host, host))
+            continue;
+
+        struct vlc_http_stream *stream = vlc_http_stream_open(entry->conn, req,
+                                                              payload);
+        if (stream != NULL)
+        {
+            struct vlc_http_msg *m = vlc_http_msg_get_initial(stream);
+            if (m != NULL)
+            {
+                vlc_list_remove(&entry->node);
+                vlc_list_prepend(&entry->node, &mgr->conns);
+                entry->last_used = vlc_tick_now();
+                mgr->stats.reused++;
+                return m;
+            }
+        }
+        /* Get rid of busy, closing or reset connection */
+        vlc_http_mgr_release(mgr, entry);
     }
-    /* Get rid of closing or reset connection */
-    vlc_http_mgr_release(mgr, conn);
     return NULL;
 }
 
@@ -151,9 +228,6 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
     vlc_tls_t *tls;
     bool http2 = true;
 
-    if (mgr->creds == NULL && mgr->conn != NULL)
-        return NULL; /* switch from HTTP to HTTPS not implemented */
-
     if (mgr->creds == NULL)
     {   /* First TLS connection: load x509 credentials */
         mgr->creds = vlc_tls_ClientCreate(mgr->obj);
@@ -167,24 +241,26 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
          * the nonidempotent request was processed if the connection fails
          * before the response is received.
          */
-        struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, host, port, req,
-                                                       payload);
+        struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, true, host, port,
+                                                       req, payload);
         if (resp != NULL)
             return resp; /* existing connection reused */
     }
 
+    /* The proxy settings only apply to new connections */
     char *proxy = vlc_http_proxy_find(host, port, true);
+
     if (proxy != NULL)
-    {
         tls = vlc_https_connect_proxy(mgr->creds, mgr->creds,
                                       host, port, &http2, proxy);
-        free(proxy);
-    }
     else
         tls = vlc_https_connect(mgr->creds, host, port, &http2);
 
     if (tls == NULL)
+    {
+        free(proxy);
         return NULL;
+    }
 
     struct vlc_http_conn *conn;
 
@@ -203,14 +279,20 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
     if (unlikely(conn == NULL))
     {
         vlc_tls_Close(tls);
+        free(proxy);
         return NULL;
     }
 
-    if (mgr->conn != NULL)
-        vlc_http_mgr_release(mgr, mgr->conn);
+    struct vlc_http_msg *resp = NULL;
+    struct vlc_http_stream *stream = vlc_http_stream_open(conn, req, payload);
+    if (stream != NULL)
+        resp = vlc_http_msg_get_initial(stream);
 
-    mgr->conn = conn;
-    return vlc_http_mgr_reuse(mgr, host, port, req, payload);
+    if (resp == NULL || vlc_http_mgr_add(mgr, true, host, port, conn))
+        /* Connection is closed once the response, if any, is destroyed */
+        vlc_http_conn_release(conn);
+    free(proxy);
+    return resp;
 }
 
 static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
@@ -218,13 +300,10 @@ static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
                                              const struct vlc_http_msg *req,
                                              bool idempotent, bool payload)
 {
-    if (mgr->creds != NULL && mgr->conn != NULL)
-        return NULL; /* switch from HTTPS to HTTP not implemented */
-
     if (idempotent)
     {
-        struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, host, port, req,
-                                                       payload);
+        struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, false, host, port,
+                                                       req, payload);
         if (resp != NULL)
             return resp;
     }
@@ -233,12 +312,12 @@ static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
     struct vlc_http_stream *stream;
 
     char *proxy = vlc_http_proxy_find(host, port, false);
+
     if (proxy != NULL)
     {
         vlc_url_t url;
 
         vlc_UrlParse(&url, proxy);
-        free(proxy);
 
         if (url.psz_host != NULL)
             stream = vlc_h1_request(mgr->logger, url.psz_host,
@@ -254,19 +333,15 @@ static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
                                 req, idempotent, payload, &conn);
 
     if (stream == NULL)
-        return NULL;
-
-    struct vlc_http_msg *resp = vlc_http_msg_get_initial(stream);
-    if (resp == NULL)
     {
-        vlc_http_conn_release(conn);
+        free(proxy);
         return NULL;
     }
 
-    if (mgr->conn != NULL)
-        vlc_http_mgr_release(mgr, mgr->conn);
-
-    mgr->conn = conn;
+    struct vlc_http_msg *resp = vlc_http_msg_get_initial(stream);
+    if (resp == NULL || vlc_http_mgr_add(mgr, false, host, port, conn))
+        vlc_http_conn_release(conn);
+    free(proxy);
     return resp;
 }
 
@@ -298,14 +373,27 @@ struct vlc_http_mgr *vlc_http_mgr_create(vlc_object_t *obj,
     mgr->obj = obj;
     mgr->creds = NULL;
     mgr->jar = jar;
-    mgr->conn = NULL;
+    vlc_list_init(&mgr->conns);
+    mgr->count = 0;
+    memset(&mgr->stats, 0, sizeof (mgr->stats));
     return mgr;
 }
 
+void vlc_http_mgr_get_stats(const struct vlc_http_mgr *mgr,
+                            struct vlc_http_mgr_stats *stats)
+{
+    *stats = mgr->stats;
+}
+
 void vlc_http_mgr_destroy(struct vlc_http_mgr *mgr)
 {
-    if (mgr->conn != NULL)
-        vlc_http_mgr_release(mgr, mgr->conn);
+    struct vlc_http_mgr_conn *entry;
+
+    vlc_list_foreach(entry, &mgr->conns, node)
+        vlc_http_mgr_release(mgr, entry);
+
+    vlc_http_dbg(mgr->logger, "%u connection(s) opened, %u reused",
+                 mgr->stats.opened, mgr->stats.reused);
     if (mgr->creds != NULL)
         vlc_tls_ClientDelete(mgr->creds);
     free(mgr);
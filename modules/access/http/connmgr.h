@@ -57,6 +57,22 @@ struct vlc_http_msg *vlc_http_mgr_request(struct vlc_http_mgr *mgr, bool https,
 
 struct vlc_http_cookie_jar_t *vlc_http_mgr_get_jar(struct vlc_http_mgr *);
 
+/**
+ * HTTP connection manager statistics
+ */
+struct vlc_http_mgr_stats
+{
+    unsigned opened; /**< connections established */
+    unsigned reused; /**< requests sent over an existing connection */
+    unsigned closed; /**< connections dropped from the pool */
+};
+
+/**
+ * Gets the connection manager statistics.
+ */
+void vlc_http_mgr_get_stats(const struct vlc_http_mgr *mgr,
+                            struct vlc_http_mgr_stats *stats);
+
 /**
  * Creates an HTTP connection manager
  *
@@ -0,0 +1,247 @@
+/*****************************************************************************
+ * connmgr_test.c: HTTP connection manager test
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#undef NDEBUG
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <sys/types.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#endif
+#ifndef SOCK_CLOEXEC
+# define SOCK_CLOEXEC 0
+# define accept4(a,b,c,d) accept(a,b,c)
+#endif
+#ifdef _WIN32
+# include <winsock2.h>
+#else
+# include <netinet/in.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_fs.h>
+#include <vlc_threads.h>
+#include "connmgr.h"
+#include "message.h"
+
+const char vlc_module_name[] = "test_http_connmgr";
+
+#define SERVERS 2
+#define REQUESTS 20
+
+static const char body[] = "Hello world!";
+
+struct server
+{
+    int fd;
+    unsigned port;
+    unsigned connections;
+    vlc_thread_t thread;
+};
+
+/* Answers requests on a keep-alive connection until the client closes it */
+static void server_client_process(int fd)
+{
+    char buf[1024];
+    size_t buflen = 0;
+
+    for (;;)
+    {
+        char *end;
+
+        while ((end = strnstr(buf, "\r\n\r\n", buflen)) == NULL)
+        {
+            ssize_t val = recv(fd, buf + buflen, sizeof (buf) - buflen - 1, 0);
+            if (val <= 0)
+                return; /* connection closed by the client */
+            buflen += val;
+        }
+
+        /* Origin form, or absolute form through the proxy */
+        assert(!strncmp(buf, "GET / HTTP/1.1\r\n", 16)
+            || !strncmp(buf, "GET http://[::1]:", 17));
+
+        char resp[256];
+        int len = snprintf(resp, sizeof (resp), "HTTP/1.1 200 OK\r\n"
+                           "Content-Length: %zu\r\n"
+                           "\r\n%s", strlen(body), body);
+        assert(len > 0 && (size_t)len < sizeof (resp));
+
+        ssize_t val = write(fd, resp, len);
+        assert(val == len);
+
+        /* Keep any pipelined data */
+        end += 4;
+        buflen -= end - buf;
+        memmove(buf, end, buflen);
+    }
+}
+
+static void *server_thread(void *data)
+{
+    struct server *s = data;
+
+    for (;;)
+    {
+        int cfd = accept4(s->fd, NULL, NULL, SOCK_CLOEXEC);
+        if (cfd == -1)
+            continue;
+
+        int canc = vlc_savecancel();
+        s->connections++;
+        server_client_process(cfd);
+        vlc_close(cfd);
+        vlc_restorecancel(canc);
+    }
+    vlc_assert_unreachable();
+}
+
+static int server_socket(unsigned *port)
+{
+    int fd = socket(PF_INET6, SOCK_STREAM|SOCK_CLOEXEC, IPPROTO_TCP);
+    if (fd == -1)
+        return -1;
+
+    struct sockaddr_in6 addr = {
+        .sin6_family = AF_INET6,
+#ifdef HAVE_SA_LEN
+        .sin6_len = sizeof (addr),
+#endif
+        .sin6_addr = in6addr_loopback,
+    };
+    socklen_t addrlen = sizeof (addr);
+
+    if (bind(fd, (struct sockaddr *)&addr, addrlen)
+     || getsockname(fd, (struct sockaddr *)&addr, &addrlen)
+     || listen(fd, 255))
+    {
+        vlc_close(fd);
+        return -1;
+    }
+
+    *port = ntohs(addr.sin6_port);
+    return fd;
+}
+
+static void request(struct vlc_http_mgr *mgr, unsigned port)
+{
+    char authority[32];
+
+    snprintf(authority, sizeof (authority), "[::1]:%u", port);
+
+    struct vlc_http_msg *req = vlc_http_req_create("GET", "http", authority,
+                                                   "/");
+    assert(req != NULL);
+
+    struct vlc_http_msg *resp = vlc_http_mgr_request(mgr, false, "::1", port,
+                                                     req, true, false);
+    vlc_http_msg_destroy(req);
+    assert(resp != NULL);
+    assert(vlc_http_msg_get_status(resp) == 200);
+
+    /* Read the whole body, so that the connection can be reused */
+    size_t len = 0;
+    block_t *block;
+
+    while ((block = vlc_http_msg_read(resp)) != NULL)
+    {
+        assert(block != vlc_http_error);
+        assert(len + block->i_buffer <= strlen(body));
+        assert(!memcmp(body + len, block->p_buffer, block->i_buffer));
+        len += block->i_buffer;
+        block_Release(block);
+    }
+    assert(len == strlen(body));
+    vlc_http_msg_destroy(resp);
+}
+
+int main(void)
+{
+    struct server servers[SERVERS + 1]; /* the last one is the proxy */
+
+    unsetenv("http_proxy"); /* connect directly to the test servers */
+
+    for (size_t i = 0; i < SERVERS + 1; i++)
+    {
+        servers[i].fd = server_socket(&servers[i].port);
+        if (servers[i].fd == -1)
+            return 77;
+        servers[i].connections = 0;
+    }
+
+    for (size_t i = 0; i < SERVERS + 1; i++)
+        if (vlc_clone(&servers[i].thread, server_thread, &servers[i]))
+            assert(!"Thread error");
+
+    struct vlc_object_t obj = { .logger = NULL };
+    struct vlc_http_mgr *mgr = vlc_http_mgr_create(&obj, NULL);
+    assert(mgr != NULL);
+
+    /* Alternate between the origins: each keeps its own connection */
+    for (unsigned i = 0; i < REQUESTS; i++)
+        request(mgr, servers[i % SERVERS].port);
+
+    struct vlc_http_mgr_stats stats;
+
+    vlc_http_mgr_get_stats(mgr, &stats);
+    assert(stats.opened == SERVERS);
+    assert(stats.reused == REQUESTS - SERVERS);
+    assert(stats.closed == 0);
+
+    /* The proxy only applies to new connections: pooled ones are reused,
+     * and a closed origin port is reached through the proxy */
+    char proxy[32];
+    unsigned closed_port;
+    int fd = server_socket(&closed_port);
+    assert(fd != -1);
+    vlc_close(fd);
+
+    snprintf(proxy, sizeof (proxy), "http://[::1]:%u", servers[SERVERS].port);
+    setenv("http_proxy", proxy, 1);
+    request(mgr, servers[0].port);
+    request(mgr, closed_port);
+    unsetenv("http_proxy");
+
+    vlc_http_mgr_get_stats(mgr, &stats);
+    assert(stats.opened == SERVERS + 1);
+    assert(stats.reused == REQUESTS - SERVERS + 1);
+    assert(stats.closed == 0);
+
+    vlc_http_mgr_destroy(mgr);
+
+    for (size_t i = 0; i < SERVERS + 1; i++)
+    {
+        vlc_cancel(servers[i].thread);
+        vlc_join(servers[i].thread, NULL);
+        assert(servers[i].connections == 1);
+        vlc_close(servers[i].fd);
+    }
+    return 0;
+}
@@ -47,6 +47,8 @@
 #define CO(c) ((c)->opaque)
 #define SO(s) CO((s)->conn)
 
+#define VLC_H2_STREAM_BUCKETS 256 /* must be a power of two */
+
 /** HTTP/2 connection */
 struct vlc_h2_conn
 {
@@ -55,6 +57,7 @@ struct vlc_h2_conn
     void *opaque;
 
     struct vlc_h2_stream *streams; /**< List of open streams */
+    struct vlc_h2_stream *buckets[VLC_H2_STREAM_BUCKETS]; /**< Streams by ID */
     uint32_t next_id; /**< Next free stream identifier */
     bool released; /**< Connection released by owner */
 
@@ -76,6 +79,7 @@ struct vlc_h2_stream
     struct vlc_h2_conn *conn; /**< Underlying HTTP/2 connection */
     struct vlc_h2_stream *older; /**< Previous open stream in connection */
     struct vlc_h2_stream *newer; /**< Next open stream in connection */
+    struct vlc_h2_stream *hash_next; /**< Next stream in hash bucket */
     uint32_t id; /**< Stream 31-bits identifier */
 
     bool interrupted;
@@ -108,12 +112,20 @@ static int vlc_h2_conn_queue_prio(struct vlc_h2_conn *conn,
 
 /* Stream callbacks */
 
+static struct vlc_h2_stream **vlc_h2_stream_bucket(struct vlc_h2_conn *conn,
+                                                   uint_fast32_t id)
+{
+    /* Locally-initiated stream identifiers are odd and consecutive */
+    return &conn->buckets[(id >> 1) & (VLC_H2_STREAM_BUCKETS - 1)];
+}
+
 /** Looks a stream up by ID. */
 static void *vlc_h2_stream_lookup(void *ctx, uint_fast32_t id)
 {
     struct vlc_h2_conn *conn = ctx;
 
-    for (struct vlc_h2_stream *s = conn->streams; s != NULL; s = s->older)
+    for (struct vlc_h2_stream *s = *vlc_h2_stream_bucket(conn, id);
+         s != NULL; s = s->hash_next)
         if (s->id == id)
             return s;
     return NULL;
@@ -451,6 +463,12 @@ static void vlc_h2_stream_close(struct vlc_http_stream *stream, bool aborted)
     uint_fast32_t code = VLC_H2_NO_ERROR;
 
     vlc_mutex_lock(&conn->lock);
+    struct vlc_h2_stream **pp = vlc_h2_stream_bucket(conn, s->id);
+
+    while (*pp != s)
+        pp = &(*pp)->hash_next;
+    *pp = s->hash_next;
+
     if (s->older != NULL)
         s->older->newer = s->newer;
     if (s->newer != NULL)
@@ -549,6 +567,11 @@ static struct vlc_http_stream *vlc_h2_stream_open(struct vlc_http_conn *c,
     if (s->older != NULL)
         s->older->newer = s;
     conn->streams = s;
+
+    struct vlc_h2_stream **pp = vlc_h2_stream_bucket(conn, s->id);
+
+    s->hash_next = *pp;
+    *pp = s;
     vlc_mutex_unlock(&conn->lock);
     return &s->stream;
 
@@ -882,6 +905,8 @@ struct vlc_http_conn *vlc_h2_conn_create(void *ctx, struct vlc_tls *tls)
     conn->out = vlc_h2_output_create(tls, true);
     conn->opaque = ctx;
     conn->streams = NULL;
+    for (size_t i = 0; i < VLC_H2_STREAM_BUCKETS; i++)
+        conn->buckets[i] = NULL;
     conn->next_id = 1; /* TODO: server side */
     conn->released = false;
     conn->max_send_frame = VLC_H2_DEFAULT_MAX_FRAME;
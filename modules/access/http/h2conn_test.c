@@ -35,6 +35,7 @@
 
 #include <vlc_common.h>
 #include <vlc_block.h>
+#include <vlc_threads.h>
 #include <vlc_tls.h>
 #include "h2frame.h"
 #include "conn.h"
@@ -157,6 +158,71 @@ static void stream_data(uint_fast32_t id, const char *str, bool eos)
     conn_send(vlc_h2_frame_data(id, str, strlen(str), eos));
 }
 
+/* Discards everything sent by the connection under test */
+static void *conn_drain(void *data)
+{
+    uint8_t buf[4096];
+
+    (void) data;
+    while (vlc_tls_Read(external_tls, buf, sizeof (buf), false) > 0);
+    return NULL;
+}
+
+#define MANY_STREAMS 500
+#define MANY_FRAMES 32
+#define MANY_FRAME_SIZE 1024 /* MANY_FRAMES * MANY_FRAME_SIZE < window */
+
+/* Many concurrent streams, with interleaved data, e.g. parallel byte ranges */
+static void test_many_streams(void)
+{
+    static struct vlc_http_stream *streams[MANY_STREAMS];
+    static char payload[MANY_FRAME_SIZE];
+    vlc_thread_t th;
+
+    memset(payload, 'x', sizeof (payload));
+    conn_create();
+    if (vlc_clone(&th, conn_drain, NULL))
+        assert(!"Thread error");
+
+    for (unsigned i = 0; i < MANY_STREAMS; i++)
+    {
+        streams[i] = stream_open(false);
+        assert(streams[i] != NULL);
+    }
+
+    for (unsigned i = MANY_STREAMS; i > 0; i--)
+        stream_reply(2 * i - 1, false);
+
+    for (unsigned f = 0; f < MANY_FRAMES; f++)
+        for (unsigned i = MANY_STREAMS; i > 0; i--)
+            conn_send(vlc_h2_frame_data(2 * i - 1, payload, sizeof (payload),
+                                        f == MANY_FRAMES - 1));
+
+    for (unsigned i = 0; i < MANY_STREAMS; i++)
+    {
+        struct vlc_http_msg *m = vlc_http_msg_get_initial(streams[i]);
+        block_t *b;
+        size_t total = 0;
+
+        assert(m != NULL);
+        assert(vlc_http_msg_get_status(m) == 200);
+
+        while ((b = vlc_http_msg_read(m)) != NULL)
+        {
+            assert(b != vlc_http_error);
+            total += b->i_buffer;
+            block_Release(b);
+        }
+        assert(total == MANY_FRAMES * MANY_FRAME_SIZE);
+        vlc_http_msg_destroy(m);
+    }
+
+    vlc_tls_Shutdown(external_tls, false);
+    vlc_http_conn_release(conn);
+    vlc_join(th, NULL);
+    vlc_tls_SessionDelete(external_tls);
+}
+
 /* TODO: check messages coming from the connection under test */
 
 int main(void)
@@ -319,5 +385,6 @@ int main(void)
     conn_destroy();
     vlc_http_stream_close(s, false);
 
+    test_many_streams();
     return 0;
 }
@@ -151,6 +151,25 @@ enum {
     VLC_H2_CONTINUATION_END_HEADERS = 0x04,
 };
 
+uint_fast32_t vlc_h2_frame_stream_id(const struct vlc_h2_frame *f)
+{
+    return vlc_h2_frame_id(f);
+}
+
+bool vlc_h2_frame_continued(const struct vlc_h2_frame *f)
+{
+    switch (vlc_h2_frame_type(f))
+    {
+        case VLC_H2_FRAME_HEADERS:
+            return !(vlc_h2_frame_flags(f) & VLC_H2_HEADERS_END_HEADERS);
+        case VLC_H2_FRAME_PUSH_PROMISE:
+            return !(vlc_h2_frame_flags(f) & VLC_H2_PUSH_PROMISE_END_HEADERS);
+        case VLC_H2_FRAME_CONTINUATION:
+            return !(vlc_h2_frame_flags(f) & VLC_H2_CONTINUATION_END_HEADERS);
+    }
+    return false;
+}
+
 struct vlc_h2_frame *
 vlc_h2_frame_headers(uint_fast32_t stream_id, uint_fast32_t mtu, bool eos,
                      unsigned count, const char *const headers[][2])
@@ -34,6 +34,15 @@ struct vlc_h2_frame
 };
 
 size_t vlc_h2_frame_size(const struct vlc_h2_frame *);
+uint_fast32_t vlc_h2_frame_stream_id(const struct vlc_h2_frame *);
+
+/**
+ * Checks if a frame is followed by a CONTINUATION frame.
+ *
+ * A header block must be sent contiguously: no other frame can be sent
+ * between a frame for which this returns true and the following frame.
+ */
+bool vlc_h2_frame_continued(const struct vlc_h2_frame *);
 
 struct vlc_h2_frame *
 vlc_h2_frame_headers(uint_fast32_t stream_id, uint_fast32_t mtu, bool eos,
@@ -39,6 +39,7 @@
 #include "h2output.h"
 
 #define VLC_H2_MAX_QUEUE (1u << 24)
+#define VLC_H2_OUTPUT_BUCKETS 64 /* must be a power of two */
 
 struct vlc_h2_queue
 {
@@ -46,12 +47,28 @@ struct vlc_h2_queue
     struct vlc_h2_frame **last;
 };
 
+/** Send queue of one stream */
+struct vlc_h2_output_stream
+{
+    struct vlc_h2_queue queue;
+    struct vlc_h2_output_stream *hash_next; /*< Next stream in hash bucket */
+    struct vlc_h2_output_stream *rr_next; /*< Next stream in round robin */
+    uint32_t id;
+};
+
 struct vlc_h2_output
 {
     struct vlc_tls *tls;
 
     struct vlc_h2_queue prio; /*< Priority send queue */
-    struct vlc_h2_queue queue; /*< Normal send queue */
+    struct vlc_h2_queue queue; /*< Connection (stream 0) send queue */
+    /* Streams with pending frames, indexed by identifier and served in
+     * round robin, one frame (or one header block) at a time. Flow control
+     * is enforced before frames are queued, so all of them can be sent. */
+    struct vlc_h2_output_stream *buckets[VLC_H2_OUTPUT_BUCKETS];
+    struct vlc_h2_output_stream *rr_first;
+    struct vlc_h2_output_stream **rr_last;
+    bool continued; /*< Header block being sent, not to be interleaved */
     size_t size; /*< Total queues depth (bytes) */
     bool failed; /*< Connection failure flag */
     bool closing; /*< Connection shutdown pending flag */
@@ -61,6 +78,38 @@ struct vlc_h2_output
     vlc_thread_t thread;
 };
 
+static struct vlc_h2_output_stream **
+vlc_h2_output_bucket(struct vlc_h2_output *out, uint_fast32_t id)
+{
+    /* Client and server streams identifiers are odd and even respectively */
+    return &out->buckets[(id >> 1) & (VLC_H2_OUTPUT_BUCKETS - 1)];
+}
+
+/** Finds or creates the send queue of a stream (with out->lock held). */
+static struct vlc_h2_queue *vlc_h2_output_stream(struct vlc_h2_output *out,
+                                                 uint_fast32_t id)
+{
+    struct vlc_h2_output_stream **pp = vlc_h2_output_bucket(out, id);
+
+    for (struct vlc_h2_output_stream *s = *pp; s != NULL; s = s->hash_next)
+        if (s->id == id)
+            return &s->queue;
+
+    struct vlc_h2_output_stream *s = malloc(sizeof (*s));
+    if (unlikely(s == NULL))
+        return NULL;
+
+    s->queue.first = NULL;
+    s->queue.last = &s->queue.first;
+    s->id = id;
+    s->hash_next = *pp;
+    *pp = s;
+    s->rr_next = NULL;
+    *(out->rr_last) = s;
+    out->rr_last = &s->rr_next;
+    return &s->queue;
+}
+
 /** Queues one outgoing HTTP/2. */
 static int vlc_h2_output_queue(struct vlc_h2_output *out,
                                struct vlc_h2_queue *q, struct vlc_h2_frame *f)
@@ -95,6 +144,21 @@ static int vlc_h2_output_queue(struct vlc_h2_output *out,
         goto error;
     }
 
+    if (q == NULL)
+    {
+        uint_fast32_t id = vlc_h2_frame_stream_id(f);
+
+        if (id != 0)
+            q = vlc_h2_output_stream(out, id);
+        else
+            q = &out->queue;
+        if (unlikely(q == NULL))
+        {
+            out->size -= len;
+            goto error;
+        }
+    }
+
     assert(*(q->last) == NULL);
     *(q->last) = f;
     q->last = lastp;
@@ -121,7 +185,32 @@ int vlc_h2_output_send_prio(struct vlc_h2_output *out, struct vlc_h2_frame *f)
 
 int vlc_h2_output_send(struct vlc_h2_output *out, struct vlc_h2_frame *f)
 {
-    return vlc_h2_output_queue(out, &out->queue, f);
+    return vlc_h2_output_queue(out, NULL, f);
+}
+
+/** Moves to the next stream in round robin (with out->lock held). */
+static void vlc_h2_output_rotate(struct vlc_h2_output *out)
+{
+    struct vlc_h2_output_stream *s = out->rr_first;
+
+    out->rr_first = s->rr_next;
+    if (out->rr_first == NULL)
+        out->rr_last = &out->rr_first;
+
+    if (s->queue.first != NULL)
+    {   /* More frames pending: go to the back of the line */
+        s->rr_next = NULL;
+        *(out->rr_last) = s;
+        out->rr_last = &s->rr_next;
+        return;
+    }
+
+    struct vlc_h2_output_stream **pp = vlc_h2_output_bucket(out, s->id);
+
+    while (*pp != s)
+        pp = &(*pp)->hash_next;
+    *pp = s->hash_next;
+    free(s);
 }
 
 /** Dequeues one outgoing HTTP/2. */
@@ -130,18 +219,30 @@ static struct vlc_h2_frame *vlc_h2_output_dequeue(struct vlc_h2_output *out)
     struct vlc_h2_queue *q;
     struct vlc_h2_frame *frame;
     size_t len;
+    bool stream = false;
 
     vlc_mutex_lock(&out->lock);
 
     for (;;)
     {
-        q = &out->prio;
-        if (q->first != NULL)
-            break;
+        /* Nothing can be interleaved with a header block */
+        if (!out->continued)
+        {
+            q = &out->prio;
+            if (q->first != NULL)
+                break;
 
-        q = &out->queue;
-        if (q->first != NULL)
+            q = &out->queue;
+            if (q->first != NULL)
+                break;
+        }
+
+        if (out->rr_first != NULL)
+        {
+            q = &out->rr_first->queue;
+            stream = true;
             break;
+        }
 
         if (unlikely(out->closing))
         {
@@ -167,24 +268,45 @@ static struct vlc_h2_frame *vlc_h2_output_dequeue(struct vlc_h2_output *out)
     assert(out->size >= len);
     out->size -= len;
 
+    if (stream)
+    {
+        out->continued = vlc_h2_frame_continued(frame);
+        if (!out->continued)
+            vlc_h2_output_rotate(out);
+    }
+
     vlc_mutex_unlock(&out->lock);
 
     frame->next = NULL;
     return frame;
 }
 
-static void vlc_h2_output_flush_unlocked(struct vlc_h2_output *out)
+static void vlc_h2_queue_flush(struct vlc_h2_queue *q)
 {
-    for (struct vlc_h2_frame *f = out->prio.first, *n; f != NULL; f = n)
+    for (struct vlc_h2_frame *f = q->first, *n; f != NULL; f = n)
     {
         n = f->next;
         free(f);
     }
-    for (struct vlc_h2_frame *f = out->queue.first, *n; f != NULL; f = n)
+    q->first = NULL;
+    q->last = &q->first;
+}
+
+static void vlc_h2_output_flush_unlocked(struct vlc_h2_output *out)
+{
+    vlc_h2_queue_flush(&out->prio);
+    vlc_h2_queue_flush(&out->queue);
+
+    for (struct vlc_h2_output_stream *s = out->rr_first, *n; s != NULL; s = n)
     {
-        n = f->next;
-        free(f);
+        n = s->rr_next;
+        vlc_h2_queue_flush(&s->queue);
+        free(s);
     }
+    out->rr_first = NULL;
+    out->rr_last = &out->rr_first;
+    memset(out->buckets, 0, sizeof (out->buckets));
+    out->continued = false;
 }
 
 /**
@@ -276,10 +398,6 @@ static void *vlc_h2_output_thread(void *data)
             /* The caller will leave the queues alone from now on until this
              * thread ends. The queues are flushed to free memory. */
             vlc_h2_output_flush_unlocked(out);
-            out->prio.first = NULL;
-            out->prio.last = &out->prio.first;
-            out->queue.first = NULL;
-            out->queue.last = &out->queue.first;
             break;
         }
     }
@@ -317,6 +435,11 @@ struct vlc_h2_output *vlc_h2_output_create(struct vlc_tls *tls, bool client)
     out->prio.last = &out->prio.first;
     out->queue.first = NULL;
     out->queue.last = &out->queue.first;
+    for (size_t i = 0; i < VLC_H2_OUTPUT_BUCKETS; i++)
+        out->buckets[i] = NULL;
+    out->rr_first = NULL;
+    out->rr_last = &out->rr_first;
+    out->continued = false;
     out->size = 0;
     out->failed = false;
     out->closing = false;
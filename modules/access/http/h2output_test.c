@@ -98,6 +98,65 @@ static vlc_tls_t fake_tls =
     .ops = &fake_ops,
 };
 
+/* Frame types, as in RFC 7540 */
+enum { DATA = 0, HEADERS = 1, PING = 6, CONTINUATION = 9 };
+
+/* Frames sent in lock step with the test, identified by type and stream */
+struct sent_frame
+{
+    uint8_t type;
+    uint32_t id;
+};
+
+static struct sent_frame sent[16];
+static unsigned sent_count;
+static vlc_sem_t gate;
+
+static ssize_t record_callback(vlc_tls_t *tls, const struct iovec *iov,
+                               unsigned count)
+{
+    assert(count == 1);
+    (void) tls;
+
+    const uint8_t *p = iov->iov_base;
+
+    assert(iov->iov_len >= 9);
+    assert(sent_count < ARRAY_SIZE(sent));
+    sent[sent_count].type = p[3];
+    sent[sent_count].id = GetDWBE(p + 5) & 0x7fffffff;
+    sent_count++;
+
+    vlc_sem_post(&rx);
+    vlc_sem_wait(&gate); /* let the test queue more frames meanwhile */
+    return iov->iov_len;
+}
+
+static const struct vlc_tls_operations record_ops =
+{
+    .get_fd = fd_callback,
+    .writev = record_callback,
+};
+
+static vlc_tls_t record_tls =
+{
+    .ops = &record_ops,
+};
+
+/* Lets the next frame be sent */
+static void step(void)
+{
+    vlc_sem_post(&gate);
+    vlc_sem_wait(&rx);
+}
+
+static void check_sent(const struct sent_frame *expected, unsigned count)
+{
+    assert(sent_count == count);
+    for (unsigned i = 0; i < count; i++)
+        assert(sent[i].type == expected[i].type
+            && sent[i].id == expected[i].id);
+}
+
 static struct vlc_h2_frame *frame(unsigned char c)
 {
     struct vlc_h2_frame *f = vlc_h2_frame_data(1, &c, 1, false);
@@ -122,6 +181,107 @@ static struct vlc_h2_frame *frame_list(struct vlc_h2_frame *first, ...)
     return first;
 }
 
+static struct vlc_h2_frame *stream_data(uint_fast32_t id)
+{
+    struct vlc_h2_frame *f = vlc_h2_frame_data(id, "x", 1, false);
+    assert(f != NULL);
+    return f;
+}
+
+/* Streams take turns, one frame at a time, whatever their queue depth */
+static void test_round_robin(void)
+{
+    vlc_sem_init(&rx, 0);
+    vlc_sem_init(&gate, 0);
+    sent_count = 0;
+
+    struct vlc_h2_output *out = vlc_h2_output_create(&record_tls, false);
+    assert(out != NULL);
+
+    /* Hold the sender while the streams queue their frames */
+    assert(vlc_h2_output_send_prio(out, vlc_h2_frame_ping(0)) == 0);
+    vlc_sem_wait(&rx);
+
+    assert(vlc_h2_output_send(out, frame_list(stream_data(1), stream_data(1),
+                                              stream_data(1), NULL)) == 0);
+    assert(vlc_h2_output_send(out, frame_list(stream_data(3), stream_data(3),
+                                              NULL)) == 0);
+    assert(vlc_h2_output_send(out, stream_data(5)) == 0);
+
+    for (unsigned i = 0; i < 6; i++)
+        step();
+
+    static const struct sent_frame expected[] = {
+        { PING, 0 },
+        { DATA, 1 }, { DATA, 3 }, { DATA, 5 },
+        { DATA, 1 }, { DATA, 3 },
+        { DATA, 1 },
+    };
+    check_sent(expected, ARRAY_SIZE(expected));
+
+    vlc_sem_post(&gate);
+    vlc_h2_output_destroy(out);
+}
+
+/* Nothing, not even a priority frame, is sent within a header block */
+static void test_continuation(void)
+{
+    static const char *const headers[][2] = {
+        { ":method", "GET" },
+        { ":scheme", "https" },
+        { ":authority", "www.example.com" },
+        { ":path", "/some/rather/long/path/to/split/the/header/block" },
+    };
+
+    vlc_sem_init(&rx, 0);
+    vlc_sem_init(&gate, 0);
+    sent_count = 0;
+
+    struct vlc_h2_output *out = vlc_h2_output_create(&record_tls, false);
+    assert(out != NULL);
+
+    assert(vlc_h2_output_send_prio(out, vlc_h2_frame_ping(0)) == 0);
+    vlc_sem_wait(&rx);
+
+    struct vlc_h2_frame *block = vlc_h2_frame_headers(7, 32, false,
+                                                      ARRAY_SIZE(headers),
+                                                      headers);
+    assert(block != NULL);
+    assert(vlc_h2_output_send(out, block) == 0);
+    assert(vlc_h2_output_send(out, stream_data(9)) == 0);
+
+    step(); /* HEADERS */
+    assert(vlc_h2_output_send_prio(out, vlc_h2_frame_ping(1)) == 0);
+    assert(vlc_h2_output_send(out, stream_data(11)) == 0);
+
+    /* The rest of the header block comes first */
+    while (sent[sent_count - 1].type == HEADERS
+        || sent[sent_count - 1].type == CONTINUATION)
+        step();
+
+    const unsigned frames = sent_count - 1;
+    assert(frames >= 3);
+    assert(sent[1].type == HEADERS && sent[1].id == 7);
+    for (unsigned i = 2; i < frames; i++)
+        assert(sent[i].type == CONTINUATION && sent[i].id == 7);
+    assert(sent[frames].type == PING);
+
+    step();
+    step();
+
+    const struct sent_frame expected[] = {
+        { PING, 0 }, { DATA, 9 }, { DATA, 11 },
+    };
+    assert(sent_count == frames + 3);
+    assert(sent[0].type == expected[0].type && sent[0].id == expected[0].id);
+    for (unsigned i = 1; i < ARRAY_SIZE(expected); i++)
+        assert(sent[frames + i].type == expected[i].type
+            && sent[frames + i].id == expected[i].id);
+
+    vlc_sem_post(&gate);
+    vlc_h2_output_destroy(out);
+}
+
 int main(void)
 {
     struct vlc_h2_output *out;
@@ -185,5 +345,7 @@ int main(void)
     assert(vlc_h2_output_send_prio(out, frame(0)) == -1);
     vlc_h2_output_destroy(out);
 
+    test_round_robin();
+    test_continuation();
     return 0;
 }
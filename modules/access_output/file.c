@@ -193,6 +193,137 @@ static int Seek( sout_access_out_t *p_access, uint64_t i_pos )
     return lseek(fd, i_pos, SEEK_SET);
 }
 
+#define MOVE_BUFFER_SIZE (UINT64_C(4) << 20)
+#define MOVE_MAX_COPY_SIZE (UINT64_C(64) << 20)
+
+static int ReadAt( int fd, uint64_t i_pos, uint8_t *p_buf, size_t i_size )
+{
+    if( lseek( fd, i_pos, SEEK_SET ) == -1 )
+        return -errno;
+
+    while( i_size > 0 )
+    {
+        ssize_t val = read( fd, p_buf, i_size );
+        if( val <= 0 )
+        {
+            if( val < 0 && errno == EINTR )
+                continue;
+            return val < 0 ? -errno : -EIO;
+        }
+        p_buf += val;
+        i_size -= val;
+    }
+    return VLC_SUCCESS;
+}
+
+static int WriteAt( int fd, uint64_t i_pos, const uint8_t *p_buf, size_t i_size )
+{
+    if( lseek( fd, i_pos, SEEK_SET ) == -1 )
+        return -errno;
+
+    while( i_size > 0 )
+    {
+        ssize_t val = write( fd, p_buf, i_size );
+        if( val <= 0 )
+        {
+            if( val < 0 && errno == EINTR )
+                continue;
+            return val < 0 ? -errno : -EIO;
+        }
+        p_buf += val;
+        i_size -= val;
+    }
+    return VLC_SUCCESS;
+}
+
+/* Copies a chunk. If the chunk overlaps with its destination, it must not be
+ * larger than MOVE_BUFFER_SIZE. */
+static int MoveChunk( int fd, uint64_t i_src, uint64_t i_dst, uint64_t i_length,
+                      bool b_overlap, uint8_t **pp_buf )
+{
+#ifdef HAVE_COPY_FILE_RANGE
+    /* Let the kernel (or the file system) copy the data, without going through
+     * user space. */
+    while( !b_overlap && i_length > 0 )
+    {
+        off_t in = i_src, out = i_dst;
+        ssize_t val = copy_file_range( fd, &in, fd, &out, i_length, 0 );
+        if( val <= 0 )
+        {
+            if( val < 0 && errno == EINTR )
+                continue;
+            break; /* not supported here, or error: try the slow path */
+        }
+        i_src += val;
+        i_dst += val;
+        i_length -= val;
+    }
+#endif
+    assert( !b_overlap || i_length <= MOVE_BUFFER_SIZE );
+
+    if( i_length > 0 && *pp_buf == NULL )
+    {
+        *pp_buf = malloc( MOVE_BUFFER_SIZE );
+        if( *pp_buf == NULL )
+            return VLC_ENOMEM;
+    }
+
+    while( i_length > 0 )
+    {
+        size_t i_chunk = __MIN( i_length, MOVE_BUFFER_SIZE );
+
+        int ret = ReadAt( fd, i_src, *pp_buf, i_chunk );
+        if( ret == VLC_SUCCESS )
+            ret = WriteAt( fd, i_dst, *pp_buf, i_chunk );
+        if( ret != VLC_SUCCESS )
+            return ret;
+
+        i_src += i_chunk;
+        i_dst += i_chunk;
+        i_length -= i_chunk;
+    }
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * MoveRange: move data within the file, as memmove() would
+ *****************************************************************************/
+static int MoveRange( sout_access_out_t *p_access, uint64_t i_src,
+                      uint64_t i_dst, uint64_t i_length )
+{
+    int *fdp = p_access->p_sys, fd = *fdp;
+    uint8_t *p_buf = NULL;
+    int ret = VLC_SUCCESS;
+
+    if( i_src == i_dst || i_length == 0 )
+        return VLC_SUCCESS;
+
+    /* Chunks no larger than the distance do not overlap with their
+     * destination, and can be copied by the kernel. Closer ranges are moved
+     * through a buffer. Either way, start from the end when moving forward,
+     * so that no data is overwritten before it is read. */
+    const uint64_t i_distance = i_src < i_dst ? i_dst - i_src : i_src - i_dst;
+    const bool b_overlap = i_distance < MOVE_BUFFER_SIZE;
+    const uint64_t i_max = b_overlap ? MOVE_BUFFER_SIZE
+                                     : __MIN( i_distance, MOVE_MAX_COPY_SIZE );
+
+    for( uint64_t i_done = 0; i_done < i_length && ret == VLC_SUCCESS; )
+    {
+        uint64_t i_chunk = __MIN( i_length - i_done, i_max );
+        uint64_t i_offset = i_src < i_dst ? i_length - i_done - i_chunk
+                                          : i_done;
+
+        ret = MoveChunk( fd, i_src + i_offset, i_dst + i_offset, i_chunk,
+                         b_overlap && i_chunk > i_distance, &p_buf );
+        i_done += i_chunk;
+    }
+
+    free( p_buf );
+    if( ret != VLC_SUCCESS )
+        msg_Err( p_access, "cannot move data: %s", vlc_strerror_c(-ret) );
+    return ret;
+}
+
 static int Control( sout_access_out_t *p_access, int i_query, va_list args )
 {
     switch( i_query )
@@ -211,6 +342,17 @@ static int Control( sout_access_out_t *p_access, int i_query, va_list args )
             break;
         }
 
+        case ACCESS_OUT_MOVE_RANGE:
+        {
+            uint64_t i_src = va_arg( args, uint64_t );
+            uint64_t i_dst = va_arg( args, uint64_t );
+            uint64_t i_length = va_arg( args, uint64_t );
+
+            if( p_access->pf_seek == NULL )
+                return VLC_EGENERIC;
+            return MoveRange( p_access, i_src, i_dst, i_length );
+        }
+
         default:
             return VLC_EGENERIC;
     }
@@ -140,6 +140,7 @@ static int Open( vlc_object_t *p_this )
         .filter_audio = DoWork, .close = Close,
     };
     p_filter->ops = &filter_ops;
+    p_filter->b_inplace = true;
 
     vlc_object_t *vlc = VLC_OBJECT(vlc_object_instance(p_filter));
 
@@ -261,6 +261,7 @@ static int Open( vlc_object_t *p_this )
         .filter_audio = DoWork, .close = Close,
     };
     p_filter->ops = &filter_ops;
+    p_filter->b_inplace = true;
 
     /* At this stage, we are ready! */
     msg_Dbg( p_filter, "compressor successfully initialized" );
@@ -0,0 +1,225 @@
+/*****************************************************************************
+ * eq_iir.h: IIR filters of the equalizers
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_EQ_IIR_H
+#define VLC_EQ_IIR_H
+
+#include <assert.h>
+#include <string.h>
+
+#include "vec4.h"
+
+/* Bands of a bank, rounded up to a multiple of the vector width */
+#define EQ_IIR_BANDS_MAX   12
+/* Biquads of a cascade kept in registers, longer ones use the scalar code */
+#define EQ_IIR_CASCADE_MAX 8
+
+/**
+ * Bank of band-pass filters fed with the same input, whose outputs are
+ * mixed. Unused bands have null coefficients and amplitude.
+ */
+typedef struct
+{
+    float alpha[EQ_IIR_BANDS_MAX];
+    float beta[EQ_IIR_BANDS_MAX];
+    float gamma[EQ_IIR_BANDS_MAX];
+    float amp[EQ_IIR_BANDS_MAX];
+} eq_iir_bank_t;
+
+/* State of a bank for one channel, [0] being the last sample */
+typedef struct
+{
+    float x[2];
+    float y[2][EQ_IIR_BANDS_MAX];
+} eq_iir_bank_state_t;
+
+/**
+ * Filters one channel of interleaved samples with a bank.
+ *
+ * The bands are independent, so they are computed side by side in the
+ * vector lanes, and the state stays in registers over the whole buffer.
+ *
+ * out = gain * (in_factor * in + sum of the bands weighted by amp)
+ *
+ * \param stride samples per frame
+ */
+static inline void eq_iir_bank_filter( const eq_iir_bank_t *restrict bank,
+                                       eq_iir_bank_state_t *restrict state,
+                                       float *out, const float *in,
+                                       unsigned stride, unsigned samples,
+                                       float in_factor, float gain )
+{
+    float x1 = state->x[0], x2 = state->x[1];
+
+#ifdef HAS_ATTRIBUTE_VECTORSIZE
+    enum { N = EQ_IIR_BANDS_MAX / 4 };
+    v4sf alpha[N], beta[N], gamma[N], amp[N], y1[N], y2[N];
+
+    memcpy( alpha, bank->alpha, sizeof (alpha) );
+    memcpy( beta, bank->beta, sizeof (beta) );
+    memcpy( gamma, bank->gamma, sizeof (gamma) );
+    memcpy( amp, bank->amp, sizeof (amp) );
+    memcpy( y1, state->y[0], sizeof (y1) );
+    memcpy( y2, state->y[1], sizeof (y2) );
+
+    for( unsigned i = 0; i < samples; i++ )
+    {
+        const float x = in[i * stride];
+        v4sf o = { 0 };
+
+        for( unsigned j = 0; j < N; j++ )
+        {
+            v4sf y = alpha[j] * ( x - x2 ) + gamma[j] * y1[j] - beta[j] * y2[j];
+
+            y2[j] = y1[j];
+            y1[j] = y;
+            o += y * amp[j];
+        }
+        x2 = x1;
+        x1 = x;
+
+        out[i * stride] = gain * ( in_factor * x + vec4_hsum( o ) );
+    }
+
+    memcpy( state->y[0], y1, sizeof (y1) );
+    memcpy( state->y[1], y2, sizeof (y2) );
+#else
+    for( unsigned i = 0; i < samples; i++ )
+    {
+        const float x = in[i * stride];
+        float o = 0.f;
+
+        for( unsigned j = 0; j < EQ_IIR_BANDS_MAX; j++ )
+        {
+            float y = bank->alpha[j] * ( x - x2 ) +
+                      bank->gamma[j] * state->y[0][j] -
+                      bank->beta[j]  * state->y[1][j];
+
+            state->y[1][j] = state->y[0][j];
+            state->y[0][j] = y;
+            o += y * bank->amp[j];
+        }
+        x2 = x1;
+        x1 = x;
+
+        out[i * stride] = gain * ( in_factor * x + o );
+    }
+#endif
+
+    state->x[0] = x1;
+    state->x[1] = x2;
+}
+
+/* Direct form 1 biquads in series, on one channel */
+static inline void eq_iir_cascade1( const float *src, float *dest,
+                                    float *restrict state, unsigned stride,
+                                    unsigned samples,
+                                    const float *restrict coeffs,
+                                    unsigned count )
+{
+    for( unsigned i = 0; i < samples; i++ )
+    {
+        float x = src[i * stride];
+
+        for( unsigned eq = 0; eq < count; eq++ )
+        {
+            const float *c = &coeffs[5 * eq];
+            float *s = &state[4 * eq];
+            float y = x*c[0] + s[0]*c[1] + s[1]*c[2] - s[2]*c[3] - s[3]*c[4];
+
+            s[1] = s[0];
+            s[0] = x;
+            s[3] = s[2];
+            s[2] = y;
+            x = y;
+        }
+        dest[i * stride] = x;
+    }
+}
+
+#ifdef HAS_ATTRIBUTE_VECTORSIZE
+/* Same on 4 adjacent channels, one per vector lane */
+static inline void eq_iir_cascade4( const float *src, float *dest,
+                                    float *restrict state, unsigned stride,
+                                    unsigned samples,
+                                    const float *restrict coeffs,
+                                    unsigned count )
+{
+    v4sf s[EQ_IIR_CASCADE_MAX][4];
+
+    assert( count <= EQ_IIR_CASCADE_MAX );
+    for( unsigned eq = 0; eq < count; eq++ )
+        for( unsigned k = 0; k < 4; k++ )
+            for( unsigned lane = 0; lane < 4; lane++ )
+                s[eq][k][lane] = state[(lane * count + eq) * 4 + k];
+
+    for( unsigned i = 0; i < samples; i++ )
+    {
+        v4sf x = vec4_load( &src[i * stride] );
+
+        for( unsigned eq = 0; eq < count; eq++ )
+        {
+            const float *c = &coeffs[5 * eq];
+            v4sf y = x*c[0] + s[eq][0]*c[1] + s[eq][1]*c[2]
+                   - s[eq][2]*c[3] - s[eq][3]*c[4];
+
+            s[eq][1] = s[eq][0];
+            s[eq][0] = x;
+            s[eq][3] = s[eq][2];
+            s[eq][2] = y;
+            x = y;
+        }
+        vec4_store( &dest[i * stride], x );
+    }
+
+    for( unsigned eq = 0; eq < count; eq++ )
+        for( unsigned k = 0; k < 4; k++ )
+            for( unsigned lane = 0; lane < 4; lane++ )
+                state[(lane * count + eq) * 4 + k] = s[eq][k][lane];
+}
+#endif
+
+/**
+ * Filters interleaved samples with biquads in series.
+ *
+ * The biquads depend on each other, so the vector lanes process adjacent
+ * channels instead.
+ *
+ * \param state 4 values per channel and biquad
+ * \param coeffs b0 b1 b2 a1 a2, normalized by a0, per biquad
+ */
+static inline void eq_iir_cascade( const float *src, float *dest, float *state,
+                                   unsigned channels, unsigned samples,
+                                   const float *coeffs, unsigned count )
+{
+    unsigned chn = 0;
+
+#ifdef HAS_ATTRIBUTE_VECTORSIZE
+    if( count <= EQ_IIR_CASCADE_MAX )
+        for( ; chn + 4 <= channels; chn += 4 )
+            eq_iir_cascade4( src + chn, dest + chn, state + chn * count * 4,
+                             channels, samples, coeffs, count );
+#endif
+    for( ; chn < channels; chn++ )
+        eq_iir_cascade1( src + chn, dest + chn, state + chn * count * 4,
+                         channels, samples, coeffs, count );
+}
+
+#endif
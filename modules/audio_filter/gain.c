@@ -101,6 +101,7 @@ static int Open( vlc_object_t *p_this )
     static const struct vlc_filter_operations filter_ops =
         { .filter_audio = Process, .close = Close };
     p_filter->ops = &filter_ops;
+    p_filter->b_inplace = true;
 
     return VLC_SUCCESS;
 }
@@ -59,6 +59,7 @@ static int Open (vlc_object_t *obj)
         .filter_audio = Process,
     };
     filter->ops = &filter_ops;
+    filter->b_inplace = true;
     return VLC_SUCCESS;
 }
 
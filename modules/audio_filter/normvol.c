@@ -122,6 +122,7 @@ static int Open( vlc_object_t *p_this )
         .filter_audio = DoWork, .close = Close,
     };
     p_filter->ops = &filter_ops;
+    p_filter->b_inplace = true;
 
     return VLC_SUCCESS;
 }
@@ -36,6 +36,8 @@
 #include <vlc_aout.h>
 #include <vlc_filter.h>
 
+#include "eq_iir.h"
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -81,6 +83,11 @@ vlc_module_end ()
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
+/* Peak filters, and the low and high shelves */
+#define EQ_COUNT 5
+static_assert( EQ_COUNT <= EQ_IIR_CASCADE_MAX,
+               "the biquads would not fit in the vectorized cascade" );
+
 typedef struct
 {
     /* Filter static config */
@@ -90,7 +97,7 @@ typedef struct
     float   f_f3, f_Q3, f_gain3;
     float   f_highf, f_highgain;
     /* Filter computed coeffs */
-    float   coeffs[5*5];
+    float   coeffs[5*EQ_COUNT];
     /* State */
     float  *p_state;
 } filter_sys_t;
@@ -119,6 +126,7 @@ static int Open( vlc_object_t *p_this )
         .filter_audio = DoWork, .close = Close,
     };
     p_filter->ops = &filter_ops;
+    p_filter->b_inplace = true;
 
     p_sys->f_lowf = var_InheritFloat( p_this, "param-eq-lowf");
     p_sys->f_lowgain = var_InheritFloat( p_this, "param-eq-lowgain");
@@ -149,7 +157,7 @@ static int Open( vlc_object_t *p_this )
                       i_samplerate, p_sys->coeffs+3*5);
     CalcShelfEQCoeffs(p_sys->f_highf, 1, p_sys->f_highgain, 0,
                       i_samplerate, p_sys->coeffs+4*5);
-    p_sys->p_state = (float*)calloc( p_filter->fmt_in.audio.i_channels*5*4,
+    p_sys->p_state = (float*)calloc( p_filter->fmt_in.audio.i_channels*EQ_COUNT*4,
                                      sizeof(float) );
 
     return VLC_SUCCESS;
@@ -173,7 +181,7 @@ static block_t *DoWork( filter_t * p_filter, block_t * p_in_buf )
     ProcessEQ( (float*)p_in_buf->p_buffer, (float*)p_in_buf->p_buffer,
                p_sys->p_state,
                p_filter->fmt_in.audio.i_channels, p_in_buf->i_nb_samples,
-               p_sys->coeffs, 5 );
+               p_sys->coeffs, EQ_COUNT );
     return p_in_buf;
 }
 
@@ -289,37 +297,5 @@ void ProcessEQ( const float *src, float *dest, float *state,
                 unsigned channels, unsigned samples, const float *coeffs,
                 unsigned eqCount )
 {
-    unsigned i, chn, eq;
-    float   b0, b1, b2, a1, a2;
-    float   x, y = 0;
-    const float *src1 = src;
-    float *dest1 = dest;
-
-    for (i = 0; i < samples; i++)
-    {
-        float *state1 = state;
-        for (chn = 0; chn < channels; chn++)
-        {
-            const float *coeffs1 = coeffs;
-            x = *src1++;
-            /* Direct form 1 IIRs */
-            for (eq = 0; eq < eqCount; eq++)
-            {
-                b0 = coeffs1[0];
-                b1 = coeffs1[1];
-                b2 = coeffs1[2];
-                a1 = coeffs1[3];
-                a2 = coeffs1[4];
-                coeffs1 += 5;
-                y = x*b0 + state1[0]*b1 + state1[1]*b2 - state1[2]*a1 - state1[3]*a2;
-                state1[1] = state1[0];
-                state1[0] = x;
-                state1[3] = state1[2];
-                state1[2] = y;
-                x = y;
-                state1 += 4;
-            }
-            *dest1++ = y;
-        }
-    }
+    eq_iir_cascade( src, dest, state, channels, samples, coeffs, eqCount );
 }
@@ -168,6 +168,7 @@ static int Open (vlc_object_t *obj)
         .filter_audio = Process, .flush = Flush, .close = Close,
     };
     p_filter->ops = &filter_ops;
+    p_filter->b_inplace = true;
 
     return VLC_SUCCESS;
 }
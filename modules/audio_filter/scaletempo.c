@@ -35,7 +35,8 @@
 
 #include <stdatomic.h>
 #include <string.h> /* for memset */
-#include <limits.h> /* form INT_MIN */
+
+#include "scaletempo_corr.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -141,10 +142,8 @@ typedef struct
 static unsigned best_overlap_offset_float( filter_t *p_filter )
 {
     filter_sys_t *p = p_filter->p_sys;
-    float *pw, *po, *ppc, *search_start;
-    float best_corr = INT_MIN;
-    unsigned best_off = 0;
-    unsigned i, off;
+    float *pw, *po, *ppc;
+    unsigned i;
 
     pw  = p->table_window;
     po  = p->buf_overlap;
@@ -154,20 +153,11 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
       *ppc++ = *pw++ * *po++;
     }
 
-    search_start = (float *)p->buf_queue + p->samples_per_frame;
-    for( off = 0; off < p->frames_search; off++ ) {
-      float corr = 0;
-      float *ps = search_start;
-      ppc = p->buf_pre_corr;
-      for( i = p->samples_per_frame; i < p->samples_overlap; i++ ) {
-        corr += *ppc++ * *ps++;
-      }
-      if( corr > best_corr ) {
-        best_corr = corr;
-        best_off  = off;
-      }
-      search_start += p->samples_per_frame;
-    }
+    unsigned best_off = scaletempo_best_offset( p->buf_pre_corr,
+                            (float *)p->buf_queue + p->samples_per_frame,
+                            p->samples_per_frame,
+                            p->samples_overlap - p->samples_per_frame,
+                            p->frames_search );
 
     return best_off * p->bytes_per_frame;
 }
@@ -574,7 +564,7 @@ static block_t *DoWork( filter_t * p_filter, block_t * p_in_buf )
                                    p_in_buf->i_buffer, 0 );
     if( i_outsize > 0 )
     {
-        p_out_buf = block_Alloc( i_outsize );
+        p_out_buf = filter_NewAudioBuffer( p_filter, i_outsize );
         if( p_out_buf == NULL )
         {
             block_Release( p_in_buf );
@@ -0,0 +1,129 @@
+/*****************************************************************************
+ * scaletempo_corr.h: overlap search of the scaletempo filter
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_SCALETEMPO_CORR_H
+#define VLC_SCALETEMPO_CORR_H
+
+#include <math.h>
+
+#include "vec4.h"
+
+/**
+ * Correlates the windowed overlap with 4 successive candidate positions.
+ *
+ * The 4 sums share the loads of the overlap, and are independent from each
+ * other, which keeps the SIMD units busy.
+ */
+static inline void scaletempo_corr4( const float *restrict pre_corr,
+                                     const float *restrict search,
+                                     unsigned step, unsigned n,
+                                     float corr[4] )
+{
+    unsigned i = 0;
+    corr[0] = corr[1] = corr[2] = corr[3] = 0.f;
+
+#ifdef HAS_ATTRIBUTE_VECTORSIZE
+    v4sf acc0 = { 0 }, acc1 = { 0 }, acc2 = { 0 }, acc3 = { 0 };
+    const float *s0 = search, *s1 = s0 + step, *s2 = s1 + step, *s3 = s2 + step;
+
+    for( ; i + 4 <= n; i += 4 )
+    {
+        v4sf pc = vec4_load( pre_corr + i );
+        acc0 += pc * vec4_load( s0 + i );
+        acc1 += pc * vec4_load( s1 + i );
+        acc2 += pc * vec4_load( s2 + i );
+        acc3 += pc * vec4_load( s3 + i );
+    }
+    corr[0] = vec4_hsum( acc0 );
+    corr[1] = vec4_hsum( acc1 );
+    corr[2] = vec4_hsum( acc2 );
+    corr[3] = vec4_hsum( acc3 );
+#endif
+
+    for( ; i < n; i++ )
+        for( unsigned k = 0; k < 4; k++ )
+            corr[k] += pre_corr[i] * search[k * step + i];
+}
+
+static inline float scaletempo_corr1( const float *restrict pre_corr,
+                                      const float *restrict search,
+                                      unsigned n )
+{
+    unsigned i = 0;
+    float corr = 0.f;
+
+#ifdef HAS_ATTRIBUTE_VECTORSIZE
+    v4sf acc = { 0 };
+    for( ; i + 4 <= n; i += 4 )
+        acc += vec4_load( pre_corr + i ) * vec4_load( search + i );
+    corr = vec4_hsum( acc );
+#endif
+
+    for( ; i < n; i++ )
+        corr += pre_corr[i] * search[i];
+    return corr;
+}
+
+/**
+ * Finds the position of the search window that best matches the overlap.
+ *
+ * \param pre_corr windowed overlap, n samples
+ * \param search first candidate position
+ * \param channels samples per frame, i.e. distance between candidates
+ * \param n number of samples to correlate
+ * \param frames_search number of candidate positions
+ * \return the offset of the best candidate, in frames
+ */
+static inline unsigned scaletempo_best_offset( const float *pre_corr,
+                                               const float *search,
+                                               unsigned channels, unsigned n,
+                                               unsigned frames_search )
+{
+    float best_corr = -HUGE_VALF;
+    unsigned best_off = 0;
+    unsigned off = 0;
+
+    for( ; off + 4 <= frames_search; off += 4 )
+    {
+        float corr[4];
+
+        scaletempo_corr4( pre_corr, search + off * channels, channels, n, corr );
+        for( unsigned k = 0; k < 4; k++ )
+            if( corr[k] > best_corr )
+            {
+                best_corr = corr[k];
+                best_off  = off + k;
+            }
+    }
+
+    for( ; off < frames_search; off++ )
+    {
+        float corr = scaletempo_corr1( pre_corr, search + off * channels, n );
+        if( corr > best_corr )
+        {
+            best_corr = corr;
+            best_off  = off;
+        }
+    }
+
+    return best_off;
+}
+
+#endif
@@ -200,6 +200,7 @@ static int Open( vlc_object_t *p_this )
     } filter_ops;
 
     p_filter->ops = &filter_ops.ops;
+    p_filter->b_inplace = true;
     return VLC_SUCCESS;
 }
 
@@ -106,6 +106,7 @@ static int Open (filter_t *p_filter)
         .filter_audio = Process,
     };
     p_filter->ops = &filter_ops;
+    p_filter->b_inplace = true;
     return VLC_SUCCESS;
 }
 
@@ -0,0 +1,54 @@
+/*****************************************************************************
+ * vec4.h: 4-wide float vectors of the audio filters
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_AUDIO_FILTER_VEC4_H
+#define VLC_AUDIO_FILTER_VEC4_H
+
+#include <string.h>
+
+/* Generic vectors, which the compiler maps to the SIMD units of the target.
+ * Without them, the filters fall back to their scalar code. */
+#if defined __has_attribute
+# if __has_attribute(__vector_size__)
+#  define HAS_ATTRIBUTE_VECTORSIZE
+typedef float v4sf __attribute__((__vector_size__(16)));
+# endif
+#endif
+
+#ifdef HAS_ATTRIBUTE_VECTORSIZE
+static inline v4sf vec4_load( const float *p )
+{
+    v4sf v;
+    memcpy( &v, p, sizeof (v) ); /* unaligned */
+    return v;
+}
+
+static inline void vec4_store( float *p, v4sf v )
+{
+    memcpy( p, &v, sizeof (v) ); /* unaligned */
+}
+
+static inline float vec4_hsum( v4sf v )
+{
+    return ( v[0] + v[1] ) + ( v[2] + v[3] );
+}
+#endif
+
+#endif
@@ -934,6 +934,16 @@ static int Statistics(struct cli_client *cl, const char *const *args,
                    item->p_stats->i_lost_abuffers);
         cli_printf(cl, "|");
 
+        /* Buffering */
+        cli_printf(cl, "%s", _("+-[Buffered data]"));
+        cli_printf(cl, _("| stream caches    : %8.0f KiB"),
+                   (float)(item->p_stats->i_buffered_demux) / 1024.f);
+        cli_printf(cl, _("| decoder queues   : %8.0f KiB"),
+                   (float)(item->p_stats->i_buffered_decoder) / 1024.f);
+        cli_printf(cl, _("| output queues    : %8.0f KiB"),
+                   (float)(item->p_stats->i_buffered_sout) / 1024.f);
+        cli_printf(cl, "|");
+
         vlc_mutex_unlock(&item->lock);
         cli_printf(cl,  "+----[ end of statistical info ]" );
     }
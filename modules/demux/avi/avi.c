@@ -37,6 +37,8 @@
 #include <vlc_demux.h>
 #include <vlc_input.h>
 #include <vlc_aout.h>
+#include <vlc_threads.h>
+#include <vlc_interrupt.h>
 
 #include <vlc_dialog.h>
 
@@ -186,6 +188,24 @@ typedef struct
 
 } avi_track_t;
 
+/* Index reconstruction running in the background, on its own stream */
+typedef struct
+{
+    vlc_thread_t     thread;
+    vlc_interrupt_t *p_interrupt;
+    char            *psz_url;
+    uint64_t         i_movi_begin;
+    uint64_t         i_movi_end;
+    uint64_t         i_riff1_pos;   /* first AVIX list, 0 if none */
+
+    vlc_mutex_t      lock;
+    vlc_cond_t       wait;
+    /* protected by lock */
+    avi_index_t     *p_pending;     /* per track, not merged yet */
+    bool             b_waiting;     /* a seek waits for new entries */
+    bool             b_done;
+} avi_index_builder_t;
+
 typedef struct
 {
     vlc_tick_t i_time;
@@ -203,6 +223,7 @@ typedef struct
 
     uint64_t i_movi_begin;
     uint64_t i_movi_lastchunk_pos;   /* XXX position of last valid chunk */
+    avi_index_builder_t *p_builder;
 
     /* number of streams and information */
     unsigned int i_track;
@@ -231,12 +252,16 @@ static int AVI_StreamBytesSet ( demux_t *, avi_track_t *, uint64_t i_byte );
 vlc_fourcc_t AVI_FourccGetCodec( unsigned int i_cat, vlc_fourcc_t );
 static int   AVI_GetKeyFlag    ( const avi_track_t *, const uint8_t * );
 
-static int AVI_PacketGetHeader( demux_t *, avi_packet_t *p_pk );
-static int AVI_PacketNext     ( demux_t * );
-static int AVI_PacketSearch   ( demux_t * );
+static int AVI_PacketGetHeader( stream_t *, avi_packet_t *p_pk );
+static int AVI_PacketNext     ( stream_t * );
+static int AVI_PacketSearch   ( demux_t *, stream_t * );
 
 static void AVI_IndexLoad    ( demux_t * );
 static void AVI_IndexCreate  ( demux_t * );
+static int  AVI_IndexStart   ( demux_t * );
+static void AVI_IndexStop    ( demux_t * );
+static void AVI_IndexMerge   ( demux_t * );
+static void AVI_IndexWait    ( demux_t *, vlc_tick_t );
 
 static void AVI_ExtractSubtitle( demux_t *, unsigned int i_stream, avi_chunk_list_t *, avi_chunk_STRING_t * );
 static avi_track_t * AVI_GetVideoTrackForXsub( demux_sys_t * );
@@ -245,6 +270,8 @@ static int AVI_SeekSubtitleTrack( demux_sys_t *, avi_track_t * );
 static void AVI_DvHandleAudio( demux_t *, avi_track_t *, block_t * );
 
 static vlc_tick_t  AVI_MovieGetLength( demux_t * );
+static vlc_tick_t  AVI_HeaderGetLength( const avi_chunk_avih_t * );
+static vlc_tick_t  AVI_TrackGetIndexLength( avi_track_t * );
 
 static void AVI_MetaLoad( demux_t *, avi_chunk_list_t *p_riff, avi_chunk_avih_t *p_avih );
 
@@ -331,6 +358,9 @@ static void Close ( vlc_object_t * p_this )
     demux_t *    p_demux = (demux_t *)p_this;
     demux_sys_t *p_sys = p_demux->p_sys  ;
 
+    if( p_sys->p_builder )
+        AVI_IndexStop( p_demux );
+
     for( unsigned int i = 0; i < p_sys->i_track; i++ )
     {
         if( p_sys->track[i] )
@@ -776,7 +806,8 @@ static int Open( vlc_object_t * p_this )
 aviindex:
         if( p_sys->b_fastseekable )
         {
-            AVI_IndexCreate( p_demux );
+            if( AVI_IndexStart( p_demux ) != VLC_SUCCESS )
+                AVI_IndexCreate( p_demux );
         }
         else if( p_sys->b_seekable )
         {
@@ -804,14 +835,14 @@ aviindex:
             i_idx_totalframes = __MAX(i_idx_totalframes, tk->idx.i_size);
     }
     if( i_idx_totalframes != p_avih->i_totalframes &&
-        p_sys->i_length < VLC_TICK_FROM_US( p_avih->i_totalframes *
-                                            p_avih->i_microsecperframe ) )
+        p_sys->i_length < AVI_HeaderGetLength( p_avih ) )
     {
         msg_Warn( p_demux, "broken or missing index, 'seek' will be "
                            "approximative or will exhibit strange behavior" );
         if( (i_do_index == 0 || i_do_index == 3) && !b_index )
         {
-            if( !p_sys->b_fastseekable ) {
+            /* The index is rebuilt while playing, no need to ask */
+            if( !p_sys->b_fastseekable || p_demux->psz_url != NULL ) {
                 b_index = true;
                 goto aviindex;
             }
@@ -850,6 +881,11 @@ aviindex:
         }
     }
 
+    /* Until the index is complete, trust the header for the length */
+    if( p_sys->p_builder )
+        p_sys->i_length = __MAX( p_sys->i_length,
+                                 AVI_HeaderGetLength( p_avih ) );
+
     /* fix some BeOS MediaKit generated file */
     for( unsigned i = 0 ; i < p_sys->i_track; i++ )
     {
@@ -861,8 +897,7 @@ aviindex:
         {
             continue;
         }
-        if( tk->idx.i_size < 1 ||
-            tk->i_scale != 1 ||
+        if( tk->i_scale != 1 ||
             tk->i_samplesize != 0 )
         {
             continue;
@@ -874,11 +909,16 @@ aviindex:
             p_auds->p_wf->wFormatTag != WAVE_FORMAT_PCM &&
             tk->i_rate == p_auds->p_wf->nSamplesPerSec )
         {
+            /* The new rate comes from the size of the whole track */
+            if( p_sys->p_builder )
+                AVI_IndexWait( p_demux, VLC_TICK_MAX );
+            if( tk->idx.i_size < 1 )
+                continue;
+
             int64_t i_track_length =
                 tk->idx.p_entry[tk->idx.i_size-1].i_length +
                 tk->idx.p_entry[tk->idx.i_size-1].i_lengthtotal;
-            vlc_tick_t i_length = VLC_TICK_FROM_US( p_avih->i_totalframes *
-                                                    p_avih->i_microsecperframe );
+            vlc_tick_t i_length = AVI_HeaderGetLength( p_avih );
 
             if( i_length == 0 )
             {
@@ -1083,6 +1123,9 @@ static int Demux_Seekable( demux_t *p_demux )
 
     unsigned int i_track_count = 0;
 
+    if( p_sys->p_builder )
+        AVI_IndexMerge( p_demux );
+
     /* detect new selected/unselected streams */
     for( unsigned int i = 0; i < p_sys->i_track; i++ )
     {
@@ -1244,7 +1287,7 @@ static int Demux_Seekable( demux_t *p_demux )
                 if (vlc_stream_Seek(p_demux->s, p_sys->i_movi_lastchunk_pos))
                     return VLC_DEMUXER_EGENERIC;
 
-                if( AVI_PacketNext( p_demux ) )
+                if( AVI_PacketNext( p_demux->s ) )
                 {
                     return( AVI_TrackStopFinishedStreams( p_demux ) ? 0 : 1 );
                 }
@@ -1259,7 +1302,7 @@ static int Demux_Seekable( demux_t *p_demux )
             {
                 avi_packet_t avi_pk;
 
-                if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+                if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
                 {
                     msg_Warn( p_demux,
                              "cannot get packet header, track disabled" );
@@ -1268,7 +1311,7 @@ static int Demux_Seekable( demux_t *p_demux )
                 if( avi_pk.i_stream >= p_sys->i_track ||
                     ( avi_pk.i_cat != AUDIO_ES && avi_pk.i_cat != VIDEO_ES ) )
                 {
-                    if( AVI_PacketNext( p_demux ) )
+                    if( AVI_PacketNext( p_demux->s ) )
                     {
                         msg_Warn( p_demux,
                                   "cannot skip packet, track disabled" );
@@ -1302,7 +1345,7 @@ static int Demux_Seekable( demux_t *p_demux )
                     }
                     else
                     {
-                        if( AVI_PacketNext( p_demux ) )
+                        if( AVI_PacketNext( p_demux->s ) )
                         {
                             msg_Warn( p_demux,
                                       "cannot skip packet, track disabled" );
@@ -1488,7 +1531,7 @@ static int Demux_UnSeekable( demux_t *p_demux )
     {
         avi_packet_t    avi_pk;
 
-        if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+        if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
         {
             return VLC_DEMUXER_EOF;
         }
@@ -1505,18 +1548,18 @@ static int Demux_UnSeekable( demux_t *p_demux )
                 case AVIFOURCC_JUNK:
                 case AVIFOURCC_LIST:
                 case AVIFOURCC_RIFF:
-                    return( !AVI_PacketNext( p_demux ) ? 1 : 0 );
+                    return( !AVI_PacketNext( p_demux->s ) ? 1 : 0 );
                 case AVIFOURCC_idx1:
                     if( p_sys->b_odml )
                     {
-                        return( !AVI_PacketNext( p_demux ) ? 1 : 0 );
+                        return( !AVI_PacketNext( p_demux->s ) ? 1 : 0 );
                     }
                     return VLC_DEMUXER_EOF;
                 default:
                     msg_Warn( p_demux,
                               "seems to have lost position @%"PRIu64", resync",
                               vlc_stream_Tell(p_demux->s) );
-                    if( AVI_PacketSearch( p_demux ) )
+                    if( AVI_PacketSearch( p_demux, p_demux->s ) )
                     {
                         msg_Err( p_demux, "resync failed" );
                         return VLC_DEMUXER_EGENERIC;
@@ -1547,7 +1590,7 @@ static int Demux_UnSeekable( demux_t *p_demux )
             }
             else
             {
-                if( AVI_PacketNext( p_demux ) )
+                if( AVI_PacketNext( p_demux->s ) )
                 {
                     return VLC_DEMUXER_EOF;
                 }
@@ -1674,6 +1717,9 @@ static int Seek( demux_t *p_demux, vlc_tick_t i_date, double f_ratio, bool b_acc
             msg_Dbg( p_demux, "estimate date %"PRId64, i_date );
         }
 
+        /* Let the background index reach the target first */
+        AVI_IndexWait( p_demux, i_date );
+
         /* */
         vlc_tick_t i_wanted = i_date;
         vlc_tick_t i_start = i_date;
@@ -1960,7 +2006,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, avi_track_t *tk )
     {
         if (vlc_stream_Seek(p_demux->s, p_sys->i_movi_lastchunk_pos))
             return VLC_EGENERIC;
-        if( AVI_PacketNext( p_demux ) )
+        if( AVI_PacketNext( p_demux->s ) )
         {
             return VLC_EGENERIC;
         }
@@ -1973,7 +2019,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, avi_track_t *tk )
 
     for( ;; )
     {
-        if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+        if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
         {
             msg_Warn( p_demux, "cannot get packet header" );
             return VLC_EGENERIC;
@@ -1981,7 +2027,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, avi_track_t *tk )
         if( avi_pk.i_stream >= p_sys->i_track ||
             ( avi_pk.i_cat != AUDIO_ES && avi_pk.i_cat != VIDEO_ES ) )
         {
-            if( AVI_PacketNext( p_demux ) )
+            if( AVI_PacketNext( p_demux->s ) )
             {
                 return VLC_EGENERIC;
             }
@@ -2006,7 +2052,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, avi_track_t *tk )
                 return VLC_SUCCESS;
             }
 
-            if( AVI_PacketNext( p_demux ) )
+            if( AVI_PacketNext( p_demux->s ) )
             {
                 return VLC_EGENERIC;
             }
@@ -2318,17 +2364,17 @@ static void AVI_ParseStreamHeader( vlc_fourcc_t i_id,
 /****************************************************************************
  *
  ****************************************************************************/
-static int AVI_PacketGetHeader( demux_t *p_demux, avi_packet_t *p_pk )
+static int AVI_PacketGetHeader( stream_t *s, avi_packet_t *p_pk )
 {
     const uint8_t *p_peek;
 
-    if( vlc_stream_Peek( p_demux->s, &p_peek, 16 ) < 16 )
+    if( vlc_stream_Peek( s, &p_peek, 16 ) < 16 )
     {
         return VLC_EGENERIC;
     }
     p_pk->i_fourcc  = VLC_FOURCC( p_peek[0], p_peek[1], p_peek[2], p_peek[3] );
     p_pk->i_size    = GetDWLE( p_peek + 4 );
-    p_pk->i_pos     = vlc_stream_Tell( p_demux->s );
+    p_pk->i_pos     = vlc_stream_Tell( s );
     if( p_pk->i_fourcc == AVIFOURCC_LIST || p_pk->i_fourcc == AVIFOURCC_RIFF )
     {
         p_pk->i_type = VLC_FOURCC( p_peek[8],  p_peek[9],
@@ -2345,12 +2391,12 @@ static int AVI_PacketGetHeader( demux_t *p_demux, avi_packet_t *p_pk )
     return VLC_SUCCESS;
 }
 
-static int AVI_PacketNext( demux_t *p_demux )
+static int AVI_PacketNext( stream_t *s )
 {
     avi_packet_t    avi_ck;
     uint32_t        i_skip = 0;
 
-    if( AVI_PacketGetHeader( p_demux, &avi_ck ) )
+    if( AVI_PacketGetHeader( s, &avi_ck ) )
     {
         return VLC_EGENERIC;
     }
@@ -2377,14 +2423,14 @@ static int AVI_PacketNext( demux_t *p_demux )
         return VLC_EGENERIC;
 #endif
 
-    if( vlc_stream_Read( p_demux->s, NULL, i_skip ) != i_skip )
+    if( vlc_stream_Read( s, NULL, i_skip ) != i_skip )
     {
         return VLC_EGENERIC;
     }
     return VLC_SUCCESS;
 }
 
-static int AVI_PacketSearch( demux_t *p_demux )
+static int AVI_PacketSearch( demux_t *p_demux, stream_t *s )
 {
     demux_sys_t     *p_sys = p_demux->p_sys;
     avi_packet_t    avi_pk;
@@ -2392,11 +2438,11 @@ static int AVI_PacketSearch( demux_t *p_demux )
 
     for( ;; )
     {
-        if( vlc_stream_Read( p_demux->s, NULL, 1 ) != 1 )
+        if( vlc_stream_Read( s, NULL, 1 ) != 1 )
         {
             return VLC_EGENERIC;
         }
-        AVI_PacketGetHeader( p_demux, &avi_pk );
+        AVI_PacketGetHeader( s, &avi_pk );
         if( avi_pk.i_stream < p_sys->i_track &&
             ( avi_pk.i_cat == AUDIO_ES || avi_pk.i_cat == VIDEO_ES ) )
         {
@@ -2810,7 +2856,7 @@ static void AVI_IndexCreate( demux_t *p_demux )
             i_dialog_update = vlc_tick_now();
         }
 
-        if( AVI_PacketGetHeader( p_demux, &pk ) )
+        if( AVI_PacketGetHeader( p_demux->s, &pk ) )
             break;
 
         if( pk.i_stream < p_sys->i_track &&
@@ -2854,7 +2900,7 @@ static void AVI_IndexCreate( demux_t *p_demux )
 
             default:
                 msg_Warn( p_demux, "need resync, probably broken avi" );
-                if( AVI_PacketSearch( p_demux ) )
+                if( AVI_PacketSearch( p_demux, p_demux->s ) )
                 {
                     msg_Warn( p_demux, "lost sync, abord index creation" );
                     goto print_stat;
@@ -2863,7 +2909,7 @@ static void AVI_IndexCreate( demux_t *p_demux )
         }
 
         if( ( !p_sys->b_odml && pk.i_pos + pk.i_size >= i_movi_end ) ||
-            AVI_PacketNext( p_demux ) )
+            AVI_PacketNext( p_demux->s ) )
         {
             break;
         }
@@ -2880,6 +2926,280 @@ print_stat:
     }
 }
 
+/*****************************************************************************
+ * Background index reconstruction
+ *****************************************************************************
+ * A thread walks the movi list from its own stream, as AVI_IndexCreate does,
+ * while playback starts from the beginning. The chunks it finds are kept
+ * aside and merged into the track indexes by the demux thread, which may have
+ * indexed some of them itself meanwhile. A seek past the indexed part waits
+ * for the scan to reach its target only, not for the whole file.
+ *****************************************************************************/
+#define AVI_INDEX_SIGNAL_CHUNKS 64
+
+static void AVI_IndexBuilderDelete( avi_index_builder_t *p_builder,
+                                    unsigned int i_track )
+{
+    if( p_builder->p_pending )
+    {
+        for( unsigned i = 0; i < i_track; i++ )
+            avi_index_Clean( &p_builder->p_pending[i] );
+        free( p_builder->p_pending );
+    }
+    if( p_builder->p_interrupt )
+        vlc_interrupt_destroy( p_builder->p_interrupt );
+    free( p_builder->psz_url );
+    free( p_builder );
+}
+
+static void AVI_IndexScan( demux_t *p_demux, stream_t *s )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    avi_index_builder_t *p_builder = p_sys->p_builder;
+    uint64_t i_last_pos = 0;
+    unsigned int i_chunks = 0;
+
+    if( vlc_stream_Seek( s, p_builder->i_movi_begin + 12 ) )
+        return;
+
+    while( !vlc_killed() )
+    {
+        avi_packet_t pk;
+
+        if( AVI_PacketGetHeader( s, &pk ) )
+            break;
+
+        if( pk.i_stream < p_sys->i_track &&
+            pk.i_cat == p_sys->track[pk.i_stream]->fmt.i_cat )
+        {
+            const avi_track_t *tk = p_sys->track[pk.i_stream];
+
+            avi_entry_t index;
+            index.i_flags   = AVI_GetKeyFlag(tk, pk.i_peek);
+            index.i_pos     = pk.i_pos;
+            index.i_length  = pk.i_size;
+            index.i_lengthtotal = pk.i_size;
+
+            vlc_mutex_lock( &p_builder->lock );
+            avi_index_Append( &p_builder->p_pending[pk.i_stream],
+                              &i_last_pos, &index );
+            if( p_builder->b_waiting &&
+                ++i_chunks % AVI_INDEX_SIGNAL_CHUNKS == 0 )
+                vlc_cond_signal( &p_builder->wait );
+            vlc_mutex_unlock( &p_builder->lock );
+        }
+        else
+        {
+            switch( pk.i_fourcc )
+            {
+            case AVIFOURCC_idx1:
+                if( p_sys->b_odml && p_builder->i_riff1_pos != 0 )
+                {
+                    msg_Dbg( p_demux, "looking for new RIFF chunk" );
+                    if( vlc_stream_Seek( s, p_builder->i_riff1_pos ) )
+                        return;
+                    continue;
+                }
+                return;
+
+            case AVIFOURCC_RIFF:
+            case AVIFOURCC_rec:
+            case AVIFOURCC_JUNK:
+                break;
+
+            default:
+                msg_Warn( p_demux, "need resync, probably broken avi" );
+                if( AVI_PacketSearch( p_demux, s ) )
+                {
+                    msg_Warn( p_demux, "lost sync, abort index creation" );
+                    return;
+                }
+            }
+        }
+
+        if( ( !p_sys->b_odml && pk.i_pos + pk.i_size >= p_builder->i_movi_end ) ||
+            AVI_PacketNext( s ) )
+            break;
+    }
+}
+
+static void *AVI_IndexThread( void *data )
+{
+    demux_t *p_demux = data;
+    demux_sys_t *p_sys = p_demux->p_sys;
+    avi_index_builder_t *p_builder = p_sys->p_builder;
+
+    vlc_thread_set_name( "vlc-avi-index" );
+    vlc_interrupt_set( p_builder->p_interrupt );
+
+    stream_t *s = vlc_stream_NewURL( p_demux, p_builder->psz_url );
+    if( s != NULL )
+    {
+        AVI_IndexScan( p_demux, s );
+        vlc_stream_Delete( s );
+    }
+
+    vlc_mutex_lock( &p_builder->lock );
+    p_builder->b_done = true;
+    vlc_cond_signal( &p_builder->wait );
+    vlc_mutex_unlock( &p_builder->lock );
+    return NULL;
+}
+
+static int AVI_IndexStart( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_demux->psz_url == NULL )
+        return VLC_EGENERIC;
+
+    avi_chunk_list_t *p_riff = AVI_ChunkFind( &p_sys->ck_root,
+                                              AVIFOURCC_RIFF, 0, true );
+    avi_chunk_list_t *p_movi = AVI_ChunkFind( p_riff, AVIFOURCC_movi, 0, true );
+    if( !p_movi )
+        return VLC_EGENERIC;
+
+    avi_index_builder_t *p_builder = malloc( sizeof(*p_builder) );
+    if( unlikely(!p_builder) )
+        return VLC_ENOMEM;
+
+    p_builder->psz_url = strdup( p_demux->psz_url );
+    p_builder->p_interrupt = vlc_interrupt_create();
+    p_builder->p_pending = vlc_alloc( p_sys->i_track, sizeof(avi_index_t) );
+    if( unlikely(!p_builder->psz_url || !p_builder->p_interrupt ||
+                 !p_builder->p_pending) )
+    {
+        AVI_IndexBuilderDelete( p_builder, 0 );
+        return VLC_ENOMEM;
+    }
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+        avi_index_Init( &p_builder->p_pending[i] );
+
+    p_builder->i_movi_begin = p_movi->i_chunk_pos;
+    p_builder->i_movi_end = __MIN( p_movi->i_chunk_pos + p_movi->i_chunk_size,
+                                   stream_Size( p_demux->s ) );
+    avi_chunk_list_t *p_avix = AVI_ChunkFind( &p_sys->ck_root,
+                                              AVIFOURCC_RIFF, 1, true );
+    p_builder->i_riff1_pos = p_avix ? p_avix->i_chunk_pos + 24 : 0;
+
+    vlc_mutex_init( &p_builder->lock );
+    vlc_cond_init( &p_builder->wait );
+    p_builder->b_waiting = false;
+    p_builder->b_done = false;
+
+    p_sys->p_builder = p_builder;
+    if( vlc_clone( &p_builder->thread, AVI_IndexThread, p_demux ) )
+    {
+        p_sys->p_builder = NULL;
+        AVI_IndexBuilderDelete( p_builder, p_sys->i_track );
+        return VLC_EGENERIC;
+    }
+
+    /* Start over, playback indexes the beginning until the thread does */
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        avi_index_Clean( &p_sys->track[i]->idx );
+        avi_index_Init( &p_sys->track[i]->idx );
+    }
+    p_sys->i_movi_lastchunk_pos = 0;
+    p_sys->b_indexloaded = true;
+
+    msg_Dbg( p_demux, "creating index from LIST-movi in the background" );
+    return VLC_SUCCESS;
+}
+
+static void AVI_IndexStop( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    avi_index_builder_t *p_builder = p_sys->p_builder;
+
+    vlc_interrupt_kill( p_builder->p_interrupt );
+    vlc_join( p_builder->thread, NULL );
+    AVI_IndexBuilderDelete( p_builder, p_sys->i_track );
+    p_sys->p_builder = NULL;
+}
+
+static void AVI_IndexMerge( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    avi_index_builder_t *p_builder = p_sys->p_builder;
+
+    vlc_mutex_lock( &p_builder->lock );
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        avi_track_t *tk = p_sys->track[i];
+        avi_index_t *p_pending = &p_builder->p_pending[i];
+
+        if( p_pending->i_size == 0 )
+            continue;
+
+        for( uint32_t j = 0; j < p_pending->i_size; j++ )
+        {
+            /* Skip what playback has already indexed */
+            if( tk->idx.i_size > 0 &&
+                tk->idx.p_entry[tk->idx.i_size - 1].i_pos >=
+                    p_pending->p_entry[j].i_pos )
+                continue;
+            avi_index_Append( &tk->idx, &p_sys->i_movi_lastchunk_pos,
+                              &p_pending->p_entry[j] );
+        }
+        p_pending->i_size = 0;
+
+        p_sys->i_length = __MAX( p_sys->i_length, AVI_TrackGetIndexLength( tk ) );
+    }
+    const bool b_done = p_builder->b_done;
+    vlc_mutex_unlock( &p_builder->lock );
+
+    if( b_done )
+    {
+        AVI_IndexStop( p_demux );
+        p_sys->i_length = AVI_MovieGetLength( p_demux );
+        for( unsigned i = 0; i < p_sys->i_track; i++ )
+            msg_Dbg( p_demux, "stream[%u] created %u index entries",
+                     i, p_sys->track[i]->idx.i_size );
+    }
+}
+
+static bool AVI_IndexReached( demux_t *p_demux, vlc_tick_t i_date )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        avi_track_t *tk = p_sys->track[i];
+        if( !tk->b_activated ||
+            ( tk->fmt.i_cat != AUDIO_ES && tk->fmt.i_cat != VIDEO_ES ) )
+            continue;
+        if( AVI_TrackGetIndexLength( tk ) <= i_date )
+            return false;
+    }
+    return true;
+}
+
+/* Waits until the index covers i_date, or is complete for VLC_TICK_MAX */
+static void AVI_IndexWait( demux_t *p_demux, vlc_tick_t i_date )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    while( p_sys->p_builder != NULL )
+    {
+        avi_index_builder_t *p_builder = p_sys->p_builder;
+
+        AVI_IndexMerge( p_demux );
+        if( p_sys->p_builder == NULL || vlc_killed() ||
+            ( i_date != VLC_TICK_MAX && AVI_IndexReached( p_demux, i_date ) ) )
+            break;
+
+        vlc_mutex_lock( &p_builder->lock );
+        p_builder->b_waiting = true;
+        if( !p_builder->b_done )
+            vlc_cond_timedwait( &p_builder->wait, &p_builder->lock,
+                                vlc_tick_now() + VLC_TICK_FROM_MS(100) );
+        p_builder->b_waiting = false;
+        vlc_mutex_unlock( &p_builder->lock );
+    }
+}
+
 /* */
 static void AVI_MetaLoad( demux_t *p_demux,
                           avi_chunk_list_t *p_riff, avi_chunk_avih_t *p_avih )
@@ -3222,6 +3542,23 @@ static int AVI_TrackStopFinishedStreams( demux_t *p_demux )
 /****************************************************************************
  * AVI_MovieGetLength give max streams length in ticks
  ****************************************************************************/
+static vlc_tick_t AVI_TrackGetIndexLength( avi_track_t *tk )
+{
+    if( tk->idx.i_size < 1 || !tk->idx.p_entry )
+        return 0;
+
+    if( tk->i_samplesize )
+        return AVI_GetDPTS( tk, tk->idx.p_entry[tk->idx.i_size-1].i_lengthtotal +
+                                tk->idx.p_entry[tk->idx.i_size-1].i_length );
+    return AVI_GetDPTS( tk, tk->idx.i_size );
+}
+
+static vlc_tick_t AVI_HeaderGetLength( const avi_chunk_avih_t *p_avih )
+{
+    return VLC_TICK_FROM_US( (uint64_t)p_avih->i_totalframes *
+                             p_avih->i_microsecperframe );
+}
+
 static vlc_tick_t  AVI_MovieGetLength( demux_t *p_demux )
 {
     demux_sys_t  *p_sys = p_demux->p_sys;
@@ -3239,16 +3576,7 @@ static vlc_tick_t  AVI_MovieGetLength( demux_t *p_demux )
             continue;
         }
 
-        if( tk->i_samplesize )
-        {
-            i_length = AVI_GetDPTS( tk,
-                                    tk->idx.p_entry[tk->idx.i_size-1].i_lengthtotal +
-                                        tk->idx.p_entry[tk->idx.i_size-1].i_length );
-        }
-        else
-        {
-            i_length = AVI_GetDPTS( tk, tk->idx.i_size );
-        }
+        i_length = AVI_TrackGetIndexLength( tk );
 
         msg_Dbg( p_demux,
                  "stream[%d] length:%"PRId64" (based on index)",
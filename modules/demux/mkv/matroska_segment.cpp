@@ -26,6 +26,7 @@
 #include "demux.hpp"
 #include "util.hpp"
 #include "Ebml_dispatcher.hpp"
+#include "matroska_segment_index.hpp"
 
 #include <vlc_arrays.h>
 
@@ -64,11 +65,21 @@ matroska_segment_c::matroska_segment_c( demux_sys_t & demuxer, matroska_iostream
     ,ep( EbmlParser(&estream, p_seg, &demuxer.demuxer ))
     ,b_preloaded(false)
     ,b_ref_external_segments(false)
+    ,i_index_cache_size(0)
 {
 }
 
 matroska_segment_c::~matroska_segment_c()
 {
+    if( indexer )
+    {
+        indexer->Stop();
+        indexer->Merge( _seeker );
+    }
+    if( !index_cache_path.empty() )
+        SegmentIndexCache::Save( VLC_OBJECT( &sys.demuxer ), index_cache_path,
+                                 _seeker, i_index_cache_size );
+
     free( psz_writing_application );
     free( psz_muxing_application );
     free( psz_segment_filename );
@@ -519,6 +530,42 @@ bool matroska_segment_c::PreloadClusters(uint64_t i_cluster_pos)
     return true;
 }
 
+/* Without Cues, seeking has to find the clusters by reading the file: reuse
+ * what a previous playback found and/or look for them in the background */
+void matroska_segment_c::IndexInit( const char *psz_url, uint64_t i_file_size )
+{
+    if( b_cues || !sys.b_seekable || cluster == NULL || psz_url == NULL )
+        return;
+
+    vlc_object_t *obj = VLC_OBJECT( &sys.demuxer );
+
+    if( var_InheritBool( obj, "mkv-index-cache" ) )
+    {
+        index_cache_path = SegmentIndexCache::GetPath( obj, psz_url, i_file_size,
+                                                       segment->GetElementPosition(),
+                                                       p_segment_uid );
+        if( !index_cache_path.empty() )
+            i_index_cache_size = SegmentIndexCache::Load( obj, index_cache_path, _seeker );
+    }
+
+    if( var_InheritBool( obj, "mkv-background-index" ) )
+    {
+        SegmentSeeker::track_ids_t track_ids;
+        for( tracks_map_t::const_iterator it = tracks.begin(); it != tracks.end(); ++it )
+            track_ids.push_back( it->first );
+
+        SegmentSeeker::fptr_t i_end = segment->IsFiniteSize()
+            ? segment->GetEndPosition()
+            : std::numeric_limits<SegmentSeeker::fptr_t>::max();
+
+        indexer.reset( new (std::nothrow) SegmentIndexer( obj, psz_url,
+                                                          cluster->GetElementPosition(),
+                                                          i_end, i_timescale, track_ids ) );
+        if( indexer && !indexer->Start() )
+            indexer.reset();
+    }
+}
+
 bool matroska_segment_c::PreloadFamily( const matroska_segment_c & of_segment )
 {
     if ( b_preloaded )
@@ -839,6 +886,9 @@ bool matroska_segment_c::Seek( demux_t &demuxer, vlc_tick_t i_absolute_mk_date,
 
     // find appropriate seekpoints //
 
+    if( indexer )
+        indexer->Merge( _seeker );
+
     try {
         seekpoints = _seeker.get_seekpoints( *this, i_mk_date, priority, selected_tracks );
     }
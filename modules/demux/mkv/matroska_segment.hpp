@@ -78,6 +78,8 @@ public:
 
 struct demux_sys_t;
 
+class SegmentIndexer;
+
 class matroska_segment_c
 {
 public:
@@ -145,6 +147,7 @@ public:
     bool PreloadFamily( const matroska_segment_c & segment );
     bool PreloadClusters( uint64_t i_cluster_position );
     void InformationCreate();
+    void IndexInit( const char *psz_url, uint64_t i_file_size );
 
     bool Seek( demux_t &, vlc_tick_t i_mk_date, vlc_tick_t i_mk_time_offset, bool b_accurate );
 
@@ -178,6 +181,9 @@ private:
     void EnsureDuration();
 
     SegmentSeeker _seeker;
+    std::unique_ptr<SegmentIndexer> indexer;
+    std::string                     index_cache_path;
+    size_t                          i_index_cache_size;
 
     friend SegmentSeeker;
 };
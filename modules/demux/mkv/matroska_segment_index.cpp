@@ -0,0 +1,783 @@
+/*****************************************************************************
+ * matroska_segment_index.cpp : matroska demuxer
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "matroska_segment_index.hpp"
+
+#include <vlc_fs.h>
+#include <vlc_hash.h>
+#include <vlc_strings.h>
+#include <vlc_configuration.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cerrno>
+#include <iterator>
+
+namespace mkv {
+
+namespace {
+    /* EBML IDs, with their length marker */
+    const uint64_t ID_CLUSTER        = 0x1F43B675;
+    const uint64_t ID_CUES           = 0x1C53BB6B;
+    const uint64_t ID_TAGS           = 0x1254C367;
+    const uint64_t ID_CHAPTERS       = 0x1043A770;
+    const uint64_t ID_ATTACHMENTS    = 0x1941A469;
+    const uint64_t ID_SEEKHEAD       = 0x114D9B74;
+    const uint64_t ID_INFO           = 0x1549A966;
+    const uint64_t ID_TRACKS         = 0x1654AE6B;
+    const uint64_t ID_TIMESTAMP      = 0xE7;
+    const uint64_t ID_SIMPLEBLOCK    = 0xA3;
+    const uint64_t ID_BLOCKGROUP     = 0xA0;
+    const uint64_t ID_BLOCK          = 0xA1;
+    const uint64_t ID_REFERENCEBLOCK = 0xFB;
+
+    const uint64_t EBML_UNKNOWN_SIZE = UINT64_MAX;
+
+    bool IsTopLevel( uint64_t id )
+    {
+        return id == ID_CLUSTER || id == ID_CUES || id == ID_TAGS ||
+               id == ID_CHAPTERS || id == ID_ATTACHMENTS || id == ID_SEEKHEAD ||
+               id == ID_INFO || id == ID_TRACKS;
+    }
+
+    /* Parses a variable size integer, keeping the length marker for IDs */
+    bool ParseVint( const uint8_t *p, size_t len, bool b_id,
+                    uint64_t *value, unsigned *vlen )
+    {
+        if( len == 0 || p[0] == 0 )
+            return false;
+
+        unsigned n = 1;
+        while( !( p[0] & ( 0x80 >> ( n - 1 ) ) ) )
+            n++;
+        if( n > len || ( b_id && n > 4 ) )
+            return false;
+
+        uint64_t v = b_id ? p[0] : ( p[0] & ( 0xFF >> n ) );
+        bool b_all_ones = v == ( 0xFFu >> n );
+        for( unsigned i = 1; i < n; i++ )
+        {
+            v = ( v << 8 ) | p[i];
+            b_all_ones &= p[i] == 0xFF;
+        }
+
+        *value = ( !b_id && b_all_ones ) ? EBML_UNKNOWN_SIZE : v;
+        *vlen = n;
+        return true;
+    }
+
+    bool ReadVint( stream_t *s, bool b_id, uint64_t *value, unsigned *vlen )
+    {
+        uint8_t buf[8];
+
+        if( vlc_stream_Read( s, buf, 1 ) != 1 || buf[0] == 0 )
+            return false;
+
+        unsigned n = 1;
+        while( !( buf[0] & ( 0x80 >> ( n - 1 ) ) ) )
+            n++;
+        if( n > 1 && vlc_stream_Read( s, &buf[1], n - 1 ) != (ssize_t)( n - 1 ) )
+            return false;
+
+        return ParseVint( buf, n, b_id, value, vlen );
+    }
+
+    bool ReadHeader( stream_t *s, uint64_t *id, uint64_t *size, unsigned *hlen )
+    {
+        unsigned id_len, size_len;
+
+        if( !ReadVint( s, true, id, &id_len ) ||
+            !ReadVint( s, false, size, &size_len ) )
+            return false;
+
+        *hlen = id_len + size_len;
+        return true;
+    }
+
+    bool SeekTo( stream_t *s, uint64_t pos )
+    {
+        return vlc_stream_Tell( s ) == pos || vlc_stream_Seek( s, pos ) == VLC_SUCCESS;
+    }
+}
+
+/* The SegmentSeeker data and its (de)serialization, apart from the demuxer
+ * so that the index is built, saved and loaded without it */
+SegmentSeeker::cluster_positions_t::iterator
+SegmentSeeker::add_cluster_position( fptr_t fpos )
+{
+    cluster_positions_t::iterator insertion_point = std::upper_bound(
+      _cluster_positions.begin(),
+      _cluster_positions.end(),
+      fpos
+    );
+
+    if( insertion_point != _cluster_positions.begin() && *std::prev( insertion_point ) == fpos )
+        return std::prev( insertion_point ); // already known
+
+    return _cluster_positions.insert( insertion_point, fpos );
+}
+
+SegmentSeeker::cluster_map_t::iterator
+SegmentSeeker::add_cluster( Cluster const& cinfo )
+{
+    add_cluster_position( cinfo.fpos );
+
+    cluster_map_t::iterator it = _clusters.lower_bound( cinfo.pts );
+
+    if( it != _clusters.end() && it->second.pts == cinfo.pts )
+    {
+        // cluster already known
+    }
+    else
+    {
+        it = _clusters.insert( cluster_map_t::value_type( cinfo.pts, cinfo ) ).first;
+    }
+
+    // ------------------------------------------------------------------
+    // IF we have two adjecent clusters, update duration where applicable
+    // ------------------------------------------------------------------
+
+    struct Duration {
+        static void fix( Cluster& prev, Cluster& next )
+        {
+            if( ( prev.fpos + prev.size) == next.fpos )
+                prev.duration = next.pts - prev.pts;
+        }
+    };
+
+    if( it != _clusters.begin() )
+    {
+        Duration::fix( std::prev( it )->second, it->second );
+    }
+
+    if( it != _clusters.end() && std::next( it ) != _clusters.end() )
+    {
+        Duration::fix( it->second, std::next( it )->second );
+    }
+
+    return it;
+}
+
+void
+SegmentSeeker::add_seekpoint( track_id_t track_id, Seekpoint sp )
+{
+    seekpoints_t&  seekpoints = _tracks_seekpoints[ track_id ];
+    seekpoints_t::iterator it = std::lower_bound( seekpoints.begin(), seekpoints.end(), sp );
+
+    if( it != seekpoints.end() && it->fpos == sp.fpos )
+    {
+        if (sp.trust_level <= it->trust_level)
+            return;
+
+        *it = sp;
+    }
+    else if( it != seekpoints.end() && it->pts == sp.pts )
+    {
+        if (sp.trust_level <= it->trust_level)
+            return;
+
+        *it = sp;
+    }
+    else
+    {
+        seekpoints.insert( it, sp );
+    }
+}
+
+void
+SegmentSeeker::mark_range_as_searched( Range data )
+{
+    /* TODO: this is utterly ugly, we should do the insertion in-place */
+
+    _ranges_searched.insert( std::upper_bound( _ranges_searched.begin(), _ranges_searched.end(), data ), data );
+
+    {
+        ranges_t merged;
+
+        for( ranges_t::iterator it = _ranges_searched.begin(); it != _ranges_searched.end(); ++it )
+        {
+            if( merged.size() )
+            {
+                Range& last_entry = *merged.rbegin();
+
+                if( last_entry.end+1 >= it->start && last_entry.end < it->end )
+                {
+                    last_entry.end = it->end;
+                    continue;
+                }
+
+                if( it->start >= last_entry.start && it->end <= last_entry.end )
+                {
+                    last_entry.end = std::max( last_entry.end, it->end );
+                    continue;
+                }
+            }
+
+            merged.push_back( *it );
+        }
+
+        _ranges_searched = merged;
+    }
+}
+
+namespace {
+    const uint8_t index_magic[8] = { 'V', 'L', 'C', 'M', 'K', 'V', 'I', '1' };
+
+    struct index_writer
+    {
+        std::vector<uint8_t>& buf;
+
+        void u32( uint32_t v )
+        {
+            uint8_t b[4];
+            SetDWLE( b, v );
+            buf.insert( buf.end(), b, b + sizeof( b ) );
+        }
+
+        void u64( uint64_t v )
+        {
+            uint8_t b[8];
+            SetQWLE( b, v );
+            buf.insert( buf.end(), b, b + sizeof( b ) );
+        }
+    };
+
+    struct index_reader
+    {
+        std::vector<uint8_t> const& buf;
+        size_t pos;
+
+        bool u32( uint32_t& v )
+        {
+            if( buf.size() - pos < 4 )
+                return false;
+            v = GetDWLE( &buf[pos] );
+            pos += 4;
+            return true;
+        }
+
+        bool u64( uint64_t& v )
+        {
+            if( buf.size() - pos < 8 )
+                return false;
+            v = GetQWLE( &buf[pos] );
+            pos += 8;
+            return true;
+        }
+
+        bool tick( vlc_tick_t& v )
+        {
+            uint64_t u;
+            if( !u64( u ) )
+                return false;
+            v = static_cast<vlc_tick_t>( u );
+            return true;
+        }
+    };
+}
+
+void
+SegmentSeeker::serialize( std::vector<uint8_t>& buf ) const
+{
+    index_writer w { buf };
+
+    buf.insert( buf.end(), index_magic, index_magic + sizeof( index_magic ) );
+
+    w.u32( _ranges_searched.size() );
+    for( ranges_t::const_iterator it = _ranges_searched.begin(); it != _ranges_searched.end(); ++it )
+    {
+        w.u64( it->start );
+        w.u64( it->end );
+    }
+
+    w.u32( _cluster_positions.size() );
+    for( cluster_positions_t::const_iterator it = _cluster_positions.begin(); it != _cluster_positions.end(); ++it )
+        w.u64( *it );
+
+    w.u32( _clusters.size() );
+    for( cluster_map_t::const_iterator it = _clusters.begin(); it != _clusters.end(); ++it )
+    {
+        w.u64( it->second.fpos );
+        w.u64( it->second.pts );
+        w.u64( it->second.duration );
+        w.u64( it->second.size );
+    }
+
+    w.u32( _tracks_seekpoints.size() );
+    for( tracks_seekpoints_t::const_iterator it = _tracks_seekpoints.begin(); it != _tracks_seekpoints.end(); ++it )
+    {
+        w.u32( it->first );
+        w.u32( it->second.size() );
+        for( seekpoints_t::const_iterator sp = it->second.begin(); sp != it->second.end(); ++sp )
+        {
+            w.u64( sp->fpos );
+            w.u64( sp->pts );
+            w.u32( sp->trust_level );
+        }
+    }
+}
+
+bool
+SegmentSeeker::deserialize( std::vector<uint8_t> const& buf )
+{
+    index_reader r { buf, sizeof( index_magic ) };
+    uint32_t count;
+
+    if( buf.size() < sizeof( index_magic ) ||
+        memcmp( buf.data(), index_magic, sizeof( index_magic ) ) )
+        return false;
+
+    // parse everything before merging anything, in case of truncated data
+
+    ranges_t ranges;
+    if( !r.u32( count ) )
+        return false;
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        Range range( 0, 0 );
+        if( !r.u64( range.start ) || !r.u64( range.end ) )
+            return false;
+        ranges.push_back( range );
+    }
+
+    cluster_positions_t positions;
+    if( !r.u32( count ) )
+        return false;
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        fptr_t fpos;
+        if( !r.u64( fpos ) )
+            return false;
+        positions.push_back( fpos );
+    }
+
+    std::vector<Cluster> clusters;
+    if( !r.u32( count ) )
+        return false;
+    for( uint32_t i = 0; i < count; ++i )
+    {
+        Cluster cinfo;
+        if( !r.u64( cinfo.fpos ) || !r.tick( cinfo.pts ) ||
+            !r.tick( cinfo.duration ) || !r.u64( cinfo.size ) )
+            return false;
+        clusters.push_back( cinfo );
+    }
+
+    std::vector<std::pair<track_id_t, Seekpoint> > seekpoints;
+    uint32_t tracks;
+    if( !r.u32( tracks ) )
+        return false;
+    for( uint32_t t = 0; t < tracks; ++t )
+    {
+        uint32_t track_id;
+        if( !r.u32( track_id ) || !r.u32( count ) )
+            return false;
+        for( uint32_t i = 0; i < count; ++i )
+        {
+            Seekpoint sp;
+            uint32_t trust;
+            if( !r.u64( sp.fpos ) || !r.tick( sp.pts ) || !r.u32( trust ) )
+                return false;
+            sp.trust_level = static_cast<Seekpoint::TrustLevel>( static_cast<int32_t>( trust ) );
+            seekpoints.push_back( std::make_pair( track_id, sp ) );
+        }
+    }
+
+    for( size_t i = 0; i < positions.size(); ++i )
+        add_cluster_position( positions[i] );
+    for( size_t i = 0; i < clusters.size(); ++i )
+        add_cluster( clusters[i] );
+    for( size_t i = 0; i < seekpoints.size(); ++i )
+        add_seekpoint( seekpoints[i].first, seekpoints[i].second );
+    for( size_t i = 0; i < ranges.size(); ++i )
+        mark_range_as_searched( ranges[i] );
+
+    return true;
+}
+
+SegmentIndexer::SegmentIndexer( vlc_object_t *obj, std::string const& url,
+                                fptr_t start, fptr_t end, uint64_t i_timescale,
+                                SegmentSeeker::track_ids_t const& tracks )
+    : obj( obj )
+    , url( url )
+    , start( start )
+    , end( end )
+    , i_timescale( i_timescale )
+    , tracks( tracks )
+    , interrupt( NULL )
+    , b_running( false )
+    , scanned_end( start )
+    , b_done( false )
+{
+    vlc_mutex_init( &lock );
+}
+
+SegmentIndexer::~SegmentIndexer()
+{
+    Stop();
+    if( interrupt != NULL )
+        vlc_interrupt_destroy( interrupt );
+}
+
+bool SegmentIndexer::Start()
+{
+    interrupt = vlc_interrupt_create();
+    if( unlikely( interrupt == NULL ) )
+        return false;
+
+    b_running = !vlc_clone( &thread, Thread, this );
+    return b_running;
+}
+
+void SegmentIndexer::Stop()
+{
+    if( !b_running )
+        return;
+
+    vlc_interrupt_kill( interrupt );
+    vlc_join( thread, NULL );
+    b_running = false;
+}
+
+void SegmentIndexer::Merge( SegmentSeeker & seeker )
+{
+    std::vector<SegmentSeeker::Cluster> new_clusters;
+    std::vector<std::pair<SegmentSeeker::track_id_t, SegmentSeeker::Seekpoint> > new_seekpoints;
+    fptr_t new_end;
+
+    {
+        vlc_mutex_locker guard( &lock );
+        new_clusters.swap( clusters );
+        new_seekpoints.swap( seekpoints );
+        new_end = scanned_end;
+    }
+
+    for( size_t i = 0; i < new_clusters.size(); ++i )
+        seeker.add_cluster( new_clusters[i] );
+    for( size_t i = 0; i < new_seekpoints.size(); ++i )
+        seeker.add_seekpoint( new_seekpoints[i].first, new_seekpoints[i].second );
+
+    if( new_end > start )
+        seeker.mark_range_as_searched( SegmentSeeker::Range( start, new_end ) );
+}
+
+bool SegmentIndexer::IsDone()
+{
+    vlc_mutex_locker guard( &lock );
+    return b_done;
+}
+
+void *SegmentIndexer::Thread( void *data )
+{
+    static_cast<SegmentIndexer *>( data )->Run();
+    return NULL;
+}
+
+void SegmentIndexer::Publish( SegmentSeeker::Cluster const& cluster, fptr_t next )
+{
+    vlc_mutex_locker guard( &lock );
+
+    clusters.push_back( cluster );
+    seekpoints.insert( seekpoints.end(), cluster_seekpoints.begin(),
+                       cluster_seekpoints.end() );
+    scanned_end = next;
+}
+
+bool SegmentIndexer::ScanBlock( stream_t *s, fptr_t pos, uint64_t size, bool b_simple,
+                                uint64_t cluster_tc, SegmentSeeker::Seekpoint & sp,
+                                SegmentSeeker::track_id_t & track_id )
+{
+    uint8_t buf[12];
+    uint64_t track;
+    unsigned track_len;
+
+    ssize_t len = vlc_stream_Read( s, buf, std::min<uint64_t>( size, sizeof( buf ) ) );
+    if( len <= 0 || !ParseVint( buf, len, false, &track, &track_len ) ||
+        (size_t)len < track_len + 3 )
+        return false;
+
+    /* the key frame flag only exists in SimpleBlock, the caller checks
+     * BlockGroup references */
+    if( b_simple && !( buf[track_len + 2] & 0x80 ) )
+        return false;
+
+    track_id = track;
+    if( std::find( tracks.begin(), tracks.end(), track_id ) == tracks.end() )
+        return false;
+
+    int16_t rel = static_cast<int16_t>( GetWBE( &buf[track_len] ) );
+    int64_t tc = static_cast<int64_t>( cluster_tc ) + rel;
+
+    sp = SegmentSeeker::Seekpoint( pos, VLC_TICK_FROM_NS( tc * static_cast<int64_t>( i_timescale ) ) );
+    return true;
+}
+
+bool SegmentIndexer::ScanCluster( stream_t *s, fptr_t pos, fptr_t data, uint64_t size,
+                                  fptr_t *next )
+{
+    const fptr_t limit = size == EBML_UNKNOWN_SIZE ? end : data + size;
+    uint64_t tc = 0;
+    bool b_tc = false;
+    fptr_t p = data;
+
+    cluster_seekpoints.clear();
+
+    while( p < limit && !vlc_killed() )
+    {
+        uint64_t id, esize;
+        unsigned hlen;
+
+        if( !SeekTo( s, p ) || !ReadHeader( s, &id, &esize, &hlen ) )
+            break; /* truncated file */
+
+        /* a cluster of unknown size ends with the next top level element */
+        if( size == EBML_UNKNOWN_SIZE && IsTopLevel( id ) )
+            break;
+
+        if( esize == EBML_UNKNOWN_SIZE )
+            return false;
+
+        const fptr_t edata = p + hlen;
+        SegmentSeeker::Seekpoint sp;
+        SegmentSeeker::track_id_t track_id;
+
+        if( id == ID_TIMESTAMP && esize <= 8 )
+        {
+            uint8_t buf[8];
+            if( vlc_stream_Read( s, buf, esize ) != (ssize_t)esize )
+                break;
+            tc = 0;
+            for( uint64_t i = 0; i < esize; i++ )
+                tc = ( tc << 8 ) | buf[i];
+            b_tc = true;
+        }
+        else if( id == ID_SIMPLEBLOCK && b_tc )
+        {
+            if( ScanBlock( s, p, esize, true, tc, sp, track_id ) )
+                cluster_seekpoints.push_back( std::make_pair( track_id, sp ) );
+        }
+        else if( id == ID_BLOCKGROUP && b_tc )
+        {
+            fptr_t block_pos = 0, block_data = 0;
+            uint64_t block_size = 0;
+            bool b_reference = false;
+            fptr_t c = edata;
+
+            while( c < edata + esize )
+            {
+                uint64_t cid, csize;
+                unsigned chlen;
+
+                if( !SeekTo( s, c ) || !ReadHeader( s, &cid, &csize, &chlen ) ||
+                    csize == EBML_UNKNOWN_SIZE )
+                    break;
+                if( cid == ID_BLOCK )
+                {
+                    block_pos = c;
+                    block_data = c + chlen;
+                    block_size = csize;
+                }
+                else if( cid == ID_REFERENCEBLOCK )
+                    b_reference = true;
+                c += chlen + csize;
+            }
+
+            /* a truncated group may have lost its references */
+            if( c == edata + esize && block_size > 0 && !b_reference &&
+                SeekTo( s, block_data ) &&
+                ScanBlock( s, block_pos, block_size, false, tc, sp, track_id ) )
+                cluster_seekpoints.push_back( std::make_pair( track_id, sp ) );
+        }
+
+        p = edata + esize;
+    }
+
+    if( vlc_killed() )
+        return false; /* do not publish a partial cluster */
+
+    *next = p;
+
+    if( !b_tc )
+    {
+        /* nothing usable for seeking */
+        vlc_mutex_locker guard( &lock );
+        scanned_end = p;
+        return true;
+    }
+
+    SegmentSeeker::Cluster cinfo = {
+        /* fpos     */ pos,
+        /* pts      */ VLC_TICK_FROM_NS( static_cast<vlc_tick_t>( tc * i_timescale ) ),
+        /* duration */ vlc_tick_t( -1 ),
+        /* size     */ size == EBML_UNKNOWN_SIZE ? UINT64_MAX : data + size - pos
+    };
+
+    Publish( cinfo, p );
+    return true;
+}
+
+void SegmentIndexer::Run()
+{
+    vlc_thread_set_name( "vlc-mkv-index" );
+    vlc_interrupt_set( interrupt );
+
+    size_t i_clusters = 0;
+    vlc_tick_t i_start = vlc_tick_now();
+    stream_t *s = vlc_stream_NewURL( obj, url.c_str() );
+
+    if( s != NULL )
+    {
+        fptr_t pos = start;
+
+        while( pos < end && !vlc_killed() )
+        {
+            uint64_t id, size;
+            unsigned hlen;
+
+            if( !SeekTo( s, pos ) || !ReadHeader( s, &id, &size, &hlen ) )
+                break;
+
+            if( id == ID_CLUSTER )
+            {
+                if( !ScanCluster( s, pos, pos + hlen, size, &pos ) )
+                    break;
+                i_clusters++;
+            }
+            else if( size == EBML_UNKNOWN_SIZE )
+                break;
+            else
+            {
+                pos += hlen + size;
+
+                vlc_mutex_locker guard( &lock );
+                scanned_end = pos;
+            }
+        }
+        vlc_stream_Delete( s );
+    }
+
+    msg_Dbg( obj, "background indexing found %zu clusters in %" PRId64 " ms%s",
+             i_clusters, MS_FROM_VLC_TICK( vlc_tick_now() - i_start ),
+             vlc_killed() ? " (interrupted)" : "" );
+
+    vlc_mutex_locker guard( &lock );
+    b_done = true;
+}
+
+namespace SegmentIndexCache {
+
+static std::string GetDir()
+{
+    char *psz_dir = config_GetUserDir( VLC_CACHE_DIR );
+    if( psz_dir == NULL )
+        return std::string();
+
+    std::string dir = std::string( psz_dir ) + DIR_SEP "mkv-index";
+    free( psz_dir );
+    return dir;
+}
+
+std::string GetPath( vlc_object_t *, std::string const& url, uint64_t file_size,
+                     uint64_t segment_pos, const EbmlBinary *segment_uid )
+{
+    std::string dir = GetDir();
+    if( dir.empty() )
+        return dir;
+
+    vlc_hash_md5_t md5;
+    uint8_t buf[8];
+    uint8_t digest[VLC_HASH_MD5_DIGEST_SIZE];
+    char hex[VLC_HASH_MD5_DIGEST_HEX_SIZE];
+
+    vlc_hash_md5_Init( &md5 );
+    vlc_hash_md5_Update( &md5, url.data(), url.size() );
+    SetQWLE( buf, file_size );
+    vlc_hash_md5_Update( &md5, buf, sizeof( buf ) );
+    SetQWLE( buf, segment_pos );
+    vlc_hash_md5_Update( &md5, buf, sizeof( buf ) );
+    if( segment_uid != NULL )
+        vlc_hash_md5_Update( &md5, segment_uid->GetBuffer(), segment_uid->GetSize() );
+    vlc_hash_md5_Finish( &md5, digest, sizeof( digest ) );
+    vlc_hex_encode_binary( digest, sizeof( digest ), hex );
+
+    return dir + DIR_SEP + hex + ".idx";
+}
+
+size_t Load( vlc_object_t *obj, std::string const& path, SegmentSeeker & seeker )
+{
+    FILE *file = vlc_fopen( path.c_str(), "rb" );
+    if( file == NULL )
+        return 0;
+
+    std::vector<uint8_t> buf;
+    uint8_t chunk[4096];
+    size_t len;
+
+    while( ( len = fread( chunk, 1, sizeof( chunk ), file ) ) > 0 )
+        buf.insert( buf.end(), chunk, chunk + len );
+    fclose( file );
+
+    if( !seeker.deserialize( buf ) )
+    {
+        msg_Warn( obj, "ignoring invalid index cache %s", path.c_str() );
+        return 0;
+    }
+
+    msg_Dbg( obj, "loaded index cache %s (%zu bytes)", path.c_str(), buf.size() );
+    return buf.size();
+}
+
+bool Save( vlc_object_t *obj, std::string const& path, SegmentSeeker const& seeker,
+           size_t i_loaded )
+{
+    std::vector<uint8_t> buf;
+    seeker.serialize( buf );
+
+    /* nothing was learned since the cache was loaded */
+    if( buf.size() <= i_loaded )
+        return true;
+
+    std::string dir = GetDir();
+    if( dir.empty() || ( vlc_mkdir_parent( dir.c_str(), 0700 ) && errno != EEXIST ) )
+        return false;
+
+    /* write aside, so that a concurrent reader never sees partial data */
+    std::string tmp = path + ".tmp";
+    FILE *file = vlc_fopen( tmp.c_str(), "wb" );
+    if( file == NULL )
+        return false;
+
+    bool b_ok = fwrite( buf.data(), 1, buf.size(), file ) == buf.size();
+    b_ok &= fclose( file ) == 0;
+
+    if( !b_ok || vlc_rename( tmp.c_str(), path.c_str() ) )
+    {
+        msg_Warn( obj, "cannot write index cache %s", path.c_str() );
+        vlc_unlink( tmp.c_str() );
+        return false;
+    }
+
+    msg_Dbg( obj, "saved index cache %s (%zu bytes)", path.c_str(), buf.size() );
+    return true;
+}
+
+} // namespace SegmentIndexCache
+
+} // namespace mkv
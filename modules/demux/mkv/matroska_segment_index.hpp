@@ -0,0 +1,96 @@
+/*****************************************************************************
+ * matroska_segment_index.hpp : matroska demuxer
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MKV_MATROSKA_SEGMENT_INDEX_HPP_
+#define MKV_MATROSKA_SEGMENT_INDEX_HPP_
+
+#include "mkv.hpp"
+#include "matroska_segment_seeker.hpp"
+
+#include <vlc_threads.h>
+#include <vlc_interrupt.h>
+
+namespace mkv {
+
+/* Finds the clusters and key frames of a segment without Cues, from its own
+ * stream in a background thread, so that seeking does not need to scan the
+ * file. What was found is handed to the SegmentSeeker by Merge(). */
+class SegmentIndexer
+{
+    public:
+        typedef SegmentSeeker::fptr_t fptr_t;
+
+        SegmentIndexer( vlc_object_t *, std::string const& url,
+                        fptr_t start, fptr_t end, uint64_t i_timescale,
+                        SegmentSeeker::track_ids_t const& tracks );
+        ~SegmentIndexer();
+
+        bool Start();
+        void Stop();
+
+        /* Does not block on the indexing thread */
+        void Merge( SegmentSeeker & );
+        bool IsDone();
+
+    private:
+        static void *Thread( void * );
+        void Run();
+        bool ScanCluster( stream_t *, fptr_t pos, fptr_t data, uint64_t size, fptr_t *next );
+        bool ScanBlock( stream_t *, fptr_t pos, uint64_t size, bool b_simple,
+                        uint64_t cluster_tc, SegmentSeeker::Seekpoint &,
+                        SegmentSeeker::track_id_t & );
+        void Publish( SegmentSeeker::Cluster const&, fptr_t end );
+
+        vlc_object_t     *obj;
+        const std::string url;
+        const fptr_t      start;
+        const fptr_t      end;
+        const uint64_t    i_timescale;
+        const SegmentSeeker::track_ids_t tracks;
+
+        vlc_thread_t      thread;
+        vlc_interrupt_t  *interrupt;
+        bool              b_running;
+
+        vlc_mutex_t       lock;
+        /* protected by lock */
+        std::vector<SegmentSeeker::Cluster> clusters;
+        std::vector<std::pair<SegmentSeeker::track_id_t, SegmentSeeker::Seekpoint> > seekpoints;
+        fptr_t            scanned_end;
+        bool              b_done;
+
+        /* only used by the indexing thread */
+        std::vector<std::pair<SegmentSeeker::track_id_t, SegmentSeeker::Seekpoint> > cluster_seekpoints;
+};
+
+/* Sidecar storage of the seek index, keyed by the file and segment identity */
+namespace SegmentIndexCache {
+    std::string GetPath( vlc_object_t *, std::string const& url, uint64_t file_size,
+                         uint64_t segment_pos, const EbmlBinary *segment_uid );
+    /* returns the size of the loaded data, 0 if there was none */
+    size_t Load( vlc_object_t *, std::string const& path, SegmentSeeker & );
+    /* only writes when more is known than what was loaded */
+    bool Save( vlc_object_t *, std::string const& path, SegmentSeeker const&,
+               size_t i_loaded );
+}
+
+} // namespace
+
+#endif /* include-guard */
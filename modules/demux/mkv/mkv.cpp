@@ -82,6 +82,14 @@ vlc_module_begin ()
             N_("Preload clusters"),
             N_("Find all cluster positions by jumping cluster-to-cluster before playback") )
 
+    add_bool( "mkv-index-cache", false,
+            N_("Cache the seek index"),
+            N_("Store the cluster positions of files without Cues on disk, and reuse them on the next playback.") )
+
+    add_bool( "mkv-background-index", false,
+            N_("Index in the background"),
+            N_("Find the cluster positions of files without Cues in a separate thread during playback.") )
+
     add_shortcut( "mka", "mkv" )
     add_file_extension("mka")
     add_file_extension("mks")
@@ -158,6 +166,9 @@ static int OpenInternal( demux_t *p_demux, bool trust_cues )
             b_need_preload = true;
     }
 
+    for (size_t i=0; i<p_stream->segments.size(); i++)
+        p_stream->segments[i]->IndexInit( p_demux->psz_url, stream_Size( p_demux->s ) );
+
     p_segment = p_stream->segments[0];
     if( p_segment->cluster == NULL && p_segment->stored_editions.size() == 0 )
     {
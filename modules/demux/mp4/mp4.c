@@ -2789,22 +2789,24 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
     {
         /* 1: all sample have the same size, so no need to construct a table */
         p_demux_track->i_sample_size = stsz->i_sample_size;
-        p_demux_track->p_sample_size = NULL;
     }
     else
     {
         /* 2: each sample can have a different size */
         p_demux_track->i_sample_size = 0;
-        p_demux_track->p_sample_size =
-            calloc( p_demux_track->i_sample_count, sizeof( uint32_t ) );
-        if( p_demux_track->p_sample_size == NULL )
-            return VLC_ENOMEM;
+        int i_ret = MP4_SampleSizes_Init( &p_demux_track->sample_sizes,
+                                          stsz->i_entry_size,
+                                          p_demux_track->i_sample_count );
+        if( i_ret != VLC_SUCCESS )
+            return i_ret;
 
-        for( uint32_t i_sample = 0; i_sample < p_demux_track->i_sample_count; i_sample++ )
-        {
-            p_demux_track->p_sample_size[i_sample] =
-                    stsz->i_entry_size[i_sample];
-        }
+        msg_Dbg( p_demux, "track[Id 0x%x] %"PRIu32" sample sizes packed in %zu bytes",
+                 p_demux_track->i_track_ID, p_demux_track->i_sample_count,
+                 MP4_SampleSizes_Memory( &p_demux_track->sample_sizes ) );
+
+        /* The expanded box table is not used anymore */
+        free( stsz->i_entry_size );
+        stsz->i_entry_size = NULL;
     }
 
     if ( p_demux_track->i_chunk_count && p_demux_track->i_sample_size == 0 )
@@ -4044,8 +4046,7 @@ static void MP4_TrackClean( es_out_t *out, mp4_track_t *p_track )
     }
     free( p_track->chunk );
 
-    if( !p_track->i_sample_size )
-        free( p_track->p_sample_size );
+    MP4_SampleSizes_Clean( &p_track->sample_sizes );
 
     ASFPacketTrackReset( &p_track->asfinfo );
 
@@ -4219,7 +4220,7 @@ static uint32_t MP4_TrackGetReadSize( mp4_track_t *p_track, uint32_t *pi_nb_samp
         *pi_nb_samples = 1;
 
         if( p_track->i_sample_size == 0 ) /* all sizes are different */
-            return p_track->p_sample_size[p_track->i_sample];
+            return MP4_SampleSizes_Get( &p_track->sample_sizes, p_track->i_sample );
         else
             return p_track->i_sample_size;
     }
@@ -4257,7 +4258,7 @@ static uint32_t MP4_TrackGetReadSize( mp4_track_t *p_track, uint32_t *pi_nb_samp
         if( p_track->i_sample_size == 0 )
         {
             *pi_nb_samples = 1;
-            return p_track->p_sample_size[p_track->i_sample];
+            return MP4_SampleSizes_Get( &p_track->sample_sizes, p_track->i_sample );
         }
 
         /* If we are compressed but not v2 LPCM frames extensions */
@@ -4267,7 +4268,7 @@ static uint32_t MP4_TrackGetReadSize( mp4_track_t *p_track, uint32_t *pi_nb_samp
             if ( p_track->i_sample_size )
                 return p_track->i_sample_size;
             else
-                return p_track->p_sample_size[p_track->i_sample];
+                return MP4_SampleSizes_Get( &p_track->sample_sizes, p_track->i_sample );
         }
 
         /* More regular V0 cases */
@@ -4347,7 +4348,7 @@ static uint32_t MP4_TrackGetReadSize( mp4_track_t *p_track, uint32_t *pi_nb_samp
                  i<p_track->i_sample_count;
                  i++ )
             {
-                i_size += p_track->p_sample_size[i];
+                i_size += MP4_SampleSizes_Get( &p_track->sample_sizes, i );
                 (*pi_nb_samples)++;
 
                 /* Try to detect compression in ISO */
@@ -4368,7 +4369,6 @@ static uint32_t MP4_TrackGetReadSize( mp4_track_t *p_track, uint32_t *pi_nb_samp
 
 static uint64_t MP4_TrackGetPos( mp4_track_t *p_track )
 {
-    unsigned int i_sample;
     uint64_t i_pos;
 
     i_pos = p_track->chunk[p_track->i_chunk].i_offset;
@@ -4401,11 +4401,9 @@ static uint64_t MP4_TrackGetPos( mp4_track_t *p_track )
     }
     else
     {
-        for( i_sample = p_track->chunk[p_track->i_chunk].i_sample_first;
-             i_sample < p_track->i_sample; i_sample++ )
-        {
-            i_pos += p_track->p_sample_size[i_sample];
-        }
+        i_pos += MP4_SampleSizes_Sum( &p_track->sample_sizes,
+                                      p_track->chunk[p_track->i_chunk].i_sample_first,
+                                      p_track->i_sample );
     }
 
     return i_pos;
@@ -28,6 +28,7 @@
 #include <vlc_common.h>
 #include "libmp4.h"
 #include "fragments.h"
+#include "sampletable.h"
 #include "../asf/asfpacket.h"
 
 #define MP4_CHUNK_SMALLBUF_ENTRIES 2
@@ -148,11 +149,10 @@ typedef struct
 
     mp4_chunk_t    *chunk; /* always defined  for each chunk */
 
-    /* sample size, p_sample_size defined only if i_sample_size == 0
+    /* sample size, sample_sizes defined only if i_sample_size == 0
         else i_sample_size is size for all sample */
     uint32_t         i_sample_size;
-    uint32_t         *p_sample_size; /* XXX perhaps add file offset if take
-//                                    too much time to do sumations each time*/
+    mp4_sample_sizes_t sample_sizes;
 
     const MP4_Box_t *p_track;
     const MP4_Box_t *p_stbl;  /* will contain all timing information */
@@ -0,0 +1,184 @@
+/*****************************************************************************
+ * sampletable.c : MP4 compact sample size table
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdbit.h>
+
+#include "sampletable.h"
+
+static uint32_t UnpackBits( const uint32_t *p_data, uint64_t i_bit, uint8_t i_bits )
+{
+    const uint32_t *p = &p_data[i_bit / 32];
+    /* the data is padded by one word, so that p[1] is always readable */
+    uint64_t v = p[0] | ((uint64_t)p[1] << 32);
+    return (v >> (i_bit % 32)) & ((UINT64_C(1) << i_bits) - 1);
+}
+
+static void PackBits( uint32_t *p_data, uint64_t i_bit, uint32_t v )
+{
+    uint32_t *p = &p_data[i_bit / 32];
+    uint64_t w = (uint64_t)v << (i_bit % 32);
+    p[0] |= (uint32_t)w;
+    p[1] |= (uint32_t)(w >> 32);
+}
+
+int MP4_SampleSizes_Init( mp4_sample_sizes_t *p_table, const uint32_t *pi_sizes,
+                          uint32_t i_count )
+{
+    const size_t i_blocks = ((size_t)i_count + MP4_SAMPLES_BLOCK - 1)
+                            >> MP4_SAMPLES_BLOCK_LOG2;
+
+    p_table->i_count = i_count;
+    p_table->p_data = NULL;
+    p_table->i_data = 0;
+    p_table->p_blocks = vlc_alloc( i_blocks, sizeof(*p_table->p_blocks) );
+    if( i_blocks && unlikely(p_table->p_blocks == NULL) )
+        return VLC_ENOMEM;
+
+    /* first pass: find the base and width of each block */
+    uint64_t i_offset = 0;
+    size_t i_words = 0;
+    for( size_t i = 0; i < i_blocks; i++ )
+    {
+        mp4_sample_block_t *p_block = &p_table->p_blocks[i];
+        const uint32_t *p_sizes = &pi_sizes[i << MP4_SAMPLES_BLOCK_LOG2];
+        const uint32_t i_entries = __MIN( MP4_SAMPLES_BLOCK,
+                                          i_count - (i << MP4_SAMPLES_BLOCK_LOG2) );
+        uint32_t i_min = UINT32_MAX, i_max = 0;
+
+        p_block->i_offset = i_offset;
+        for( uint32_t j = 0; j < i_entries; j++ )
+        {
+            i_min = __MIN( i_min, p_sizes[j] );
+            i_max = __MAX( i_max, p_sizes[j] );
+            i_offset += p_sizes[j];
+        }
+
+        p_block->i_base = i_min;
+        p_block->i_bits = stdc_bit_width( i_max - i_min );
+        p_block->i_word = i_words;
+        i_words += (i_entries * p_block->i_bits + 31) / 32;
+        if( unlikely(i_words > UINT32_MAX) )
+        {
+            free( p_table->p_blocks );
+            p_table->p_blocks = NULL;
+            return VLC_EGENERIC;
+        }
+    }
+
+    /* second pass: pack the differences */
+    if( i_words > 0 )
+    {
+        p_table->i_data = i_words + 1;
+        p_table->p_data = calloc( p_table->i_data, sizeof(*p_table->p_data) );
+        if( unlikely(p_table->p_data == NULL) )
+        {
+            free( p_table->p_blocks );
+            p_table->p_blocks = NULL;
+            return VLC_ENOMEM;
+        }
+
+        for( size_t i = 0; i < i_blocks; i++ )
+        {
+            const mp4_sample_block_t *p_block = &p_table->p_blocks[i];
+            const uint32_t *p_sizes = &pi_sizes[i << MP4_SAMPLES_BLOCK_LOG2];
+            const uint32_t i_entries = __MIN( MP4_SAMPLES_BLOCK,
+                                              i_count - (i << MP4_SAMPLES_BLOCK_LOG2) );
+
+            if( p_block->i_bits == 0 )
+                continue;
+            for( uint32_t j = 0; j < i_entries; j++ )
+                PackBits( p_table->p_data,
+                          (uint64_t)p_block->i_word * 32 + j * p_block->i_bits,
+                          p_sizes[j] - p_block->i_base );
+        }
+    }
+
+    return VLC_SUCCESS;
+}
+
+void MP4_SampleSizes_Clean( mp4_sample_sizes_t *p_table )
+{
+    free( p_table->p_blocks );
+    free( p_table->p_data );
+    p_table->p_blocks = NULL;
+    p_table->p_data = NULL;
+    p_table->i_count = 0;
+}
+
+uint32_t MP4_SampleSizes_Get( const mp4_sample_sizes_t *p_table, uint32_t i_sample )
+{
+    assert( i_sample < p_table->i_count );
+
+    const mp4_sample_block_t *p_block =
+        &p_table->p_blocks[i_sample >> MP4_SAMPLES_BLOCK_LOG2];
+    if( p_block->i_bits == 0 )
+        return p_block->i_base;
+
+    uint32_t j = i_sample & (MP4_SAMPLES_BLOCK - 1);
+    return p_block->i_base + UnpackBits( p_table->p_data,
+                                         (uint64_t)p_block->i_word * 32 + j * p_block->i_bits,
+                                         p_block->i_bits );
+}
+
+/* sum of the sizes of all the samples before i_sample */
+static uint64_t SampleOffset( const mp4_sample_sizes_t *p_table, uint32_t i_sample )
+{
+    if( i_sample >= p_table->i_count )
+    {
+        if( p_table->i_count == 0 )
+            return 0;
+        i_sample = p_table->i_count - 1;
+        return SampleOffset( p_table, i_sample ) +
+               MP4_SampleSizes_Get( p_table, i_sample );
+    }
+
+    const mp4_sample_block_t *p_block =
+        &p_table->p_blocks[i_sample >> MP4_SAMPLES_BLOCK_LOG2];
+    const uint32_t i_entries = i_sample & (MP4_SAMPLES_BLOCK - 1);
+    uint64_t i_offset = p_block->i_offset + (uint64_t)i_entries * p_block->i_base;
+
+    if( p_block->i_bits > 0 )
+    {
+        uint64_t i_bit = (uint64_t)p_block->i_word * 32;
+        for( uint32_t j = 0; j < i_entries; j++, i_bit += p_block->i_bits )
+            i_offset += UnpackBits( p_table->p_data, i_bit, p_block->i_bits );
+    }
+    return i_offset;
+}
+
+uint64_t MP4_SampleSizes_Sum( const mp4_sample_sizes_t *p_table,
+                              uint32_t i_first, uint32_t i_last )
+{
+    if( i_last <= i_first )
+        return 0;
+    return SampleOffset( p_table, i_last ) - SampleOffset( p_table, i_first );
+}
+
+size_t MP4_SampleSizes_Memory( const mp4_sample_sizes_t *p_table )
+{
+    return sizeof(*p_table) +
+           (((size_t)p_table->i_count + MP4_SAMPLES_BLOCK - 1) >> MP4_SAMPLES_BLOCK_LOG2)
+           * sizeof(*p_table->p_blocks) +
+           p_table->i_data * sizeof(*p_table->p_data);
+}
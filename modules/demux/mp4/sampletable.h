@@ -0,0 +1,70 @@
+/*****************************************************************************
+ * sampletable.h : MP4 compact sample size table
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_MP4_SAMPLETABLE_H_
+#define VLC_MP4_SAMPLETABLE_H_
+
+#include <vlc_common.h>
+
+#define MP4_SAMPLES_BLOCK_LOG2 6
+#define MP4_SAMPLES_BLOCK (1 << MP4_SAMPLES_BLOCK_LOG2)
+
+/* Samples sizes, by blocks of MP4_SAMPLES_BLOCK entries stored as
+ * bit packed differences from the smallest size of the block.
+ * Blocks of identical sizes take no packed data at all. */
+typedef struct
+{
+    uint64_t i_offset;  /* sum of the sizes of all previous samples */
+    uint32_t i_base;    /* smallest size in the block */
+    uint32_t i_word;    /* first word of the packed differences */
+    uint8_t  i_bits;    /* bits per packed difference */
+} mp4_sample_block_t;
+
+typedef struct
+{
+    uint32_t i_count;
+    mp4_sample_block_t *p_blocks;
+    uint32_t *p_data;
+    size_t i_data;
+} mp4_sample_sizes_t;
+
+/**
+ * Builds the table from a stsz/stz2 entries array.
+ */
+int MP4_SampleSizes_Init( mp4_sample_sizes_t *, const uint32_t *pi_sizes,
+                          uint32_t i_count );
+void MP4_SampleSizes_Clean( mp4_sample_sizes_t * );
+
+/**
+ * Returns the size of the sample at the given index.
+ */
+uint32_t MP4_SampleSizes_Get( const mp4_sample_sizes_t *, uint32_t i_sample );
+
+/**
+ * Returns the sum of the sizes of the samples in [i_first, i_last).
+ */
+uint64_t MP4_SampleSizes_Sum( const mp4_sample_sizes_t *,
+                              uint32_t i_first, uint32_t i_last );
+
+/**
+ * Returns the memory used by the table, in bytes.
+ */
+size_t MP4_SampleSizes_Memory( const mp4_sample_sizes_t * );
+
+#endif
@@ -39,11 +39,13 @@
 #include <vlc_input.h>
 
 #include "../../packetizer/a52.h"
+#include "../../packetizer/adts.h"
 #include "../../packetizer/dts_header.h"
 #include "../../packetizer/mpegaudio.h"
 #include "../../meta_engine/ID3Tag.h"
 #include "../../meta_engine/ID3Text.h"
 #include "../../meta_engine/ID3Meta.h"
+#include "es_index.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -56,6 +58,11 @@ static void Close    ( vlc_object_t * );
 #define FPS_LONGTEXT N_("This is the frame rate used as a fallback when " \
     "playing MPEG video elementary streams.")
 
+#define INDEX_TEXT N_("Index frames in the background")
+#define INDEX_LONGTEXT N_("Find the frame positions of MPEG audio, ADTS AAC " \
+    "and A/52 files in a separate thread during playback, for exact seeking " \
+    "and duration of variable bitrate files.")
+
 vlc_module_begin ()
     set_subcategory( SUBCAT_INPUT_DEMUX )
     set_description( N_("MPEG-I/II/4 / A52 / DTS / MLP audio" ) )
@@ -70,6 +77,8 @@ vlc_module_begin ()
                   "dts",
                   "mlp", "thd" )
 
+    add_bool( "es-index", false, INDEX_TEXT, INDEX_LONGTEXT )
+
     add_submodule()
     set_description( N_("MPEG-4 video" ) )
     set_capability( "demux", 7 )
@@ -97,6 +106,8 @@ typedef struct
     const char *psz_name;
     int  (*pf_probe)( demux_t *p_demux, uint64_t *pi_offset );
     int  (*pf_init)( demux_t *p_demux );
+    es_index_parse_cb pf_frame; /* frame header parser for indexing */
+    unsigned   i_frame_header;
 } codec_t;
 
 typedef struct
@@ -366,6 +377,8 @@ typedef struct
     float rgf_replay_peak[AUDIO_REPLAY_GAIN_MAX];
 
     sync_table_t mllt;
+    es_index_t *p_index;
+    bool        b_index_length;
     struct
     {
         size_t i_count;
@@ -376,13 +389,16 @@ typedef struct
 
 static int MpgaProbe( demux_t *p_demux, uint64_t *pi_offset );
 static int MpgaInit( demux_t *p_demux );
+static int MpgaFrameParse( const uint8_t *, unsigned *, unsigned * );
 
 static int AacProbe( demux_t *p_demux, uint64_t *pi_offset );
 static int AacInit( demux_t *p_demux );
+static int AacFrameParse( const uint8_t *, unsigned *, unsigned * );
 
 static int EA52Probe( demux_t *p_demux, uint64_t *pi_offset );
 static int A52Probe( demux_t *p_demux, uint64_t *pi_offset );
 static int A52Init( demux_t *p_demux );
+static int A52FrameParse( const uint8_t *, unsigned *, unsigned * );
 
 static int DtsProbe( demux_t *p_demux, uint64_t *pi_offset );
 static int DtsInit( demux_t *p_demux );
@@ -395,23 +411,56 @@ static bool Parse( demux_t *p_demux, block_t **pp_output );
 static int SeekByMlltTable( sync_table_t *, vlc_tick_t *, uint64_t * );
 
 static const codec_t p_codecs[] = {
-    { VLC_CODEC_MP4A, false, "mp4 audio",  AacProbe,  AacInit },
-    { VLC_CODEC_MPGA, false, "mpeg audio", MpgaProbe, MpgaInit },
-    { VLC_CODEC_A52, true,  "a52 audio",  A52Probe,  A52Init },
-    { VLC_CODEC_EAC3, true,  "eac3 audio", EA52Probe, A52Init },
-    { VLC_CODEC_DTS, false, "dts audio",  DtsProbe,  DtsInit },
-    { VLC_CODEC_MLP, false, "mlp audio",  MlpProbe,  MlpInit },
-    { VLC_CODEC_TRUEHD, false, "TrueHD audio",  ThdProbe,  MlpInit },
-
-    { 0, false, NULL, NULL, NULL }
+    { VLC_CODEC_MP4A, false, "mp4 audio",  AacProbe,  AacInit, AacFrameParse, VLC_ADTS_MIN_HEADER_SIZE },
+    { VLC_CODEC_MPGA, false, "mpeg audio", MpgaProbe, MpgaInit, MpgaFrameParse, 4 },
+    { VLC_CODEC_A52, true,  "a52 audio",  A52Probe,  A52Init, A52FrameParse, VLC_A52_MIN_HEADER_SIZE },
+    { VLC_CODEC_EAC3, true,  "eac3 audio", EA52Probe, A52Init, A52FrameParse, VLC_A52_MIN_HEADER_SIZE },
+    { VLC_CODEC_DTS, false, "dts audio",  DtsProbe,  DtsInit, NULL, 0 },
+    { VLC_CODEC_MLP, false, "mlp audio",  MlpProbe,  MlpInit, NULL, 0 },
+    { VLC_CODEC_TRUEHD, false, "TrueHD audio",  ThdProbe,  MlpInit, NULL, 0 },
+
+    { 0, false, NULL, NULL, NULL, NULL, 0 }
 };
 
 static int VideoInit( demux_t *p_demux );
 
 static const codec_t codec_m4v = {
-    VLC_CODEC_MP4V, false, "mp4 video", NULL,  VideoInit
+    VLC_CODEC_MP4V, false, "mp4 video", NULL,  VideoInit, NULL, 0
 };
 
+/*****************************************************************************
+ * IndexInit: starts the frame index of variable bitrate streams
+ *****************************************************************************/
+static void IndexInit( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    bool b_fastseek = false;
+
+    if( !p_sys->codec.pf_frame || p_sys->mllt.p_bits ||
+        p_demux->b_preparsing || !p_demux->psz_url ||
+        !var_InheritBool( p_demux, "es-index" ) )
+        return;
+
+    /* The index reads the whole file again */
+    vlc_stream_Control( p_demux->s, STREAM_CAN_FASTSEEK, &b_fastseek );
+    if( !b_fastseek )
+        return;
+
+    /* Constant bitrate files are already seeked exactly */
+    if( p_sys->codec.i_codec == VLC_CODEC_MP3 || p_sys->codec.i_codec == VLC_CODEC_MPGA )
+    {
+        const struct xing_info_s *xing = &p_sys->xing;
+        if( xing->infotag == VLC_FOURCC('I','n','f','o') ||
+            xing->brmode == XING_MODE_CBR || xing->brmode == XING_MODE_CBR_2PASS )
+            return;
+    }
+
+    p_sys->p_index = es_index_New( VLC_OBJECT(p_demux), p_demux->psz_url,
+                                   p_sys->i_stream_offset,
+                                   p_sys->codec.i_frame_header,
+                                   p_sys->codec.pf_frame );
+}
+
 /*****************************************************************************
  * OpenCommon: initializes demux structures
  *****************************************************************************/
@@ -490,6 +539,8 @@ static int OpenCommon( demux_t *p_demux,
             break;
     }
 
+    IndexInit( p_demux );
+
     return VLC_SUCCESS;
 }
 static int OpenAudio( vlc_object_t *p_this )
@@ -622,6 +673,8 @@ static void Close( vlc_object_t * p_this )
     TAB_CLEAN( p_sys->chapters.i_count, p_sys->chapters.p_entry );
     if( p_sys->mllt.p_bits )
         free( p_sys->mllt.p_bits );
+    if( p_sys->p_index )
+        es_index_Delete( p_sys->p_index );
     demux_PacketizerDestroy( p_sys->p_packetizer );
     free( p_sys );
 }
@@ -661,6 +714,11 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
     demux_sys_t *p_sys  = p_demux->p_sys;
     bool *pb_bool;
 
+    /* The index knows the exact duration once complete */
+    if( p_sys->p_index && !p_sys->b_index_length )
+        p_sys->b_index_length =
+            !es_index_GetLength( p_sys->p_index, &p_sys->i_duration );
+
     switch( i_query )
     {
         case DEMUX_HAS_UNSUPPORTED_META:
@@ -732,6 +790,17 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             }
             va_end( ap );
 
+            /* Try to use the frame index, then present from the exact time */
+            vlc_tick_t i_frame_time;
+            if( p_sys->p_index && i_time != VLC_TICK_INVALID &&
+                !es_index_Lookup( p_sys->p_index, i_time, &i_frame_time, &i_offset ) &&
+                !MovetoTimePos( p_demux, i_frame_time, i_offset ) )
+            {
+                es_out_Control( p_demux->out, ES_OUT_SET_NEXT_DISPLAY_TIME,
+                                VLC_TICK_0 + i_time );
+                return VLC_SUCCESS;
+            }
+
             /* Try to use ID3 table */
             if( !SeekByMlltTable( &p_sys->mllt, &i_time, &i_offset ) )
                 return MovetoTimePos( p_demux, i_time, i_offset );
@@ -1199,6 +1268,20 @@ static int MpgaProbe( demux_t *p_demux, uint64_t *pi_offset )
     return VLC_SUCCESS;
 }
 
+static int MpgaFrameParse( const uint8_t *p_peek, unsigned *pi_samples, unsigned *pi_rate )
+{
+    struct mpga_frameheader_s mpgah;
+
+    if( !MpgaCheckSync( p_peek ) ||
+        mpga_decode_frameheader( GetDWBE( p_peek ), &mpgah ) ||
+        mpgah.i_bit_rate == 0 /* free format */ )
+        return -1;
+
+    *pi_samples = mpgah.i_samples_per_frame;
+    *pi_rate = mpgah.i_sample_rate;
+    return mpgah.i_frame_size;
+}
+
 static int SeekByMlltTable( sync_table_t *mllt, vlc_tick_t *pi_time, uint64_t *pi_offset )
 {
     if( !mllt->p_bits )
@@ -1484,6 +1567,19 @@ static int AacInit( demux_t *p_demux )
     return VLC_SUCCESS;
 }
 
+/* ADTS only, LOAS is not indexed */
+static int AacFrameParse( const uint8_t *p_peek, unsigned *pi_samples, unsigned *pi_rate )
+{
+    vlc_adts_header_t header;
+
+    if( vlc_adts_header_Parse( &header, p_peek ) != VLC_SUCCESS )
+        return -1;
+
+    *pi_samples = 1024 * header.i_raw_blocks;
+    *pi_rate = header.i_rate;
+    return header.i_frame_size;
+}
+
 
 /*****************************************************************************
  * A52
@@ -1509,6 +1605,25 @@ static int A52CheckSync( const uint8_t *p_peek, bool *p_big_endian, unsigned *pi
         *pi_samples = header.i_samples;
     return header.i_size;
 }
+static int A52FrameParse( const uint8_t *p_peek, unsigned *pi_samples, unsigned *pi_rate )
+{
+    vlc_a52_header_t header;
+    uint8_t p_tmp[VLC_A52_MIN_HEADER_SIZE];
+
+    if( p_peek[0] != 0x0b || p_peek[1] != 0x77 )
+    {
+        swab( p_peek, p_tmp, VLC_A52_MIN_HEADER_SIZE );
+        p_peek = p_tmp;
+    }
+
+    if( vlc_a52_header_Parse( &header, p_peek, VLC_A52_MIN_HEADER_SIZE ) )
+        return -1;
+
+    *pi_samples = header.i_samples;
+    *pi_rate = header.i_rate;
+    return header.i_size;
+}
+
 static int EA52CheckSyncProbe( const uint8_t *p_peek, unsigned *pi_samples )
 {
     bool b_dummy;
@@ -0,0 +1,304 @@
+/*****************************************************************************
+ * es_index.c: audio elementary stream seek index
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_stream.h>
+#include <vlc_threads.h>
+#include <vlc_interrupt.h>
+
+#include <string.h>
+
+#include "es_index.h"
+
+#define ES_INDEX_MAX_ENTRIES 4096
+#define ES_INDEX_BUFFER      (64 * 1024)
+#define ES_INDEX_MAX_FRAME   (16 * 1024) /* larger frames are sync errors */
+
+typedef struct
+{
+    vlc_tick_t i_time;
+    uint64_t   i_pos;
+} es_index_entry_t;
+
+struct es_index_t
+{
+    vlc_object_t     *p_obj;
+    char             *psz_url;
+    uint64_t          i_start;
+    unsigned          i_header_size;
+    es_index_parse_cb pf_parse;
+
+    vlc_thread_t      thread;
+    vlc_interrupt_t  *p_interrupt;
+
+    vlc_mutex_t       lock;
+    /* protected by lock */
+    es_index_entry_t *p_entries;
+    size_t            i_entries;
+    unsigned          i_step;     /* frames between entries */
+    vlc_tick_t        i_indexed;  /* time up to which frames were seen */
+    bool              b_done;
+};
+
+/* Frame counting, by the thread only */
+typedef struct
+{
+    uint64_t   i_frames;
+    vlc_tick_t i_time_base; /* time of the last sample rate change */
+    uint64_t   i_samples;   /* since then */
+    unsigned   i_rate;
+} es_index_clock_t;
+
+static vlc_tick_t ClockGet( const es_index_clock_t *p_clock )
+{
+    if( p_clock->i_rate == 0 )
+        return p_clock->i_time_base;
+    return p_clock->i_time_base +
+           vlc_tick_from_samples( p_clock->i_samples, p_clock->i_rate );
+}
+
+static void AddFrame( es_index_t *p_index, es_index_clock_t *p_clock,
+                      uint64_t i_pos, unsigned i_samples, unsigned i_rate )
+{
+    if( i_rate != p_clock->i_rate )
+    {
+        p_clock->i_time_base = ClockGet( p_clock );
+        p_clock->i_samples = 0;
+        p_clock->i_rate = i_rate;
+    }
+    const vlc_tick_t i_time = ClockGet( p_clock );
+
+    vlc_mutex_lock( &p_index->lock );
+    if( p_clock->i_frames % p_index->i_step == 0 )
+    {
+        if( p_index->i_entries == ES_INDEX_MAX_ENTRIES )
+        {
+            /* Keep every other entry, they are then twice as far apart */
+            for( size_t i = 0; i < ES_INDEX_MAX_ENTRIES / 2; i++ )
+                p_index->p_entries[i] = p_index->p_entries[2 * i];
+            p_index->i_entries = ES_INDEX_MAX_ENTRIES / 2;
+            p_index->i_step *= 2;
+        }
+        if( p_clock->i_frames % p_index->i_step == 0 )
+        {
+            p_index->p_entries[p_index->i_entries].i_time = i_time;
+            p_index->p_entries[p_index->i_entries].i_pos = i_pos;
+            p_index->i_entries++;
+        }
+    }
+    p_clock->i_samples += i_samples;
+    p_clock->i_frames++;
+    p_index->i_indexed = ClockGet( p_clock );
+    vlc_mutex_unlock( &p_index->lock );
+}
+
+static void Scan( es_index_t *p_index, stream_t *s )
+{
+    const unsigned i_header = p_index->i_header_size;
+    uint8_t *p_buf = malloc( ES_INDEX_BUFFER );
+    size_t i_buf = 0;
+    uint64_t i_buf_pos = p_index->i_start; /* of p_buf[0] */
+    size_t i_resync = 0; /* bytes skipped since the last frame */
+    uint64_t i_skipped = 0;
+    bool b_eof = false;
+    es_index_clock_t clock = { 0 };
+
+    if( unlikely(p_buf == NULL) ||
+        vlc_stream_Seek( s, p_index->i_start ) != VLC_SUCCESS )
+    {
+        free( p_buf );
+        return;
+    }
+
+    while( !vlc_killed() && !b_eof )
+    {
+        ssize_t i_read = vlc_stream_Read( s, &p_buf[i_buf], ES_INDEX_BUFFER - i_buf );
+        if( i_read <= 0 )
+        {
+            if( i_read < 0 || vlc_killed() )
+                break;
+            b_eof = true;
+        }
+        else
+            i_buf += i_read;
+
+        size_t i = 0;
+        while( i + i_header <= i_buf )
+        {
+            unsigned i_samples, i_rate;
+            int i_size = p_index->pf_parse( &p_buf[i], &i_samples, &i_rate );
+            bool b_frame = i_size > 0 && i_size <= ES_INDEX_MAX_FRAME &&
+                           i_samples > 0 && i_rate > 0;
+
+            if( b_frame )
+            {
+                /* Wait for the next header, unless at the end */
+                if( i + i_size + i_header > i_buf && !b_eof )
+                    break;
+
+                /* After a resync, the next frame must match too */
+                unsigned i_dummy;
+                if( i_resync > 0 && i + i_size + i_header <= i_buf &&
+                    p_index->pf_parse( &p_buf[i + i_size], &i_dummy, &i_dummy ) <= 0 )
+                    b_frame = false;
+            }
+
+            if( !b_frame )
+            {
+                /* Skip tags and garbage, even in the middle of the file: the
+                 * index is only complete at the end of the stream */
+                i_resync++;
+                i_skipped++;
+                i++;
+                continue;
+            }
+
+            if( i + i_size > i_buf )
+                break; /* truncated last frame */
+
+            AddFrame( p_index, &clock, i_buf_pos + i - p_index->i_start,
+                      i_samples, i_rate );
+            i_resync = 0;
+            i += i_size;
+        }
+
+        i_buf -= i;
+        i_buf_pos += i;
+        memmove( p_buf, &p_buf[i], i_buf );
+    }
+    free( p_buf );
+
+    if( b_eof )
+    {
+        vlc_mutex_lock( &p_index->lock );
+        p_index->b_done = true;
+        vlc_mutex_unlock( &p_index->lock );
+    }
+
+    msg_Dbg( p_index->p_obj, "indexed %" PRIu64 " frames, %" PRId64 " s, "
+             "skipped %" PRIu64 " bytes%s",
+             clock.i_frames, SEC_FROM_VLC_TICK( ClockGet( &clock ) ),
+             i_skipped, b_eof ? "" : " (interrupted)" );
+}
+
+static void *Thread( void *data )
+{
+    es_index_t *p_index = data;
+
+    vlc_thread_set_name( "vlc-es-index" );
+    vlc_interrupt_set( p_index->p_interrupt );
+
+    stream_t *s = vlc_stream_NewURL( p_index->p_obj, p_index->psz_url );
+    if( s != NULL )
+    {
+        Scan( p_index, s );
+        vlc_stream_Delete( s );
+    }
+    return NULL;
+}
+
+es_index_t * es_index_New( vlc_object_t *p_obj, const char *psz_url,
+                           uint64_t i_start, unsigned i_header_size,
+                           es_index_parse_cb pf_parse )
+{
+    es_index_t *p_index = malloc( sizeof(*p_index) );
+    if( unlikely(p_index == NULL) )
+        return NULL;
+
+    p_index->p_obj = p_obj;
+    p_index->psz_url = strdup( psz_url );
+    p_index->i_start = i_start;
+    p_index->i_header_size = i_header_size;
+    p_index->pf_parse = pf_parse;
+    p_index->p_interrupt = vlc_interrupt_create();
+    p_index->p_entries = vlc_alloc( ES_INDEX_MAX_ENTRIES, sizeof(es_index_entry_t) );
+    p_index->i_entries = 0;
+    p_index->i_step = 1;
+    p_index->i_indexed = 0;
+    p_index->b_done = false;
+    vlc_mutex_init( &p_index->lock );
+
+    if( unlikely(p_index->psz_url == NULL || p_index->p_interrupt == NULL ||
+                 p_index->p_entries == NULL) ||
+        vlc_clone( &p_index->thread, Thread, p_index ) )
+    {
+        if( p_index->p_interrupt != NULL )
+            vlc_interrupt_destroy( p_index->p_interrupt );
+        free( p_index->p_entries );
+        free( p_index->psz_url );
+        free( p_index );
+        return NULL;
+    }
+    return p_index;
+}
+
+void es_index_Delete( es_index_t *p_index )
+{
+    vlc_interrupt_kill( p_index->p_interrupt );
+    vlc_join( p_index->thread, NULL );
+
+    vlc_interrupt_destroy( p_index->p_interrupt );
+    free( p_index->p_entries );
+    free( p_index->psz_url );
+    free( p_index );
+}
+
+int es_index_Lookup( es_index_t *p_index, vlc_tick_t i_time,
+                     vlc_tick_t *pi_time, uint64_t *pi_pos )
+{
+    int i_ret = VLC_EGENERIC;
+
+    vlc_mutex_lock( &p_index->lock );
+    if( p_index->i_entries > 0 &&
+        ( i_time < p_index->i_indexed || p_index->b_done ) )
+    {
+        size_t i_low = 0, i_high = p_index->i_entries;
+        while( i_high - i_low > 1 )
+        {
+            size_t i_mid = i_low + (i_high - i_low) / 2;
+            if( p_index->p_entries[i_mid].i_time <= i_time )
+                i_low = i_mid;
+            else
+                i_high = i_mid;
+        }
+        *pi_time = p_index->p_entries[i_low].i_time;
+        *pi_pos = p_index->p_entries[i_low].i_pos;
+        i_ret = VLC_SUCCESS;
+    }
+    vlc_mutex_unlock( &p_index->lock );
+    return i_ret;
+}
+
+int es_index_GetLength( es_index_t *p_index, vlc_tick_t *pi_length )
+{
+    int i_ret = VLC_EGENERIC;
+
+    vlc_mutex_lock( &p_index->lock );
+    if( p_index->b_done && p_index->i_indexed > 0 )
+    {
+        *pi_length = p_index->i_indexed;
+        i_ret = VLC_SUCCESS;
+    }
+    vlc_mutex_unlock( &p_index->lock );
+    return i_ret;
+}
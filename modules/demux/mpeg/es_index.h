@@ -0,0 +1,66 @@
+/*****************************************************************************
+ * es_index.h: audio elementary stream seek index
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_ES_INDEX_H
+#define VLC_ES_INDEX_H
+
+/*
+ * Frame index of an audio elementary stream, built by a background thread
+ * walking the frame headers from its own stream. It keeps the time and
+ * offset of one frame every few, doubling that interval whenever it holds
+ * too many entries, so that its size is bounded whatever the file length.
+ */
+typedef struct es_index_t es_index_t;
+
+/**
+ * Parses the frame header at p.
+ *
+ * \return the frame size in bytes, or -1 if there is no valid header
+ */
+typedef int (*es_index_parse_cb)( const uint8_t *p, unsigned *pi_samples,
+                                  unsigned *pi_rate );
+
+/**
+ * Starts indexing.
+ *
+ * \param i_start offset of the first frame, offsets are relative to it
+ * \param i_header_size bytes needed by pf_parse
+ */
+es_index_t * es_index_New( vlc_object_t *, const char *psz_url,
+                           uint64_t i_start, unsigned i_header_size,
+                           es_index_parse_cb pf_parse );
+void es_index_Delete( es_index_t * );
+
+/**
+ * Finds the last indexed frame not after the given time.
+ *
+ * \param i_time time from the first frame
+ * \param pi_time time of the frame found
+ * \param pi_pos offset of the frame found
+ * \return VLC_SUCCESS, or VLC_EGENERIC if that part is not indexed (yet)
+ */
+int es_index_Lookup( es_index_t *, vlc_tick_t i_time,
+                     vlc_tick_t *pi_time, uint64_t *pi_pos );
+
+/**
+ * Gets the exact duration, once the whole stream was indexed.
+ */
+int es_index_GetLength( es_index_t *, vlc_tick_t *pi_length );
+
+#endif
@@ -46,6 +46,7 @@
 #include "ts_hotfixes.h"
 #include "ts_sl.h"
 #include "ts_metadata.h"
+#include "ts_index.h"
 #include "sections.h"
 #include "pes.h"
 #include "timestamps.h"
@@ -123,6 +124,13 @@ static void Close ( vlc_object_t * );
 #define TS_OFFSETFIX_TEXT   "Try to fix too early PCR (or late DTS)"
 #define TS_GENERATED_PCR_OFFSET_TEXT "Offset in ms for generated PCR"
 
+#define INDEX_TEXT N_("Build a seek index")
+#define INDEX_LONGTEXT N_( \
+    "Find the PCR and random access points of seekable files in the " \
+    "background, and keep them in the cache directory for the next " \
+    "playback. Seeking then jumps to the right position without searching " \
+    "the file." )
+
 #define PCR_TEXT N_("Trust in-stream PCR")
 #define PCR_LONGTEXT N_("Use the stream PCR as a reference.")
 
@@ -157,6 +165,7 @@ vlc_module_begin ()
 
     add_bool( "ts-split-es", true, SPLIT_ES_TEXT, SPLIT_ES_LONGTEXT )
     add_bool( "ts-seek-percent", false, SEEK_PERCENT_TEXT, SEEK_PERCENT_LONGTEXT )
+    add_bool( "ts-index", false, INDEX_TEXT, INDEX_LONGTEXT )
     add_bool( "ts-cc-check", true, CC_CHECK_TEXT, CC_CHECK_LONGTEXT )
     add_bool( "ts-pmtfix-waitdata", true, TS_SKIP_GHOST_PROGRAM_TEXT, NULL )
     add_bool( "ts-patfix", true, TS_PATFIX_TEXT, NULL )
@@ -194,7 +203,8 @@ static bool GatherPESData( demux_t *p_demux, ts_pid_t *, block_t *, size_t );
 static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_prg, stime_t i_pcr );
 
 static block_t* ReadTSPacket( demux_t *p_demux );
-static int SeekToTime( demux_t *p_demux, const ts_pmt_t *, stime_t time );
+static size_t ReadTSPacketBatch( demux_t *p_demux, block_t **pp_pkts );
+static int SeekToTime( demux_t *p_demux, const ts_pmt_t *, stime_t time, stime_t *pi_pcr );
 static void ReadyQueuesPostSeek( demux_t *p_demux );
 static void PCRHandle( demux_t *p_demux, ts_pid_t *, stime_t );
 static void PCRFixHandle( demux_t *, ts_pmt_t *, block_t * );
@@ -509,6 +519,7 @@ static int Open( vlc_object_t *p_this )
     p_sys->b_canfastseek = false;
     p_sys->b_lowdelay = var_InheritBool( p_demux, "low-delay" );
     p_sys->b_ignore_time_for_positions = var_InheritBool( p_demux, "ts-seek-percent" );
+    p_sys->b_index = var_InheritBool( p_demux, "ts-index" );
     p_sys->b_cc_check = var_InheritBool( p_demux, "ts-cc-check" );
 
     p_sys->standard = TS_STANDARD_AUTO;
@@ -640,13 +651,26 @@ static int Demux( demux_t *p_demux )
         p_sys->patfix.status = PAT_FIXTRIED;
     }
 
+    /* Packets read ahead and descrambled together */
+    block_t *batch[TS_CSA_BATCH_MAX];
+    size_t i_batch = 0, i_batch_pos = 0;
+
     /* We read at most 100 TS packet or until a frame is completed */
-    for( unsigned i_pkt = 0; i_pkt < p_sys->i_ts_read; i_pkt++ )
+    for( unsigned i_pkt = 0; i_pkt < p_sys->i_ts_read || i_batch_pos < i_batch; i_pkt++ )
     {
         bool         b_frame = false;
         int          i_header = 0;
         block_t     *p_pkt;
-        if( !(p_pkt = ReadTSPacket( p_demux )) )
+        if( p_sys->csa && i_batch_pos == i_batch )
+        {
+            i_batch = ReadTSPacketBatch( p_demux, batch );
+            i_batch_pos = 0;
+        }
+        if( p_sys->csa )
+            p_pkt = i_batch_pos < i_batch ? batch[i_batch_pos++] : NULL;
+        else
+            p_pkt = ReadTSPacket( p_demux );
+        if( !p_pkt )
         {
             return VLC_DEMUXER_EOF;
         }
@@ -738,6 +762,14 @@ static int Demux( demux_t *p_demux )
                 continue;
             }
 
+            /* The ES was selected after its packet was read ahead, and not
+             * descrambled */
+            if( p_sys->csa && (p_pkt->p_buffer[3]&0x80) )
+            {
+                block_Release( p_pkt );
+                continue;
+            }
+
             if( p_pid->u.p_stream->transport == TS_TRANSPORT_PES )
             {
                 b_frame = GatherPESData( p_demux, p_pid, p_pkt, i_header );
@@ -772,7 +804,9 @@ static int Demux( demux_t *p_demux )
             break;
         }
 
-        if( b_frame || ( b_wait_es && p_sys->i_pmt_es > 0 ) )
+        /* Do not drop the packets read ahead */
+        if( ( b_frame || ( b_wait_es && p_sys->i_pmt_es > 0 ) ) &&
+            i_batch_pos == i_batch )
             break;
     }
 
@@ -984,7 +1018,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
         {
             time_t i_time, i_length;
             if( !EITCurrentEventTime( p_pmt, p_sys, &i_time, &i_length ) &&
-                 i_length > 0 && !SeekToTime( p_demux, p_pmt, (int64_t)(TO_SCALE( vlc_tick_from_sec( i_length * f ))) ) )
+                 i_length > 0 && !SeekToTime( p_demux, p_pmt, (int64_t)(TO_SCALE( vlc_tick_from_sec( i_length * f ))), NULL ) )
             {
                 ReadyQueuesPostSeek( p_demux );
                 es_out_Control( p_demux->out, ES_OUT_SET_NEXT_DISPLAY_TIME,
@@ -1002,7 +1036,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             i64 = p_pmt->pcr.i_first + (int64_t)(i_length * f);
             if( i64 <= p_pmt->i_last_dts )
             {
-                if( !SeekToTime( p_demux, p_pmt, i64 ) )
+                if( !SeekToTime( p_demux, p_pmt, i64, &i64 ) )
                 {
                     ReadyQueuesPostSeek( p_demux );
                     es_out_Control( p_demux->out, ES_OUT_SET_NEXT_DISPLAY_TIME, FROM_SCALE(i64) );
@@ -1023,13 +1057,14 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
     case DEMUX_SET_TIME:
     {
         vlc_tick_t i_time = va_arg( args, vlc_tick_t );
+        stime_t i_pcr;
 
         if( p_sys->b_canseek && p_pmt && p_pmt->pcr.i_first > -1 &&
-           !SeekToTime( p_demux, p_pmt, p_pmt->pcr.i_first + TO_SCALE(i_time) ) )
+           !SeekToTime( p_demux, p_pmt, p_pmt->pcr.i_first + TO_SCALE(i_time), &i_pcr ) )
         {
             ReadyQueuesPostSeek( p_demux );
             es_out_Control( p_demux->out, ES_OUT_SET_NEXT_DISPLAY_TIME,
-                            FROM_SCALE(p_pmt->pcr.i_first) + i_time - VLC_TICK_0 );
+                            FROM_SCALE(i_pcr) );
             return VLC_SUCCESS;
         }
         break;
@@ -1804,6 +1839,47 @@ static void PESDataChainHandle( vlc_object_t *p_obj, void *priv, block_t *p_data
     ParsePESDataChain( (demux_t *)p_obj, (ts_pid_t *) priv, p_data, i_flags, i_appendpcr );
 }
 
+/* Reads a batch of packets, and descrambles them all at once, which is much
+ * faster than packet per packet. This delays the demuxing by a few dozens of
+ * packets at most. */
+static size_t ReadTSPacketBatch( demux_t *p_demux, block_t **pp_pkts )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    uint8_t *pp_scrambled[TS_CSA_BATCH_MAX];
+    size_t i_count = 0, i_scrambled = 0;
+    size_t i_max = __MIN( csa_GetBatchSize( p_sys->csa ), TS_CSA_BATCH_MAX );
+
+    while( i_count < i_max )
+    {
+        block_t *p_pkt = ReadTSPacket( p_demux );
+        if( !p_pkt )
+            break;
+        pp_pkts[i_count++] = p_pkt;
+
+        /* Truncated and uncorrected packets are dropped anyway */
+        if( p_pkt->i_buffer < TS_PACKET_SIZE_188 ||
+            (p_pkt->p_buffer[1]&0x80) || !(p_pkt->p_buffer[3]&0x80) )
+            continue;
+
+        /* So are the packets of unselected ES */
+        const ts_pid_t *p_pid = GetPID( p_sys, PIDGet( p_pkt ) );
+        if( p_pid->type == TYPE_STREAM && !p_sys->b_access_control &&
+            !(p_pid->i_flags & FLAG_FILTERED) )
+            continue;
+
+        pp_scrambled[i_scrambled++] = p_pkt->p_buffer;
+    }
+
+    if( i_scrambled > 0 )
+    {
+        vlc_mutex_lock( &p_sys->csa_lock );
+        csa_DecryptBatch( p_sys->csa, pp_scrambled, i_scrambled,
+                          p_sys->i_csa_pkt_size );
+        vlc_mutex_unlock( &p_sys->csa_lock );
+    }
+    return i_count;
+}
+
 static block_t* ReadTSPacket( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -2004,14 +2080,31 @@ static void ReadyQueuesPostSeek( demux_t *p_demux )
     }
 }
 
-static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaledtime )
+static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaledtime,
+                       stime_t *pi_pcr )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
+    if( pi_pcr )
+        *pi_pcr = i_scaledtime;
+
     /* Deal with common but worst binary search case */
     if( p_pmt->pcr.i_first == i_scaledtime && p_sys->b_canseek )
         return vlc_stream_Seek( p_sys->stream, 0 );
 
+    /* Exact position of the preceding random access point, if indexed */
+    uint64_t i_index_pos;
+    stime_t i_index_pcr;
+    if( p_pmt->p_index &&
+        ts_index_Lookup( p_pmt->p_index, i_scaledtime - p_pmt->pcr.i_first,
+                         &i_index_pos, &i_index_pcr ) == VLC_SUCCESS &&
+        vlc_stream_Seek( p_sys->stream, i_index_pos ) == VLC_SUCCESS )
+    {
+        if( pi_pcr )
+            *pi_pcr = TimeStampWrapAround( p_pmt->pcr.i_first, i_index_pcr );
+        return VLC_SUCCESS;
+    }
+
     const int64_t i_stream_size = stream_Size( p_sys->stream );
     if( !p_sys->b_canfastseek || i_stream_size < p_sys->i_packet_size )
         return VLC_EGENERIC;
@@ -2280,6 +2373,48 @@ int ProbeEnd( demux_t *p_demux, int i_program )
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
 }
 
+static void ProgramIndexInit( demux_t *p_demux, ts_pmt_t *p_pmt )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    p_pmt->b_index_tried = true;
+
+    /* The index reads the file again by itself, which is only useful for
+     * seekable files not descrambled by a stream filter, and only cheap
+     * enough for local files and fast seeking streams */
+    if( !p_sys->b_canseek || p_sys->b_access_control || p_demux->b_preparsing ||
+        ( !p_sys->b_canfastseek && ( p_demux->psz_url == NULL ||
+          strncasecmp( p_demux->psz_url, "file://", 7 ) ) ) ||
+        p_sys->stream != p_demux->s || p_demux->psz_url == NULL ||
+        p_pmt->i_pid_pcr == 0x1FFF || p_pmt->pcr.b_disable )
+        return;
+
+    /* Random access points are only relevant for video, if any */
+    uint16_t *pi_pids = vlc_alloc( p_pmt->e_streams.i_size, sizeof(*pi_pids) );
+    size_t i_pids = 0;
+    if( !pi_pids )
+        return;
+
+    for( int b_all = 0; b_all < 2 && i_pids == 0; b_all++ )
+    {
+        for( int i = 0; i < p_pmt->e_streams.i_size; i++ )
+        {
+            const ts_pid_t *p_pid = p_pmt->e_streams.p_elems[i];
+            if( p_pid->type == TYPE_STREAM && ( b_all ||
+                p_pid->u.p_stream->p_es->fmt.i_cat == VIDEO_ES ) )
+                pi_pids[i_pids++] = p_pid->i_pid;
+        }
+    }
+
+    p_pmt->p_index = ts_index_New( VLC_OBJECT(p_demux), p_demux->psz_url,
+                                   p_sys->i_packet_size, p_sys->i_packet_header_size,
+                                   p_pmt->i_number, p_pmt->i_pid_pcr,
+                                   pi_pids, i_pids );
+    free( pi_pids );
+    if( p_pmt->p_index )
+        msg_Dbg( p_demux, "indexing program %d in the background", p_pmt->i_number );
+}
+
 static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, stime_t i_pcr )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -2326,6 +2461,9 @@ static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, stime_t i_pcr )
 
     if ( p_sys->i_pmt_es )
     {
+        if( p_sys->b_index && p_pmt->b_selected && !p_pmt->b_index_tried )
+            ProgramIndexInit( p_demux, p_pmt );
+
         es_out_Control( p_demux->out, ES_OUT_SET_GROUP_PCR, p_pmt->i_number, FROM_SCALE(i_pcr) );
         /* growing files/named fifo handling */
         if( p_sys->b_access_control == false &&
@@ -2576,17 +2714,10 @@ static block_t * ProcessTSPacket( demux_t *p_demux, ts_pid_t *pid, block_t *p_pk
      * TODO: handle Reed-Solomon 204,188 error correction */
     p_pkt->i_buffer = TS_PACKET_SIZE_188;
 
-    if( b_scrambled )
-    {
-        if( p_sys->csa )
-        {
-            vlc_mutex_lock( &p_sys->csa_lock );
-            csa_Decrypt( p_sys->csa, p_pkt->p_buffer, p_sys->i_csa_pkt_size );
-            vlc_mutex_unlock( &p_sys->csa_lock );
-        }
-        else
-            p_pkt->i_flags |= BLOCK_FLAG_SCRAMBLED;
-    }
+    /* With a key, ReadTSPacketBatch() descrambled the packets to demux, the
+     * others are left scrambled and dropped */
+    if( b_scrambled && !p_sys->csa )
+        p_pkt->i_flags |= BLOCK_FLAG_SCRAMBLED;
 
     /* We don't have any adaptation_field, so payload starts
      * immediately after the 4 byte TS header */
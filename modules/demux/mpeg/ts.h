@@ -74,6 +74,7 @@ struct demux_sys_t
 
     bool        b_cc_check;
     bool        b_ignore_time_for_positions;
+    bool        b_index;
 
     ts_standards_e standard;
 
@@ -0,0 +1,671 @@
+/*****************************************************************************
+ * ts_index.c: Transport Stream seek index
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_stream.h>
+#include <vlc_threads.h>
+#include <vlc_interrupt.h>
+#include <vlc_vector.h>
+#include <vlc_hash.h>
+#include <vlc_strings.h>
+#include <vlc_fs.h>
+#include <vlc_configuration.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "ts_index.h"
+
+#define TS_INDEX_MAGIC          "VLCTSIX1"
+#define TS_INDEX_READ_PACKETS   512
+#define TS_INDEX_MAX_PACKET     204
+#define TS_INDEX_HEAD_SIZE      65536 /* start of the file identifying it */
+#define TS_INDEX_TAIL_SIZE      188   /* last bytes read, checked on resume */
+
+#define TS_INDEX_PCR_INTERVAL   90000  /* entry every second without RAP */
+#define TS_INDEX_RAP_INTERVAL   9000   /* at most 10 RAP per second */
+#define TS_INDEX_MAX_PCR_GAP    450000 /* larger PCR jumps are discontinuities */
+
+#define TS_INDEX_CACHE_MAX_SIZE (32 << 20) /* of all the cached indexes */
+#define TS_INDEX_CACHE_MAX_AGE  (90 * 24 * 3600) /* since last written */
+
+typedef struct
+{
+    stime_t  i_time;  /* from the first PCR, discontinuities removed */
+    stime_t  i_pcr;   /* PCR value at i_time */
+    uint64_t i_pos;   /* of the packet, including its header */
+    bool     b_rap;
+} ts_index_entry_t;
+
+struct ts_index_t
+{
+    vlc_object_t *p_obj;
+    char         *psz_url;
+    char         *psz_cache; /* NULL if not cached */
+    unsigned      i_packet_size;
+    unsigned      i_packet_header_size;
+    uint16_t      i_pcr_pid;
+    uint8_t       pids[8192 / 8]; /* pids searched for random access points */
+
+    vlc_thread_t     thread;
+    vlc_interrupt_t *p_interrupt;
+    bool             b_running;
+
+    vlc_mutex_t   lock;
+    /* protected by lock */
+    struct VLC_VECTOR(ts_index_entry_t) entries;
+    bool          b_has_rap;
+    bool          b_done;
+
+    /* Scanning state, used by the thread only while it runs, and stored
+     * along with the entries to resume reading a grown file */
+    struct
+    {
+        uint64_t i_pos;       /* next byte to read */
+        stime_t  i_time;      /* of the last PCR */
+        stime_t  i_pcr;       /* last PCR, -1 if none yet */
+        stime_t  i_last_pcr_entry;
+        stime_t  i_last_rap_entry;
+        uint8_t  head[VLC_HASH_MD5_DIGEST_SIZE];
+        uint8_t  tail[TS_INDEX_TAIL_SIZE];
+    } scan;
+
+    size_t        i_loaded;   /* entries read from the cache */
+    uint64_t      i_loaded_pos;
+};
+
+static bool HasPID( const ts_index_t *p_index, uint16_t i_pid )
+{
+    return p_index->pids[i_pid >> 3] & (1 << (i_pid & 7));
+}
+
+static void AddEntry( ts_index_t *p_index, uint64_t i_pos, bool b_rap )
+{
+    ts_index_entry_t entry = {
+        .i_time = p_index->scan.i_time,
+        .i_pcr = p_index->scan.i_pcr,
+        .i_pos = i_pos,
+        .b_rap = b_rap,
+    };
+
+    if( b_rap )
+        p_index->scan.i_last_rap_entry = entry.i_time;
+    p_index->scan.i_last_pcr_entry = entry.i_time;
+
+    vlc_mutex_lock( &p_index->lock );
+    if( vlc_vector_push( &p_index->entries, entry ) )
+        p_index->b_has_rap |= b_rap;
+    vlc_mutex_unlock( &p_index->lock );
+}
+
+static void ScanPacket( ts_index_t *p_index, const uint8_t *p, uint64_t i_pos )
+{
+    const uint16_t i_pid = ( (p[1] & 0x1f) << 8 ) | p[2];
+
+    if( p[1] & 0x80 ) /* transport error */
+        return;
+    if( i_pid != p_index->i_pcr_pid && !HasPID( p_index, i_pid ) )
+        return;
+    if( !(p[3] & 0x20) || p[4] == 0 ) /* no adaptation field flags */
+        return;
+
+    const uint8_t i_flags = p[5];
+
+    if( i_pid == p_index->i_pcr_pid && p[4] >= 7 && (i_flags & 0x10) )
+    {
+        stime_t i_pcr = ( (stime_t)p[6] << 25 ) |
+                        ( (stime_t)p[7] << 17 ) |
+                        ( (stime_t)p[8] << 9 ) |
+                        ( (stime_t)p[9] << 1 ) |
+                        ( (stime_t)p[10] >> 7 );
+
+        if( p_index->scan.i_pcr >= 0 )
+        {
+            /* 33 bits wrap around */
+            stime_t i_delta = ( i_pcr - p_index->scan.i_pcr ) & 0x1FFFFFFFF;
+            if( (i_flags & 0x80) || i_delta > TS_INDEX_MAX_PCR_GAP )
+                i_delta = 0; /* discontinuity, continue from there */
+            p_index->scan.i_time += i_delta;
+        }
+        p_index->scan.i_pcr = i_pcr;
+
+        /* a random access point below takes precedence */
+        bool b_rap = (i_flags & 0x40) && HasPID( p_index, i_pid );
+        if( !b_rap && ( p_index->entries.size == 0 ||
+            p_index->scan.i_time - p_index->scan.i_last_pcr_entry >= TS_INDEX_PCR_INTERVAL ) )
+            AddEntry( p_index, i_pos, false );
+    }
+
+    if( (i_flags & 0x40) && HasPID( p_index, i_pid ) && /* random access */
+        p_index->scan.i_pcr >= 0 &&
+        ( p_index->scan.i_last_rap_entry < 0 ||
+          p_index->scan.i_time - p_index->scan.i_last_rap_entry >= TS_INDEX_RAP_INTERVAL ) )
+        AddEntry( p_index, i_pos, true );
+}
+
+static bool ReadAt( stream_t *s, uint64_t i_pos, uint8_t *p_buf, size_t i_size )
+{
+    return vlc_stream_Seek( s, i_pos ) == VLC_SUCCESS &&
+           vlc_stream_Read( s, p_buf, i_size ) == (ssize_t)i_size;
+}
+
+static bool HashHead( stream_t *s, uint8_t digest[VLC_HASH_MD5_DIGEST_SIZE] )
+{
+    uint8_t *p_buf = malloc( TS_INDEX_HEAD_SIZE );
+    if( unlikely(p_buf == NULL) )
+        return false;
+
+    ssize_t i_read = -1;
+    if( vlc_stream_Seek( s, 0 ) == VLC_SUCCESS )
+        i_read = vlc_stream_Read( s, p_buf, TS_INDEX_HEAD_SIZE );
+
+    if( i_read > 0 )
+    {
+        vlc_hash_md5_t md5;
+        vlc_hash_md5_Init( &md5 );
+        vlc_hash_md5_Update( &md5, p_buf, i_read );
+        vlc_hash_md5_Finish( &md5, digest, VLC_HASH_MD5_DIGEST_SIZE );
+    }
+    free( p_buf );
+    return i_read > 0;
+}
+
+/* Checks that the loaded index describes the start of this file */
+static bool CheckResume( ts_index_t *p_index, stream_t *s,
+                         const uint8_t head[VLC_HASH_MD5_DIGEST_SIZE] )
+{
+    uint8_t tail[TS_INDEX_TAIL_SIZE];
+
+    if( p_index->scan.i_pos < TS_INDEX_TAIL_SIZE ||
+        memcmp( head, p_index->scan.head, VLC_HASH_MD5_DIGEST_SIZE ) ||
+        !ReadAt( s, p_index->scan.i_pos - TS_INDEX_TAIL_SIZE, tail, sizeof(tail) ) )
+        return false;
+    return !memcmp( tail, p_index->scan.tail, sizeof(tail) );
+}
+
+static void ResetScan( ts_index_t *p_index )
+{
+    p_index->scan.i_pos = 0;
+    p_index->scan.i_time = 0;
+    p_index->scan.i_pcr = -1;
+    p_index->scan.i_last_pcr_entry = -1;
+    p_index->scan.i_last_rap_entry = -1;
+}
+
+static void Scan( ts_index_t *p_index, stream_t *s )
+{
+    const unsigned i_size = p_index->i_packet_size;
+    const unsigned i_header = p_index->i_packet_header_size;
+    uint8_t *p_buf = malloc( TS_INDEX_READ_PACKETS * TS_INDEX_MAX_PACKET );
+    size_t i_buf = 0;
+
+    if( unlikely(p_buf == NULL) ||
+        vlc_stream_Seek( s, p_index->scan.i_pos ) != VLC_SUCCESS )
+    {
+        free( p_buf );
+        return;
+    }
+
+    while( !vlc_killed() )
+    {
+        ssize_t i_read = vlc_stream_Read( s, &p_buf[i_buf],
+                                          TS_INDEX_READ_PACKETS * i_size - i_buf );
+        if( i_read <= 0 )
+        {
+            if( i_read == 0 && !vlc_killed() )
+            {
+                vlc_mutex_lock( &p_index->lock );
+                p_index->b_done = true;
+                vlc_mutex_unlock( &p_index->lock );
+            }
+            break;
+        }
+        i_buf += i_read;
+
+        size_t i = 0;
+        while( i + i_size <= i_buf )
+        {
+            if( p_buf[i + i_header] != 0x47 )
+            {
+                i++; /* lost sync */
+                continue;
+            }
+            ScanPacket( p_index, &p_buf[i + i_header], p_index->scan.i_pos + i );
+            i += i_size;
+        }
+
+        /* only move the resume point along with its check bytes */
+        if( i >= TS_INDEX_TAIL_SIZE )
+        {
+            memcpy( p_index->scan.tail, &p_buf[i - TS_INDEX_TAIL_SIZE],
+                    TS_INDEX_TAIL_SIZE );
+            p_index->scan.i_pos += i;
+            i_buf -= i;
+            memmove( p_buf, &p_buf[i], i_buf );
+        }
+    }
+    free( p_buf );
+}
+
+static void *Thread( void *data )
+{
+    ts_index_t *p_index = data;
+    uint8_t head[VLC_HASH_MD5_DIGEST_SIZE];
+
+    vlc_thread_set_name( "vlc-ts-index" );
+    vlc_interrupt_set( p_index->p_interrupt );
+
+    vlc_tick_t i_start = vlc_tick_now();
+    uint64_t i_start_pos = p_index->scan.i_pos;
+    stream_t *s = vlc_stream_NewURL( p_index->p_obj, p_index->psz_url );
+
+    if( s != NULL && HashHead( s, head ) )
+    {
+        if( p_index->i_loaded > 0 && !CheckResume( p_index, s, head ) )
+        {
+            msg_Dbg( p_index->p_obj, "file changed, rebuilding its index" );
+            vlc_mutex_lock( &p_index->lock );
+            vlc_vector_clear( &p_index->entries );
+            p_index->b_has_rap = false;
+            vlc_mutex_unlock( &p_index->lock );
+            ResetScan( p_index );
+            p_index->i_loaded = 0;
+            p_index->i_loaded_pos = 0;
+            i_start_pos = 0;
+        }
+        memcpy( p_index->scan.head, head, sizeof(head) );
+
+        Scan( p_index, s );
+    }
+    if( s != NULL )
+        vlc_stream_Delete( s );
+
+    vlc_mutex_lock( &p_index->lock );
+    msg_Dbg( p_index->p_obj, "indexed %" PRIu64 " bytes in %" PRId64 " ms, "
+             "%zu entries%s", p_index->scan.i_pos - i_start_pos,
+             MS_FROM_VLC_TICK( vlc_tick_now() - i_start ),
+             p_index->entries.size, p_index->b_done ? "" : " (interrupted)" );
+    vlc_mutex_unlock( &p_index->lock );
+    return NULL;
+}
+
+/*****************************************************************************
+ * Cache
+ *****************************************************************************/
+static char *GetCachePath( const char *psz_url, int i_program, uint16_t i_pcr_pid )
+{
+    char *psz_dir = config_GetUserDir( VLC_CACHE_DIR );
+    if( psz_dir == NULL )
+        return NULL;
+
+    vlc_hash_md5_t md5;
+    uint8_t buf[6];
+    uint8_t digest[VLC_HASH_MD5_DIGEST_SIZE];
+    char hex[VLC_HASH_MD5_DIGEST_HEX_SIZE];
+
+    vlc_hash_md5_Init( &md5 );
+    vlc_hash_md5_Update( &md5, psz_url, strlen( psz_url ) );
+    SetDWBE( buf, i_program );
+    SetWBE( &buf[4], i_pcr_pid );
+    vlc_hash_md5_Update( &md5, buf, sizeof(buf) );
+    vlc_hash_md5_Finish( &md5, digest, sizeof(digest) );
+    vlc_hex_encode_binary( digest, sizeof(digest), hex );
+
+    char *psz_path;
+    if( asprintf( &psz_path, "%s" DIR_SEP "ts-index" DIR_SEP "%s.idx",
+                  psz_dir, hex ) < 0 )
+        psz_path = NULL;
+    free( psz_dir );
+    return psz_path;
+}
+
+#define HEADER_SIZE (8 + VLC_HASH_MD5_DIGEST_SIZE + TS_INDEX_TAIL_SIZE + 5 * 8 + 4)
+#define ENTRY_SIZE  (3 * 8 + 1)
+
+static void Load( ts_index_t *p_index )
+{
+    FILE *p_file = vlc_fopen( p_index->psz_cache, "rb" );
+    if( p_file == NULL )
+        return;
+
+    uint8_t header[HEADER_SIZE];
+    if( fread( header, 1, sizeof(header), p_file ) != sizeof(header) ||
+        memcmp( header, TS_INDEX_MAGIC, 8 ) )
+        goto invalid;
+
+    const uint8_t *p = &header[8];
+    memcpy( p_index->scan.head, p, VLC_HASH_MD5_DIGEST_SIZE );
+    p += VLC_HASH_MD5_DIGEST_SIZE;
+    memcpy( p_index->scan.tail, p, TS_INDEX_TAIL_SIZE );
+    p += TS_INDEX_TAIL_SIZE;
+    p_index->scan.i_pos = GetQWBE( p );
+    p_index->scan.i_time = GetQWBE( p + 8 );
+    p_index->scan.i_pcr = GetQWBE( p + 16 );
+    p_index->scan.i_last_pcr_entry = GetQWBE( p + 24 );
+    p_index->scan.i_last_rap_entry = GetQWBE( p + 32 );
+    const uint32_t i_count = GetDWBE( p + 40 );
+
+    if( i_count > p_index->scan.i_pos / p_index->i_packet_size ||
+        !vlc_vector_reserve( &p_index->entries, i_count ) )
+        goto invalid;
+
+    for( uint32_t i = 0; i < i_count; i++ )
+    {
+        uint8_t buf[ENTRY_SIZE];
+        if( fread( buf, 1, sizeof(buf), p_file ) != sizeof(buf) )
+            goto invalid;
+
+        ts_index_entry_t entry = {
+            .i_time = GetQWBE( buf ),
+            .i_pcr = GetQWBE( &buf[8] ),
+            .i_pos = GetQWBE( &buf[16] ),
+            .b_rap = buf[24] != 0,
+        };
+        if( entry.i_pos >= p_index->scan.i_pos || ( i > 0 &&
+            entry.i_time < p_index->entries.data[i - 1].i_time ) )
+            goto invalid;
+        vlc_vector_push( &p_index->entries, entry );
+        p_index->b_has_rap |= entry.b_rap;
+    }
+    fclose( p_file );
+
+    p_index->i_loaded = p_index->entries.size;
+    p_index->i_loaded_pos = p_index->scan.i_pos;
+    msg_Dbg( p_index->p_obj, "loaded index cache %s (%zu entries)",
+             p_index->psz_cache, p_index->i_loaded );
+    return;
+
+invalid:
+    msg_Warn( p_index->p_obj, "ignoring invalid index cache %s",
+              p_index->psz_cache );
+    fclose( p_file );
+    vlc_vector_clear( &p_index->entries );
+    p_index->b_has_rap = false;
+    ResetScan( p_index );
+}
+
+typedef struct
+{
+    char    *psz_path;
+    time_t   i_mtime;
+    uint64_t i_size;
+} ts_index_file_t;
+
+static int CompareFiles( const void *a, const void *b )
+{
+    const ts_index_file_t *p_a = a, *p_b = b;
+    return ( p_a->i_mtime > p_b->i_mtime ) - ( p_a->i_mtime < p_b->i_mtime );
+}
+
+/* Removes the indexes not written for long, then the oldest ones until
+ * the directory fits its size limit. The one just written is kept. */
+static void Trim( ts_index_t *p_index, const char *psz_index_dir )
+{
+    vlc_DIR *p_dir = vlc_opendir( psz_index_dir );
+    if( p_dir == NULL )
+        return;
+
+    struct VLC_VECTOR(ts_index_file_t) files = VLC_VECTOR_INITIALIZER;
+    const time_t i_now = time( NULL );
+    uint64_t i_total = 0;
+    const char *psz_name;
+
+    while( ( psz_name = vlc_readdir( p_dir ) ) != NULL )
+    {
+        ts_index_file_t file;
+        struct stat st;
+
+        if( psz_name[0] == '.' ||
+            asprintf( &file.psz_path, "%s" DIR_SEP "%s",
+                      psz_index_dir, psz_name ) < 0 )
+            continue;
+        if( !strcmp( file.psz_path, p_index->psz_cache ) ||
+            vlc_stat( file.psz_path, &st ) || !S_ISREG( st.st_mode ) )
+        {
+            free( file.psz_path );
+            continue;
+        }
+        file.i_mtime = st.st_mtime;
+        file.i_size = st.st_size;
+
+        if( i_now - file.i_mtime > TS_INDEX_CACHE_MAX_AGE ||
+            !vlc_vector_push( &files, file ) )
+        {
+            vlc_unlink( file.psz_path );
+            free( file.psz_path );
+            continue;
+        }
+        i_total += file.i_size;
+    }
+    vlc_closedir( p_dir );
+
+    struct stat st;
+    if( !vlc_stat( p_index->psz_cache, &st ) )
+        i_total += st.st_size;
+
+    qsort( files.data, files.size, sizeof(*files.data), CompareFiles );
+    for( size_t i = 0; i < files.size; i++ )
+    {
+        if( i_total > TS_INDEX_CACHE_MAX_SIZE )
+        {
+            msg_Dbg( p_index->p_obj, "evicting index cache %s",
+                     files.data[i].psz_path );
+            vlc_unlink( files.data[i].psz_path );
+            i_total -= files.data[i].i_size;
+        }
+        free( files.data[i].psz_path );
+    }
+    vlc_vector_destroy( &files );
+}
+
+static void Save( ts_index_t *p_index )
+{
+    /* nothing was learned since the cache was loaded */
+    if( p_index->scan.i_pos <= p_index->i_loaded_pos ||
+        p_index->entries.size == 0 )
+        return;
+
+    char *psz_dir = config_GetUserDir( VLC_CACHE_DIR );
+    if( psz_dir == NULL )
+        return;
+    char *psz_index_dir, *psz_tmp;
+    if( asprintf( &psz_index_dir, "%s" DIR_SEP "ts-index", psz_dir ) < 0 )
+        psz_index_dir = NULL;
+    free( psz_dir );
+    if( psz_index_dir == NULL )
+        return;
+    int i_ret = vlc_mkdir_parent( psz_index_dir, 0700 );
+    if( i_ret && errno != EEXIST )
+        goto end;
+
+    /* write aside, so that a concurrent reader never sees partial data */
+    if( asprintf( &psz_tmp, "%s.tmp", p_index->psz_cache ) < 0 )
+        goto end;
+    FILE *p_file = vlc_fopen( psz_tmp, "wb" );
+    if( p_file == NULL )
+    {
+        free( psz_tmp );
+        goto end;
+    }
+
+    uint8_t header[HEADER_SIZE];
+    uint8_t *p = header;
+    memcpy( p, TS_INDEX_MAGIC, 8 );
+    p += 8;
+    memcpy( p, p_index->scan.head, VLC_HASH_MD5_DIGEST_SIZE );
+    p += VLC_HASH_MD5_DIGEST_SIZE;
+    memcpy( p, p_index->scan.tail, TS_INDEX_TAIL_SIZE );
+    p += TS_INDEX_TAIL_SIZE;
+    SetQWBE( p, p_index->scan.i_pos );
+    SetQWBE( p + 8, p_index->scan.i_time );
+    SetQWBE( p + 16, p_index->scan.i_pcr );
+    SetQWBE( p + 24, p_index->scan.i_last_pcr_entry );
+    SetQWBE( p + 32, p_index->scan.i_last_rap_entry );
+    SetDWBE( p + 40, p_index->entries.size );
+
+    bool b_ok = fwrite( header, 1, sizeof(header), p_file ) == sizeof(header);
+    for( size_t i = 0; i < p_index->entries.size && b_ok; i++ )
+    {
+        const ts_index_entry_t *p_entry = &p_index->entries.data[i];
+        uint8_t buf[ENTRY_SIZE];
+
+        SetQWBE( buf, p_entry->i_time );
+        SetQWBE( &buf[8], p_entry->i_pcr );
+        SetQWBE( &buf[16], p_entry->i_pos );
+        buf[24] = p_entry->b_rap;
+        b_ok = fwrite( buf, 1, sizeof(buf), p_file ) == sizeof(buf);
+    }
+    b_ok &= fclose( p_file ) == 0;
+
+    if( !b_ok || vlc_rename( psz_tmp, p_index->psz_cache ) )
+    {
+        msg_Warn( p_index->p_obj, "cannot write index cache %s",
+                  p_index->psz_cache );
+        vlc_unlink( psz_tmp );
+    }
+    else
+    {
+        msg_Dbg( p_index->p_obj, "saved index cache %s (%zu entries)",
+                 p_index->psz_cache, p_index->entries.size );
+        Trim( p_index, psz_index_dir );
+    }
+    free( psz_tmp );
+end:
+    free( psz_index_dir );
+}
+
+/*****************************************************************************
+ * API
+ *****************************************************************************/
+ts_index_t * ts_index_New( vlc_object_t *p_obj, const char *psz_url,
+                           unsigned i_packet_size, unsigned i_packet_header_size,
+                           int i_program, uint16_t i_pcr_pid,
+                           const uint16_t *pi_pids, size_t i_pids )
+{
+    if( i_packet_size > TS_INDEX_MAX_PACKET || i_pcr_pid >= 0x1FFF )
+        return NULL;
+
+    ts_index_t *p_index = calloc( 1, sizeof(*p_index) );
+    if( unlikely(p_index == NULL) )
+        return NULL;
+
+    p_index->p_obj = p_obj;
+    p_index->psz_url = strdup( psz_url );
+    p_index->p_interrupt = vlc_interrupt_create();
+    if( unlikely(p_index->psz_url == NULL || p_index->p_interrupt == NULL) )
+        goto error;
+
+    p_index->i_packet_size = i_packet_size;
+    p_index->i_packet_header_size = i_packet_header_size;
+    p_index->i_pcr_pid = i_pcr_pid;
+    for( size_t i = 0; i < i_pids; i++ )
+        p_index->pids[pi_pids[i] >> 3] |= 1 << (pi_pids[i] & 7);
+
+    vlc_mutex_init( &p_index->lock );
+    vlc_vector_init( &p_index->entries );
+    ResetScan( p_index );
+
+    p_index->psz_cache = GetCachePath( psz_url, i_program, i_pcr_pid );
+    if( p_index->psz_cache != NULL )
+        Load( p_index );
+
+    if( vlc_clone( &p_index->thread, Thread, p_index ) )
+    {
+        vlc_vector_destroy( &p_index->entries );
+        goto error;
+    }
+    p_index->b_running = true;
+    return p_index;
+
+error:
+    if( p_index->p_interrupt != NULL )
+        vlc_interrupt_destroy( p_index->p_interrupt );
+    free( p_index->psz_cache );
+    free( p_index->psz_url );
+    free( p_index );
+    return NULL;
+}
+
+void ts_index_Delete( ts_index_t *p_index )
+{
+    if( p_index->b_running )
+    {
+        vlc_interrupt_kill( p_index->p_interrupt );
+        vlc_join( p_index->thread, NULL );
+    }
+
+    if( p_index->psz_cache != NULL )
+        Save( p_index );
+
+    vlc_interrupt_destroy( p_index->p_interrupt );
+    vlc_vector_destroy( &p_index->entries );
+    free( p_index->psz_cache );
+    free( p_index->psz_url );
+    free( p_index );
+}
+
+int ts_index_Lookup( ts_index_t *p_index, stime_t i_time,
+                     uint64_t *pi_pos, stime_t *pi_pcr )
+{
+    int i_ret = VLC_EGENERIC;
+
+    vlc_mutex_lock( &p_index->lock );
+
+    const size_t i_count = p_index->entries.size;
+    const ts_index_entry_t *p_entries = p_index->entries.data;
+
+    /* Past the indexed part, unless the whole file was, which may still
+     * be growing */
+    if( i_count == 0 || i_time > p_entries[i_count - 1].i_time +
+        ( p_index->b_done ? TS_INDEX_MAX_PCR_GAP : 0 ) )
+        goto end;
+
+    /* last entry not after i_time */
+    size_t i_low = 0, i_high = i_count;
+    while( i_high - i_low > 1 )
+    {
+        size_t i_mid = i_low + (i_high - i_low) / 2;
+        if( p_entries[i_mid].i_time <= i_time )
+            i_low = i_mid;
+        else
+            i_high = i_mid;
+    }
+
+    const ts_index_entry_t *p_entry = &p_entries[i_low];
+    *pi_pcr = p_entry->i_pcr + __MAX( i_time - p_entry->i_time, 0 );
+
+    size_t i_rap = i_low;
+    if( p_index->b_has_rap )
+        while( i_rap > 0 && !p_entries[i_rap].b_rap )
+            i_rap--;
+    *pi_pos = p_entries[i_rap].i_pos;
+    i_ret = VLC_SUCCESS;
+
+end:
+    vlc_mutex_unlock( &p_index->lock );
+    return i_ret;
+}
@@ -0,0 +1,56 @@
+/*****************************************************************************
+ * ts_index.h: Transport Stream seek index
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_TS_INDEX_H
+#define VLC_TS_INDEX_H
+
+#include "timestamps.h"
+
+/*
+ * Time to byte offset index of a program, built by a background thread
+ * reading the file through its own stream. Every entry is a packet carrying
+ * the random access indicator, or a PCR of the program when there was none
+ * for a while. Times are counted from the first PCR, PCR discontinuities
+ * removed, so that a file made of several recordings seeks linearly.
+ *
+ * The index is stored in the user cache directory when deleted, and reused
+ * by the next playback of the same file. When the file grew in between (a
+ * recording still in progress), only its new part is read. The indexes not
+ * written for 90 days are removed, then the oldest ones beyond 32 MiB.
+ */
+typedef struct ts_index_t ts_index_t;
+
+ts_index_t * ts_index_New( vlc_object_t *, const char *psz_url,
+                           unsigned i_packet_size, unsigned i_packet_header_size,
+                           int i_program, uint16_t i_pcr_pid,
+                           const uint16_t *pi_pids, size_t i_pids );
+void ts_index_Delete( ts_index_t * );
+
+/**
+ * Finds where to start reading to present the given time.
+ *
+ * \param i_time time from the first PCR, in 90 kHz units
+ * \param pi_pos packet offset of the closest preceding random access point
+ * \param pi_pcr PCR value matching i_time, i.e. the time to display from
+ * \return VLC_SUCCESS, or VLC_EGENERIC if that part is not indexed (yet)
+ */
+int ts_index_Lookup( ts_index_t *, stime_t i_time,
+                     uint64_t *pi_pos, stime_t *pi_pcr );
+
+#endif
@@ -37,6 +37,7 @@
 #include "ts_psi.h"
 #include "ts_si.h"
 #include "ts_psip.h"
+#include "ts_index.h"
 
 ts_pat_t *ts_pat_New( demux_t *p_demux )
 {
@@ -107,6 +108,9 @@ ts_pmt_t *ts_pmt_New( demux_t *p_demux )
     pmt->i_last_dts = TS_TICK_UNKNOWN;
     pmt->i_last_dts_byte = 0;
 
+    pmt->p_index = NULL;
+    pmt->b_index_tried = false;
+
     pmt->p_atsc_si_basepid      = NULL;
     pmt->p_si_sdt_pid = NULL;
 
@@ -129,6 +133,8 @@ ts_pmt_t *ts_pmt_New( demux_t *p_demux )
 
 void ts_pmt_Del( demux_t *p_demux, ts_pmt_t *pmt )
 {
+    if( pmt->p_index )
+        ts_index_Delete( pmt->p_index );
     ts_psi_context_Delete( pmt->p_ctx );
     for( int i=0; i<pmt->e_streams.i_size; i++ )
         PIDRelease( p_demux, pmt->e_streams.p_elems[i] );
@@ -21,6 +21,7 @@
 
 typedef struct ts_psi_context_t ts_psi_context_t;
 typedef struct ts_sections_processor_t ts_sections_processor_t;
+typedef struct ts_index_t ts_index_t;
 
 #include "mpeg4_iod.h"
 #include "timestamps.h"
@@ -77,6 +78,10 @@ struct ts_pmt_t
     stime_t i_last_dts;
     uint64_t i_last_dts_byte;
 
+    /* Background seek index, see ts_index.h */
+    ts_index_t     *p_index;
+    bool            b_index_tried;
+
     /* CA */
     //en50221_capmt_info_t *capmt;
 
@@ -111,9 +111,15 @@ typedef struct
     size_t  i_line_count;
     size_t  i_line;
     char    **line;
+
+    /* When reading lines on demand, only the last one is kept */
+    stream_t *s;
+    char     *psz_last;
+    bool      b_previous;
 } text_t;
 
 static int  TextLoad( text_t *, stream_t *s );
+static void TextOpen( text_t *, stream_t *s );
 static void TextUnload( text_t * );
 
 typedef struct
@@ -122,8 +128,11 @@ typedef struct
     vlc_tick_t i_stop;
 
     char    *psz_text;
+    uint64_t i_offset; /* of the cue in the stream, when parsed lazily */
 } subtitle_t;
 
+typedef int (*subtitle_timing_cb)( subtitle_t *, const char * );
+
 typedef struct
 {
     enum subtitle_type_e i_type;
@@ -170,6 +179,7 @@ typedef struct
         subtitle_t *p_array;
         size_t      i_count;
         size_t      i_current;
+        bool        b_lazy; /* texts are parsed when sent */
     } subtitles;
 
     vlc_tick_t  i_length;
@@ -177,6 +187,7 @@ typedef struct
     /* */
     subs_properties_t props;
 
+    int  (*pf_read)( vlc_object_t *, subs_properties_t *, text_t *, subtitle_t*, size_t );
     block_t * (*pf_convert)( const subtitle_t * );
 } demux_sys_t;
 
@@ -233,9 +244,29 @@ static const struct
  * to src/input/subtitles.c to enable auto-detection.
  */
 
+static int subtitle_ParseSubRipTiming( subtitle_t *, const char * );
+static int subtitle_ParseSubViewerTiming( subtitle_t *, const char * );
+
+/* Formats whose cues start with a timing line and end with an empty line,
+ * so that they can be indexed without being parsed */
+static subtitle_timing_cb GetCueTiming( int i_type )
+{
+    switch( i_type )
+    {
+        case SUB_TYPE_SUBRIP:
+            return subtitle_ParseSubRipTiming;
+        case SUB_TYPE_SUBVIEWER:
+            return subtitle_ParseSubViewerTiming;
+        default:
+            return NULL;
+    }
+}
+
 static int Demux( demux_t * );
 static int Control( demux_t *, int, va_list );
 
+static int  LoadCues( demux_t * );
+static int  ScanCues( demux_t *, subtitle_timing_cb );
 static void Fix( demux_t * );
 static char * get_language_from_filename( const char * );
 
@@ -295,7 +326,6 @@ static int Open ( vlc_object_t *p_this )
     es_format_t    fmt;
     float          f_fps;
     char           *psz_type;
-    int  (*pf_read)( vlc_object_t *, subs_properties_t *, text_t *, subtitle_t*, size_t );
 
     if( !p_demux->obj.force )
     {
@@ -319,6 +349,7 @@ static int Open ( vlc_object_t *p_this )
     p_sys->subtitles.i_current= 0;
     p_sys->subtitles.i_count  = 0;
     p_sys->subtitles.p_array  = NULL;
+    p_sys->subtitles.b_lazy   = false;
 
     p_sys->props.psz_header         = NULL;
     p_sys->props.psz_lang           = NULL;
@@ -623,13 +654,11 @@ static int Open ( vlc_object_t *p_this )
         {
             msg_Dbg( p_demux, "detected %s format",
                      sub_read_subtitle_function[i].psz_name );
-            pf_read = sub_read_subtitle_function[i].pf_read;
+            p_sys->pf_read = sub_read_subtitle_function[i].pf_read;
             break;
         }
     }
 
-    msg_Dbg( p_demux, "loading all subtitles..." );
-
     if( e_bom == UTF8BOM && /* skip BOM */
         vlc_stream_Read( p_demux->s, NULL, 3 ) != 3 )
     {
@@ -637,44 +666,45 @@ static int Open ( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
-    /* Load the whole file */
-    text_t txtlines;
-    TextLoad( &txtlines, p_demux->s );
-
-    /* Parse it */
-    for( size_t i_max = 0; i_max < SIZE_MAX - 500 * sizeof(subtitle_t); )
+    /* Only index the cues if they can be read again cheaply later on:
+     * each cue is sent after a seek */
+    subtitle_timing_cb pf_timing = GetCueTiming( p_sys->props.i_type );
+    bool b_fastseek = false;
+    vlc_stream_Control( p_demux->s, STREAM_CAN_FASTSEEK, &b_fastseek );
+    if( pf_timing != NULL && e_bom != UTF16LE && e_bom != UTF16BE &&
+        b_fastseek )
     {
-        if( p_sys->subtitles.i_count >= i_max )
+        msg_Dbg( p_demux, "indexing subtitles..." );
+
+        int i_ret = ScanCues( p_demux, pf_timing );
+        if( i_ret != VLC_SUCCESS )
         {
-            i_max += 500;
-            subtitle_t *p_realloc = realloc( p_sys->subtitles.p_array, sizeof(subtitle_t) * i_max );
-            if( p_realloc == NULL )
-            {
-                TextUnload( &txtlines );
-                Close( p_this );
-                return VLC_ENOMEM;
-            }
-            p_sys->subtitles.p_array = p_realloc;
+            Close( p_this );
+            return i_ret;
         }
+        p_sys->subtitles.b_lazy = true;
+    }
+    else
+    {
+        msg_Dbg( p_demux, "loading all subtitles..." );
 
-        if( pf_read( VLC_OBJECT(p_demux), &p_sys->props, &txtlines,
-                     &p_sys->subtitles.p_array[p_sys->subtitles.i_count],
-                     p_sys->subtitles.i_count ) )
-            break;
-
-        p_sys->subtitles.i_count++;
+        int i_ret = LoadCues( p_demux );
+        if( i_ret != VLC_SUCCESS )
+        {
+            Close( p_this );
+            return i_ret;
+        }
     }
-    /* Unload */
-    TextUnload( &txtlines );
 
     msg_Dbg(p_demux, "loaded %zu subtitles", p_sys->subtitles.i_count );
 
+    Fix( p_demux );
+
     /* *** add subtitle ES *** */
     if( p_sys->props.i_type == SUB_TYPE_SSA1 ||
              p_sys->props.i_type == SUB_TYPE_SSA2_4 ||
              p_sys->props.i_type == SUB_TYPE_ASS )
     {
-        Fix( p_demux );
         es_format_Init( &fmt, SPU_ES, VLC_CODEC_SSA );
     }
     else if( p_sys->props.i_type == SUB_TYPE_SCC )
@@ -748,13 +778,20 @@ static void
 ResetCurrentIndex( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    for( size_t i = 0; i < p_sys->subtitles.i_count; i++ )
+
+    /* Last subtitle starting before the date, or the first one */
+    size_t i_low = 0, i_high = p_sys->subtitles.i_count;
+    while( i_low < i_high )
     {
-        if( p_sys->subtitles.p_array[i].i_start * p_sys->f_rate >
-            p_sys->i_next_demux_date && i > 0 )
-            break;
-        p_sys->subtitles.i_current = i;
+        size_t i_mid = i_low + (i_high - i_low) / 2;
+        if( p_sys->subtitles.p_array[i_mid].i_start * p_sys->f_rate >
+            p_sys->i_next_demux_date )
+            i_high = i_mid;
+        else
+            i_low = i_mid + 1;
     }
+    if( p_sys->subtitles.i_count > 0 )
+        p_sys->subtitles.i_current = i_low > 0 ? i_low - 1 : 0;
 }
 
 /*****************************************************************************
@@ -844,6 +881,28 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
     return VLC_EGENERIC;
 }
 
+/*****************************************************************************
+ * LoadCueText: parse an indexed subtitle again, with its text this time
+ *****************************************************************************/
+static char *LoadCueText( demux_t *p_demux, const subtitle_t *p_subtitle )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( vlc_stream_Seek( p_demux->s, p_subtitle->i_offset ) != VLC_SUCCESS )
+        return NULL;
+
+    text_t txt;
+    TextOpen( &txt, p_demux->s );
+
+    subtitle_t cue = { .psz_text = NULL };
+    if( p_sys->pf_read( VLC_OBJECT(p_demux), &p_sys->props, &txt, &cue,
+                        p_sys->subtitles.i_current ) != VLC_SUCCESS )
+        cue.psz_text = NULL;
+    TextUnload( &txt );
+
+    return cue.psz_text;
+}
+
 /*****************************************************************************
  * Demux: Send subtitle to decoder
  *****************************************************************************/
@@ -857,7 +916,7 @@ static int Demux( demux_t *p_demux )
            ( p_sys->subtitles.p_array[p_sys->subtitles.i_current].i_start *
              p_sys->f_rate ) <= i_barrier )
     {
-        const subtitle_t *p_subtitle = &p_sys->subtitles.p_array[p_sys->subtitles.i_current];
+        subtitle_t *p_subtitle = &p_sys->subtitles.p_array[p_sys->subtitles.i_current];
 
         if ( !p_sys->b_slave && p_sys->b_first_time )
         {
@@ -865,7 +924,10 @@ static int Demux( demux_t *p_demux )
             p_sys->b_first_time = false;
         }
 
-        if( p_subtitle->i_start >= 0 )
+        if( p_sys->subtitles.b_lazy )
+            p_subtitle->psz_text = LoadCueText( p_demux, p_subtitle );
+
+        if( p_subtitle->i_start >= 0 && p_subtitle->psz_text != NULL )
         {
             block_t *p_block = p_sys->pf_convert( p_subtitle );
             if( p_block )
@@ -879,6 +941,12 @@ static int Demux( demux_t *p_demux )
             }
         }
 
+        if( p_sys->subtitles.b_lazy )
+        {
+            free( p_subtitle->psz_text );
+            p_subtitle->psz_text = NULL;
+        }
+
         p_sys->subtitles.i_current++;
     }
 
@@ -910,7 +978,107 @@ static void Fix( demux_t *p_demux )
     demux_sys_t *p_sys = p_demux->p_sys;
 
     /* *** fix order (to be sure...) *** */
-    qsort( p_sys->subtitles.p_array, p_sys->subtitles.i_count, sizeof( p_sys->subtitles.p_array[0] ), subtitle_cmp);
+    for( size_t i = 1; i < p_sys->subtitles.i_count; i++ )
+    {
+        if( p_sys->subtitles.p_array[i].i_start < p_sys->subtitles.p_array[i - 1].i_start )
+        {
+            qsort( p_sys->subtitles.p_array, p_sys->subtitles.i_count, sizeof( p_sys->subtitles.p_array[0] ), subtitle_cmp);
+            break;
+        }
+    }
+}
+
+/*****************************************************************************
+ * LoadCues: parse the whole file
+ *****************************************************************************/
+static int LoadCues( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    /* Load the whole file */
+    text_t txtlines;
+    TextLoad( &txtlines, p_demux->s );
+
+    /* Parse it */
+    for( size_t i_max = 0; i_max < SIZE_MAX - 500 * sizeof(subtitle_t); )
+    {
+        if( p_sys->subtitles.i_count >= i_max )
+        {
+            i_max += 500;
+            subtitle_t *p_realloc = realloc( p_sys->subtitles.p_array, sizeof(subtitle_t) * i_max );
+            if( p_realloc == NULL )
+            {
+                TextUnload( &txtlines );
+                return VLC_ENOMEM;
+            }
+            p_sys->subtitles.p_array = p_realloc;
+        }
+
+        if( p_sys->pf_read( VLC_OBJECT(p_demux), &p_sys->props, &txtlines,
+                     &p_sys->subtitles.p_array[p_sys->subtitles.i_count],
+                     p_sys->subtitles.i_count ) )
+            break;
+
+        p_sys->subtitles.i_count++;
+    }
+    /* Unload */
+    TextUnload( &txtlines );
+
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * ScanCues: index the timing and position of the subtitles, without their
+ * text, so that large files do not need to be parsed and kept in memory
+ *****************************************************************************/
+static int ScanCues( demux_t *p_demux, subtitle_timing_cb pf_timing )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    size_t i_max = 0;
+    bool b_text = false;
+
+    for( ;; )
+    {
+        const uint64_t i_offset = vlc_stream_Tell( p_demux->s );
+        char *psz = vlc_stream_ReadLine( p_demux->s );
+        if( psz == NULL )
+            break;
+
+        subtitle_t cue;
+        if( b_text )
+        {
+            /* The text ends with an empty line */
+            b_text = *psz != '\0';
+        }
+        else if( pf_timing( &cue, psz ) == VLC_SUCCESS &&
+                 cue.i_start < cue.i_stop )
+        {
+            if( p_sys->subtitles.i_count >= i_max )
+            {
+                if( i_max >= SIZE_MAX / sizeof(subtitle_t) - 500 )
+                {
+                    free( psz );
+                    break;
+                }
+                i_max += 500;
+                subtitle_t *p_realloc = realloc( p_sys->subtitles.p_array, sizeof(subtitle_t) * i_max );
+                if( p_realloc == NULL )
+                {
+                    free( psz );
+                    return VLC_ENOMEM;
+                }
+                p_sys->subtitles.p_array = p_realloc;
+            }
+
+            cue.psz_text = NULL;
+            cue.i_offset = i_offset;
+            p_sys->subtitles.p_array[p_sys->subtitles.i_count++] = cue;
+            b_text = true;
+        }
+        free( psz );
+    }
+
+    return VLC_SUCCESS;
 }
 
 static int TextLoad( text_t *txt, stream_t *s )
@@ -921,6 +1089,9 @@ static int TextLoad( text_t *txt, stream_t *s )
     i_line_max          = 500;
     txt->i_line_count   = 0;
     txt->i_line         = 0;
+    txt->s              = NULL;
+    txt->psz_last       = NULL;
+    txt->b_previous     = false;
     txt->line           = calloc( i_line_max, sizeof( char * ) );
     if( !txt->line )
         return VLC_ENOMEM;
@@ -953,8 +1124,19 @@ static int TextLoad( text_t *txt, stream_t *s )
 
     return VLC_SUCCESS;
 }
+static void TextOpen( text_t *txt, stream_t *s )
+{
+    txt->i_line_count = 0;
+    txt->i_line       = 0;
+    txt->line         = NULL;
+    txt->s            = s;
+    txt->psz_last     = NULL;
+    txt->b_previous   = false;
+}
 static void TextUnload( text_t *txt )
 {
+    free( txt->psz_last );
+    txt->psz_last = NULL;
     if( txt->i_line_count )
     {
         for( size_t i = 0; i < txt->i_line_count; i++ )
@@ -967,6 +1149,18 @@ static void TextUnload( text_t *txt )
 
 static char *TextGetLine( text_t *txt )
 {
+    if( txt->s != NULL )
+    {
+        if( txt->b_previous )
+            txt->b_previous = false;
+        else
+        {
+            free( txt->psz_last );
+            txt->psz_last = vlc_stream_ReadLine( txt->s );
+        }
+        return txt->psz_last;
+    }
+
     if( txt->i_line >= txt->i_line_count )
         return( NULL );
 
@@ -974,7 +1168,9 @@ static char *TextGetLine( text_t *txt )
 }
 static void TextPreviousLine( text_t *txt )
 {
-    if( txt->i_line > 0 )
+    if( txt->s != NULL )
+        txt->b_previous = txt->psz_last != NULL;
+    else if( txt->i_line > 0 )
         txt->i_line--;
 }
 
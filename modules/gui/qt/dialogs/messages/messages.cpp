@@ -143,6 +143,7 @@ MessagesDialog::MessagesDialog( qt_intf_t *_p_intf)
     static const struct vlc_logger_operations log_ops =
     {
         MessagesDialog::MsgCallback,
+        NULL,
         NULL
     };
     libvlc_int_t *vlc = vlc_object_instance(p_intf);
@@ -68,7 +68,13 @@ static void AndroidPrintMsg(void *opaque, int type, const vlc_log_t *p_item,
     free(format2);
 }
 
-static const struct vlc_logger_operations ops = { AndroidPrintMsg, NULL };
+static int AndroidVerbosity(void *opaque)
+{
+    return (intptr_t)opaque;
+}
+
+static const struct vlc_logger_operations ops =
+    { AndroidPrintMsg, NULL, AndroidVerbosity };
 
 static const struct vlc_logger_operations *Open(vlc_object_t *obj, void **sysp)
 {
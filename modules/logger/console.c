@@ -97,10 +97,16 @@ static void LogConsoleColor(void *opaque, int type, const vlc_log_t *meta,
     funlockfile(stream);
 }
 
+static int LogConsoleVerbosity(void *opaque)
+{
+    return (char *)opaque - verbosities;
+}
+
 static const struct vlc_logger_operations color_ops =
 {
     LogConsoleColor,
-    NULL
+    NULL,
+    LogConsoleVerbosity
 };
 
 static void LogConsoleGray(void *opaque, int type, const vlc_log_t *meta,
@@ -129,7 +135,8 @@ static void LogConsoleGray(void *opaque, int type, const vlc_log_t *meta,
 static const struct vlc_logger_operations gray_ops =
 {
     LogConsoleGray,
-    NULL
+    NULL,
+    LogConsoleVerbosity
 };
 
 static const struct vlc_logger_operations *Open(vlc_object_t *obj,
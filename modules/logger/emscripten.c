@@ -64,7 +64,13 @@ static void EmscriptenPrintMsg(void *opaque, int type, const vlc_log_t *p_item,
     free(message);
 }
 
-static const struct vlc_logger_operations ops = { EmscriptenPrintMsg, NULL };
+static int EmscriptenVerbosity(void *opaque)
+{
+    return (int)opaque;
+}
+
+static const struct vlc_logger_operations ops =
+    { EmscriptenPrintMsg, NULL, EmscriptenVerbosity };
 
 static const struct vlc_logger_operations *Open(vlc_object_t *obj, void **sysp)
 {
@@ -75,10 +75,18 @@ static void Close(void *opaque)
     free(sys);
 }
 
+static int Verbosity(void *opaque)
+{
+    vlc_logger_sys_t *sys = opaque;
+
+    return sys->verbosity;
+}
+
 static const struct vlc_logger_operations text_ops =
 {
     LogText,
-    Close
+    Close,
+    Verbosity
 };
 
 #define HTML_FILENAME "vlc-log.html"
@@ -124,7 +132,8 @@ static void LogHtml(void *opaque, int type, const vlc_log_t *meta,
 static const struct vlc_logger_operations html_ops =
 {
     LogHtml,
-    Close
+    Close,
+    Verbosity
 };
 
 static const struct vlc_logger_operations *Open(vlc_object_t *obj,
@@ -64,7 +64,7 @@ static void Log(void *opaque, int type, const vlc_log_t *meta,
     (void) opaque;
 }
 
-static const struct vlc_logger_operations ops = { Log, NULL };
+static const struct vlc_logger_operations ops = { Log, NULL, NULL };
 
 static const struct vlc_logger_operations *Open(vlc_object_t *obj, void **sysp)
 {
@@ -110,7 +110,7 @@ static void Close(void *opaque)
         free(ident);
 }
 
-static const struct vlc_logger_operations ops = { Log, Close };
+static const struct vlc_logger_operations ops = { Log, Close, NULL };
 
 static const struct vlc_logger_operations *Open(vlc_object_t *obj,
                                                 void **restrict sysp)
@@ -38,6 +38,8 @@
 #include <vlc_tls.h>
 #include <vlc_block.h>
 #include <vlc_dialog.h>
+#include <vlc_list.h>
+#include <vlc_network.h>
 
 #include <gnutls/gnutls.h>
 #include <gnutls/x509.h>
@@ -47,8 +49,32 @@ typedef struct vlc_tls_gnutls
     vlc_tls_t tls;
     gnutls_session_t session;
     vlc_object_t *obj;
+    struct vlc_tls_gnutls_client *client; /* NULL on server side */
+    char *server; /* host:port, to save the session for resumption */
+    bool handshaked;
 } vlc_tls_gnutls_t;
 
+/**
+ * Client-side TLS credentials private data
+ */
+typedef struct vlc_tls_gnutls_client
+{
+    gnutls_certificate_credentials_t x509;
+    vlc_mutex_t lock;
+    struct vlc_list resumptions; /**< most recently saved first */
+    unsigned resumption_count;
+} vlc_tls_gnutls_client_t;
+
+/* Data of a previous session, to resume it instead of a full handshake */
+struct vlc_tls_gnutls_resumption
+{
+    struct vlc_list node;
+    gnutls_datum_t data;
+    char server[]; /* host:port */
+};
+
+#define MAX_RESUMPTIONS 16
+
 static void gnutls_Banner(vlc_object_t *obj)
 {
     msg_Dbg(obj, "using GnuTLS v%s (built with v"GNUTLS_VERSION")",
@@ -203,11 +229,61 @@ static int gnutls_Shutdown(vlc_tls_t *tls, bool duplex)
     return 0;
 }
 
+static void gnutls_SaveSession(vlc_tls_gnutls_t *priv)
+{
+    vlc_tls_gnutls_client_t *sys = priv->client;
+    struct vlc_tls_gnutls_resumption *r;
+    gnutls_datum_t data;
+
+    /* With TLS 1.3, this only works if a session ticket was received */
+    if (gnutls_session_get_data2(priv->session, &data) != 0)
+        return;
+
+    size_t len = strlen(priv->server) + 1;
+    struct vlc_tls_gnutls_resumption *entry = malloc(sizeof (*entry) + len);
+    if (unlikely(entry == NULL))
+    {
+        gnutls_free(data.data);
+        return;
+    }
+    entry->data = data;
+    memcpy(entry->server, priv->server, len);
+
+    vlc_mutex_lock(&sys->lock);
+    vlc_list_foreach(r, &sys->resumptions, node)
+        if (!strcmp(r->server, priv->server))
+        {   /* Replace the previous data for the same server */
+            vlc_list_remove(&r->node);
+            gnutls_free(r->data.data);
+            free(r);
+            sys->resumption_count--;
+            break;
+        }
+
+    if (sys->resumption_count >= MAX_RESUMPTIONS)
+    {   /* Forget the oldest session */
+        r = vlc_list_last_entry_or_null(&sys->resumptions,
+                                        struct vlc_tls_gnutls_resumption, node);
+        vlc_list_remove(&r->node);
+        gnutls_free(r->data.data);
+        free(r);
+        sys->resumption_count--;
+    }
+
+    vlc_list_prepend(&entry->node, &sys->resumptions);
+    sys->resumption_count++;
+    vlc_mutex_unlock(&sys->lock);
+}
+
 static void gnutls_Close (vlc_tls_t *tls)
 {
     vlc_tls_gnutls_t *priv = (vlc_tls_gnutls_t *)tls;
 
+    if (priv->client != NULL && priv->server != NULL && priv->handshaked)
+        gnutls_SaveSession(priv);
+
     gnutls_deinit(priv->session);
+    free(priv->server);
     free(priv);
 }
 
@@ -297,6 +373,9 @@ static vlc_tls_gnutls_t *gnutls_SessionOpen(vlc_object_t *obj, int type,
 
     priv->session = session;
     priv->obj = obj;
+    priv->client = NULL;
+    priv->server = NULL;
+    priv->handshaked = false;
 
     vlc_tls_t *tls = &priv->tls;
 
@@ -354,6 +433,8 @@ static int gnutls_Handshake(vlc_tls_t *tls, char **restrict alp)
         msg_Dbg(obj, " - encrypt then MAC (RFC7366) enabled");
     if (flags & GNUTLS_SFLAGS_FALSE_START)
         msg_Dbg(obj, " - false start (RFC7918) enabled");
+    if (gnutls_session_is_resumed(session))
+        msg_Dbg(obj, " - session resumed");
 
     if (alp != NULL)
     {
@@ -379,8 +460,9 @@ static vlc_tls_t *gnutls_ClientSessionOpen(vlc_tls_client_t *crd,
                                            vlc_tls_t *sk, const char *hostname,
                                            const char *const *alpn)
 {
+    vlc_tls_gnutls_client_t *sys = crd->sys;
     vlc_tls_gnutls_t *priv = gnutls_SessionOpen(VLC_OBJECT(crd), GNUTLS_CLIENT,
-                                                crd->sys, sk, alpn);
+                                                sys->x509, sk, alpn);
     if (priv == NULL)
         return NULL;
 
@@ -389,11 +471,41 @@ static vlc_tls_t *gnutls_ClientSessionOpen(vlc_tls_client_t *crd,
     /* minimum DH prime bits */
     gnutls_dh_set_prime_bits (session, 1024);
 
+    priv->client = sys;
+
     if (likely(hostname != NULL))
+    {
         /* fill Server Name Indication */
         gnutls_server_name_set (session, GNUTLS_NAME_DNS,
                                 hostname, strlen (hostname));
 
+        /* resume the previous session with the same server, if any: the
+         * port is that of the peer, i.e. of the proxy when tunnelling */
+        int port = 0;
+        char addr[NI_MAXNUMERICHOST];
+        int fd = vlc_tls_GetFD(sk);
+
+        if (fd < 0 || net_GetPeerAddress(fd, addr, &port))
+            port = 0;
+        if (asprintf(&priv->server, "%s:%d", hostname, port) < 0)
+            priv->server = NULL;
+
+        if (priv->server != NULL)
+        {
+            struct vlc_tls_gnutls_resumption *r;
+
+            vlc_mutex_lock(&sys->lock);
+            vlc_list_foreach(r, &sys->resumptions, node)
+                if (!strcmp(r->server, priv->server))
+                {
+                    gnutls_session_set_data(session, r->data.data,
+                                            r->data.size);
+                    break;
+                }
+            vlc_mutex_unlock(&sys->lock);
+        }
+    }
+
     return &priv->tls;
 }
 
@@ -421,7 +533,10 @@ static int gnutls_ClientHandshake(vlc_tls_t *tls,
     }
 
     if (status == 0) /* Good certificate */
+    {
+        priv->handshaked = true;
         return 0;
+    }
 
     /* Bad certificate */
     gnutls_datum_t desc;
@@ -533,9 +648,16 @@ error:
 
 static void gnutls_ClientDestroy(vlc_tls_client_t *crd)
 {
-    gnutls_certificate_credentials_t x509 = crd->sys;
+    vlc_tls_gnutls_client_t *sys = crd->sys;
+    struct vlc_tls_gnutls_resumption *r;
 
-    gnutls_certificate_free_credentials(x509);
+    vlc_list_foreach(r, &sys->resumptions, node)
+    {
+        gnutls_free(r->data.data);
+        free(r);
+    }
+    gnutls_certificate_free_credentials(sys->x509);
+    free(sys);
 }
 
 static const struct vlc_tls_client_operations gnutls_ClientOps =
@@ -554,11 +676,16 @@ static int OpenClient(vlc_tls_client_t *crd)
 
     gnutls_Banner(VLC_OBJECT(crd));
 
+    vlc_tls_gnutls_client_t *sys = malloc(sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return VLC_ENOMEM;
+
     int val = gnutls_certificate_allocate_credentials (&x509);
     if (val != 0)
     {
         msg_Err (crd, "cannot allocate credentials: %s",
                  gnutls_strerror (val));
+        free(sys);
         return VLC_EGENERIC;
     }
 
@@ -588,8 +715,13 @@ static int OpenClient(vlc_tls_client_t *crd)
     gnutls_certificate_set_verify_flags (x509,
                                          GNUTLS_VERIFY_ALLOW_X509_V1_CA_CRT);
 
+    sys->x509 = x509;
+    vlc_mutex_init(&sys->lock);
+    vlc_list_init(&sys->resumptions);
+    sys->resumption_count = 0;
+
     crd->ops = &gnutls_ClientOps;
-    crd->sys = x509;
+    crd->sys = sys;
     return VLC_SUCCESS;
 }
 
@@ -601,6 +733,7 @@ typedef struct vlc_tls_creds_sys
 {
     gnutls_certificate_credentials_t x509_cred;
     gnutls_dh_params_t dh_params;
+    gnutls_datum_t ticket_key; /* to let clients resume their sessions */
 } vlc_tls_creds_sys_t;
 
 /**
@@ -613,7 +746,12 @@ static vlc_tls_t *gnutls_ServerSessionOpen(vlc_tls_server_t *crd,
     vlc_tls_creds_sys_t *sys = crd->sys;
     vlc_tls_gnutls_t *priv = gnutls_SessionOpen(VLC_OBJECT(crd), GNUTLS_SERVER,
                                                 sys->x509_cred, sk, alpn);
-    return (priv != NULL) ? &priv->tls : NULL;
+    if (priv == NULL)
+        return NULL;
+
+    if (sys->ticket_key.data != NULL)
+        gnutls_session_ticket_enable_server(priv->session, &sys->ticket_key);
+    return &priv->tls;
 }
 
 static void gnutls_ServerDestroy(vlc_tls_server_t *crd)
@@ -623,6 +761,11 @@ static void gnutls_ServerDestroy(vlc_tls_server_t *crd)
     /* all sessions depending on the server are now deinitialized */
     gnutls_certificate_free_credentials(sys->x509_cred);
     gnutls_dh_params_deinit(sys->dh_params);
+    if (sys->ticket_key.data != NULL)
+    {
+        gnutls_memset(sys->ticket_key.data, 0, sys->ticket_key.size);
+        gnutls_free(sys->ticket_key.data);
+    }
     free(sys);
 }
 
@@ -713,6 +856,10 @@ static int OpenServer(vlc_tls_server_t *crd, const char *cert, const char *key)
 
     msg_Dbg (crd, "ciphers parameters loaded");
 
+    /* Without a ticket key, sessions are not resumed */
+    if (gnutls_session_ticket_key_generate (&sys->ticket_key) != 0)
+        sys->ticket_key.data = NULL;
+
     crd->ops = &gnutls_ServerOps;
     crd->sys = sys;
     return VLC_SUCCESS;
@@ -58,6 +58,13 @@
     "\"Fast Start\" files are optimized for downloads and allow the user " \
     "to start previewing the file while it is downloading.")
 
+#define MOOV_RESERVE_TEXT N_("Space reserved for the index (KiB)")
+#define MOOV_RESERVE_LONGTEXT N_(\
+    "Space to reserve at the start of \"Fast Start\" files for the index, " \
+    "in KiB. If the index fits, the file does not need to be rewritten " \
+    "when the muxer stops. The index takes roughly 30 KiB per minute of " \
+    "video. 0 disables the reservation.")
+
 static int  Open   (vlc_object_t *);
 static void Close  (vlc_object_t *);
 static void CloseFrag  (vlc_object_t *);
@@ -71,6 +78,8 @@ vlc_module_begin ()
 
     add_bool(SOUT_CFG_PREFIX "faststart", false,
               FASTSTART_TEXT, FASTSTART_LONGTEXT)
+    add_integer_with_range(SOUT_CFG_PREFIX "moov-reserve", 0, 0, 1 << 20,
+                           MOOV_RESERVE_TEXT, MOOV_RESERVE_LONGTEXT)
     set_capability("sout mux", 5)
     add_shortcut("mp4", "mov", "3gp")
     set_callbacks(Open, Close)
@@ -89,7 +98,7 @@ vlc_module_end ()
  * Exported prototypes
  *****************************************************************************/
 static const char *const ppsz_sout_options[] = {
-    "faststart", NULL
+    "faststart", "moov-reserve", NULL
 };
 
 static int Control(sout_mux_t *, int, va_list);
@@ -165,6 +174,8 @@ typedef struct
 
     uint64_t i_mdat_pos;
     uint64_t i_pos;
+    uint64_t i_reserve_pos; /* space reserved for the fast start moov */
+    uint64_t i_reserve_size;
     vlc_tick_t  i_read_duration;
     vlc_tick_t  i_start_dts;
 
@@ -265,6 +276,31 @@ static int WriteSlowStartHeader(sout_mux_t *p_mux)
         box_send(p_mux, box);
     }
 
+    /* Reserve space for the moov, as a free box, so that it can be written
+     * in place at the end */
+    p_sys->i_reserve_pos = p_sys->i_pos;
+    if (var_GetBool(p_mux, SOUT_CFG_PREFIX "faststart"))
+    {
+        uint64_t i_reserve = var_GetInteger(p_mux, SOUT_CFG_PREFIX "moov-reserve");
+        if (i_reserve > 0)
+        {
+            i_reserve *= 1024;
+            block_t *p_free = block_Alloc(i_reserve);
+            if (!p_free)
+                return VLC_ENOMEM;
+            memset(p_free->p_buffer, 0, i_reserve);
+            SetDWBE(p_free->p_buffer, i_reserve);
+            memcpy(&p_free->p_buffer[4], "free", 4);
+
+            if (sout_AccessOutWrite(p_mux->p_access, p_free) == (ssize_t) i_reserve)
+            {
+                p_sys->i_reserve_size = i_reserve;
+                p_sys->i_pos += i_reserve;
+                p_sys->i_mdat_pos = p_sys->i_pos;
+            }
+        }
+    }
+
     /* Now add mdat header */
     box = box_new("mdat");
     if(!box)
@@ -310,6 +346,8 @@ static int Open(vlc_object_t *p_this)
     p_sys->i_nb_streams = 0;
     p_sys->pp_streams   = NULL;
     p_sys->i_mdat_pos   = 0;
+    p_sys->i_reserve_pos = 0;
+    p_sys->i_reserve_size = 0;
     p_sys->b_header_sent = false;
 
     p_sys->i_read_duration   = 0;
@@ -336,6 +374,61 @@ static int Open(vlc_object_t *p_this)
     return VLC_SUCCESS;
 }
 
+/* Returns by how much the mdat must be moved for a moov of the given size to
+ * fit in the reserved space, leaving either no space or room for a free box */
+static uint64_t GetMdatShift(uint64_t i_reserve, uint64_t i_moov)
+{
+    if (i_moov > i_reserve)
+        return i_moov - i_reserve;
+    if (i_reserve - i_moov < 8 && i_reserve != i_moov)
+        return 8 - (i_reserve - i_moov);
+    return 0;
+}
+
+#define MDAT_MOVE_CHUNK (4 << 20)
+
+/* Moves the mdat by i_shift bytes towards the end of the file. Returns
+ * VLC_EGENERIC if nothing could be moved */
+static int MoveMdat(sout_mux_t *p_mux, uint64_t i_shift)
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    uint64_t i_mdatsize = p_sys->i_pos - p_sys->i_mdat_pos;
+
+    int ret = sout_AccessOutMoveRange(p_mux->p_access, p_sys->i_mdat_pos,
+                                      p_sys->i_mdat_pos + i_shift, i_mdatsize);
+    if (ret != VLC_EGENERIC)
+        return ret;
+
+    /* The access output cannot move data by itself, copy it from the end,
+     * so that nothing is overwritten before being read */
+    for (uint64_t i_left = i_mdatsize; i_left > 0;)
+    {
+        size_t i_chunk = __MIN(MDAT_MOVE_CHUNK, i_left);
+        block_t *p_buf = block_Alloc(i_chunk);
+        if (!p_buf)
+            return i_left == i_mdatsize ? VLC_EGENERIC : VLC_ENOMEM;
+
+        sout_AccessOutSeek(p_mux->p_access,
+                           p_sys->i_mdat_pos + i_left - i_chunk);
+        ssize_t i_read = sout_AccessOutRead(p_mux->p_access, p_buf);
+        if (i_read < 0 || (size_t) i_read < i_chunk)
+        {
+            block_Release(p_buf);
+            if (i_left < i_mdatsize)
+                return -EIO;
+            msg_Warn(p_mux, "read() not supported by access output, "
+                      "won't create a fast start file");
+            return VLC_EGENERIC;
+        }
+        sout_AccessOutSeek(p_mux->p_access,
+                           p_sys->i_mdat_pos + i_left + i_shift - i_chunk);
+        if (sout_AccessOutWrite(p_mux->p_access, p_buf) < (ssize_t) i_chunk)
+            return -EIO;
+        i_left -= i_chunk;
+    }
+    return VLC_SUCCESS;
+}
+
 /*****************************************************************************
  * Close:
  *****************************************************************************/
@@ -373,18 +466,19 @@ static void Close(vlc_object_t *p_this)
         mp4mux_Set64BitExt(p_sys->muxh);
 
     uint64_t i_moov_pos = p_sys->i_pos;
+    uint64_t i_free_size = 0;
     bo_t *moov = mp4mux_GetMoov(p_sys->muxh, VLC_OBJECT(p_mux), 0);
 
     /* Check we need to create "fast start" files */
     p_sys->b_fast_start = var_GetBool(p_this, SOUT_CFG_PREFIX "faststart");
     while (p_sys->b_fast_start && moov && moov->b)
     {
-        /* Move data to the end of the file so we can fit the moov header
-         * at the start */
-        uint64_t i_mdatsize = p_sys->i_pos - p_sys->i_mdat_pos;
+        /* Move data towards the end of the file, if the reserved space (if
+         * any) is too small, so we can fit the moov header at the start */
+        uint64_t i_shift = GetMdatShift(p_sys->i_reserve_size, bo_size(moov));
 
         /* moving samples will need new moov with 64bit atoms ? */
-        if(!b_64bitext && p_sys->i_pos + bo_size(moov) > UINT32_MAX)
+        if(!b_64bitext && i_shift > 0 && p_sys->i_pos + i_shift > UINT32_MAX)
         {
             mp4mux_Set64BitExt(p_sys->muxh);
             b_64bitext = true;
@@ -394,51 +488,51 @@ static void Close(vlc_object_t *p_this)
             {
                 bo_free(moov);
                 moov = moov64;
+                i_shift = GetMdatShift(p_sys->i_reserve_size, bo_size(moov));
             }
         }
         /* We now know our final MOOV size */
 
-        /* Fix-up samples to chunks table in MOOV header to they point to next MDAT location */
-        mp4mux_ShiftSamples(p_sys->muxh, bo_size(moov));
-        msg_Dbg(p_this,"Moving data by %"PRIu64, (uint64_t)bo_size(moov));
-        bo_t *shifted = mp4mux_GetMoov(p_sys->muxh, VLC_OBJECT(p_mux), 0);
-        if(!shifted)
+        if (i_shift > 0)
         {
-            /* fail */
-            p_sys->b_fast_start = false;
-            continue;
-        }
-        assert(bo_size(shifted) == bo_size(moov));
-        bo_free(moov);
-        moov = shifted;
+            /* Fix-up samples to chunks table in MOOV header to they point to next MDAT location */
+            mp4mux_ShiftSamples(p_sys->muxh, i_shift);
+            msg_Dbg(p_this,"Moving data by %"PRIu64, i_shift);
+            bo_t *shifted = mp4mux_GetMoov(p_sys->muxh, VLC_OBJECT(p_mux), 0);
+            if(!shifted)
+            {
+                /* fail */
+                mp4mux_ShiftSamples(p_sys->muxh, -(int64_t) i_shift);
+                p_sys->b_fast_start = false;
+                continue;
+            }
+            assert(bo_size(shifted) == bo_size(moov));
+            bo_free(moov);
+            moov = shifted;
 
-        /* Make space, move MDAT data by moov size towards the end */
-        while (i_mdatsize > 0)
-        {
-            size_t i_chunk = __MIN(32768, i_mdatsize);
-            block_t *p_buf = block_Alloc(i_chunk);
-            sout_AccessOutSeek(p_mux->p_access,
-                                p_sys->i_mdat_pos + i_mdatsize - i_chunk);
-            ssize_t i_read = sout_AccessOutRead(p_mux->p_access, p_buf);
-            if (i_read < 0 || (size_t) i_read < i_chunk) {
-                msg_Warn(p_this, "read() not supported by access output, "
-                          "won't create a fast start file");
+            /* Make space, move MDAT data towards the end */
+            int ret = MoveMdat(p_mux, i_shift);
+            if (ret == VLC_EGENERIC)
+            {
+                /* Nothing moved: write the moov at the end instead */
+                mp4mux_ShiftSamples(p_sys->muxh, -(int64_t) i_shift);
+                bo_t *unshifted = mp4mux_GetMoov(p_sys->muxh, VLC_OBJECT(p_mux), 0);
+                bo_free(moov);
+                moov = unshifted;
                 p_sys->b_fast_start = false;
-                block_Release(p_buf);
-                break;
+                continue;
             }
-            sout_AccessOutSeek(p_mux->p_access, p_sys->i_mdat_pos + i_mdatsize +
-                               bo_size(moov) - i_chunk);
-            sout_AccessOutWrite(p_mux->p_access, p_buf);
-            i_mdatsize -= i_chunk;
-        }
+            if (ret != VLC_SUCCESS)
+                msg_Err(p_this, "cannot move data, the file is corrupted");
 
-        if (!p_sys->b_fast_start) /* failed above */
-            continue;
+            /* Update pos pointers */
+            p_sys->i_mdat_pos += i_shift;
+        }
+        else
+            msg_Dbg(p_this, "moov fits in the reserved space");
 
-        /* Update pos pointers */
-        i_moov_pos = p_sys->i_mdat_pos;
-        p_sys->i_mdat_pos += bo_size(moov);
+        i_moov_pos = p_sys->i_reserve_pos;
+        i_free_size = p_sys->i_mdat_pos - i_moov_pos - bo_size(moov);
 
         p_sys->b_fast_start = false;
     }
@@ -448,6 +542,18 @@ static void Close(vlc_object_t *p_this)
     if (moov != NULL)
         box_send(p_mux, moov);
 
+    /* Pad the rest of the reserved space, the data is not relevant */
+    if (i_free_size > 0)
+    {
+        assert(i_free_size >= 8);
+        if (bo_init(&bo, 8))
+        {
+            bo_add_32be  (&bo, i_free_size);
+            bo_add_fourcc(&bo, "free");
+            sout_AccessOutWrite(p_mux->p_access, bo.b);
+        }
+    }
+
 cleanup:
     /* Clean-up */
     for (unsigned int i_trak = 0; i_trak < p_sys->i_nb_streams; i_trak++)
@@ -38,6 +38,11 @@ struct csa_t
 {
     bool    use_odd;
     struct dvbcsa_key_s *keys[2];
+
+    /* bitsliced batches */
+    struct dvbcsa_bs_key_s *bs_keys[2];
+    struct dvbcsa_bs_batch_s *batch; /* batch_size + 1 entries */
+    unsigned batch_size;
 };
 
 /*****************************************************************************
@@ -46,18 +51,24 @@ struct csa_t
 csa_t *csa_New( void )
 {
     csa_t *csa = calloc( 1, sizeof( csa_t ) );
-    if(csa)
+    if( !csa )
+        return NULL;
+
+    csa->batch_size = dvbcsa_bs_batch_size();
+    csa->batch = vlc_alloc( csa->batch_size + 1, sizeof( *csa->batch ) );
+    for( int i = 0; i < 2; i++ )
     {
-        csa->keys[0] = dvbcsa_key_alloc();
-        if(csa->keys[0])
-            csa->keys[1] = dvbcsa_key_alloc();
-        if(csa->keys[1])
-            return csa;
-        else
-            dvbcsa_key_free(csa->keys[0]);
+        csa->keys[i] = dvbcsa_key_alloc();
+        csa->bs_keys[i] = dvbcsa_bs_key_alloc();
     }
-    free(csa);
-    return NULL;
+
+    if( !csa->batch || !csa->keys[0] || !csa->keys[1] ||
+        !csa->bs_keys[0] || !csa->bs_keys[1] )
+    {
+        csa_Delete( csa );
+        return NULL;
+    }
+    return csa;
 }
 
 /*****************************************************************************
@@ -65,8 +76,14 @@ csa_t *csa_New( void )
  *****************************************************************************/
 void csa_Delete( csa_t *c )
 {
-    dvbcsa_key_free( c->keys[0] );
-    dvbcsa_key_free( c->keys[1] );
+    for( int i = 0; i < 2; i++ )
+    {
+        if( c->keys[i] )
+            dvbcsa_key_free( c->keys[i] );
+        if( c->bs_keys[i] )
+            dvbcsa_bs_key_free( c->bs_keys[i] );
+    }
+    free( c->batch );
     free( c );
 }
 
@@ -104,6 +121,7 @@ int csa_SetCW( vlc_object_t *p_caller, csa_t *c, char *psz_ck, bool set_odd )
 # endif
 
         dvbcsa_key_set( ck, c->keys[set_odd ? 1 : 0] );
+        dvbcsa_bs_key_set( ck, c->bs_keys[set_odd ? 1 : 0] );
 
         return VLC_SUCCESS;
     }
@@ -197,6 +215,117 @@ void csa_Encrypt( csa_t *c, uint8_t *pkt, int i_pkt_size )
 
     dvbcsa_encrypt(key, &pkt[i_hdr], i_pkt_size - i_hdr);
 }
+
+/*****************************************************************************
+ * csa_GetBatchSize:
+ *****************************************************************************/
+unsigned csa_GetBatchSize( const csa_t *c )
+{
+    return c->batch_size;
+}
+
+static void BatchFlush( csa_t *c, unsigned *pi_count, unsigned *pi_maxlen,
+                        bool odd, bool encrypt )
+{
+    if( *pi_count == 0 )
+        return;
+
+    c->batch[*pi_count].data = NULL;
+    /* the maximum length must be a multiple of 8 */
+    unsigned maxlen = (*pi_maxlen + 7) & ~7u;
+    if( encrypt )
+        dvbcsa_bs_encrypt( c->bs_keys[odd], c->batch, maxlen );
+    else
+        dvbcsa_bs_decrypt( c->bs_keys[odd], c->batch, maxlen );
+    *pi_count = 0;
+    *pi_maxlen = 0;
+}
+
+static void BatchAdd( csa_t *c, unsigned *pi_count, unsigned *pi_maxlen,
+                      uint8_t *p_data, unsigned i_len )
+{
+    c->batch[*pi_count].data = p_data;
+    c->batch[*pi_count].len = i_len;
+    (*pi_count)++;
+    if( i_len > *pi_maxlen )
+        *pi_maxlen = i_len;
+}
+
+/*****************************************************************************
+ * csa_DecryptBatch:
+ *****************************************************************************/
+void csa_DecryptBatch( csa_t *c, uint8_t *const *pp_pkts, size_t i_pkts,
+                       int i_pkt_size )
+{
+    /* One pass per key: packets using the other key are left for the next
+     * pass, and descrambled packets are no longer marked as scrambled */
+    for( int odd = 0; odd < 2; odd++ )
+    {
+        unsigned i_count = 0, i_maxlen = 0;
+
+        for( size_t i = 0; i < i_pkts; i++ )
+        {
+            uint8_t *pkt = pp_pkts[i];
+
+            /* transport scrambling control */
+            if( (pkt[3]&0x80) == 0 || !(pkt[3]&0x40) != !odd )
+                continue;
+
+            /* clear transport scrambling control */
+            pkt[3] &= 0x3f;
+
+            int i_hdr = 4;
+            if( pkt[3]&0x20 )
+            {
+                /* skip adaption field */
+                i_hdr += pkt[4] + 1;
+            }
+
+            if( 188 - i_hdr < 8 || i_pkt_size <= i_hdr )
+                continue;
+
+            BatchAdd( c, &i_count, &i_maxlen, &pkt[i_hdr], i_pkt_size - i_hdr );
+            if( i_count == c->batch_size )
+                BatchFlush( c, &i_count, &i_maxlen, odd, false );
+        }
+        BatchFlush( c, &i_count, &i_maxlen, odd, false );
+    }
+}
+
+/*****************************************************************************
+ * csa_EncryptBatch:
+ *****************************************************************************/
+void csa_EncryptBatch( csa_t *c, uint8_t *const *pp_pkts, size_t i_pkts,
+                       int i_pkt_size )
+{
+    unsigned i_count = 0, i_maxlen = 0;
+
+    for( size_t i = 0; i < i_pkts; i++ )
+    {
+        uint8_t *pkt = pp_pkts[i];
+
+        /* set transport scrambling control */
+        pkt[3] |= c->use_odd ? 0xc0 : 0x80;
+
+        int i_hdr = 4;
+        if( pkt[3]&0x20 )
+        {
+            /* skip adaption field */
+            i_hdr += pkt[4] + 1;
+        }
+
+        if( (i_pkt_size - i_hdr) / 8 <= 0 )
+        {
+            pkt[3] &= 0x3f;
+            continue;
+        }
+
+        BatchAdd( c, &i_count, &i_maxlen, &pkt[i_hdr], i_pkt_size - i_hdr );
+        if( i_count == c->batch_size )
+            BatchFlush( c, &i_count, &i_maxlen, c->use_odd, true );
+    }
+    BatchFlush( c, &i_count, &i_maxlen, c->use_odd, true );
+}
 #else
 
 csa_t *csa_New( void )
@@ -239,4 +368,28 @@ void csa_Encrypt( csa_t *c, uint8_t *pkt, int i_pkt_size )
     VLC_UNUSED(i_pkt_size);
 }
 
+unsigned csa_GetBatchSize( const csa_t *c )
+{
+    VLC_UNUSED(c);
+    return 1;
+}
+
+void csa_DecryptBatch( csa_t *c, uint8_t *const *pp_pkts, size_t i_pkts,
+                       int i_pkt_size )
+{
+    VLC_UNUSED(c);
+    VLC_UNUSED(pp_pkts);
+    VLC_UNUSED(i_pkts);
+    VLC_UNUSED(i_pkt_size);
+}
+
+void csa_EncryptBatch( csa_t *c, uint8_t *const *pp_pkts, size_t i_pkts,
+                       int i_pkt_size )
+{
+    VLC_UNUSED(c);
+    VLC_UNUSED(pp_pkts);
+    VLC_UNUSED(i_pkts);
+    VLC_UNUSED(i_pkt_size);
+}
+
 #endif
@@ -34,4 +34,13 @@ void   csa_UseKey( vlc_object_t *p_caller, csa_t *, bool use_odd );
 void   csa_Decrypt( csa_t *, uint8_t *pkt, int i_pkt_size );
 void   csa_Encrypt( csa_t *, uint8_t *pkt, int i_pkt_size );
 
+/* Batched variants, several times faster with many packets. Packets may
+ * mix both keys when decrypting. */
+#define TS_CSA_BATCH_MAX 256 /* packets processed at once by callers, at most */
+unsigned csa_GetBatchSize( const csa_t * );
+void   csa_DecryptBatch( csa_t *, uint8_t *const *pp_pkts, size_t i_pkts,
+                         int i_pkt_size );
+void   csa_EncryptBatch( csa_t *, uint8_t *const *pp_pkts, size_t i_pkts,
+                         int i_pkt_size );
+
 #endif /* _CSA_H */
@@ -0,0 +1,85 @@
+/*****************************************************************************
+ * adts.h: ADTS (MPEG-2/4 AAC) frame header parser
+ *****************************************************************************
+ * Copyright (C) 2001-2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_ADTS_H_
+#define VLC_ADTS_H_
+
+/**
+ * Minimum ADTS header size that vlc_adts_header_Parse needs.
+ */
+#define VLC_ADTS_MIN_HEADER_SIZE (7)
+
+/**
+ * Sampling frequencies of the MPEG-4 audio sampling frequency index.
+ */
+static const unsigned vlc_mpeg4_sample_rates[16] =
+{
+    96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050,
+    16000, 12000, 11025, 8000,  7350,  0,     0,     0
+};
+
+/**
+ * ADTS header information.
+ */
+typedef struct
+{
+    unsigned i_profile;     /* audio object type minus 1 */
+    unsigned i_rate_index;
+    unsigned i_rate;
+    unsigned i_channels;    /* channel configuration, 0 if in the payload */
+    unsigned i_frame_size;  /* including the header */
+    unsigned i_header_size; /* 9 with a CRC, 7 otherwise */
+    unsigned i_raw_blocks;  /* raw data blocks in the frame */
+} vlc_adts_header_t;
+
+static inline bool vlc_adts_HasSync( const uint8_t *p_buf )
+{
+    /* syncword, layer 0 */
+    return p_buf[0] == 0xff && (p_buf[1] & 0xf6) == 0xf0;
+}
+
+/**
+ * It parses an ADTS header of VLC_ADTS_MIN_HEADER_SIZE bytes.
+ */
+static inline int vlc_adts_header_Parse( vlc_adts_header_t *p_header,
+                                         const uint8_t *p_buf )
+{
+    if( !vlc_adts_HasSync( p_buf ) )
+        return VLC_EGENERIC;
+
+    /* Fixed header between frames */
+    p_header->i_header_size = (p_buf[1] & 0x01) ? 7 : 9; /* protection_absent */
+    p_header->i_profile = p_buf[2] >> 6;
+    p_header->i_rate_index = (p_buf[2] >> 2) & 0x0f;
+    p_header->i_rate = vlc_mpeg4_sample_rates[p_header->i_rate_index];
+    p_header->i_channels = ((p_buf[2] & 0x01) << 2) | ((p_buf[3] >> 6) & 0x03);
+
+    /* Variable header */
+    p_header->i_frame_size = ((p_buf[3] & 0x03) << 11) | (p_buf[4] << 3) |
+                             (p_buf[5] >> 5);
+    p_header->i_raw_blocks = (p_buf[6] & 0x03) + 1;
+
+    if( p_header->i_rate == 0 ||
+        p_header->i_frame_size < p_header->i_header_size )
+        return VLC_EGENERIC;
+    return VLC_SUCCESS;
+}
+
+#endif
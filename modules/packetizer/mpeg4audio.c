@@ -38,6 +38,7 @@
 #include <vlc_block_helper.h>
 #include "packetizer_helper.h"
 #include "mpeg4audio.h"
+#include "adts.h"
 
 #include <assert.h>
 
@@ -167,12 +168,6 @@ enum {
     TYPE_LOAS
 };
 
-static const int pi_sample_rates[16] =
-{
-    96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050,
-    16000, 12000, 11025, 8000,  7350,  0,     0,     0
-};
-
 
 static int ChannelConfigurationToVLC(uint8_t i_channel)
 {
@@ -400,35 +395,23 @@ static int ADTSSyncInfo(decoder_t * p_dec, const uint8_t * p_buf,
                          unsigned int * pi_frame_length,
                          unsigned int * pi_header_size)
 {
-    int i_profile, i_sample_rate_idx, i_frame_size;
-    bool b_crc;
-
-    /* Fixed header between frames */
-    //int i_id = ((p_buf[1] >> 3) & 0x01) ? 2 : 4; /* MPEG-2 or 4 */
-    b_crc = !(p_buf[1] & 0x01);
-    i_profile = p_buf[2] >> 6;
-    i_sample_rate_idx = (p_buf[2] >> 2) & 0x0f;
-    *pi_sample_rate = pi_sample_rates[i_sample_rate_idx];
-    //private_bit = (p_buf[2] >> 1) & 0x01;
-    *pi_channels = ((p_buf[2] & 0x01) << 2) | ((p_buf[3] >> 6) & 0x03);
-    if (*pi_channels == 0) /* workaround broken streams */
-        *pi_channels = 2;
-    //original_copy = (p_buf[3] >> 5) & 0x01;
-    //home = (p_buf[3] >> 4) & 0x01;
-
-    /* Variable header */
-    //copyright_id_bit = (p_buf[3] >> 3) & 0x01;
-    //copyright_id_start = (p_buf[3] >> 2) & 0x01;
-    i_frame_size = ((p_buf[3] & 0x03) << 11) | (p_buf[4] << 3) |
-                   ((p_buf[5] >> 5) /*& 0x7*/);
-    //uint16_t buffer_fullness = ((p_buf[5] & 0x1f) << 6) | (p_buf[6] >> 2);
-    unsigned short i_raw_blocks_in_frame = p_buf[6] & 0x03;
-
-    if (!*pi_sample_rate || !i_frame_size) {
+    vlc_adts_header_t header;
+
+    if (vlc_adts_header_Parse(&header, p_buf) != VLC_SUCCESS) {
         msg_Warn(p_dec, "Invalid ADTS header");
         return 0;
     }
 
+    const bool b_crc = header.i_header_size > VLC_ADTS_MIN_HEADER_SIZE;
+    const unsigned i_profile = header.i_profile;
+    const unsigned i_sample_rate_idx = header.i_rate_index;
+    const unsigned i_raw_blocks_in_frame = header.i_raw_blocks - 1;
+
+    *pi_sample_rate = header.i_rate;
+    *pi_channels = header.i_channels;
+    if (*pi_channels == 0) /* workaround broken streams */
+        *pi_channels = 2;
+
     *pi_frame_length = 1024;
 
     if (i_raw_blocks_in_frame == 0) {
@@ -478,9 +461,9 @@ static int ADTSSyncInfo(decoder_t * p_dec, const uint8_t * p_buf,
     }
 
     /* ADTS header length */
-    *pi_header_size = b_crc ? 9 : 7;
+    *pi_header_size = header.i_header_size;
 
-    return i_frame_size - *pi_header_size;
+    return header.i_frame_size - *pi_header_size;
 }
 
 /****************************************************************************
@@ -633,7 +616,7 @@ static unsigned Mpeg4ReadAudioSamplerate(bs_t *s)
 {
     int i_index = bs_read(s, 4);
     if (i_index != 0x0f)
-        return pi_sample_rates[i_index];
+        return vlc_mpeg4_sample_rates[i_index];
     return bs_read(s, 24);
 }
 
@@ -1149,11 +1132,6 @@ static void Flush(decoder_t *p_dec)
     p_sys->b_discontuinity = true;
 }
 
-static inline bool HasADTSHeader( const uint8_t *p_header )
-{
-    return p_header[0] == 0xff && (p_header[1] & 0xf6) == 0xf0;
-}
-
 static inline bool HasLoasHeader( const uint8_t *p_header )
 {
     return p_header[0] == 0x56 && (p_header[1] & 0xe0) == 0xe0;
@@ -1182,7 +1160,7 @@ static block_t *PacketizeStreamBlock(decoder_t *p_dec, block_t **pp_block)
         while (block_PeekBytes(&p_sys->bytestream, p_header, 2) == VLC_SUCCESS) {
             /* Look for sync word - should be 0xfff(adts) or 0x2b7(loas) */
             if ((p_sys->i_type == TYPE_ADTS || p_sys->i_type == TYPE_UNKNOWN_NONRAW) &&
-                HasADTSHeader( p_header ) )
+                vlc_adts_HasSync( p_header ) )
             {
                 if (p_sys->i_type != TYPE_ADTS)
                     msg_Dbg(p_dec, "detected ADTS format");
@@ -1274,7 +1252,7 @@ static block_t *PacketizeStreamBlock(decoder_t *p_dec, block_t **pp_block)
         }
 
         assert((p_sys->i_type == TYPE_ADTS) || (p_sys->i_type == TYPE_LOAS));
-        if ( (p_sys->i_type == TYPE_ADTS && !HasADTSHeader( p_header )) ||
+        if ( (p_sys->i_type == TYPE_ADTS && !vlc_adts_HasSync( p_header )) ||
              (p_sys->i_type == TYPE_LOAS && !HasLoasHeader( p_header )) )
         {
             /* Check spacial padding case. Failing if need more bytes is ok since
@@ -1283,7 +1261,7 @@ static block_t *PacketizeStreamBlock(decoder_t *p_dec, block_t **pp_block)
                                       p_sys->i_frame_size + p_sys->i_header_size,
                                       p_header, 3) == VLC_SUCCESS &&
                 p_header[0] == 0x00 &&
-               ((p_sys->i_type == TYPE_ADTS && HasADTSHeader( &p_header[1] )) ||
+               ((p_sys->i_type == TYPE_ADTS && vlc_adts_HasSync( &p_header[1] )) ||
                 (p_sys->i_type == TYPE_LOAS && !HasLoasHeader( &p_header[1] ))))
             {
                 p_sys->i_state = STATE_SEND_DATA;
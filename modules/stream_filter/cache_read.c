@@ -32,6 +32,7 @@
 #include <vlc_plugin.h>
 #include <vlc_stream.h>
 #include <vlc_interrupt.h>
+#include <vlc_membudget.h>
 
 // #define STREAM_DEBUG 1
 
@@ -96,6 +97,7 @@ typedef struct
     /* */
     unsigned     i_used; /* Used since last read */
     unsigned     i_read_size;
+    size_t       i_budget; /* bytes reported to the memory budget */
 
     struct
     {
@@ -106,6 +108,22 @@ typedef struct
     } stat;
 } stream_sys_t;
 
+/* Reports the data held by the tracks to the memory budget */
+static void AStreamUpdateBudget(stream_t *s)
+{
+    stream_sys_t *sys = s->p_sys;
+    size_t i_bytes = 0;
+
+    for (unsigned i = 0; i < STREAM_CACHE_TRACK; i++)
+        i_bytes += sys->tk[i].i_end - sys->tk[i].i_start;
+
+    if (i_bytes > sys->i_budget)
+        vlc_membudget_Add(s, VLC_MEMBUDGET_DEMUX, i_bytes - sys->i_budget);
+    else
+        vlc_membudget_Remove(s, VLC_MEMBUDGET_DEMUX, sys->i_budget - i_bytes);
+    sys->i_budget = i_bytes;
+}
+
 static int AStreamRefillStream(stream_t *s)
 {
     stream_sys_t *sys = s->p_sys;
@@ -141,7 +159,7 @@ static int AStreamRefillStream(stream_t *s)
             continue;
         }
         else if (i_read == 0)
-            return VLC_SUCCESS;
+            break; /* EOF */
 
         /* Update end */
         tk->i_end += i_read;
@@ -163,6 +181,7 @@ static int AStreamRefillStream(stream_t *s)
     }
 
     sys->stat.i_read_time += vlc_tick_now() - start;
+    AStreamUpdateBudget(s);
     return VLC_SUCCESS;
 }
 
@@ -215,6 +234,7 @@ static void AStreamPrebufferStream(stream_t *s)
         tk->i_end += i_read;
         sys->stat.i_read_count++;
     }
+    AStreamUpdateBudget(s);
 }
 
 /****************************************************************************
@@ -521,6 +541,7 @@ static int Open(vlc_object_t *obj)
 
     sys->i_used   = 0;
     sys->i_read_size = STREAM_READ_ATONCE;
+    sys->i_budget = 0;
     static_assert (STREAM_READ_ATONCE >= 256,
                    "Invalid STREAM_READ_ATONCE value");
 
@@ -540,6 +561,7 @@ static int Open(vlc_object_t *obj)
     if (sys->tk[sys->i_tk].i_end <= 0)
     {
         msg_Err(s, "cannot pre fill buffer");
+        vlc_membudget_Remove(s, VLC_MEMBUDGET_DEMUX, sys->i_budget);
         free(sys->p_buffer);
         free(sys);
         return VLC_EGENERIC;
@@ -559,6 +581,7 @@ static void Close(vlc_object_t *obj)
     stream_t *s = (stream_t *)obj;
     stream_sys_t *sys = s->p_sys;
 
+    vlc_membudget_Remove(s, VLC_MEMBUDGET_DEMUX, sys->i_budget);
     free(sys->p_buffer);
     free(sys);
 }
@@ -34,6 +34,7 @@
 #include <vlc_stream.h>
 #include <vlc_fs.h>
 #include <vlc_interrupt.h>
+#include <vlc_membudget.h>
 
 struct stream_ctrl
 {
@@ -73,6 +74,7 @@ typedef struct
     uint64_t     stream_offset;
     size_t       buffer_length;
     size_t       buffer_size;
+    size_t       budget; /* bytes reported to the memory budget */
     char        *buffer;
     size_t       seek_threshold;
 
@@ -124,6 +126,19 @@ static int ThreadControl(stream_t *stream, int query, ...)
     return ret;
 }
 
+/* Reports the filled part of the buffer to the memory budget */
+static void UpdateBudget(stream_t *stream)
+{
+    stream_sys_t *sys = stream->p_sys;
+    size_t length = sys->buffer_length;
+
+    if (length > sys->budget)
+        vlc_membudget_Add(stream, VLC_MEMBUDGET_DEMUX, length - sys->budget);
+    else
+        vlc_membudget_Remove(stream, VLC_MEMBUDGET_DEMUX, sys->budget - length);
+    sys->budget = length;
+}
+
 static void *Thread(void *data)
 {
     vlc_thread_set_name("vlc-prefetch");
@@ -139,6 +154,9 @@ static void *Thread(void *data)
     {
         struct stream_ctrl *ctrl = sys->controls;
 
+        /* Only this thread changes the buffer length */
+        UpdateBudget(stream);
+
         if (unlikely(ctrl != NULL))
         {
             sys->controls = ctrl->next;
@@ -470,6 +488,7 @@ static int Open(vlc_object_t *obj)
     sys->buffer_offset = 0;
     sys->stream_offset = 0;
     sys->buffer_length = 0;
+    sys->budget = 0;
     sys->buffer_size = var_InheritInteger(obj, "prefetch-buffer-size") << 10u;
     sys->seek_threshold = var_InheritInteger(obj, "prefetch-seek-threshold");
     sys->controls = NULL;
@@ -537,6 +556,7 @@ static void Close (vlc_object_t *obj)
         sys->controls = ctrl->next;
         free(ctrl);
     }
+    vlc_membudget_Remove(stream, VLC_MEMBUDGET_DEMUX, sys->budget);
     free(sys->buffer);
     free(sys->content_type);
     free(sys);
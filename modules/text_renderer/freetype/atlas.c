@@ -0,0 +1,336 @@
+/*****************************************************************************
+ * atlas.c : Rasterized glyphs atlas for freetype2
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+
+/* Freetype */
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_GLYPH_H
+
+#include "atlas.h"
+
+#define ATLAS_PAGE_SIZE 512
+#define ATLAS_BUCKETS   1024
+
+/* A glyph rasterized at a given subpixel phase. Positions are relative to
+ * the integer part of the origin. */
+struct atlas_entry
+{
+    struct atlas_entry *p_next;
+    vlc_glyph_atlas_key_t key;
+    FT_Pos i_phase_x;
+    FT_Pos i_phase_y;
+    FT_Vector advance;
+    int i_left;
+    int i_top;
+    unsigned i_width;
+    unsigned i_rows;
+    uint8_t *p_pixels; /* in a page, or NULL if the bitmap is empty */
+};
+
+struct atlas_page
+{
+    uint8_t *p_pixels;
+    unsigned i_x;       /* current shelf cursor */
+    unsigned i_y;       /* current shelf top */
+    unsigned i_shelf;   /* current shelf height */
+};
+
+struct vlc_glyph_atlas
+{
+    struct atlas_entry *buckets[ATLAS_BUCKETS];
+    struct atlas_page *p_pages;
+    unsigned i_max_pages;
+    unsigned i_allocated_pages;
+    unsigned i_current_page;
+    bool b_full;
+    vlc_glyph_atlas_stats_t stats;
+};
+
+vlc_glyph_atlas * vlc_glyph_atlas_New( unsigned i_max_pages )
+{
+    vlc_glyph_atlas *atlas = calloc( 1, sizeof(*atlas) );
+    if( !atlas )
+        return NULL;
+
+    atlas->p_pages = calloc( i_max_pages, sizeof(*atlas->p_pages) );
+    if( !atlas->p_pages )
+    {
+        free( atlas );
+        return NULL;
+    }
+    atlas->i_max_pages = i_max_pages;
+    return atlas;
+}
+
+static void vlc_glyph_atlas_Reset( vlc_glyph_atlas *atlas )
+{
+    for( size_t i = 0; i < ATLAS_BUCKETS; i++ )
+    {
+        for( struct atlas_entry *e = atlas->buckets[i], *next; e; e = next )
+        {
+            next = e->p_next;
+            free( e );
+        }
+        atlas->buckets[i] = NULL;
+    }
+
+    for( unsigned i = 0; i < atlas->i_allocated_pages; i++ )
+    {
+        atlas->p_pages[i].i_x = 0;
+        atlas->p_pages[i].i_y = 0;
+        atlas->p_pages[i].i_shelf = 0;
+    }
+    atlas->i_current_page = 0;
+    atlas->b_full = false;
+    atlas->stats.i_glyphs = 0;
+}
+
+void vlc_glyph_atlas_Delete( vlc_glyph_atlas *atlas )
+{
+    vlc_glyph_atlas_Reset( atlas );
+    for( unsigned i = 0; i < atlas->i_allocated_pages; i++ )
+        free( atlas->p_pages[i].p_pixels );
+    free( atlas->p_pages );
+    free( atlas );
+}
+
+void vlc_glyph_atlas_Trim( vlc_glyph_atlas *atlas )
+{
+    if( atlas->b_full )
+    {
+        vlc_glyph_atlas_Reset( atlas );
+        atlas->stats.i_resets++;
+    }
+}
+
+void vlc_glyph_atlas_GetStats( const vlc_glyph_atlas *atlas,
+                               vlc_glyph_atlas_stats_t *p_stats )
+{
+    *p_stats = atlas->stats;
+    p_stats->i_pages = atlas->i_allocated_pages;
+}
+
+static size_t Hash( const vlc_glyph_atlas_key_t *key,
+                    FT_Pos i_phase_x, FT_Pos i_phase_y )
+{
+    uint64_t h = (uintptr_t) key->p_faceid;
+    h = h * 31 + (unsigned) key->i_width_px;
+    h = h * 31 + (unsigned) key->i_height_px;
+    h = h * 31 + key->i_glyph_index;
+    h = h * 31 + key->i_flags;
+    h = h * 31 + (unsigned) key->i_outline;
+    h = h * 31 + (i_phase_x << 6 | i_phase_y);
+    h *= UINT64_C(0x9E3779B97F4A7C15);
+    return (h >> 32) & (ATLAS_BUCKETS - 1);
+}
+
+static bool KeyEquals( const vlc_glyph_atlas_key_t *a,
+                       const vlc_glyph_atlas_key_t *b )
+{
+    return a->p_faceid == b->p_faceid
+        && a->i_width_px == b->i_width_px
+        && a->i_height_px == b->i_height_px
+        && a->i_glyph_index == b->i_glyph_index
+        && a->i_flags == b->i_flags
+        && a->i_outline == b->i_outline;
+}
+
+/* Allocates a rectangle from the pages, using shelves */
+static uint8_t *AllocRect( vlc_glyph_atlas *atlas, unsigned i_width,
+                           unsigned i_rows )
+{
+    if( i_width > ATLAS_PAGE_SIZE || i_rows > ATLAS_PAGE_SIZE )
+        return NULL;
+
+    while( atlas->i_current_page < atlas->i_max_pages )
+    {
+        if( atlas->i_current_page == atlas->i_allocated_pages )
+        {
+            struct atlas_page *page = &atlas->p_pages[atlas->i_allocated_pages];
+            page->p_pixels = malloc( ATLAS_PAGE_SIZE * ATLAS_PAGE_SIZE );
+            if( !page->p_pixels )
+                break;
+            page->i_x = page->i_y = page->i_shelf = 0;
+            atlas->i_allocated_pages++;
+        }
+
+        struct atlas_page *page = &atlas->p_pages[atlas->i_current_page];
+        if( page->i_x + i_width > ATLAS_PAGE_SIZE )
+        {
+            /* Open a new shelf */
+            page->i_y += page->i_shelf;
+            page->i_x = 0;
+            page->i_shelf = 0;
+        }
+
+        if( page->i_y + i_rows <= ATLAS_PAGE_SIZE )
+        {
+            uint8_t *p = &page->p_pixels[page->i_y * ATLAS_PAGE_SIZE + page->i_x];
+            page->i_x += i_width;
+            if( i_rows > page->i_shelf )
+                page->i_shelf = i_rows;
+            return p;
+        }
+
+        atlas->i_current_page++;
+    }
+
+    atlas->b_full = true;
+    return NULL;
+}
+
+static struct atlas_entry *AddEntry( vlc_glyph_atlas *atlas, size_t i_bucket,
+                                     const vlc_glyph_atlas_key_t *key,
+                                     const FT_Vector *p_phase,
+                                     const FT_BitmapGlyph bitmap )
+{
+    const FT_Bitmap *p_bitmap = &bitmap->bitmap;
+    if( p_bitmap->pixel_mode != FT_PIXEL_MODE_GRAY )
+        return NULL;
+
+    struct atlas_entry *e = malloc( sizeof(*e) );
+    if( !e )
+        return NULL;
+
+    e->p_pixels = NULL;
+    if( p_bitmap->width > 0 && p_bitmap->rows > 0 )
+    {
+        e->p_pixels = AllocRect( atlas, p_bitmap->width, p_bitmap->rows );
+        if( !e->p_pixels )
+        {
+            free( e );
+            return NULL;
+        }
+
+        const uint8_t *src = p_bitmap->buffer;
+        if( p_bitmap->pitch < 0 )
+            src -= (ptrdiff_t) p_bitmap->pitch * (p_bitmap->rows - 1);
+        for( unsigned y = 0; y < p_bitmap->rows; y++ )
+            memcpy( &e->p_pixels[y * ATLAS_PAGE_SIZE],
+                    &src[(ptrdiff_t) y * p_bitmap->pitch], p_bitmap->width );
+    }
+
+    e->key = *key;
+    e->i_phase_x = p_phase->x;
+    e->i_phase_y = p_phase->y;
+    e->advance = bitmap->root.advance;
+    e->i_left = bitmap->left;
+    e->i_top = bitmap->top;
+    e->i_width = p_bitmap->width;
+    e->i_rows = p_bitmap->rows;
+
+    e->p_next = atlas->buckets[i_bucket];
+    atlas->buckets[i_bucket] = e;
+    atlas->stats.i_glyphs++;
+    return e;
+}
+
+static FT_BitmapGlyph Borrow( const struct atlas_entry *e,
+                              const FT_Vector *p_offset )
+{
+    FT_BitmapGlyph glyph = calloc( 1, sizeof(*glyph) );
+    if( !glyph )
+        return NULL;
+
+    /* No class nor library: this is not a FreeType object */
+    glyph->root.format = FT_GLYPH_FORMAT_BITMAP;
+    glyph->root.advance = e->advance;
+    glyph->left = e->i_left;
+    glyph->top = e->i_top;
+    if( e->p_pixels ) /* FreeType does not position empty bitmaps */
+    {
+        glyph->left += p_offset->x / 64;
+        glyph->top += p_offset->y / 64;
+    }
+    glyph->bitmap.rows = e->i_rows;
+    glyph->bitmap.width = e->i_width;
+    glyph->bitmap.pitch = ATLAS_PAGE_SIZE;
+    glyph->bitmap.buffer = e->p_pixels;
+    glyph->bitmap.num_grays = 256;
+    glyph->bitmap.pixel_mode = FT_PIXEL_MODE_GRAY;
+    return glyph;
+}
+
+FT_BitmapGlyph vlc_glyph_atlas_Rasterize( vlc_glyph_atlas *atlas,
+                                          const vlc_glyph_atlas_key_t *key,
+                                          FT_Glyph p_source,
+                                          const FT_Vector *p_origin )
+{
+    FT_Glyph glyph = p_source;
+
+    if( p_source->format != FT_GLYPH_FORMAT_OUTLINE )
+    {
+        /* Only outlines are cached */
+        if( FT_Glyph_To_Bitmap( &glyph, FT_RENDER_MODE_NORMAL,
+                                (FT_Vector *) p_origin, 0 ) )
+            return NULL;
+        return (FT_BitmapGlyph) glyph;
+    }
+
+    /* Split the origin into the subpixel phase, used for rasterization,
+     * and the integer offset, applied to the bitmap position */
+    FT_Vector phase = { p_origin->x & 63, p_origin->y & 63 };
+    const FT_Vector offset = { p_origin->x - phase.x, p_origin->y - phase.y };
+
+    const size_t i_bucket = Hash( key, phase.x, phase.y );
+    for( const struct atlas_entry *e = atlas->buckets[i_bucket]; e; e = e->p_next )
+    {
+        if( e->i_phase_x == phase.x && e->i_phase_y == phase.y
+         && KeyEquals( &e->key, key ) )
+        {
+            atlas->stats.i_hits++;
+            return Borrow( e, &offset );
+        }
+    }
+
+    atlas->stats.i_misses++;
+    if( FT_Glyph_To_Bitmap( &glyph, FT_RENDER_MODE_NORMAL, &phase, 0 ) )
+        return NULL;
+
+    FT_BitmapGlyph bitmap = (FT_BitmapGlyph) glyph;
+    const struct atlas_entry *e = AddEntry( atlas, i_bucket, key, &phase, bitmap );
+    FT_BitmapGlyph borrowed = e ? Borrow( e, &offset ) : NULL;
+    if( !borrowed )
+    {
+        /* Atlas full or unsupported bitmap: keep the owned copy */
+        if( bitmap->bitmap.width > 0 && bitmap->bitmap.rows > 0 )
+        {
+            bitmap->left += offset.x / 64;
+            bitmap->top += offset.y / 64;
+        }
+        return bitmap;
+    }
+
+    FT_Done_Glyph( glyph );
+    return borrowed;
+}
+
+void vlc_glyph_atlas_ReleaseGlyph( FT_BitmapGlyph glyph )
+{
+    if( vlc_glyph_atlas_IsBorrowed( glyph ) )
+        free( glyph );
+    else
+        FT_Done_Glyph( (FT_Glyph) glyph );
+}
@@ -0,0 +1,95 @@
+/*****************************************************************************
+ * atlas.h : Rasterized glyphs atlas for freetype2
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Rasterized glyphs are packed into 8 bits pages, and handed out as bitmap
+ * glyphs borrowing the page pixels. Borrowed glyphs are not FreeType objects:
+ * they must be released with vlc_glyph_atlas_ReleaseGlyph() and never with
+ * FT_Done_Glyph(). */
+typedef struct vlc_glyph_atlas vlc_glyph_atlas;
+
+typedef struct
+{
+    const void *p_faceid;   /* face of the glyph */
+    int i_width_px;         /* face size */
+    int i_height_px;
+    unsigned i_glyph_index;
+    unsigned i_flags;       /* VLC_GLYPH_ATLAS_* */
+    int i_outline;          /* outline thickness, when stroked */
+} vlc_glyph_atlas_key_t;
+
+#define VLC_GLYPH_ATLAS_EMBOLDEN 0x1
+#define VLC_GLYPH_ATLAS_OBLIQUE  0x2
+#define VLC_GLYPH_ATLAS_OUTLINE  0x4
+
+typedef struct
+{
+    unsigned i_hits;
+    unsigned i_misses;
+    unsigned i_glyphs;
+    unsigned i_pages;
+    unsigned i_resets;
+} vlc_glyph_atlas_stats_t;
+
+vlc_glyph_atlas * vlc_glyph_atlas_New( unsigned i_max_pages );
+void vlc_glyph_atlas_Delete( vlc_glyph_atlas * );
+
+/**
+ * Rasterizes a glyph at a 26.6 origin, through the atlas.
+ *
+ * \param p_source outline glyph to rasterize (not released)
+ * \return a bitmap glyph, either borrowed from the atlas or owned,
+ *         or NULL on error
+ */
+FT_BitmapGlyph vlc_glyph_atlas_Rasterize( vlc_glyph_atlas *,
+                                          const vlc_glyph_atlas_key_t *,
+                                          FT_Glyph p_source,
+                                          const FT_Vector *p_origin );
+
+static inline bool vlc_glyph_atlas_IsBorrowed( const FT_BitmapGlyph glyph )
+{
+    return glyph->root.clazz == NULL;
+}
+
+/**
+ * Releases a glyph returned by vlc_glyph_atlas_Rasterize().
+ */
+void vlc_glyph_atlas_ReleaseGlyph( FT_BitmapGlyph );
+
+/**
+ * Starts a new rendering pass.
+ *
+ * If the atlas filled up during the previous pass, it is emptied. No glyph
+ * borrowed from the atlas must be alive at this point.
+ */
+void vlc_glyph_atlas_Trim( vlc_glyph_atlas * );
+
+void vlc_glyph_atlas_GetStats( const vlc_glyph_atlas *, vlc_glyph_atlas_stats_t * );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1202,6 +1202,9 @@ static int Create( filter_t *p_filter )
     if( !p_sys->ftcache )
         goto error;
 
+    if( LayoutCacheInit( p_filter ) )
+        goto error;
+
     p_sys->i_scale = 100;
 
     /* default style to apply to incomplete segments styles */
@@ -1268,6 +1271,8 @@ static void Destroy( filter_t *p_filter )
         DumpFamilies( p_sys->fs );
 #endif
 
+    LayoutCacheClean( p_filter );
+
     if( p_sys->ftcache )
         vlc_ftcache_Delete( p_sys->ftcache );
 
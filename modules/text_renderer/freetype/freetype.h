@@ -73,6 +73,8 @@ typedef uint32_t uni_char_t;
 #endif
 
 #include "ftcache.h"
+#include "lru.h"
+#include "atlas.h"
 
 typedef struct vlc_font_select_t vlc_font_select_t;
 
@@ -113,6 +115,12 @@ typedef struct
     vlc_font_select_t *fs;
     vlc_ftcache_t     *ftcache;
 
+    /* Layout caches */
+    vlc_glyph_atlas   *atlas;
+    vlc_lru           *shaping_cache;
+    unsigned           i_shaping_hits;
+    unsigned           i_shaping_misses;
+
 } filter_sys_t;
 
 /**
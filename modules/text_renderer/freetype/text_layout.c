@@ -40,6 +40,7 @@
 
 #include <vlc_common.h>
 #include <vlc_filter.h>
+#include <vlc_memstream.h>
 #include <vlc_text_style.h>
 
 /* Freetype */
@@ -127,6 +128,10 @@ typedef struct glyph_bitmaps_t
     int      i_y_offset;
     int      i_x_advance;
     int      i_y_advance;
+    /* Glyph atlas key */
+    unsigned i_glyph_index;
+    unsigned i_atlas_flags;
+    int      i_stroker_radius;
 } glyph_bitmaps_t;
 
 typedef struct paragraph_t
@@ -145,6 +150,7 @@ typedef struct paragraph_t
 
 #ifdef HAVE_HARFBUZZ
     hb_script_t         *p_scripts;
+    int                 *pi_source_indices; /**< Code point each shaped glyph comes from */
 #endif
 
 #ifdef HAVE_FRIBIDI
@@ -164,11 +170,11 @@ static void FreeLine( line_desc_t *p_line )
     for( int i = 0; i < p_line->i_character_count; i++ )
     {
         line_character_t *ch = &p_line->p_character[i];
-        FT_Done_Glyph( (FT_Glyph)ch->p_glyph );
+        vlc_glyph_atlas_ReleaseGlyph( ch->p_glyph );
         if( ch->p_outline )
-            FT_Done_Glyph( (FT_Glyph)ch->p_outline );
+            vlc_glyph_atlas_ReleaseGlyph( ch->p_outline );
         if( ch->p_shadow && ch->p_shadow != ch->p_glyph )
-            FT_Done_Glyph( (FT_Glyph)ch->p_shadow );
+            vlc_glyph_atlas_ReleaseGlyph( ch->p_shadow );
     }
 
 //    if( p_line->p_ruby )
@@ -297,6 +303,7 @@ static void FreeParagraph( paragraph_t *p_paragraph )
 
 #ifdef HAVE_HARFBUZZ
     free( p_paragraph->p_scripts );
+    free( p_paragraph->pi_source_indices );
 #endif
 
 #ifdef HAVE_FRIBIDI
@@ -359,7 +366,9 @@ static paragraph_t *NewParagraph( filter_t *p_filter,
 
 #ifdef HAVE_HARFBUZZ
     p_paragraph->p_scripts = vlc_alloc( i_size, sizeof( *p_paragraph->p_scripts ) );
-    if( !p_paragraph->p_scripts )
+    p_paragraph->pi_source_indices =
+            vlc_alloc( i_size, sizeof( *p_paragraph->pi_source_indices ) );
+    if( !p_paragraph->p_scripts || !p_paragraph->pi_source_indices )
         goto error;
 #endif
 
@@ -822,6 +831,7 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
             p_new_paragraph->p_code_points[ i_index ] = 0;
             p_new_paragraph->pi_glyph_indices[ i_index ] =
                 p_infos[ i_run_index ].codepoint;
+            p_new_paragraph->pi_source_indices[ i_index ] = i_source_index;
             p_new_paragraph->p_scripts[ i_index ] =
                 p_paragraph->p_scripts[ i_source_index ];
             p_new_paragraph->p_types[ i_index ] =
@@ -965,7 +975,7 @@ static void ReleaseGlyphBitMaps(filter_t *p_filter, glyph_bitmaps_t *p_bitmaps)
     if( p_bitmaps->p_shadow &&
         p_bitmaps->p_shadow != p_bitmaps->cglyph.p_glyph &&
         p_bitmaps->p_shadow != p_bitmaps->coutline.p_glyph )
-        FT_Done_Glyph( p_bitmaps->p_shadow );
+        vlc_glyph_atlas_ReleaseGlyph( (FT_BitmapGlyph) p_bitmaps->p_shadow );
     vlc_ftcache_Custom_Glyph_Release( &p_bitmaps->coutline );
     vlc_ftcache_Glyph_Release( p_sys->ftcache, &p_bitmaps->cglyph );
 }
@@ -1099,6 +1109,10 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
 
 #undef SKIP_GLYPH
 
+            p_bitmaps->i_glyph_index = i_glyph_index;
+            p_bitmaps->i_atlas_flags = 0;
+            p_bitmaps->i_stroker_radius = i_stroker_radius;
+
             const bool b_embolden = ( p_style->i_style_flags & STYLE_BOLD ) &&
                                    !( style_flags & FT_STYLE_FLAG_BOLD );
             const bool b_oblique = ( p_style->i_style_flags & STYLE_ITALIC ) &&
@@ -1119,6 +1133,9 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
                     }
                     if( b_embolden )
                         FT_Outline_Embolden( &((FT_OutlineGlyph)transformed)->outline, 1<<6 );
+                    p_bitmaps->i_atlas_flags =
+                        ( b_oblique ? VLC_GLYPH_ATLAS_OBLIQUE : 0 ) |
+                        ( b_embolden ? VLC_GLYPH_ATLAS_EMBOLDEN : 0 );
                     vlc_ftcache_Glyph_Release( p_sys->ftcache, &p_bitmaps->cglyph );
                     p_bitmaps->cglyph.p_glyph = transformed;
                 }
@@ -1153,6 +1170,34 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
     return VLC_SUCCESS;
 }
 
+static void GetAtlasKey( const glyph_bitmaps_t *p_bitmaps,
+                         const vlc_face_id_t *p_faceid,
+                         const vlc_ftcache_metrics_t *p_metrics,
+                         bool b_outline, vlc_glyph_atlas_key_t *p_key )
+{
+    p_key->p_faceid = p_faceid;
+    p_key->i_width_px = p_metrics->width_px;
+    p_key->i_height_px = p_metrics->height_px;
+    p_key->i_glyph_index = p_bitmaps->i_glyph_index;
+    p_key->i_flags = p_bitmaps->i_atlas_flags;
+    p_key->i_outline = 0;
+    if( b_outline )
+    {
+        p_key->i_flags |= VLC_GLYPH_ATLAS_OUTLINE;
+        p_key->i_outline = p_bitmaps->i_stroker_radius;
+    }
+}
+
+/* FT_Glyph_Get_CBox() only handles FreeType owned glyphs */
+static void GetBitmapBBox( FT_Glyph glyph, FT_BBox *p_bbox )
+{
+    const FT_BitmapGlyph glyph_bmp = (FT_BitmapGlyph)glyph;
+    p_bbox->xMin = glyph_bmp->left;
+    p_bbox->xMax = glyph_bmp->left + (FT_Pos) glyph_bmp->bitmap.width;
+    p_bbox->yMax = glyph_bmp->top;
+    p_bbox->yMin = glyph_bmp->top - (FT_Pos) glyph_bmp->bitmap.rows;
+}
+
 static int LayoutLine( filter_t *p_filter,
                        paragraph_t *p_paragraph,
                        int i_first_char, int i_last_char,
@@ -1244,19 +1289,24 @@ static int LayoutLine( filter_t *p_filter,
             .y = pen_new.y + p_sys->f_shadow_vector_y * ( metrics.height_px << 6 )
         };
 
+        vlc_glyph_atlas_key_t key;
+
         /* Shadow being a reference to main glyph, it must be processed first */
-        if( p_bitmaps->p_shadow &&
-            FT_Glyph_To_Bitmap( &p_bitmaps->p_shadow, FT_RENDER_MODE_NORMAL,
-                                &pen_shadow, 0 ) )
+        if( p_bitmaps->p_shadow )
         {
-            p_bitmaps->p_shadow = 0;
+            GetAtlasKey( p_bitmaps, p_run->p_faceid, &metrics,
+                         p_bitmaps->p_shadow == p_bitmaps->coutline.p_glyph, &key );
+            p_bitmaps->p_shadow = (FT_Glyph)
+                vlc_glyph_atlas_Rasterize( p_sys->atlas, &key,
+                                           p_bitmaps->p_shadow, &pen_shadow );
         }
 
         /* Ensure we don't release reference */
-        FT_Glyph bitmapglyph = p_bitmaps->cglyph.p_glyph;
-        if( FT_Glyph_To_Bitmap( &bitmapglyph,
-                                FT_RENDER_MODE_NORMAL,
-                                &pen_new, 0 ) )
+        GetAtlasKey( p_bitmaps, p_run->p_faceid, &metrics, false, &key );
+        FT_BitmapGlyph bitmapglyph =
+            vlc_glyph_atlas_Rasterize( p_sys->atlas, &key,
+                                       p_bitmaps->cglyph.p_glyph, &pen_new );
+        if( !bitmapglyph )
         {
             ReleaseGlyphBitMaps( p_filter, p_bitmaps );
             continue;
@@ -1264,36 +1314,32 @@ static int LayoutLine( filter_t *p_filter,
 
         /* release the source glyph or reference */
         vlc_ftcache_Glyph_Release( p_sys->ftcache, &p_bitmaps->cglyph );
-        p_bitmaps->cglyph.p_glyph = bitmapglyph;
+        p_bitmaps->cglyph.p_glyph = (FT_Glyph) bitmapglyph;
 
         if( p_bitmaps->coutline.p_glyph )
         {
-            bitmapglyph = p_bitmaps->coutline.p_glyph;
-            if( FT_Glyph_To_Bitmap( &bitmapglyph,
-                                    FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 0 ) )
-                bitmapglyph = NULL;
+            GetAtlasKey( p_bitmaps, p_run->p_faceid, &metrics, true, &key );
+            bitmapglyph = vlc_glyph_atlas_Rasterize( p_sys->atlas, &key,
+                                                     p_bitmaps->coutline.p_glyph,
+                                                     &pen_new );
             vlc_ftcache_Custom_Glyph_Release( &p_bitmaps->coutline );
-            p_bitmaps->coutline.p_glyph = bitmapglyph;
+            p_bitmaps->coutline.p_glyph = (FT_Glyph) bitmapglyph;
         }
 
-        FT_Glyph_Get_CBox( p_bitmaps->cglyph.p_glyph, FT_GLYPH_BBOX_PIXELS,
-                           &p_bitmaps->glyph_bbox );
+        GetBitmapBBox( p_bitmaps->cglyph.p_glyph, &p_bitmaps->glyph_bbox );
         FixGlyph( p_bitmaps->cglyph.p_glyph, &p_bitmaps->glyph_bbox,
                   p_bitmaps->i_x_advance, p_bitmaps->i_y_advance,
                   &pen_new );
         if( p_bitmaps->coutline.p_glyph )
         {
-            FT_Glyph_Get_CBox( p_bitmaps->coutline.p_glyph, FT_GLYPH_BBOX_PIXELS,
-                               &p_bitmaps->outline_bbox );
+            GetBitmapBBox( p_bitmaps->coutline.p_glyph, &p_bitmaps->outline_bbox );
             FixGlyph( p_bitmaps->coutline.p_glyph, &p_bitmaps->outline_bbox,
                       p_bitmaps->i_x_advance, p_bitmaps->i_y_advance,
                       &pen_new );
         }
         if( p_bitmaps->p_shadow )
         {
-            FT_Glyph_Get_CBox( p_bitmaps->p_shadow, FT_GLYPH_BBOX_PIXELS,
-                               &p_bitmaps->shadow_bbox );
+            GetBitmapBBox( p_bitmaps->p_shadow, &p_bitmaps->shadow_bbox );
             FixGlyph( p_bitmaps->p_shadow, &p_bitmaps->shadow_bbox,
                       p_bitmaps->i_x_advance, p_bitmaps->i_y_advance,
                       &pen_shadow );
@@ -1630,6 +1676,283 @@ error:
     return VLC_EGENERIC;
 }
 
+#ifdef HAVE_HARFBUZZ
+/* Number of shaped paragraphs kept in cache */
+#define SHAPING_CACHE_SIZE 64
+
+/**
+ * Shaping results of a paragraph. Styles are stored as indices in the styles
+ * of the source text, so that they can be applied to another text block with
+ * the same code points and font styles.
+ */
+typedef struct
+{
+    int                 i_start_offset;
+    int                 i_end_offset;
+    vlc_face_id_t      *p_faceid;
+    int                 i_style_index;     /**< -1 for the default style */
+} shaped_run_t;
+
+typedef struct
+{
+    int                 i_glyph_index;
+    int                 i_source_index;
+    hb_script_t         script;
+    FriBidiCharType     type;
+    FriBidiLevel        level;
+    int                 i_x_offset;
+    int                 i_y_offset;
+    int                 i_x_advance;
+    int                 i_y_advance;
+} shaped_glyph_t;
+
+typedef struct
+{
+    FriBidiParType      paragraph_type;
+    int                 i_size;
+    int                 i_runs_count;
+    shaped_run_t       *p_runs;
+    shaped_glyph_t     *p_glyphs;
+} shaped_paragraph_t;
+
+static void ReleaseShapedParagraph( void *priv, void *value )
+{
+    VLC_UNUSED(priv);
+    free( value );
+}
+
+/**
+ * Builds the shaping cache key: everything ItemizeParagraph() and
+ * ShapeParagraphHarfBuzz() depend on, that is the code points and the face
+ * properties of each style change.
+ */
+static char * ShapingCacheKey( filter_t *p_filter, int i_size,
+                               const uni_char_t *p_uchars,
+                               text_style_t **pp_styles )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    struct vlc_memstream stream;
+
+    if( vlc_memstream_open( &stream ) )
+        return NULL;
+
+    vlc_memstream_printf( &stream, "%p:%"PRId64, (void *) p_sys->p_faceid,
+                          var_InheritInteger( p_filter, "freetype-text-direction" ) );
+
+    for( int i = 0; i < i_size; ++i )
+    {
+        if( i == 0 || !FaceStyleEquals( p_filter, pp_styles[ i - 1 ], pp_styles[ i ] ) )
+        {
+            const text_style_t *p_style = pp_styles[ i ];
+            const int i_style_mask = STYLE_BOLD | STYLE_ITALIC | STYLE_HALFWIDTH
+                                   | STYLE_DOUBLEWIDTH | STYLE_MONOSPACED;
+            const char *psz_fontname = p_style->i_style_flags & STYLE_MONOSPACED
+                                     ? p_style->psz_monofontname : p_style->psz_fontname;
+
+            vlc_memstream_printf( &stream, "|%d:%x:%d:%s|", i,
+                                  p_style->i_style_flags & i_style_mask,
+                                  ConvertToLiveSize( p_filter, p_style ),
+                                  psz_fontname ? psz_fontname : "" );
+        }
+        vlc_memstream_printf( &stream, " %"PRIx32, p_uchars[ i ] );
+    }
+
+    if( vlc_memstream_close( &stream ) )
+        return NULL;
+    return stream.ptr;
+}
+
+static shaped_paragraph_t * SaveShapedParagraph( filter_t *p_filter,
+                                                 const paragraph_t *p_paragraph,
+                                                 text_style_t **pp_styles )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    shaped_paragraph_t *p_shaped =
+        malloc( sizeof( *p_shaped )
+              + p_paragraph->i_runs_count * sizeof( *p_shaped->p_runs )
+              + p_paragraph->i_size * sizeof( *p_shaped->p_glyphs ) );
+    if( !p_shaped )
+        return NULL;
+
+    p_shaped->paragraph_type = p_paragraph->paragraph_type;
+    p_shaped->i_size = p_paragraph->i_size;
+    p_shaped->i_runs_count = p_paragraph->i_runs_count;
+    p_shaped->p_runs = (shaped_run_t *) &p_shaped[ 1 ];
+    p_shaped->p_glyphs = (shaped_glyph_t *) &p_shaped->p_runs[ p_shaped->i_runs_count ];
+
+    for( int i = 0; i < p_paragraph->i_size; ++i )
+    {
+        const glyph_bitmaps_t *p_bitmaps = &p_paragraph->p_glyph_bitmaps[ i ];
+        shaped_glyph_t *p_glyph = &p_shaped->p_glyphs[ i ];
+
+        p_glyph->i_glyph_index = p_paragraph->pi_glyph_indices[ i ];
+        p_glyph->i_source_index = p_paragraph->pi_source_indices[ i ];
+        p_glyph->script = p_paragraph->p_scripts[ i ];
+        p_glyph->type = p_paragraph->p_types[ i ];
+        p_glyph->level = p_paragraph->p_levels[ i ];
+        p_glyph->i_x_offset = p_bitmaps->i_x_offset;
+        p_glyph->i_y_offset = p_bitmaps->i_y_offset;
+        p_glyph->i_x_advance = p_bitmaps->i_x_advance;
+        p_glyph->i_y_advance = p_bitmaps->i_y_advance;
+    }
+
+    for( int i = 0; i < p_paragraph->i_runs_count; ++i )
+    {
+        const run_desc_t *p_run = &p_paragraph->p_runs[ i ];
+        shaped_run_t *p_shaped_run = &p_shaped->p_runs[ i ];
+
+        p_shaped_run->i_start_offset = p_run->i_start_offset;
+        p_shaped_run->i_end_offset = p_run->i_end_offset;
+        p_shaped_run->p_faceid = p_run->p_faceid;
+
+        if( p_run->p_style == p_sys->p_default_style )
+        {
+            p_shaped_run->i_style_index = -1;
+            continue;
+        }
+
+        /* The run style is the one of its first source code point */
+        int i_source = INT_MAX;
+        for( int j = p_run->i_start_offset; j < p_run->i_end_offset; ++j )
+            i_source = __MIN( i_source, p_paragraph->pi_source_indices[ j ] );
+
+        if( pp_styles[ i_source ] != p_run->p_style )
+        {
+            free( p_shaped );
+            return NULL;
+        }
+        p_shaped_run->i_style_index = i_source;
+    }
+
+    return p_shaped;
+}
+
+static paragraph_t * RestoreShapedParagraph( filter_t *p_filter,
+                                             const shaped_paragraph_t *p_shaped,
+                                             text_style_t **pp_styles )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    paragraph_t *p_paragraph = NewParagraph( p_filter, p_shaped->i_size,
+                                             NULL, NULL, NULL,
+                                             p_shaped->i_runs_count );
+    if( !p_paragraph )
+        return NULL;
+
+    p_paragraph->paragraph_type = p_shaped->paragraph_type;
+
+    for( int i = 0; i < p_shaped->i_size; ++i )
+    {
+        const shaped_glyph_t *p_glyph = &p_shaped->p_glyphs[ i ];
+        glyph_bitmaps_t *p_bitmaps = &p_paragraph->p_glyph_bitmaps[ i ];
+
+        p_paragraph->p_code_points[ i ] = 0;
+        p_paragraph->pi_glyph_indices[ i ] = p_glyph->i_glyph_index;
+        p_paragraph->pi_source_indices[ i ] = p_glyph->i_source_index;
+        p_paragraph->p_scripts[ i ] = p_glyph->script;
+        p_paragraph->p_types[ i ] = p_glyph->type;
+        p_paragraph->p_levels[ i ] = p_glyph->level;
+        p_paragraph->pp_styles[ i ] = pp_styles[ p_glyph->i_source_index ];
+        p_bitmaps->i_x_offset = p_glyph->i_x_offset;
+        p_bitmaps->i_y_offset = p_glyph->i_y_offset;
+        p_bitmaps->i_x_advance = p_glyph->i_x_advance;
+        p_bitmaps->i_y_advance = p_glyph->i_y_advance;
+    }
+
+    for( int i = 0; i < p_shaped->i_runs_count; ++i )
+    {
+        const shaped_run_t *p_run = &p_shaped->p_runs[ i ];
+        const text_style_t *p_style = p_run->i_style_index < 0
+                                    ? p_sys->p_default_style
+                                    : pp_styles[ p_run->i_style_index ];
+
+        if( AddRun( p_filter, p_paragraph, p_run->i_start_offset,
+                    p_run->i_end_offset, p_run->p_faceid, p_style ) )
+        {
+            FreeParagraph( p_paragraph );
+            return NULL;
+        }
+    }
+
+    return p_paragraph;
+}
+
+static paragraph_t * ShapeParagraph( filter_t *p_filter,
+                                     int i_size,
+                                     const uni_char_t *p_uchars,
+                                     text_style_t **pp_styles,
+                                     ruby_block_t **pp_ruby,
+                                     int i_runs_size )
+{
+    paragraph_t *p_paragraph = NewParagraph( p_filter, i_size,
+                                p_uchars,
+                                pp_styles,
+                                pp_ruby,
+                                i_runs_size );
+    if( !p_paragraph )
+        return NULL;
+
+    if( AnalyzeParagraph( p_paragraph )
+     || ItemizeParagraph( p_filter, p_paragraph )
+     || ShapeParagraphHarfBuzz( p_filter, &p_paragraph ) )
+    {
+        FreeParagraph( p_paragraph );
+        return NULL;
+    }
+
+    return p_paragraph;
+}
+
+/**
+ * Shape a paragraph, or reuse the shaping of an identical one.
+ * Paragraphs with ruby annotations are not cached.
+ */
+static paragraph_t * GetShapedParagraph( filter_t *p_filter,
+                                         int i_size,
+                                         const uni_char_t *p_uchars,
+                                         text_style_t **pp_styles,
+                                         ruby_block_t **pp_ruby,
+                                         int i_runs_size )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    paragraph_t *p_paragraph = NULL;
+    char *psz_key = NULL;
+
+    if( !pp_ruby )
+        psz_key = ShapingCacheKey( p_filter, i_size, p_uchars, pp_styles );
+
+    if( psz_key )
+    {
+        const shaped_paragraph_t *p_shaped =
+            vlc_lru_Get( p_sys->shaping_cache, psz_key );
+        if( p_shaped )
+        {
+            p_sys->i_shaping_hits++;
+            p_paragraph = RestoreShapedParagraph( p_filter, p_shaped, pp_styles );
+        }
+        else
+            p_sys->i_shaping_misses++;
+    }
+
+    if( !p_paragraph )
+    {
+        p_paragraph = ShapeParagraph( p_filter, i_size, p_uchars, pp_styles,
+                                      pp_ruby, i_runs_size );
+        if( p_paragraph && psz_key && !vlc_lru_HasKey( p_sys->shaping_cache, psz_key ) )
+        {
+            shaped_paragraph_t *p_shaped =
+                SaveShapedParagraph( p_filter, p_paragraph, pp_styles );
+            if( p_shaped )
+                vlc_lru_Insert( p_sys->shaping_cache, psz_key, p_shaped );
+        }
+    }
+
+    free( psz_key );
+    return p_paragraph;
+}
+#endif
+
 static paragraph_t * BuildParagraph( filter_t *p_filter,
                                      int i_size,
                                      const uni_char_t *p_uchars,
@@ -1638,6 +1961,17 @@ static paragraph_t * BuildParagraph( filter_t *p_filter,
                                      int i_runs_size,
                                      unsigned *pi_max_advance_x )
 {
+#if defined HAVE_HARFBUZZ
+    paragraph_t *p_paragraph = GetShapedParagraph( p_filter, i_size,
+                                                   p_uchars, pp_styles,
+                                                   pp_ruby, i_runs_size );
+    if( !p_paragraph )
+        return NULL;
+
+    if( LoadGlyphs( p_filter, p_paragraph, true, false, pi_max_advance_x ) )
+        goto error;
+
+#else
     paragraph_t *p_paragraph = NewParagraph( p_filter, i_size,
                                 p_uchars,
                                 pp_styles,
@@ -1654,14 +1988,7 @@ static paragraph_t * BuildParagraph( filter_t *p_filter,
     if( ItemizeParagraph( p_filter, p_paragraph ) )
         goto error;
 
-#if defined HAVE_HARFBUZZ
-    if( ShapeParagraphHarfBuzz( p_filter, &p_paragraph ) )
-        goto error;
-
-    if( LoadGlyphs( p_filter, p_paragraph, true, false, pi_max_advance_x ) )
-        goto error;
-
-#elif defined HAVE_FRIBIDI
+#if defined HAVE_FRIBIDI
     if( ShapeParagraphFriBidi( p_filter, p_paragraph ) )
         goto error;
     if( LoadGlyphs( p_filter, p_paragraph, false, true, pi_max_advance_x ) )
@@ -1673,6 +2000,7 @@ static paragraph_t * BuildParagraph( filter_t *p_filter,
 #else
     if( LoadGlyphs( p_filter, p_paragraph, false, true, pi_max_advance_x ) )
         goto error;
+#endif
 #endif
 
     return p_paragraph;
@@ -1728,6 +2056,7 @@ int LayoutTextBlock( filter_t *p_filter,
                      line_desc_t **pp_lines, FT_BBox *p_bbox,
                      int *pi_max_face_height )
 {
+    filter_sys_t *p_sys = p_filter->p_sys;
     line_desc_t *p_first_line = 0;
     line_desc_t **pp_line = &p_first_line;
     size_t i_paragraph_start = 0;
@@ -1735,6 +2064,9 @@ int LayoutTextBlock( filter_t *p_filter,
     unsigned i_max_advance_x = 0;
     int i_max_face_height = 0;
 
+    /* No glyph from the previous layout is alive anymore */
+    vlc_glyph_atlas_Trim( p_sys->atlas );
+
     /* Prepare ruby content */
     if( p_textblock->pp_ruby )
     {
@@ -1835,3 +2167,50 @@ int LayoutTextBlock( filter_t *p_filter,
     *p_bbox = bbox;
     return VLC_SUCCESS;
 }
+
+/* 512x512 pages of 8 bits glyphs */
+#define GLYPH_ATLAS_MAX_PAGES 8
+
+int LayoutCacheInit( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    p_sys->atlas = vlc_glyph_atlas_New( GLYPH_ATLAS_MAX_PAGES );
+    if( !p_sys->atlas )
+        return VLC_ENOMEM;
+
+#ifdef HAVE_HARFBUZZ
+    p_sys->shaping_cache = vlc_lru_New( SHAPING_CACHE_SIZE,
+                                        ReleaseShapedParagraph, NULL );
+    if( !p_sys->shaping_cache )
+    {
+        vlc_glyph_atlas_Delete( p_sys->atlas );
+        p_sys->atlas = NULL;
+        return VLC_ENOMEM;
+    }
+#endif
+
+    return VLC_SUCCESS;
+}
+
+void LayoutCacheClean( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->shaping_cache )
+    {
+        msg_Dbg( p_filter, "shaping cache: %u hits, %u misses",
+                 p_sys->i_shaping_hits, p_sys->i_shaping_misses );
+        vlc_lru_Release( p_sys->shaping_cache );
+    }
+
+    if( p_sys->atlas )
+    {
+        vlc_glyph_atlas_stats_t stats;
+        vlc_glyph_atlas_GetStats( p_sys->atlas, &stats );
+        msg_Dbg( p_filter, "glyph atlas: %u hits, %u misses, %u glyphs, "
+                 "%u pages, %u resets", stats.i_hits, stats.i_misses,
+                 stats.i_glyphs, stats.i_pages, stats.i_resets );
+        vlc_glyph_atlas_Delete( p_sys->atlas );
+    }
+}
@@ -105,3 +105,12 @@ typedef struct
  */
 int LayoutTextBlock( filter_t *p_filter, const layout_text_block_t *p_textblock,
                      line_desc_t **pp_lines, FT_BBox *p_bbox, int *pi_max_face_height );
+
+/**
+ * Create and release the caches of shaped paragraphs and rasterized glyphs
+ * used by LayoutTextBlock().
+ *
+ * \param p_filter the FreeType module object [IN]
+ */
+int LayoutCacheInit( filter_t *p_filter );
+void LayoutCacheClean( filter_t *p_filter );
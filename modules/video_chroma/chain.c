@@ -34,6 +34,8 @@
 #include <vlc_mouse.h>
 #include <vlc_picture.h>
 
+#include "chain_cost.h"
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -135,6 +137,136 @@ static const vlc_fourcc_t *get_allowed_chromas( filter_t *p_filter )
     }
 }
 
+/*****************************************************************************
+ * Planner
+ *****************************************************************************
+ * Middle chromas are tried by increasing estimated cost.
+ *****************************************************************************/
+#define CANDIDATES_MAX 16
+
+/* Sorts the candidate middle chromas, cheapest first */
+static size_t GetCandidates( filter_t *p_filter, vlc_fourcc_t *pi_chromas )
+{
+    const vlc_fourcc_t i_in = p_filter->fmt_in.video.i_chroma;
+    const vlc_fourcc_t i_out = p_filter->fmt_out.video.i_chroma;
+    const vlc_fourcc_t *pi_allowed_chromas = get_allowed_chromas( p_filter );
+    unsigned pi_costs[CANDIDATES_MAX];
+    size_t i_count = 0;
+
+    for( size_t i = 0; pi_allowed_chromas[i] && i_count < CANDIDATES_MAX; i++ )
+    {
+        const vlc_fourcc_t i_chroma = pi_allowed_chromas[i];
+        if( i_chroma == p_filter->fmt_in.i_codec ||
+            i_chroma == p_filter->fmt_out.i_codec )
+            continue;
+
+        const unsigned i_cost = EstimateChromaCost( i_in, i_chroma, i_out );
+        size_t j = i_count++;
+
+        /* Stable insertion: equal costs keep the list preference */
+        for( ; j > 0 && pi_costs[j - 1] > i_cost; j-- )
+        {
+            pi_chromas[j] = pi_chromas[j - 1];
+            pi_costs[j] = pi_costs[j - 1];
+        }
+        pi_chromas[j] = i_chroma;
+        pi_costs[j] = i_cost;
+    }
+    return i_count;
+}
+
+/*****************************************************************************
+ * Plans cache
+ *****************************************************************************
+ * Successful plans are remembered process-wide by input and output formats:
+ * chromas, but also sizes and orientations, which decide whether a resize or
+ * transform step is needed and whether a converter accepts them. Rebuilding
+ * the same chain then does not probe the failing candidates (and load their
+ * modules) again. A cached plan is only a hint: if it fails,
+ * the whole search is done again.
+ *****************************************************************************/
+#define PLAN_CACHE_SIZE 32
+
+typedef struct
+{
+    int (*pf_build)( filter_t * );
+    vlc_fourcc_t i_chroma_in;
+    vlc_fourcc_t i_chroma_out;
+    unsigned i_width_in, i_height_in;
+    unsigned i_width_out, i_height_out;
+    video_orientation_t orientation_in;
+    video_orientation_t orientation_out;
+    bool b_allow_fmt_out_change;
+    vlc_fourcc_t i_plan; /* middle chroma, or attempt number */
+} chain_plan_t;
+
+static vlc_mutex_t plan_lock = VLC_STATIC_MUTEX;
+static chain_plan_t plan_cache[PLAN_CACHE_SIZE];
+static size_t plan_next;
+
+static chain_plan_t *FindPlan( filter_t *p_filter, int (*pf_build)( filter_t * ) )
+{
+    const video_format_t *p_in = &p_filter->fmt_in.video;
+    const video_format_t *p_out = &p_filter->fmt_out.video;
+
+    for( size_t i = 0; i < PLAN_CACHE_SIZE; i++ )
+    {
+        chain_plan_t *p_plan = &plan_cache[i];
+
+        if( p_plan->pf_build == pf_build
+         && p_plan->i_chroma_in == p_in->i_chroma
+         && p_plan->i_chroma_out == p_out->i_chroma
+         && p_plan->i_width_in == p_in->i_width
+         && p_plan->i_height_in == p_in->i_height
+         && p_plan->i_width_out == p_out->i_width
+         && p_plan->i_height_out == p_out->i_height
+         && p_plan->orientation_in == p_in->orientation
+         && p_plan->orientation_out == p_out->orientation
+         && p_plan->b_allow_fmt_out_change == p_filter->b_allow_fmt_out_change )
+            return p_plan;
+    }
+    return NULL;
+}
+
+static bool GetPlan( filter_t *p_filter, int (*pf_build)( filter_t * ),
+                     vlc_fourcc_t *pi_plan )
+{
+    vlc_mutex_lock( &plan_lock );
+    const chain_plan_t *p_plan = FindPlan( p_filter, pf_build );
+    if( p_plan != NULL )
+        *pi_plan = p_plan->i_plan;
+    vlc_mutex_unlock( &plan_lock );
+    return p_plan != NULL;
+}
+
+static void SetPlan( filter_t *p_filter, int (*pf_build)( filter_t * ),
+                     vlc_fourcc_t i_plan )
+{
+    vlc_mutex_lock( &plan_lock );
+    chain_plan_t *p_plan = FindPlan( p_filter, pf_build );
+    if( p_plan == NULL )
+    {
+        /* Replace the oldest plan */
+        p_plan = &plan_cache[plan_next];
+        plan_next = (plan_next + 1) % PLAN_CACHE_SIZE;
+        const video_format_t *p_in = &p_filter->fmt_in.video;
+        const video_format_t *p_out = &p_filter->fmt_out.video;
+
+        p_plan->pf_build = pf_build;
+        p_plan->i_chroma_in = p_in->i_chroma;
+        p_plan->i_chroma_out = p_out->i_chroma;
+        p_plan->i_width_in = p_in->i_width;
+        p_plan->i_height_in = p_in->i_height;
+        p_plan->i_width_out = p_out->i_width;
+        p_plan->i_height_out = p_out->i_height;
+        p_plan->orientation_in = p_in->orientation;
+        p_plan->orientation_out = p_out->orientation;
+        p_plan->b_allow_fmt_out_change = p_filter->b_allow_fmt_out_change;
+    }
+    p_plan->i_plan = i_plan;
+    vlc_mutex_unlock( &plan_lock );
+}
+
 typedef struct
 {
     filter_chain_t *p_chain;
@@ -219,7 +351,14 @@ static int Activate( filter_t *p_filter, int (*pf_build)(filter_t *) )
     if( level < 0 || level > CHAIN_LEVEL_MAX )
         msg_Err( p_filter, "Too high level of recursion (%d)", level );
     else
+    {
+        vlc_tick_t i_start = vlc_tick_now();
+
         i_ret = pf_build( p_filter );
+        msg_Dbg( p_filter, "chain %s in %"PRId64" us (level %d)",
+                 i_ret ? "failed" : "built",
+                 US_FROM_VLC_TICK( vlc_tick_now() - i_start ), level );
+    }
 
     var_Destroy( p_filter, "chain-level" );
 
@@ -308,83 +447,133 @@ static void Flush( filter_t *p_filter )
  * Builders
  *****************************************************************************/
 
-static int BuildTransformChain( filter_t *p_filter )
+static int TryTransformChain( filter_t *p_filter, unsigned i_attempt )
 {
-
     es_format_t fmt_mid;
     int i_ret;
 
-    /* Lets try transform first, then (potentially) resize+chroma */
-    msg_Dbg( p_filter, "Trying to build transform, then chroma+resize" );
-    es_format_Copy( &fmt_mid, &p_filter->fmt_in );
-    video_format_TransformTo(&fmt_mid.video, p_filter->fmt_out.video.orientation);
-    i_ret = CreateChain( p_filter, &fmt_mid );
-    es_format_Clean( &fmt_mid );
-    if( i_ret == VLC_SUCCESS )
-        return VLC_SUCCESS;
-
-    /* Lets try resize+chroma first, then transform */
-    msg_Dbg( p_filter, "Trying to build chroma+resize" );
-    EsFormatMergeSize( &fmt_mid, &p_filter->fmt_out, &p_filter->fmt_in );
+    if( i_attempt == 0 )
+    {
+        /* Lets try transform first, then (potentially) resize+chroma */
+        msg_Dbg( p_filter, "Trying to build transform, then chroma+resize" );
+        es_format_Copy( &fmt_mid, &p_filter->fmt_in );
+        video_format_TransformTo(&fmt_mid.video, p_filter->fmt_out.video.orientation);
+    }
+    else
+    {
+        /* Lets try resize+chroma first, then transform */
+        msg_Dbg( p_filter, "Trying to build chroma+resize" );
+        EsFormatMergeSize( &fmt_mid, &p_filter->fmt_out, &p_filter->fmt_in );
+    }
     i_ret = CreateChain( p_filter, &fmt_mid );
     es_format_Clean( &fmt_mid );
     return i_ret;
 }
 
-static int BuildChromaResize( filter_t *p_filter )
+static int TryChromaResize( filter_t *p_filter, unsigned i_attempt )
 {
     es_format_t fmt_mid;
     int i_ret;
 
-    /* Lets try resizing and then doing the chroma conversion */
-    msg_Dbg( p_filter, "Trying to build resize+chroma" );
-    EsFormatMergeSize( &fmt_mid, &p_filter->fmt_in, &p_filter->fmt_out );
-    i_ret = CreateResizeChromaChain( p_filter, &fmt_mid );
+    if( i_attempt == 0 )
+    {
+        /* Lets try resizing and then doing the chroma conversion */
+        msg_Dbg( p_filter, "Trying to build resize+chroma" );
+        EsFormatMergeSize( &fmt_mid, &p_filter->fmt_in, &p_filter->fmt_out );
+        i_ret = CreateResizeChromaChain( p_filter, &fmt_mid );
+    }
+    else
+    {
+        /* Lets try it the other way around (chroma and then resize) */
+        msg_Dbg( p_filter, "Trying to build chroma+resize" );
+        EsFormatMergeSize( &fmt_mid, &p_filter->fmt_out, &p_filter->fmt_in );
+        i_ret = CreateChain( p_filter, &fmt_mid );
+    }
     es_format_Clean( &fmt_mid );
+    return i_ret;
+}
 
-    if( i_ret == VLC_SUCCESS )
-        return VLC_SUCCESS;
+/* Tries the cached attempt first, then the others in order */
+static int BuildWithPlan( filter_t *p_filter, int (*pf_build)( filter_t * ),
+                          int (*pf_try)( filter_t *, unsigned ),
+                          unsigned i_attempts )
+{
+    vlc_fourcc_t i_plan;
+    bool b_plan = GetPlan( p_filter, pf_build, &i_plan ) && i_plan < i_attempts;
 
-    /* Lets try it the other way around (chroma and then resize) */
-    msg_Dbg( p_filter, "Trying to build chroma+resize" );
-    EsFormatMergeSize( &fmt_mid, &p_filter->fmt_out, &p_filter->fmt_in );
-    i_ret = CreateChain( p_filter, &fmt_mid );
-    es_format_Clean( &fmt_mid );
-    if( i_ret == VLC_SUCCESS )
-        return VLC_SUCCESS;
+    if( b_plan )
+    {
+        msg_Dbg( p_filter, "Using cached plan %"PRIu32, i_plan );
+        if( pf_try( p_filter, i_plan ) == VLC_SUCCESS )
+            return VLC_SUCCESS;
+    }
 
+    for( unsigned i = 0; i < i_attempts; i++ )
+    {
+        if( b_plan && i == i_plan )
+            continue;
+        if( pf_try( p_filter, i ) == VLC_SUCCESS )
+        {
+            SetPlan( p_filter, pf_build, i );
+            return VLC_SUCCESS;
+        }
+    }
     return VLC_EGENERIC;
 }
 
-static int BuildChromaChain( filter_t *p_filter )
+static int BuildTransformChain( filter_t *p_filter )
+{
+    return BuildWithPlan( p_filter, BuildTransformChain, TryTransformChain, 2 );
+}
+
+static int BuildChromaResize( filter_t *p_filter )
+{
+    return BuildWithPlan( p_filter, BuildChromaResize, TryChromaResize, 2 );
+}
+
+static int TryChromaChain( filter_t *p_filter, vlc_fourcc_t i_chroma )
 {
     es_format_t fmt_mid;
-    int i_ret = VLC_EGENERIC;
 
-    /* Now try chroma format list */
-    const vlc_fourcc_t *pi_allowed_chromas = get_allowed_chromas( p_filter );
-    for( int i = 0; pi_allowed_chromas[i]; i++ )
-    {
-        const vlc_fourcc_t i_chroma = pi_allowed_chromas[i];
-        if( i_chroma == p_filter->fmt_in.i_codec ||
-            i_chroma == p_filter->fmt_out.i_codec )
-            continue;
+    msg_Dbg( p_filter, "Trying to use chroma %4.4s as middle man",
+             (char*)&i_chroma );
 
-        msg_Dbg( p_filter, "Trying to use chroma %4.4s as middle man",
-                 (char*)&i_chroma );
+    es_format_Copy( &fmt_mid, &p_filter->fmt_in );
+    fmt_mid.i_codec        =
+    fmt_mid.video.i_chroma = i_chroma;
 
-        es_format_Copy( &fmt_mid, &p_filter->fmt_in );
-        fmt_mid.i_codec        =
-        fmt_mid.video.i_chroma = i_chroma;
+    int i_ret = CreateChain( p_filter, &fmt_mid );
+    es_format_Clean( &fmt_mid );
+    return i_ret;
+}
 
-        i_ret = CreateChain( p_filter, &fmt_mid );
-        es_format_Clean( &fmt_mid );
+static int BuildChromaChain( filter_t *p_filter )
+{
+    vlc_fourcc_t pi_chromas[CANDIDATES_MAX];
+    size_t i_count = GetCandidates( p_filter, pi_chromas );
+    vlc_fourcc_t i_plan;
+    bool b_plan = GetPlan( p_filter, BuildChromaChain, &i_plan );
 
-        if( i_ret == VLC_SUCCESS )
-            break;
+    if( b_plan )
+    {
+        msg_Dbg( p_filter, "Using cached plan %4.4s", (char*)&i_plan );
+        if( TryChromaChain( p_filter, i_plan ) == VLC_SUCCESS )
+            return VLC_SUCCESS;
     }
 
-    return i_ret;
+    /* Now try chroma format list */
+    for( size_t i = 0; i < i_count; i++ )
+    {
+        if( b_plan && pi_chromas[i] == i_plan )
+            continue;
+        if( TryChromaChain( p_filter, pi_chromas[i] ) == VLC_SUCCESS )
+        {
+            SetPlan( p_filter, BuildChromaChain, pi_chromas[i] );
+            return VLC_SUCCESS;
+        }
+    }
+
+    return VLC_EGENERIC;
 }
 
 static int ChainMouse( filter_t *p_filter, vlc_mouse_t *p_mouse,
@@ -403,15 +592,13 @@ static int BuildFilterChain( filter_t *p_filter )
     filter_sys_t *p_sys = p_filter->p_sys;
 
     /* Now try chroma format list */
-    const vlc_fourcc_t *pi_allowed_chromas = get_allowed_chromas( p_filter );
-    for( int i = 0; pi_allowed_chromas[i]; i++ )
+    vlc_fourcc_t pi_chromas[CANDIDATES_MAX];
+    size_t i_count = GetCandidates( p_filter, pi_chromas );
+    for( size_t i = 0; i < i_count; i++ )
     {
         filter_chain_Reset( p_sys->p_chain, &p_filter->fmt_in, p_filter->vctx_in, &p_filter->fmt_out );
 
-        const vlc_fourcc_t i_chroma = pi_allowed_chromas[i];
-        if( i_chroma == p_filter->fmt_in.i_codec ||
-            i_chroma == p_filter->fmt_out.i_codec )
-            continue;
+        const vlc_fourcc_t i_chroma = pi_chromas[i];
 
         msg_Dbg( p_filter, "Trying to use chroma %4.4s as middle man in chain (%p)",
                  (char*)&i_chroma, (void*)p_sys->p_chain );
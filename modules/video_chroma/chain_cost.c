@@ -0,0 +1,142 @@
+/*****************************************************************************
+ * chain_cost.c: cost of a middle chroma in a chroma conversion chain
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <limits.h>
+
+#include <vlc_common.h>
+#include <vlc_fourcc.h>
+
+#include "chain_cost.h"
+
+/* Packed chromas whose depth or subsampling do not follow from their size */
+static const struct
+{
+    vlc_fourcc_t i_chroma;
+    uint8_t i_depth;       /* bits per component */
+    uint8_t i_subsampling; /* luma samples per chroma sample */
+} p_packed_chromas[] = {
+    { VLC_CODEC_YUYV,      8, 2 },
+    { VLC_CODEC_YVYU,      8, 2 },
+    { VLC_CODEC_UYVY,      8, 2 },
+    { VLC_CODEC_VYUY,      8, 2 },
+    { VLC_CODEC_YUV2,      8, 2 },
+    { VLC_CODEC_Y210,     10, 2 },
+    { VLC_CODEC_Y211,      8, 4 },
+    { VLC_CODEC_Y410,     10, 1 },
+    { VLC_CODEC_RGBA10LE, 10, 1 },
+    { VLC_CODEC_RGB565LE,  5, 1 },
+    { VLC_CODEC_RGB565BE,  5, 1 },
+    { VLC_CODEC_BGR565LE,  5, 1 },
+    { VLC_CODEC_BGR565BE,  5, 1 },
+    { VLC_CODEC_RGB233,    2, 1 },
+    { VLC_CODEC_BGR233,    2, 1 },
+    { VLC_CODEC_RGB332,    2, 1 },
+    { VLC_CODEC_YUVP,      8, 1 },
+    { VLC_CODEC_RGBP,      8, 1 },
+    { VLC_CODEC_GREY,      8, 1 },
+    { VLC_CODEC_GREY_10L, 10, 1 },
+    { VLC_CODEC_GREY_10B, 10, 1 },
+    { VLC_CODEC_GREY_12L, 12, 1 },
+    { VLC_CODEC_GREY_12B, 12, 1 },
+    { VLC_CODEC_GREY_16L, 16, 1 },
+    { VLC_CODEC_GREY_16B, 16, 1 },
+    { VLC_CODEC_XYZ_12L,  12, 1 },
+    { VLC_CODEC_XYZ_12B,  12, 1 },
+};
+
+static int FindPackedChroma( vlc_fourcc_t i_chroma )
+{
+    for( size_t i = 0; i < ARRAY_SIZE(p_packed_chromas); i++ )
+        if( p_packed_chromas[i].i_chroma == i_chroma )
+            return i;
+    return -1;
+}
+
+static unsigned GetChromaDepth( const vlc_chroma_description_t *p_dsc )
+{
+    if( p_dsc->plane_count > 1 )
+        return p_dsc->pixel_bits;
+
+    int i = FindPackedChroma( p_dsc->fcc );
+    if( i >= 0 )
+        return p_packed_chromas[i].i_depth;
+    /* other packed: RGB with or without alpha or padding */
+    return p_dsc->pixel_bits / (p_dsc->pixel_bits % 3 == 0 ? 3 : 4);
+}
+
+static unsigned GetChromaSubsampling( const vlc_chroma_description_t *p_dsc )
+{
+    if( p_dsc->plane_count > 1 )
+        return p_dsc->p[1].w.den * p_dsc->p[1].h.den;
+
+    int i = FindPackedChroma( p_dsc->fcc );
+    return i >= 0 ? p_packed_chromas[i].i_subsampling : 1;
+}
+
+/* in sixteenths of byte per pixel */
+static unsigned GetChromaBandwidth( const vlc_chroma_description_t *p_dsc )
+{
+    unsigned i_size = 0;
+
+    for( unsigned i = 0; i < p_dsc->plane_count; i++ )
+        i_size += p_dsc->pixel_size * 16 * p_dsc->p[i].w.num * p_dsc->p[i].h.num
+                / (p_dsc->p[i].w.den * p_dsc->p[i].h.den);
+    return i_size;
+}
+
+unsigned EstimateChromaCost( vlc_fourcc_t i_in, vlc_fourcc_t i_mid,
+                             vlc_fourcc_t i_out )
+{
+    const vlc_chroma_description_t *p_in = vlc_fourcc_GetChromaDescription( i_in );
+    const vlc_chroma_description_t *p_mid = vlc_fourcc_GetChromaDescription( i_mid );
+    const vlc_chroma_description_t *p_out = vlc_fourcc_GetChromaDescription( i_out );
+
+    if( p_mid == NULL || p_mid->plane_count == 0 )
+        return UINT_MAX;
+
+    unsigned i_cost = GetChromaBandwidth( p_mid );
+    unsigned i_depth = UINT_MAX, i_subsampling = 1;
+
+    /* Hardware surfaces have no known precision nor resolution */
+    if( p_in != NULL && p_in->plane_count > 0 )
+    {
+        i_depth = __MIN( i_depth, GetChromaDepth( p_in ) );
+        i_subsampling = __MAX( i_subsampling, GetChromaSubsampling( p_in ) );
+    }
+    if( p_out != NULL && p_out->plane_count > 0 )
+    {
+        i_depth = __MIN( i_depth, GetChromaDepth( p_out ) );
+        i_subsampling = __MAX( i_subsampling, GetChromaSubsampling( p_out ) );
+    }
+
+    if( i_depth != UINT_MAX && GetChromaDepth( p_mid ) < i_depth )
+        i_cost += 1000;
+    if( GetChromaSubsampling( p_mid ) > i_subsampling )
+        i_cost += 1000;
+    if( vlc_fourcc_IsYUV( i_mid ) != vlc_fourcc_IsYUV( i_in ) )
+        i_cost += 100;
+    if( vlc_fourcc_IsYUV( i_mid ) != vlc_fourcc_IsYUV( i_out ) )
+        i_cost += 100;
+    return i_cost;
+}
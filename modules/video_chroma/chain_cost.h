@@ -0,0 +1,36 @@
+/*****************************************************************************
+ * chain_cost.h: cost of a middle chroma in a chroma conversion chain
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_VIDEOCHROMA_CHAIN_COST_H_
+#define VLC_VIDEOCHROMA_CHAIN_COST_H_
+
+/**
+ * Estimates the cost of converting through a middle chroma.
+ *
+ * Losing precision or chroma resolution is worse than converting between YUV
+ * and RGB, which is worse than moving more data.
+ *
+ * \return the cost, lower is better, or UINT_MAX if the middle chroma
+ * cannot be converted in software
+ */
+unsigned EstimateChromaCost(vlc_fourcc_t i_in, vlc_fourcc_t i_mid,
+                            vlc_fourcc_t i_out);
+
+#endif
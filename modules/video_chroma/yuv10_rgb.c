@@ -0,0 +1,167 @@
+/*****************************************************************************
+ * yuv10_rgb.c: high bit depth YUV to RGB conversions
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+
+#include "yuv10_rgb.h"
+
+typedef struct
+{
+    yuv10_row_cb row;
+    struct yuv10_matrix matrix;
+    /* Unpacked P010 row */
+    uint16_t *y, *u, *v;
+} filter_sys_t;
+
+/*****************************************************************************
+ * semiplanar P010 4:2:0 to packed RGB
+ *****************************************************************************/
+static void P010_RGB(filter_t *filter, picture_t *src, picture_t *dst)
+{
+    filter_sys_t *sys = filter->p_sys;
+    const unsigned width = src->format.i_x_offset
+                         + src->format.i_visible_width;
+    const unsigned height = src->format.i_y_offset
+                          + src->format.i_visible_height;
+
+    for (unsigned j = 0; j < height; j++)
+    {
+        const uint8_t *y = src->p[0].p_pixels + j * src->p[0].i_pitch;
+        const uint8_t *uv = NULL;
+
+        /* Each chroma row is unpacked once for two luma rows */
+        if ((j & 1) == 0)
+            uv = src->p[1].p_pixels + (j >> 1) * src->p[1].i_pitch;
+
+        yuv10_UnpackP010(sys->y, sys->u, sys->v, (const uint16_t *)y,
+                         (const uint16_t *)uv, width);
+        sys->row(dst->p[0].p_pixels + j * dst->p[0].i_pitch,
+                 sys->y, sys->u, sys->v, width, 1, &sys->matrix);
+    }
+}
+
+/*****************************************************************************
+ * planar 10-bit 4:2:0 or 4:4:4 to packed RGB
+ *****************************************************************************/
+static void Planar_RGB(filter_t *filter, picture_t *src, picture_t *dst)
+{
+    filter_sys_t *sys = filter->p_sys;
+    const unsigned width = src->format.i_x_offset
+                         + src->format.i_visible_width;
+    const unsigned height = src->format.i_y_offset
+                          + src->format.i_visible_height;
+    const unsigned shift = src->format.i_chroma == VLC_CODEC_I420_10L;
+
+    for (unsigned j = 0; j < height; j++)
+    {
+        const uint8_t *y = src->p[0].p_pixels + j * src->p[0].i_pitch;
+        const uint8_t *u = src->p[1].p_pixels + (j >> shift) * src->p[1].i_pitch;
+        const uint8_t *v = src->p[2].p_pixels + (j >> shift) * src->p[2].i_pitch;
+
+        sys->row(dst->p[0].p_pixels + j * dst->p[0].i_pitch,
+                 (const uint16_t *)y, (const uint16_t *)u,
+                 (const uint16_t *)v, width, shift, &sys->matrix);
+    }
+}
+
+VIDEO_FILTER_WRAPPER(P010_RGB)
+VIDEO_FILTER_WRAPPER(Planar_RGB)
+
+static int Create(filter_t *filter)
+{
+    const video_format_t *in = &filter->fmt_in.video;
+    const video_format_t *out = &filter->fmt_out.video;
+
+    /* resizing not supported */
+    if (in->i_x_offset + in->i_visible_width
+            != out->i_x_offset + out->i_visible_width
+     || in->i_y_offset + in->i_visible_height
+            != out->i_y_offset + out->i_visible_height
+     || in->orientation != out->orientation)
+        return VLC_EGENERIC;
+
+    yuv10_row_cb row = yuv10_rgb_GetRow(out->i_chroma, true);
+    if (row == NULL)
+        return VLC_EGENERIC;
+
+    switch (in->i_chroma)
+    {
+        case VLC_CODEC_P010:
+            filter->ops = &P010_RGB_ops;
+            break;
+        case VLC_CODEC_I420_10L:
+        case VLC_CODEC_I444_10L:
+            filter->ops = &Planar_RGB_ops;
+            break;
+        default:
+            return VLC_EGENERIC;
+    }
+
+    const unsigned width = in->i_x_offset + in->i_visible_width;
+    size_t scratch = 0;
+
+    if (in->i_chroma == VLC_CODEC_P010)
+        scratch = (width + 2 * ((width + 1) / 2)) * sizeof (uint16_t);
+
+    filter_sys_t *sys = vlc_obj_malloc(VLC_OBJECT(filter),
+                                       sizeof (*sys) + scratch);
+    if (unlikely(sys == NULL))
+        return VLC_ENOMEM;
+
+    if (scratch > 0)
+    {
+        sys->y = (uint16_t *)(sys + 1);
+        sys->u = sys->y + width;
+        sys->v = sys->u + (width + 1) / 2;
+    }
+
+    video_color_space_t space = in->space;
+    video_color_range_t range = in->color_range;
+
+    if (space == COLOR_SPACE_UNDEF)
+        space = in->i_visible_height > 576 ? COLOR_SPACE_BT709
+                                           : COLOR_SPACE_BT601;
+    if (range == COLOR_RANGE_UNDEF)
+        range = COLOR_RANGE_LIMITED;
+
+    sys->row = row;
+    yuv10_matrix_Init(&sys->matrix, space, range,
+                      out->i_chroma == VLC_CODEC_RGBA10LE ? 10 : 8);
+    filter->p_sys = sys;
+
+    msg_Dbg(filter, "%4.4s to %4.4s, %s matrix, %s range",
+            (const char *)&in->i_chroma, (const char *)&out->i_chroma,
+            space == COLOR_SPACE_BT2020 ? "BT.2020" :
+            space == COLOR_SPACE_BT709 ? "BT.709" : "BT.601",
+            range == COLOR_RANGE_FULL ? "full" : "limited");
+    return VLC_SUCCESS;
+}
+
+vlc_module_begin ()
+    set_description(N_("10-bit YUV to RGB conversions"))
+    set_callback_video_converter(Create, 160)
+vlc_module_end ()
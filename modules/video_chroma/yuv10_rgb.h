@@ -0,0 +1,72 @@
+/*****************************************************************************
+ * yuv10_rgb.h: high bit depth YUV to RGB conversion rows
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_VIDEO_CHROMA_YUV10_RGB_H_
+#define VLC_VIDEO_CHROMA_YUV10_RGB_H_
+
+#define YUV10_RGB_FRAC 14 /* fixed point precision of the matrix */
+
+/**
+ * YUV to RGB matrix, for 10-bit samples, in Q14 fixed point.
+ */
+struct yuv10_matrix
+{
+    int32_t y_offset; /* black level */
+    int32_t y; /* luma gain */
+    int32_t rv, gu, gv, bu; /* chroma contributions (positive) */
+    int32_t max; /* largest output value */
+};
+
+/**
+ * Initializes a matrix.
+ *
+ * \param bits output bit depth (8 or 10)
+ */
+void yuv10_matrix_Init(struct yuv10_matrix *, video_color_space_t,
+                       video_color_range_t, unsigned bits);
+
+/**
+ * Converts one row of 10-bit samples to packed RGB.
+ *
+ * \param u,v chroma samples, one for each (1 << chroma_shift) pixels
+ */
+typedef void (*yuv10_row_cb)(void *dst, const uint16_t *y, const uint16_t *u,
+                             const uint16_t *v, unsigned width,
+                             unsigned chroma_shift,
+                             const struct yuv10_matrix *);
+
+/**
+ * Gets the row converter to VLC_CODEC_RGBA or VLC_CODEC_RGBA10LE.
+ *
+ * \param optimized whether to use the SIMD version, if supported by the CPU
+ * \return the converter, or NULL if the output chroma is not supported
+ */
+yuv10_row_cb yuv10_rgb_GetRow(vlc_fourcc_t chroma, bool optimized);
+
+/**
+ * Unpacks one P010 row into 10-bit samples.
+ *
+ * \param y,uv luma and interleaved chroma rows (or NULL to skip chroma)
+ */
+void yuv10_UnpackP010(uint16_t *restrict dy, uint16_t *restrict du,
+                      uint16_t *restrict dv, const uint16_t *y,
+                      const uint16_t *uv, unsigned width);
+
+#endif
@@ -0,0 +1,543 @@
+/*****************************************************************************
+ * yuv10_rgb_row.c: high bit depth YUV to RGB conversion rows
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef YUV10_RGB_TEST
+# undef NDEBUG
+# include <assert.h>
+#endif
+
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_es.h>
+#include <vlc_cpu.h>
+
+#include "yuv10_rgb.h"
+
+#if defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+# ifdef __AVX2__
+#  define YUV10_AVX2
+# else
+#  define YUV10_AVX2 __attribute__ ((__target__ ("avx2")))
+# endif
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+# define YUV10_NEON
+#endif
+
+void yuv10_matrix_Init(struct yuv10_matrix *m, video_color_space_t space,
+                       video_color_range_t range, unsigned bits)
+{
+    double kr, kb;
+
+    switch (space)
+    {
+        case COLOR_SPACE_BT2020:
+            kr = 0.2627;
+            kb = 0.0593;
+            break;
+        case COLOR_SPACE_BT709:
+            kr = 0.2126;
+            kb = 0.0722;
+            break;
+        default:
+            kr = 0.299;
+            kb = 0.114;
+            break;
+    }
+
+    const double kg = 1. - kr - kb;
+    const double max = (1 << bits) - 1;
+    double ys, cs;
+
+    if (range == COLOR_RANGE_FULL)
+    {
+        m->y_offset = 0;
+        ys = cs = max / 1023.;
+    }
+    else
+    {
+        m->y_offset = 64;
+        ys = max / 876.;
+        cs = max / 896.;
+    }
+
+    const double one = 1 << YUV10_RGB_FRAC;
+
+    m->y = lround(ys * one);
+    m->rv = lround(2. * (1. - kr) * cs * one);
+    m->bu = lround(2. * (1. - kb) * cs * one);
+    m->gu = lround(2. * kb * (1. - kb) / kg * cs * one);
+    m->gv = lround(2. * kr * (1. - kr) / kg * cs * one);
+    m->max = max;
+}
+
+static inline int32_t Clip(int32_t v, int32_t max)
+{
+    return v < 0 ? 0 : v > max ? max : v;
+}
+
+static inline void Pixel(const struct yuv10_matrix *m, unsigned y, unsigned u,
+                         unsigned v, int32_t *r, int32_t *g, int32_t *b)
+{
+    const int32_t l = ((int32_t)y - m->y_offset) * m->y
+                    + (1 << (YUV10_RGB_FRAC - 1));
+    const int32_t cu = (int32_t)u - 512, cv = (int32_t)v - 512;
+
+    *r = Clip((l + m->rv * cv) >> YUV10_RGB_FRAC, m->max);
+    *g = Clip((l - m->gu * cu - m->gv * cv) >> YUV10_RGB_FRAC, m->max);
+    *b = Clip((l + m->bu * cu) >> YUV10_RGB_FRAC, m->max);
+}
+
+static void RowRGBA(void *dst, const uint16_t *y, const uint16_t *u,
+                    const uint16_t *v, unsigned width, unsigned shift,
+                    const struct yuv10_matrix *m)
+{
+    uint8_t *out = dst;
+
+    for (unsigned x = 0; x < width; x++)
+    {
+        int32_t r, g, b;
+
+        Pixel(m, y[x], u[x >> shift], v[x >> shift], &r, &g, &b);
+        out[4 * x + 0] = r;
+        out[4 * x + 1] = g;
+        out[4 * x + 2] = b;
+        out[4 * x + 3] = 0xff;
+    }
+}
+
+static void RowRGBA10(void *dst, const uint16_t *y, const uint16_t *u,
+                      const uint16_t *v, unsigned width, unsigned shift,
+                      const struct yuv10_matrix *m)
+{
+    uint8_t *out = dst;
+
+    for (unsigned x = 0; x < width; x++)
+    {
+        int32_t r, g, b;
+
+        Pixel(m, y[x], u[x >> shift], v[x >> shift], &r, &g, &b);
+        SetDWLE(&out[4 * x], r | (g << 10) | (b << 20) | (UINT32_C(3) << 30));
+    }
+}
+
+#ifdef YUV10_AVX2
+/* 8 pixels per iteration, on 32-bit lanes */
+YUV10_AVX2
+static void RowAVX2(uint32_t *out, const uint16_t *y, const uint16_t *u,
+                    const uint16_t *v, unsigned width, unsigned shift,
+                    const struct yuv10_matrix *m, bool rgba10)
+{
+    const __m256i offset = _mm256_set1_epi32(m->y_offset);
+    const __m256i ky = _mm256_set1_epi32(m->y);
+    const __m256i krv = _mm256_set1_epi32(m->rv);
+    const __m256i kgu = _mm256_set1_epi32(m->gu);
+    const __m256i kgv = _mm256_set1_epi32(m->gv);
+    const __m256i kbu = _mm256_set1_epi32(m->bu);
+    const __m256i round = _mm256_set1_epi32(1 << (YUV10_RGB_FRAC - 1));
+    const __m256i center = _mm256_set1_epi32(512);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max = _mm256_set1_epi32(m->max);
+    const __m256i alpha = _mm256_set1_epi32(rgba10 ? (int32_t)0xC0000000
+                                                   : (int32_t)0xFF000000);
+    const int gshift = rgba10 ? 10 : 8;
+    unsigned x = 0;
+
+    for (; x + 8 <= width; x += 8)
+    {
+        __m128i cu, cv;
+
+        if (shift)
+        {
+            cu = _mm_loadl_epi64((const __m128i *)(u + x / 2));
+            cv = _mm_loadl_epi64((const __m128i *)(v + x / 2));
+            cu = _mm_unpacklo_epi16(cu, cu);
+            cv = _mm_unpacklo_epi16(cv, cv);
+        }
+        else
+        {
+            cu = _mm_loadu_si128((const __m128i *)(u + x));
+            cv = _mm_loadu_si128((const __m128i *)(v + x));
+        }
+
+        __m256i vy = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(y + x)));
+        __m256i vu = _mm256_sub_epi32(_mm256_cvtepu16_epi32(cu), center);
+        __m256i vv = _mm256_sub_epi32(_mm256_cvtepu16_epi32(cv), center);
+        __m256i l = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(vy, offset), ky),
+                                     round);
+
+        __m256i r = _mm256_add_epi32(l, _mm256_mullo_epi32(vv, krv));
+        __m256i g = _mm256_sub_epi32(l, _mm256_add_epi32(_mm256_mullo_epi32(vu, kgu),
+                                                         _mm256_mullo_epi32(vv, kgv)));
+        __m256i b = _mm256_add_epi32(l, _mm256_mullo_epi32(vu, kbu));
+
+        r = _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(r, YUV10_RGB_FRAC), zero), max);
+        g = _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(g, YUV10_RGB_FRAC), zero), max);
+        b = _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(b, YUV10_RGB_FRAC), zero), max);
+
+        __m256i px = _mm256_or_si256(r, _mm256_slli_epi32(g, gshift));
+        px = _mm256_or_si256(px, _mm256_slli_epi32(b, 2 * gshift));
+        px = _mm256_or_si256(px, alpha);
+        _mm256_storeu_si256((__m256i *)(out + x), px);
+    }
+
+    if (x < width)
+        (rgba10 ? RowRGBA10 : RowRGBA)(out + x, y + x, u + (x >> shift),
+                                       v + (x >> shift), width - x, shift, m);
+}
+
+static void RowRGBA_AVX2(void *dst, const uint16_t *y, const uint16_t *u,
+                         const uint16_t *v, unsigned width, unsigned shift,
+                         const struct yuv10_matrix *m)
+{
+    RowAVX2(dst, y, u, v, width, shift, m, false);
+}
+
+static void RowRGBA10_AVX2(void *dst, const uint16_t *y, const uint16_t *u,
+                           const uint16_t *v, unsigned width, unsigned shift,
+                           const struct yuv10_matrix *m)
+{
+    RowAVX2(dst, y, u, v, width, shift, m, true);
+}
+#endif
+
+#ifdef YUV10_NEON
+static inline int32x4_t ClipNEON(int32x4_t v, int32x4_t max)
+{
+    return vminq_s32(vmaxq_s32(vshrq_n_s32(v, YUV10_RGB_FRAC), vdupq_n_s32(0)),
+                     max);
+}
+
+/* 4 pixels, on 32-bit lanes */
+static inline void Pixels4NEON(uint32_t *out, uint16x4_t y, uint16x4_t u,
+                               uint16x4_t v, const struct yuv10_matrix *m,
+                               bool rgba10)
+{
+    const int32x4_t center = vdupq_n_s32(512);
+    const int32x4_t max = vdupq_n_s32(m->max);
+    int32x4_t vy = vreinterpretq_s32_u32(vmovl_u16(y));
+    int32x4_t vu = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(u)), center);
+    int32x4_t vv = vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(v)), center);
+    int32x4_t l = vmlaq_n_s32(vdupq_n_s32(1 << (YUV10_RGB_FRAC - 1)),
+                              vsubq_s32(vy, vdupq_n_s32(m->y_offset)), m->y);
+
+    uint32x4_t r = vreinterpretq_u32_s32(ClipNEON(vmlaq_n_s32(l, vv, m->rv), max));
+    uint32x4_t g = vreinterpretq_u32_s32(ClipNEON(vmlsq_n_s32(vmlsq_n_s32(l, vu, m->gu),
+                                                              vv, m->gv), max));
+    uint32x4_t b = vreinterpretq_u32_s32(ClipNEON(vmlaq_n_s32(l, vu, m->bu), max));
+    uint32x4_t px;
+
+    if (rgba10)
+        px = vorrq_u32(vorrq_u32(r, vshlq_n_u32(g, 10)),
+                       vorrq_u32(vshlq_n_u32(b, 20), vdupq_n_u32(0xC0000000)));
+    else
+        px = vorrq_u32(vorrq_u32(r, vshlq_n_u32(g, 8)),
+                       vorrq_u32(vshlq_n_u32(b, 16), vdupq_n_u32(0xFF000000)));
+    vst1q_u32(out, px);
+}
+
+/* 8 pixels per iteration */
+static void RowNEON(uint32_t *out, const uint16_t *y, const uint16_t *u,
+                    const uint16_t *v, unsigned width, unsigned shift,
+                    const struct yuv10_matrix *m, bool rgba10)
+{
+    unsigned x = 0;
+
+    for (; x + 8 <= width; x += 8)
+    {
+        uint16x8_t vy = vld1q_u16(y + x);
+        uint16x8_t vu, vv;
+
+        if (shift)
+        {
+            uint16x4_t cu = vld1_u16(u + x / 2), cv = vld1_u16(v + x / 2);
+
+            vu = vcombine_u16(vzip1_u16(cu, cu), vzip2_u16(cu, cu));
+            vv = vcombine_u16(vzip1_u16(cv, cv), vzip2_u16(cv, cv));
+        }
+        else
+        {
+            vu = vld1q_u16(u + x);
+            vv = vld1q_u16(v + x);
+        }
+
+        Pixels4NEON(out + x, vget_low_u16(vy), vget_low_u16(vu),
+                    vget_low_u16(vv), m, rgba10);
+        Pixels4NEON(out + x + 4, vget_high_u16(vy), vget_high_u16(vu),
+                    vget_high_u16(vv), m, rgba10);
+    }
+
+    if (x < width)
+        (rgba10 ? RowRGBA10 : RowRGBA)(out + x, y + x, u + (x >> shift),
+                                       v + (x >> shift), width - x, shift, m);
+}
+
+static void RowRGBA_NEON(void *dst, const uint16_t *y, const uint16_t *u,
+                         const uint16_t *v, unsigned width, unsigned shift,
+                         const struct yuv10_matrix *m)
+{
+    RowNEON(dst, y, u, v, width, shift, m, false);
+}
+
+static void RowRGBA10_NEON(void *dst, const uint16_t *y, const uint16_t *u,
+                           const uint16_t *v, unsigned width, unsigned shift,
+                           const struct yuv10_matrix *m)
+{
+    RowNEON(dst, y, u, v, width, shift, m, true);
+}
+#endif
+
+yuv10_row_cb yuv10_rgb_GetRow(vlc_fourcc_t chroma, bool optimized)
+{
+    const bool rgba10 = chroma == VLC_CODEC_RGBA10LE;
+
+    if (!rgba10 && chroma != VLC_CODEC_RGBA)
+        return NULL;
+
+#ifdef YUV10_AVX2
+    if (optimized && vlc_CPU_AVX2())
+        return rgba10 ? RowRGBA10_AVX2 : RowRGBA_AVX2;
+#endif
+#ifdef YUV10_NEON
+    if (optimized && vlc_CPU_ARM_NEON())
+        return rgba10 ? RowRGBA10_NEON : RowRGBA_NEON;
+#endif
+    VLC_UNUSED(optimized);
+    return rgba10 ? RowRGBA10 : RowRGBA;
+}
+
+void yuv10_UnpackP010(uint16_t *restrict dy, uint16_t *restrict du,
+                      uint16_t *restrict dv, const uint16_t *y,
+                      const uint16_t *uv, unsigned width)
+{
+    for (unsigned x = 0; x < width; x++)
+        dy[x] = y[x] >> 6;
+
+    if (uv == NULL)
+        return;
+
+    for (unsigned x = 0; x < (width + 1) / 2; x++)
+    {
+        du[x] = uv[2 * x] >> 6;
+        dv[x] = uv[2 * x + 1] >> 6;
+    }
+}
+
+#ifdef YUV10_RGB_TEST
+
+#include <stdio.h>
+
+#define BENCH_WIDTH  3840
+#define BENCH_HEIGHT 2160
+
+static const unsigned widths[] = { 1, 2, 7, 8, 9, 17, 63, 1920 };
+
+static void FillRandom(uint16_t *buf, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        buf[i] = rand() & 0x3ff;
+}
+
+static void test_matrix(void)
+{
+    struct yuv10_matrix m;
+    uint8_t rgba[4];
+    uint32_t rgba10;
+    const uint16_t black = 64, white = 940, grey = 512;
+
+    /* Limited range black, white, and no chroma whatever the matrix */
+    for (int space = COLOR_SPACE_BT601; space <= COLOR_SPACE_BT2020; space++)
+    {
+        yuv10_matrix_Init(&m, space, COLOR_RANGE_LIMITED, 8);
+        RowRGBA(rgba, &black, &grey, &grey, 1, 0, &m);
+        assert(rgba[0] == 0 && rgba[1] == 0 && rgba[2] == 0 && rgba[3] == 255);
+        RowRGBA(rgba, &white, &grey, &grey, 1, 0, &m);
+        assert(rgba[0] == 255 && rgba[1] == 255 && rgba[2] == 255);
+
+        yuv10_matrix_Init(&m, space, COLOR_RANGE_LIMITED, 10);
+        RowRGBA10(&rgba10, &white, &grey, &grey, 1, 0, &m);
+        assert(GetDWLE(&rgba10) == 0xFFFFFFFF);
+        RowRGBA10(&rgba10, &black, &grey, &grey, 1, 0, &m);
+        assert(GetDWLE(&rgba10) == 0xC0000000);
+    }
+
+    /* BT.709 and BT.2020 saturated red differ */
+    const uint16_t y = 250, u = 409, v = 960;
+    uint8_t red709[4], red2020[4];
+
+    yuv10_matrix_Init(&m, COLOR_SPACE_BT709, COLOR_RANGE_LIMITED, 8);
+    RowRGBA(red709, &y, &u, &v, 1, 0, &m);
+    yuv10_matrix_Init(&m, COLOR_SPACE_BT2020, COLOR_RANGE_LIMITED, 8);
+    RowRGBA(red2020, &y, &u, &v, 1, 0, &m);
+    assert(red709[0] > 250 && red709[1] < 5 && red709[2] < 5);
+    assert(memcmp(red709, red2020, 3));
+}
+
+/* Whether the host CPU has an optimized converter */
+static bool HasOptimized(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    return vlc_CPU_AVX2();
+#elif defined(__aarch64__)
+    return vlc_CPU_ARM_NEON();
+#else
+    return false;
+#endif
+}
+
+static void test_rows(vlc_fourcc_t chroma)
+{
+    yuv10_row_cb ref = yuv10_rgb_GetRow(chroma, false);
+    yuv10_row_cb opt = yuv10_rgb_GetRow(chroma, true);
+    const unsigned bits = chroma == VLC_CODEC_RGBA10LE ? 10 : 8;
+    const unsigned max = widths[ARRAY_SIZE(widths) - 1];
+    uint16_t *y = malloc(max * sizeof (*y));
+    uint16_t *u = malloc(max * sizeof (*u));
+    uint16_t *v = malloc(max * sizeof (*v));
+    uint32_t *a = malloc(max * sizeof (*a));
+    uint32_t *b = malloc(max * sizeof (*b));
+    assert(y && u && v && a && b);
+
+    if (ref == opt)
+    {
+        fprintf(stderr, "%4.4s: no optimized converter\n", (char *)&chroma);
+        /* Not built, e.g. the compiler lacks the intrinsics */
+        assert(!HasOptimized());
+    }
+
+    for (int space = COLOR_SPACE_BT601; space <= COLOR_SPACE_BT2020; space++)
+        for (int range = COLOR_RANGE_FULL; range <= COLOR_RANGE_LIMITED; range++)
+        {
+            struct yuv10_matrix m;
+
+            yuv10_matrix_Init(&m, space, range, bits);
+            for (size_t i = 0; i < ARRAY_SIZE(widths); i++)
+                for (unsigned shift = 0; shift <= 1; shift++)
+                {
+                    const unsigned w = widths[i];
+
+                    FillRandom(y, max);
+                    FillRandom(u, max);
+                    FillRandom(v, max);
+                    ref(a, y, u, v, w, shift, &m);
+                    opt(b, y, u, v, w, shift, &m);
+                    assert(!memcmp(a, b, w * sizeof (*a)));
+                }
+        }
+
+    free(b);
+    free(a);
+    free(v);
+    free(u);
+    free(y);
+}
+
+static void bench(vlc_fourcc_t in, vlc_fourcc_t out, bool optimized)
+{
+    yuv10_row_cb row = yuv10_rgb_GetRow(out, optimized);
+    const size_t pixels = BENCH_WIDTH * BENCH_HEIGHT;
+    uint16_t *y = malloc(pixels * sizeof (*y));
+    uint16_t *uv = malloc(pixels * 2 * sizeof (*uv));
+    uint16_t *tmp = malloc(BENCH_WIDTH * 2 * sizeof (*tmp));
+    uint32_t *dst = malloc(pixels * sizeof (*dst));
+    assert(y && uv && tmp && dst);
+
+    struct yuv10_matrix m;
+    yuv10_matrix_Init(&m, COLOR_SPACE_BT2020, COLOR_RANGE_LIMITED,
+                      out == VLC_CODEC_RGBA10LE ? 10 : 8);
+    FillRandom(y, pixels);
+    FillRandom(uv, pixels * 2);
+
+    vlc_tick_t start = vlc_tick_now();
+
+    for (unsigned j = 0; j < BENCH_HEIGHT; j++)
+    {
+        uint32_t *d = dst + j * BENCH_WIDTH;
+        const uint16_t *sy = y + j * BENCH_WIDTH;
+
+        switch (in)
+        {
+            case VLC_CODEC_P010:
+            {
+                uint16_t *ty = tmp, *tu = tmp + BENCH_WIDTH;
+                uint16_t *tv = tu + BENCH_WIDTH / 2;
+
+                yuv10_UnpackP010(ty, tu, tv, sy,
+                                 uv + (j / 2) * BENCH_WIDTH, BENCH_WIDTH);
+                row(d, ty, tu, tv, BENCH_WIDTH, 1, &m);
+                break;
+            }
+            case VLC_CODEC_I420_10L:
+                row(d, sy, uv + (j / 2) * (BENCH_WIDTH / 2),
+                    uv + pixels + (j / 2) * (BENCH_WIDTH / 2),
+                    BENCH_WIDTH, 1, &m);
+                break;
+            case VLC_CODEC_I444_10L:
+                row(d, sy, uv + j * BENCH_WIDTH, uv + pixels + j * BENCH_WIDTH,
+                    BENCH_WIDTH, 0, &m);
+                break;
+        }
+    }
+
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+    fprintf(stderr, "%4.4s -> %4.4s (%s): %"PRId64" us per %ux%u frame, "
+            "%.1f Mpixels/s\n", (char *)&in, (char *)&out,
+            optimized ? "optimized" : "C", US_FROM_VLC_TICK(elapsed),
+            BENCH_WIDTH, BENCH_HEIGHT,
+            pixels / (double)__MAX(US_FROM_VLC_TICK(elapsed), 1));
+
+    free(dst);
+    free(tmp);
+    free(uv);
+    free(y);
+}
+
+int main(void)
+{
+    static const vlc_fourcc_t ins[] = {
+        VLC_CODEC_P010, VLC_CODEC_I420_10L, VLC_CODEC_I444_10L,
+    };
+    static const vlc_fourcc_t outs[] = {
+        VLC_CODEC_RGBA, VLC_CODEC_RGBA10LE,
+    };
+
+    test_matrix();
+
+    for (size_t i = 0; i < ARRAY_SIZE(outs); i++)
+        test_rows(outs[i]);
+
+    for (size_t i = 0; i < ARRAY_SIZE(ins); i++)
+        for (size_t j = 0; j < ARRAY_SIZE(outs); j++)
+        {
+            bench(ins[i], outs[j], false);
+            bench(ins[i], outs[j], true);
+        }
+    return 0;
+}
+
+#endif
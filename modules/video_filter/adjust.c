@@ -120,7 +120,7 @@ static int FloatCallback( vlc_object_t *obj, char const *varname,
     return VLC_SUCCESS;
 }
 
-VIDEO_FILTER_WRAPPER_CLOSE( FilterPlanar, Destroy )
+VIDEO_FILTER_WRAPPER_CLOSE_POINT_OP( FilterPlanar, Destroy, PointOp )
 
 static const struct vlc_filter_operations packed_filter_ops =
 {
@@ -218,6 +218,42 @@ static void Destroy( filter_t *p_filter )
     var_DelCallback( p_filter, "gamma", FloatCallback, &p_sys->f_gamma );
 }
 
+/*****************************************************************************
+ * Fill the luma lookup table from the contrast, brightness and gamma
+ *****************************************************************************/
+static void FillLuma( filter_sys_t *p_sys, float f_range, int *pi_luma )
+{
+    /* The full range will only be used for 10-bit */
+    int pi_gamma[1024];
+
+    const float f_max = f_range - 1.f;
+    const unsigned i_max = f_max;
+    const int i_range = f_range;
+    const unsigned i_size = i_range;
+    const unsigned i_mid = i_range >> 1;
+
+    /* Get variables */
+    int32_t i_cont = lroundf( atomic_load_explicit( &p_sys->f_contrast, memory_order_relaxed ) * f_max );
+    int32_t i_lum = lroundf( (atomic_load_explicit( &p_sys->f_brightness, memory_order_relaxed ) - 1.f) * f_max );
+    float f_gamma = 1.f / atomic_load_explicit( &p_sys->f_gamma, memory_order_relaxed );
+
+    /* Contrast is a fast but kludged function, so I put this gap to be
+     * cleaner :) */
+    i_lum += i_mid - i_cont / 2;
+
+    /* Fill the gamma lookup table */
+    for( unsigned i = 0 ; i < i_size; i++ )
+    {
+        pi_gamma[ i ] = VLC_CLIP( powf(i / f_max, f_gamma) * f_max, 0, i_max );
+    }
+
+    /* Fill the luma lookup table */
+    for( unsigned i = 0 ; i < i_size; i++ )
+    {
+        pi_luma[ i ] = pi_gamma[VLC_CLIP( (int)(i_lum + i_cont * i / i_range), 0, (int) i_max )];
+    }
+}
+
 /*****************************************************************************
  * Run the filter on a Planar YUV picture
  *****************************************************************************/
@@ -225,7 +261,6 @@ static void FilterPlanar( filter_t *p_filter, picture_t *p_pic, picture_t *p_out
 {
     /* The full range will only be used for 10-bit */
     int pi_luma[1024];
-    int pi_gamma[1024];
 
     filter_sys_t *p_sys = p_filter->p_sys;
 
@@ -247,33 +282,14 @@ static void FilterPlanar( filter_t *p_filter, picture_t *p_pic, picture_t *p_out
     }
 
     const float f_max = f_range - 1.f;
-    const unsigned i_max = f_max;
     const int i_range = f_range;
-    const unsigned i_size = i_range;
     const unsigned i_mid = i_range >> 1;
 
     /* Get variables */
-    int32_t i_cont = lroundf( atomic_load_explicit( &p_sys->f_contrast, memory_order_relaxed ) * f_max );
-    int32_t i_lum = lroundf( (atomic_load_explicit( &p_sys->f_brightness, memory_order_relaxed ) - 1.f) * f_max );
     float f_hue = atomic_load_explicit( &p_sys->f_hue, memory_order_relaxed ) * (float)(M_PI / 180.);
     int i_sat = (int)( atomic_load_explicit( &p_sys->f_saturation, memory_order_relaxed ) * f_range );
-    float f_gamma = 1.f / atomic_load_explicit( &p_sys->f_gamma, memory_order_relaxed );
-
-    /* Contrast is a fast but kludged function, so I put this gap to be
-     * cleaner :) */
-    i_lum += i_mid - i_cont / 2;
 
-    /* Fill the gamma lookup table */
-    for( unsigned i = 0 ; i < i_size; i++ )
-    {
-        pi_gamma[ i ] = VLC_CLIP( powf(i / f_max, f_gamma) * f_max, 0, i_max );
-    }
-
-    /* Fill the luma lookup table */
-    for( unsigned i = 0 ; i < i_size; i++ )
-    {
-        pi_luma[ i ] = pi_gamma[VLC_CLIP( (int)(i_lum + i_cont * i / i_range), 0, (int) i_max )];
-    }
+    FillLuma( p_sys, f_range, pi_luma );
 
     /*
      * Do the Y plane
@@ -378,6 +394,60 @@ static void FilterPlanar( filter_t *p_filter, picture_t *p_pic, picture_t *p_out
     }
 }
 
+/*****************************************************************************
+ * Describe the filter on an 8-bit Planar YUV picture as lookup tables
+ *****************************************************************************
+ * Without hue rotation, the U and V planes do not depend on each other.
+ * The tables are computed as FilterPlanar and planar_sat_hue_C do.
+ *****************************************************************************/
+static int PointOp( filter_t *p_filter, uint8_t lut[][256] )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    switch( p_filter->fmt_in.video.i_chroma )
+    {
+        CASE_PLANAR_YUV10
+        CASE_PLANAR_YUV9
+            return VLC_EGENERIC;
+        default:
+            break;
+    }
+
+    float f_hue = atomic_load_explicit( &p_sys->f_hue, memory_order_relaxed ) * (float)(M_PI / 180.);
+    int i_sat = (int)( atomic_load_explicit( &p_sys->f_saturation, memory_order_relaxed ) * 256.f );
+
+    int i_sin = sinf(f_hue) * 255.f;
+    int i_cos = cosf(f_hue) * 255.f;
+    if( i_sin != 0 )
+        return VLC_EGENERIC;
+
+    int i_x = ( cosf(f_hue) + sinf(f_hue) ) * 256.f * 128;
+    int i_y = ( cosf(f_hue) - sinf(f_hue) ) * 256.f * 128;
+
+    int pi_luma[256];
+    FillLuma( p_sys, 256.f, pi_luma );
+
+    const bool b_alpha = p_filter->fmt_in.video.i_chroma == VLC_CODEC_YUVA;
+
+    for( int i = 0; i < 256; i++ )
+    {
+        int i_u = (((( ((i * i_cos - i_x) + 128) >> 8) * i_sat) + 128) >> 8) + 128;
+        int i_v = (((( ((i * i_cos - i_y) + 128) >> 8) * i_sat) + 128) >> 8) + 128;
+
+        if( i_sat > 256 )
+        {
+            i_u = VLC_CLIP( i_u, 0, 255 );
+            i_v = VLC_CLIP( i_v, 0, 255 );
+        }
+        lut[Y_PLANE][i] = pi_luma[i];
+        lut[U_PLANE][i] = i_u;
+        lut[V_PLANE][i] = i_v;
+        if( b_alpha )
+            lut[A_PLANE][i] = i; /* keep the alpha plane */
+    }
+    return VLC_SUCCESS;
+}
+
 /*****************************************************************************
  * Run the filter on a Packed YUV picture
  *****************************************************************************/
@@ -38,7 +38,7 @@
  *****************************************************************************/
 static int  Create      ( filter_t * );
 
-VIDEO_FILTER_WRAPPER(Filter)
+VIDEO_FILTER_WRAPPER_POINT_OP(Filter, PointOp)
 
 /*****************************************************************************
  * Module descriptor
@@ -145,3 +145,23 @@ static void Filter( filter_t *p_filter, picture_t *p_pic, picture_t *p_outpic )
         }
     }
 }
+
+/*****************************************************************************
+ * PointOp: describes the inversion as lookup tables
+ *****************************************************************************/
+static int PointOp( filter_t *p_filter, uint8_t lut[][256] )
+{
+    vlc_fourcc_t fourcc = p_filter->fmt_in.video.i_chroma;
+    const vlc_chroma_description_t *p_chroma =
+        vlc_fourcc_GetChromaDescription( fourcc );
+
+    for( unsigned i = 0; i < p_chroma->plane_count; i++ )
+    {
+        /* We don't want to invert the alpha plane */
+        bool b_alpha = fourcc == VLC_CODEC_YUVA && i == A_PLANE;
+
+        for( unsigned j = 0; j < 256; j++ )
+            lut[i][j] = b_alpha ? j : ~j;
+    }
+    return VLC_SUCCESS;
+}
@@ -48,7 +48,7 @@ static void PackedYUVPosterize( picture_t *, picture_t *, int);
 static void RVPosterize( picture_t *, picture_t *, bool, int );
 static void YuvPosterization( uint8_t *, uint8_t *, uint8_t *, uint8_t *,
                     uint8_t, uint8_t, uint8_t, uint8_t, int );
-VIDEO_FILTER_WRAPPER_CLOSE(Filter, Destroy)
+VIDEO_FILTER_WRAPPER_CLOSE_POINT_OP(Filter, Destroy, PointOp)
 
 static const char *const ppsz_filter_options[] = {
     "level", NULL
@@ -383,6 +383,31 @@ static void RVPosterize( picture_t *p_pic, picture_t *p_outpic,
     }
 }
 
+/*****************************************************************************
+ * PointOp: describes the RV24/RV32 posterization as a lookup table
+ *****************************************************************************
+ * YUV is posterized in RGB space, so the planes depend on each other.
+ *****************************************************************************/
+static int PointOp( filter_t *p_filter, uint8_t lut[][256] )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    int level = atomic_load( &p_sys->i_level );
+
+    switch( p_filter->fmt_in.video.i_chroma )
+    {
+        case VLC_CODEC_RGB24:
+        case VLC_CODEC_BGR24:
+        CASE_PACKED_RGB32
+            break;
+        default:
+            return VLC_EGENERIC;
+    }
+
+    for( int i = 0; i < 256; i++ )
+        lut[0][i] = POSTERIZE_PIXEL( i, level );
+    return VLC_SUCCESS;
+}
+
 /*****************************************************************************
  * YuvPosterization: Lowers the color depth of YUV color space
  *****************************************************************************
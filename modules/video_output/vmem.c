@@ -34,6 +34,8 @@
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_vout_display.h>
+#include <vlc_picture_pool.h>
+#include <vlc_atomic.h>
 
 /*****************************************************************************
  * Module descriptor
@@ -76,10 +78,26 @@ vlc_module_end()
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
-typedef struct
+/* Maximum number of application buffers */
+#define VMEM_MAX_BUFFERS 64
+
+/* Application buffer */
+struct vmem_buffer
 {
     void *id;
-} picture_sys_t;
+    void *planes[PICTURE_PLANE_MAX];
+};
+
+/* Application buffers, shared by the display and the pictures wrapping them,
+ * which may outlive the display */
+struct vmem_buffers
+{
+    vlc_atomic_rc_t rc;
+    void *opaque;
+    void (*cleanup)(void *sys);
+    unsigned count;
+    struct vmem_buffer buffers[];
+};
 
 /* NOTE: the callback prototypes must match those of LibVLC */
 typedef struct vout_display_sys_t {
@@ -92,6 +110,9 @@ typedef struct vout_display_sys_t {
 
     unsigned pitches[PICTURE_PLANE_MAX];
     unsigned lines[PICTURE_PLANE_MAX];
+
+    struct vmem_buffers *buffers; /* NULL if not supplied by the application */
+    bool pooled; /* whether the buffers were handed out as a pool */
 } vout_display_sys_t;
 
 typedef unsigned (*vlc_format_cb)(void **, char *, unsigned *, unsigned *,
@@ -100,14 +121,116 @@ typedef unsigned (*vlc_format_cb)(void **, char *, unsigned *, unsigned *,
 static void           Prepare(vout_display_t *, picture_t *, const struct vlc_render_subpicture *, vlc_tick_t);
 static void           Display(vout_display_t *, picture_t *);
 static int            Control(vout_display_t *, int);
+static picture_pool_t *Pool(vout_display_t *, unsigned);
 
 static const struct vlc_display_operations ops = {
     .close = Close,
     .prepare = Prepare,
     .display = Display,
     .control = Control,
+    .pool = Pool,
 };
 
+static void BuffersRelease(struct vmem_buffers *b)
+{
+    if (!vlc_atomic_rc_dec(&b->rc))
+        return;
+
+    if (b->cleanup != NULL)
+        b->cleanup(b->opaque);
+    free(b);
+}
+
+/* Gets the application buffers, once the format is set up */
+static struct vmem_buffers *BuffersNew(vout_display_t *vd, unsigned count)
+{
+    vout_display_sys_t *sys = vd->sys;
+    void *(*get)(void *, unsigned, void **) =
+        var_InheritAddress(vd, "vmem-buffer");
+
+    if (get == NULL)
+        return NULL;
+    if (count > VMEM_MAX_BUFFERS) {
+        msg_Warn(vd, "%u buffers, more than %u, copying pictures", count,
+                 VMEM_MAX_BUFFERS);
+        return NULL;
+    }
+
+    struct vmem_buffers *b = malloc(sizeof (*b)
+                                    + count * sizeof (b->buffers[0]));
+    if (unlikely(b == NULL))
+        return NULL;
+
+    for (unsigned i = 0; i < count; i++) {
+        struct vmem_buffer *buf = &b->buffers[i];
+
+        memset(buf->planes, 0, sizeof (buf->planes));
+        buf->id = get(sys->opaque, i, buf->planes);
+        if (buf->planes[0] == NULL) {
+            msg_Warn(vd, "buffer %u not supplied, copying pictures", i);
+            free(b);
+            return NULL;
+        }
+    }
+
+    vlc_atomic_rc_init(&b->rc);
+    b->opaque = sys->opaque;
+    b->cleanup = sys->cleanup;
+    b->count = count;
+    msg_Dbg(vd, "%u application buffers", count);
+    return b;
+}
+
+static void PictureDestroy(picture_t *pic)
+{
+    BuffersRelease(pic->p_sys);
+}
+
+/* Hands the application buffers out, for the pictures to be rendered
+ * directly into them */
+static picture_pool_t *Pool(vout_display_t *vd, unsigned count)
+{
+    vout_display_sys_t *sys = vd->sys;
+    struct vmem_buffers *b = sys->buffers;
+
+    if (b == NULL || sys->pooled || count > b->count)
+        return NULL;
+    assert(b->count <= VMEM_MAX_BUFFERS);
+
+    picture_t *pics[VMEM_MAX_BUFFERS];
+    unsigned n;
+
+    for (n = 0; n < b->count; n++) {
+        picture_resource_t rsc = {
+            .p_sys = b,
+            .pf_destroy = PictureDestroy,
+        };
+
+        for (unsigned i = 0; i < PICTURE_PLANE_MAX; i++) {
+            rsc.p[i].p_pixels = b->buffers[n].planes[i];
+            rsc.p[i].i_lines  = sys->lines[i];
+            rsc.p[i].i_pitch  = sys->pitches[i];
+        }
+
+        pics[n] = picture_NewFromResource(vd->fmt, &rsc);
+        if (unlikely(pics[n] == NULL))
+            goto error;
+        vlc_atomic_rc_inc(&b->rc);
+    }
+
+    picture_pool_t *pool = picture_pool_New(n, pics);
+    if (unlikely(pool == NULL))
+        goto error;
+
+    sys->pooled = true;
+    return pool;
+
+error:
+    while (n > 0)
+        picture_Release(pics[--n]);
+    return NULL;
+}
+
 /*****************************************************************************
  * Open: allocates video thread
  *****************************************************************************
@@ -136,6 +259,7 @@ static int Open(vout_display_t *vd,
 
     /* Define the video format */
     video_format_t fmt;
+    unsigned buffers = 0;
     video_format_ApplyRotation(&fmt, vd->source);
 
     if (setup != NULL) {
@@ -153,8 +277,9 @@ static int Open(vout_display_t *vd,
         heights[0] = fmt.i_height;
         heights[1] = fmt.i_visible_height;
 
-        if (setup(&sys->opaque, chroma, widths, heights,
-                           sys->pitches, sys->lines) == 0) {
+        buffers = setup(&sys->opaque, chroma, widths, heights,
+                        sys->pitches, sys->lines);
+        if (buffers == 0) {
             msg_Err(vd, "video format setup failure (no pictures)");
             free(sys);
             return VLC_EGENERIC;
@@ -195,6 +320,9 @@ static int Open(vout_display_t *vd,
     vd->sys     = sys;
     vd->ops     = &ops;
 
+    sys->buffers = (buffers > 0) ? BuffersNew(vd, buffers) : NULL;
+    sys->pooled = false;
+
     (void) context;
     return VLC_SUCCESS;
 }
@@ -203,7 +331,10 @@ static void Close(vout_display_t *vd)
 {
     vout_display_sys_t *sys = vd->sys;
 
-    if (sys->cleanup)
+    /* Pictures from the pool may still refer to the buffers */
+    if (sys->buffers != NULL)
+        BuffersRelease(sys->buffers);
+    else if (sys->cleanup)
         sys->cleanup(sys->opaque);
     free(sys);
 }
@@ -217,6 +348,18 @@ static void Prepare(vout_display_t *vd, picture_t *pic,
     picture_resource_t rsc = { .p_sys = NULL };
     void *planes[PICTURE_PLANE_MAX];
 
+    if (sys->buffers != NULL) {
+        const struct vmem_buffers *b = sys->buffers;
+
+        /* Rendered directly into an application buffer: nothing to copy */
+        for (unsigned i = 0; i < b->count; i++)
+            if (pic->p[0].p_pixels == b->buffers[i].planes[0]) {
+                sys->pic_opaque = b->buffers[i].id;
+                (void) subpic;
+                return;
+            }
+    }
+
     sys->pic_opaque = sys->lock(sys->opaque, planes);
 
     picture_t *locked = picture_NewFromResource(vd->fmt, &rsc);
@@ -37,10 +37,14 @@
 
 #include "aout_internal.h"
 #include "clock/clock.h"
+#include "misc/spsc.h"
 #include "libvlc.h"
 
 #define BLOCK_FLAG_CORE_PRIVATE_FILTERED (1 << BLOCK_FLAG_CORE_PRIVATE_SHIFT)
 
+/* Number of blocks queued towards the audio processing thread */
+#define AOUT_WORKER_QUEUE_SIZE 8
+
 struct vlc_aout_stream
 {
     aout_instance_t *instance;
@@ -110,8 +114,31 @@ struct vlc_aout_stream
 
     atomic_uint buffers_lost;
     atomic_uint buffers_played;
+
+    /* Optional audio processing thread, running filters and output */
+    struct
+    {
+        bool enabled;
+        vlc_thread_t thread;
+        vlc_mutex_t lock; /* Held while processing a block or controlling
+                             the stream from the decoder */
+        vlc_cond_t idle;
+        vlc_sem_t queued; /* Count of blocks in the ring */
+        vlc_sem_t room; /* Count of free slots in the ring */
+        struct vlc_spsc ring;
+        atomic_uint pending; /* Blocks queued or being processed */
+        atomic_bool discard;
+        atomic_int status; /* Last non-success status to report */
+        bool broken; /* Output failed, until the next restart (decoder) */
+        block_t *held; /* Blocks left to the decoder thread by a restart */
+        block_t **held_last;
+    } worker;
 };
 
+static int stream_Play(vlc_aout_stream *stream, block_t *block);
+static void stream_Flush(vlc_aout_stream *stream);
+static void stream_Drain(vlc_aout_stream *stream);
+
 static inline aout_owner_t *aout_stream_owner(vlc_aout_stream *stream)
 {
     return &stream->instance->owner;
@@ -199,7 +226,7 @@ static int stream_StartDiscontinuity(vlc_aout_stream *stream, block_t *block)
 
     msg_Dbg(aout, "discontinuity: at %"PRId64" us, draining output",
             block->i_pts);
-    vlc_aout_stream_Drain(stream);
+    stream_Drain(stream);
     stream->discontinuity.draining = true;
 
     stream->discontinuity.fifo_first = NULL;
@@ -238,7 +265,7 @@ static int stream_HandleDiscontinuity(vlc_aout_stream *stream, block_t *block)
 
     /* Reset the discontinuity state, and flush */
     stream->discontinuity.draining = false;
-    vlc_aout_stream_Flush(stream);
+    stream_Flush(stream);
 
     msg_Dbg(aout, "discontinuity: playing back %d blocks for a total length of "
             "%"PRId64" us", count, length);
@@ -249,7 +276,7 @@ static int stream_HandleDiscontinuity(vlc_aout_stream *stream, block_t *block)
         next = block->p_next;
         block->p_next = NULL;
 
-        vlc_aout_stream_Play(stream, block);
+        stream_Play(stream, block);
     }
     return AOUT_DEC_SUCCESS;
 }
@@ -317,6 +344,152 @@ static void stream_Reset(vlc_aout_stream *stream)
     stream_ResetTimings(stream);
 }
 
+/*
+ * Audio processing thread
+ *
+ * When enabled, decoded blocks are handed over to a dedicated thread through
+ * a lock-free ring, so that heavy filters do not stall the decoder. Control
+ * functions wait for the queued blocks to be processed (or discarded) before
+ * touching the stream state, which preserves the synchronous semantics.
+ */
+
+static void *stream_WorkerThread(void *data)
+{
+    vlc_aout_stream *stream = data;
+
+    vlc_thread_set_name("vlc-aout-stream");
+
+    for (;;)
+    {
+        void *item;
+
+        vlc_sem_wait(&stream->worker.queued);
+        bool popped = vlc_spsc_Pop(&stream->worker.ring, &item);
+        assert(popped); (void) popped;
+        vlc_sem_post(&stream->worker.room);
+
+        block_t *block = item;
+        if (block == NULL)
+            break; /* Terminating */
+
+        vlc_mutex_lock(&stream->worker.lock);
+        if (atomic_load_explicit(&stream->worker.discard, memory_order_relaxed))
+            block_Release(block);
+        else if (stream->worker.held != NULL
+              || atomic_load_explicit(&stream->restart,
+                                      memory_order_acquire) != 0)
+            /* Leave restarts to the decoder thread, which gets their status
+             * synchronously, see vlc_aout_stream_Play() */
+            block_ChainLastAppend(&stream->worker.held_last, block);
+        else
+        {
+            int ret = stream_Play(stream, block);
+            if (ret != AOUT_DEC_SUCCESS)
+                atomic_store_explicit(&stream->worker.status, ret,
+                                      memory_order_relaxed);
+        }
+
+        if (atomic_fetch_sub_explicit(&stream->worker.pending, 1,
+                                      memory_order_release) == 1)
+            vlc_cond_broadcast(&stream->worker.idle);
+        vlc_mutex_unlock(&stream->worker.lock);
+    }
+    return NULL;
+}
+
+static void stream_WorkerQueue(vlc_aout_stream *stream, block_t *block)
+{
+    /* Wait for room in the ring: this paces the decoder */
+    vlc_sem_wait(&stream->worker.room);
+    bool pushed = vlc_spsc_Push(&stream->worker.ring, block);
+    assert(pushed); (void) pushed;
+    vlc_sem_post(&stream->worker.queued);
+}
+
+static int stream_WorkerStart(vlc_aout_stream *stream)
+{
+    if (vlc_spsc_Init(&stream->worker.ring, AOUT_WORKER_QUEUE_SIZE))
+        return VLC_ENOMEM;
+
+    vlc_mutex_init(&stream->worker.lock);
+    vlc_cond_init(&stream->worker.idle);
+    vlc_sem_init(&stream->worker.queued, 0);
+    vlc_sem_init(&stream->worker.room, AOUT_WORKER_QUEUE_SIZE);
+    atomic_init(&stream->worker.pending, 0);
+    atomic_init(&stream->worker.discard, false);
+    atomic_init(&stream->worker.status, AOUT_DEC_SUCCESS);
+    stream->worker.broken = false;
+    stream->worker.held = NULL;
+    stream->worker.held_last = &stream->worker.held;
+
+    if (vlc_clone(&stream->worker.thread, stream_WorkerThread, stream))
+    {
+        vlc_spsc_Destroy(&stream->worker.ring);
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static void stream_WorkerDropHeld(vlc_aout_stream *stream)
+{
+    block_ChainRelease(stream->worker.held);
+    stream->worker.held = NULL;
+    stream->worker.held_last = &stream->worker.held;
+}
+
+/* Plays the blocks held back by the processing thread, on the calling one */
+static int stream_WorkerPlayHeld(vlc_aout_stream *stream)
+{
+    block_t *block = stream->worker.held;
+    int ret = AOUT_DEC_SUCCESS;
+
+    stream->worker.held = NULL;
+    stream->worker.held_last = &stream->worker.held;
+
+    while (block != NULL)
+    {
+        block_t *next = block->p_next;
+
+        block->p_next = NULL;
+        int status = stream_Play(stream, block);
+        if (status != AOUT_DEC_SUCCESS)
+            ret = status;
+        block = next;
+    }
+    return ret;
+}
+
+static void stream_WorkerStop(vlc_aout_stream *stream)
+{
+    /* Drop pending blocks, then queue the termination marker */
+    atomic_store_explicit(&stream->worker.discard, true, memory_order_relaxed);
+    stream_WorkerQueue(stream, NULL);
+    vlc_join(stream->worker.thread, NULL);
+    vlc_spsc_Destroy(&stream->worker.ring);
+    stream_WorkerDropHeld(stream);
+}
+
+/**
+ * Waits for all queued blocks to be processed and locks out the processing
+ * thread, if any.
+ */
+static void stream_WorkerLock(vlc_aout_stream *stream)
+{
+    if (!stream->worker.enabled)
+        return;
+
+    vlc_mutex_lock(&stream->worker.lock);
+    while (atomic_load_explicit(&stream->worker.pending,
+                                memory_order_acquire) > 0)
+        vlc_cond_wait(&stream->worker.idle, &stream->worker.lock);
+}
+
+static void stream_WorkerUnlock(vlc_aout_stream *stream)
+{
+    if (stream->worker.enabled)
+        vlc_mutex_unlock(&stream->worker.lock);
+}
+
 /**
  * Creates an audio output
  */
@@ -423,6 +596,13 @@ error:
         }
     }
 
+    stream->worker.enabled = var_InheritBool(p_aout, "audio-thread");
+    if (stream->worker.enabled && stream_WorkerStart(stream))
+    {
+        msg_Warn(p_aout, "cannot start audio processing thread");
+        stream->worker.enabled = false;
+    }
+
     return stream;
 }
 
@@ -434,6 +614,9 @@ void vlc_aout_stream_Delete (vlc_aout_stream *stream)
     audio_output_t *aout = aout_stream_aout(stream);
     aout_owner_t *owner = aout_stream_owner(stream);
 
+    if (stream->worker.enabled)
+        stream_WorkerStop(stream);
+
     if (stream->mixer_format.i_format)
     {
         vlc_audio_meter_Reset(&owner->meter, NULL);
@@ -622,7 +805,7 @@ static void stream_HandleDrift(vlc_aout_stream *stream, vlc_tick_t drift,
         else
             msg_Dbg (aout, "playback too late (%"PRId64"): "
                      "flushing buffers", drift);
-        vlc_aout_stream_Flush(stream);
+        stream_Flush(stream);
         stream_StopResampling(stream);
 
         return; /* nothing can be done if timing is unknown */
@@ -845,9 +1028,9 @@ static vlc_tick_t stream_ClockConvert(vlc_aout_stream *stream,
 }
 
 /*****************************************************************************
- * vlc_aout_stream_Play : filter & mix the decoded buffer
+ * stream_Play : filter & mix the decoded buffer
  *****************************************************************************/
-int vlc_aout_stream_Play(vlc_aout_stream *stream, block_t *block)
+static int stream_Play(vlc_aout_stream *stream, block_t *block)
 {
     aout_owner_t *owner = aout_stream_owner(stream);
     audio_output_t *aout = aout_stream_aout(stream);
@@ -958,6 +1141,7 @@ void vlc_aout_stream_ChangePause(vlc_aout_stream *stream, bool paused, vlc_tick_
 {
     audio_output_t *aout = aout_stream_aout(stream);
 
+    stream_WorkerLock(stream);
     if (stream->mixer_format.i_format)
     {
         struct vlc_tracer *tracer = aout_stream_tracer(stream);
@@ -985,7 +1169,7 @@ void vlc_aout_stream_ChangePause(vlc_aout_stream *stream, bool paused, vlc_tick_
         if (aout->pause != NULL)
             aout->pause(aout, paused, date);
         else if (paused)
-            vlc_aout_stream_Flush(stream);
+            stream_Flush(stream);
 
         /* Update the rate point after the pause */
         if (aout->time_get == NULL && !paused
@@ -1000,19 +1184,24 @@ void vlc_aout_stream_ChangePause(vlc_aout_stream *stream, bool paused, vlc_tick_
             stream->timing.rate_system_ts = play_date;
         }
     }
+    stream_WorkerUnlock(stream);
 }
 
 void vlc_aout_stream_ChangeRate(vlc_aout_stream *stream, float rate)
 {
+    stream_WorkerLock(stream);
     stream->sync.rate = rate;
+    stream_WorkerUnlock(stream);
 }
 
 void vlc_aout_stream_ChangeDelay(vlc_aout_stream *stream, vlc_tick_t delay)
 {
+    stream_WorkerLock(stream);
     stream->sync.request_delay = delay;
+    stream_WorkerUnlock(stream);
 }
 
-void vlc_aout_stream_Flush(vlc_aout_stream *stream)
+static void stream_Flush(vlc_aout_stream *stream)
 {
     audio_output_t *aout = aout_stream_aout(stream);
 
@@ -1038,6 +1227,11 @@ void vlc_aout_stream_NotifyDrained(vlc_aout_stream *stream)
 
 bool vlc_aout_stream_IsDrained(vlc_aout_stream *stream)
 {
+    /* Blocks are still queued towards the processing thread */
+    if (stream->worker.enabled
+     && atomic_load_explicit(&stream->worker.pending, memory_order_acquire) > 0)
+        return false;
+
     /* The internal draining state should not mess with the public one */
     if (stream->discontinuity.draining)
         return false;
@@ -1045,7 +1239,7 @@ bool vlc_aout_stream_IsDrained(vlc_aout_stream *stream)
     return stream_IsDrained(stream);
 }
 
-void vlc_aout_stream_Drain(vlc_aout_stream *stream)
+static void stream_Drain(vlc_aout_stream *stream)
 {
     audio_output_t *aout = aout_stream_aout(stream);
 
@@ -1105,3 +1299,65 @@ void vlc_aout_stream_Drain(vlc_aout_stream *stream)
                               memory_order_relaxed);
     }
 }
+
+int vlc_aout_stream_Play(vlc_aout_stream *stream, block_t *block)
+{
+    if (!stream->worker.enabled)
+        return stream_Play(stream, block);
+
+    /* Report errors from previously processed blocks, if a restart was
+     * requested while one of them was being played */
+    int ret = atomic_exchange_explicit(&stream->worker.status,
+                                       AOUT_DEC_SUCCESS, memory_order_relaxed);
+    if (ret == AOUT_DEC_FAILED)
+        stream->worker.broken = true;
+
+    /* Restarts can fail or require a decoder change: apply them on this
+     * thread, so that the status is reported with the very block. A failed
+     * output stays so until the next restart, so that is synchronous too.
+     * The processing thread holds blocks back while a restart is pending. */
+    if (stream->worker.broken
+     || atomic_load_explicit(&stream->restart, memory_order_acquire) != 0)
+    {
+        stream_WorkerLock(stream);
+        int status = stream_WorkerPlayHeld(stream);
+        int played = stream_Play(stream, block);
+        if (played != AOUT_DEC_SUCCESS)
+            status = played;
+        stream_WorkerUnlock(stream);
+
+        stream->worker.broken = status == AOUT_DEC_FAILED;
+        return status != AOUT_DEC_SUCCESS ? status : ret;
+    }
+
+    atomic_fetch_add_explicit(&stream->worker.pending, 1,
+                              memory_order_relaxed);
+    stream_WorkerQueue(stream, block);
+    return ret;
+}
+
+void vlc_aout_stream_Flush(vlc_aout_stream *stream)
+{
+    if (stream->worker.enabled)
+        atomic_store_explicit(&stream->worker.discard, true,
+                              memory_order_relaxed);
+
+    stream_WorkerLock(stream);
+    if (stream->worker.enabled)
+    {
+        atomic_store_explicit(&stream->worker.discard, false,
+                              memory_order_relaxed);
+        stream_WorkerDropHeld(stream);
+    }
+    stream_Flush(stream);
+    stream_WorkerUnlock(stream);
+}
+
+void vlc_aout_stream_Drain(vlc_aout_stream *stream)
+{
+    stream_WorkerLock(stream);
+    if (stream->worker.enabled)
+        stream_WorkerPlayHeld(stream);
+    stream_Drain(stream);
+    stream_WorkerUnlock(stream);
+}
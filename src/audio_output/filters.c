@@ -41,11 +41,20 @@
 #include "aout_internal.h"
 #include "../video_output/vout_internal.h" /* for vout_Request */
 
+struct filter_owner_sys
+{
+    vlc_clock_t *clock_source;
+    vlc_clock_t *clock;
+    vout_thread_t *vout;
+    struct aout_buffer_pool *pool;
+};
+
 struct aout_filter
 {
     filter_t *f;
     vlc_clock_t *clock;
     vout_thread_t *vout;
+    struct filter_owner_sys *owner_sys;
 };
 
 static inline void aout_filter_Init(struct aout_filter *tab, filter_t *f)
@@ -53,8 +62,176 @@ static inline void aout_filter_Init(struct aout_filter *tab, filter_t *f)
     tab->f = f;
     tab->clock = NULL;
     tab->vout = NULL;
+    tab->owner_sys = NULL;
+}
+
+/*
+ * Audio buffer pool
+ *
+ * Output buffers of the filters that cannot work in place (converters,
+ * resamplers, time stretching...) are recycled within the pipeline instead
+ * of being allocated for every block. Buffers may outlive the pipeline (they
+ * are passed to the audio output), so the pool is reference counted.
+ */
+
+#define AOUT_POOL_ALIGN 64
+#define AOUT_POOL_MAX_FREE 8
+
+struct aout_buffer_pool
+{
+    vlc_mutex_t lock;
+    struct aout_pool_block *free; /**< Recycled buffers */
+    unsigned free_count;
+    unsigned refs; /**< Pipeline and outstanding buffers */
+    bool dead; /**< Pipeline deleted, do not recycle anymore */
+
+    /* Statistics (only updated from the filtering thread) */
+    unsigned allocated; /**< Buffers allocated */
+    unsigned reused; /**< Buffers taken from the pool */
+    unsigned inplace; /**< Filter passes reusing the input buffer */
+};
+
+struct aout_pool_block
+{
+    block_t self;
+    struct aout_buffer_pool *pool;
+    struct aout_pool_block *next;
+    size_t capacity;
+};
+
+#define AOUT_POOL_HEADER \
+    ((sizeof (struct aout_pool_block) + AOUT_POOL_ALIGN - 1) \
+     & ~(size_t)(AOUT_POOL_ALIGN - 1))
+
+static struct aout_buffer_pool *aout_BufferPoolNew(void)
+{
+    struct aout_buffer_pool *pool = malloc(sizeof (*pool));
+    if (unlikely(pool == NULL))
+        return NULL;
+
+    vlc_mutex_init(&pool->lock);
+    pool->free = NULL;
+    pool->free_count = 0;
+    pool->refs = 1;
+    pool->dead = false;
+    pool->allocated = pool->reused = pool->inplace = 0;
+    return pool;
+}
+
+static void aout_BufferPoolDestroy(struct aout_buffer_pool *pool)
+{
+    assert(pool->refs == 0);
+
+    for (struct aout_pool_block *b = pool->free, *next; b != NULL; b = next)
+    {
+        next = b->next;
+        aligned_free(b);
+    }
+    free(pool);
+}
+
+static void aout_BufferPoolUnref(struct aout_buffer_pool *pool)
+{
+    vlc_mutex_lock(&pool->lock);
+    bool last = --pool->refs == 0;
+    vlc_mutex_unlock(&pool->lock);
+
+    if (last)
+        aout_BufferPoolDestroy(pool);
+}
+
+static void aout_BufferPoolRecycle(block_t *block)
+{
+    struct aout_pool_block *b = container_of(block, struct aout_pool_block,
+                                             self);
+    struct aout_buffer_pool *pool = b->pool;
+
+    vlc_mutex_lock(&pool->lock);
+    if (!pool->dead && pool->free_count < AOUT_POOL_MAX_FREE)
+    {
+        b->next = pool->free;
+        pool->free = b;
+        pool->free_count++;
+        b = NULL;
+    }
+    vlc_mutex_unlock(&pool->lock);
+
+    aligned_free(b);
+    aout_BufferPoolUnref(pool);
+}
+
+static const struct vlc_block_callbacks aout_pool_block_cbs =
+{
+    aout_BufferPoolRecycle,
+};
+
+static block_t *aout_BufferPoolGet(struct aout_buffer_pool *pool, size_t size)
+{
+    vlc_mutex_lock(&pool->lock);
+    struct aout_pool_block *b = pool->free;
+    if (b != NULL)
+    {
+        pool->free = b->next;
+        pool->free_count--;
+    }
+    pool->refs++;
+    vlc_mutex_unlock(&pool->lock);
+
+    if (b != NULL && b->capacity < size)
+    {
+        aligned_free(b);
+        b = NULL;
+    }
+
+    if (b == NULL)
+    {
+        /* Round up so that buffers of slightly varying sizes (e.g. from
+         * resamplers) can be recycled. */
+        size_t capacity = (size + 4095) & ~(size_t)4095;
+        if (unlikely(capacity < size || capacity > SIZE_MAX - AOUT_POOL_HEADER))
+            b = NULL;
+        else
+            b = aligned_alloc(AOUT_POOL_ALIGN, AOUT_POOL_HEADER + capacity);
+        if (unlikely(b == NULL))
+        {
+            aout_BufferPoolUnref(pool);
+            return NULL;
+        }
+        b->pool = pool;
+        b->capacity = capacity;
+        pool->allocated++;
+    }
+    else
+        pool->reused++;
+
+    block_t *block = block_Init(&b->self, &aout_pool_block_cbs,
+                                (uint8_t *)b + AOUT_POOL_HEADER, b->capacity);
+    block->i_buffer = size;
+    return block;
+}
+
+static void aout_BufferPoolRelease(vlc_object_t *obj,
+                                   struct aout_buffer_pool *pool)
+{
+    msg_Dbg(obj, "filters buffers: %u allocated, %u recycled, %u in place",
+            pool->allocated, pool->reused, pool->inplace);
+
+    vlc_mutex_lock(&pool->lock);
+    pool->dead = true;
+    vlc_mutex_unlock(&pool->lock);
+    aout_BufferPoolUnref(pool);
+}
+
+static block_t *aout_filter_NewBuffer(filter_t *filter, size_t size)
+{
+    struct filter_owner_sys *owner_sys = filter->owner.sys;
+    return aout_BufferPoolGet(owner_sys->pool, size);
 }
 
+static const struct filter_audio_callbacks aout_filter_audio_cbs = {
+    .buffer_new = aout_filter_NewBuffer,
+};
+
 filter_t *aout_filter_Create(vlc_object_t *obj, const filter_owner_t *restrict owner,
                              const char *type, const char *name,
                              const audio_sample_format_t *infmt,
@@ -106,19 +283,21 @@ filter_t *aout_filter_Create(vlc_object_t *obj, const filter_owner_t *restrict o
 }
 
 static filter_t *FindConverter (vlc_object_t *obj,
+                                const filter_owner_t *restrict owner,
                                 const audio_sample_format_t *infmt,
                                 const audio_sample_format_t *outfmt)
 {
-    return aout_filter_Create(obj, NULL, "audio converter", NULL, infmt, outfmt,
+    return aout_filter_Create(obj, owner, "audio converter", NULL, infmt, outfmt,
                               NULL, true);
 }
 
 static filter_t *FindResampler (vlc_object_t *obj,
+                                const filter_owner_t *restrict owner,
                                 const audio_sample_format_t *infmt,
                                 const audio_sample_format_t *outfmt)
 {
     char *modlist = var_InheritString(obj, "audio-resampler");
-    filter_t *filter = aout_filter_Create(obj, NULL, "audio resampler", modlist,
+    filter_t *filter = aout_filter_Create(obj, owner, "audio resampler", modlist,
                                           infmt, outfmt, NULL, true);
     free(modlist);
     return filter;
@@ -134,6 +313,7 @@ static void aout_FiltersPipelineDestroy(struct aout_filter *tab, unsigned n)
         filter_t *p_filter = tab[i].f;
 
         vlc_filter_Delete(p_filter);
+        free(tab[i].owner_sys);
         if (tab[i].vout != NULL)
             vout_Close(tab[i].vout);
         if (tab[i].clock != NULL)
@@ -146,7 +326,9 @@ static void aout_FiltersPipelineDestroy(struct aout_filter *tab, unsigned n)
     }
 }
 
-static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
+static filter_t *TryFormat (vlc_object_t *obj,
+                            const filter_owner_t *restrict owner,
+                            vlc_fourcc_t codec,
                             audio_sample_format_t *restrict fmt)
 {
     audio_sample_format_t output = *fmt;
@@ -155,7 +337,7 @@ static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
     output.i_format = codec;
     aout_FormatPrepare (&output);
 
-    filter_t *filter = FindConverter (obj, fmt, &output);
+    filter_t *filter = FindConverter (obj, owner, fmt, &output);
     if (filter != NULL)
         *fmt = output;
     return filter;
@@ -164,6 +346,7 @@ static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
 /**
  * Allocates audio format conversion filters
  * @param obj parent VLC object for new filters
+ * @param owner owner of the new filters (or NULL)
  * @param filters table of filters [IN/OUT]
  * @param count pointer to the number of filters in the table [IN/OUT]
  * @param max size of filters table [IN]
@@ -171,7 +354,9 @@ static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
  * @param outfmt output audio format
  * @return 0 on success, -1 on failure
  */
-static int aout_FiltersPipelineCreate(vlc_object_t *obj, struct aout_filter *filters,
+static int aout_FiltersPipelineCreate(vlc_object_t *obj,
+                                      const filter_owner_t *restrict owner,
+                                      struct aout_filter *filters,
                                       unsigned *count, unsigned max,
                                  const audio_sample_format_t *restrict infmt,
                                  const audio_sample_format_t *restrict outfmt)
@@ -202,7 +387,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, struct aout_filter *fil
             if (n == max)
                 goto overflow;
 
-            filter_t *f = TryFormat (obj, VLC_CODEC_FL32, &input);
+            filter_t *f = TryFormat (obj, owner, VLC_CODEC_FL32, &input);
             if (f == NULL)
             {
                 msg_Err (obj, "cannot find %s for conversion pipeline",
@@ -228,7 +413,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, struct aout_filter *fil
             infmt->channel_type != outfmt->channel_type ?
             "audio renderer" : "audio converter";
 
-        filter_t *f = aout_filter_Create(obj, NULL, filter_type, NULL,
+        filter_t *f = aout_filter_Create(obj, owner, filter_type, NULL,
                                          &input, &output, NULL, true);
 
         if (f == NULL)
@@ -251,7 +436,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, struct aout_filter *fil
         audio_sample_format_t output = input;
         output.i_rate = outfmt->i_rate;
 
-        filter_t *f = FindConverter (obj, &input, &output);
+        filter_t *f = FindConverter (obj, owner, &input, &output);
         if (f == NULL)
         {
             msg_Err (obj, "cannot find %s for conversion pipeline",
@@ -269,7 +454,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, struct aout_filter *fil
         if (max == 0)
             goto overflow;
 
-        filter_t *f = TryFormat (obj, outfmt->i_format, &input);
+        filter_t *f = TryFormat (obj, owner, outfmt->i_format, &input);
         if (f == NULL)
         {
             msg_Err (obj, "cannot find %s for conversion pipeline",
@@ -296,16 +481,25 @@ error:
  * Filters an audio buffer through a chain of filters.
  */
 static block_t *aout_FiltersPipelinePlay(const struct aout_filter *tab,
-                                         unsigned count, block_t *block)
+                                         unsigned count, block_t *block,
+                                         struct aout_buffer_pool *pool)
 {
     /* TODO: use filter chain */
     for (unsigned i = 0; (i < count) && (block != NULL); i++)
     {
         filter_t *filter = tab[i].f;
+#ifndef NDEBUG
+        const block_t *in = block;
+#endif
 
         /* Please note that p_block->i_nb_samples & i_buffer
          * shall be set by the filter plug-in. */
         block = filter->ops->filter_audio (filter, block);
+        if (filter->b_inplace)
+        {
+            assert(block == in || block == NULL);
+            pool->inplace++;
+        }
     }
     return block;
 }
@@ -315,7 +509,8 @@ static block_t *aout_FiltersPipelinePlay(const struct aout_filter *tab,
  * Drain the chain of filters.
  */
 static block_t *aout_FiltersPipelineDrain(const struct aout_filter *tab,
-                                          unsigned count)
+                                          unsigned count,
+                                          struct aout_buffer_pool *pool)
 {
     block_t *chain = NULL;
 
@@ -330,7 +525,7 @@ static block_t *aout_FiltersPipelineDrain(const struct aout_filter *tab,
              * chain of filters  */
             if (i + 1 < count)
                 block = aout_FiltersPipelinePlay (&tab[i + 1],
-                                                  count - i - 1, block);
+                                                  count - i - 1, block, pool);
             if (block)
                 block_ChainAppend (&chain, block);
         }
@@ -369,6 +564,9 @@ struct aout_filters
     struct aout_filter resampler; /**< The resampler */
     int resampling; /**< Current resampling (Hz) */
     vlc_clock_t *clock_source;
+    struct aout_buffer_pool *pool; /**< Output buffers of the filters */
+    struct filter_owner_sys conv_owner_sys; /**< Owner of the converters */
+    filter_owner_t conv_owner;
 
     unsigned count; /**< Number of filters */
     struct aout_filter tab[AOUT_MAX_FILTERS]; /**< Configured user filters
@@ -402,13 +600,6 @@ static int VisualizationCallback (vlc_object_t *obj, const char *var,
     return VLC_SUCCESS;
 }
 
-struct filter_owner_sys
-{
-    vlc_clock_t *clock_source;
-    vlc_clock_t *clock;
-    vout_thread_t *vout;
-};
-
 vout_thread_t *aout_filter_GetVout(filter_t *filter, const video_format_t *fmt)
 {
     struct filter_owner_sys *owner_sys = filter->owner.sys;
@@ -460,37 +651,48 @@ static int AppendFilter(vlc_object_t *obj, const char *type, const char *name,
         return -1;
     }
 
-    struct filter_owner_sys owner_sys = {
-        .clock_source = filters->clock_source,
-        .clock = NULL,
-        .vout = NULL,
+    struct filter_owner_sys *owner_sys = malloc(sizeof (*owner_sys));
+    if (unlikely(owner_sys == NULL))
+        return -1;
+
+    owner_sys->clock_source = filters->clock_source;
+    owner_sys->clock = NULL;
+    owner_sys->vout = NULL;
+    owner_sys->pool = filters->pool;
+
+    const filter_owner_t owner = {
+        .audio = &aout_filter_audio_cbs,
+        .sys = owner_sys,
     };
-    const filter_owner_t owner = { .sys = &owner_sys };
     filter_t *filter = aout_filter_Create(obj, &owner, type, name,
                                           infmt, outfmt, cfg, false);
     if (filter == NULL)
     {
         msg_Err (obj, "cannot add user %s \"%s\" (skipped)", type, name);
+        free(owner_sys);
         return -1;
     }
 
     /* convert to the filter input format if necessary */
-    if (aout_FiltersPipelineCreate (obj, filters->tab, &filters->count,
-                                    max - 1, infmt, &filter->fmt_in.audio))
+    if (aout_FiltersPipelineCreate (obj, &filters->conv_owner, filters->tab,
+                                    &filters->count, max - 1, infmt,
+                                    &filter->fmt_in.audio))
     {
         msg_Err (filter, "cannot add user %s \"%s\" (skipped)", type, name);
         vlc_filter_Delete(filter);
-        if (owner_sys.vout != NULL)
-            vout_Close(owner_sys.vout);
-        if (owner_sys.clock != NULL)
-            vlc_clock_Delete(owner_sys.clock);
+        if (owner_sys->vout != NULL)
+            vout_Close(owner_sys->vout);
+        if (owner_sys->clock != NULL)
+            vlc_clock_Delete(owner_sys->clock);
+        free(owner_sys);
         return -1;
     }
 
     assert (filters->count < max);
     aout_filter_Init(&filters->tab[filters->count], filter);
-    filters->tab[filters->count].clock = owner_sys.clock;
-    filters->tab[filters->count].vout = owner_sys.vout;
+    filters->tab[filters->count].clock = owner_sys->clock;
+    filters->tab[filters->count].vout = owner_sys->vout;
+    filters->tab[filters->count].owner_sys = owner_sys;
     filters->count++;
     *infmt = filter->fmt_out.audio;
     return 0;
@@ -551,11 +753,26 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, vlc_clock_t *clock,
     if (unlikely(filters == NULL))
         return NULL;
 
+    filters->pool = aout_BufferPoolNew();
+    if (unlikely(filters->pool == NULL))
+    {
+        free(filters);
+        return NULL;
+    }
+
     filters->rate_filter = NULL;
     aout_filter_Init(&filters->resampler, NULL);
     filters->resampling = 0;
     filters->count = 0;
     filters->clock_source = clock;
+    filters->conv_owner_sys = (struct filter_owner_sys) {
+        .clock_source = NULL, .clock = NULL, .vout = NULL,
+        .pool = filters->pool,
+    };
+    filters->conv_owner = (filter_owner_t) {
+        .audio = &aout_filter_audio_cbs,
+        .sys = &filters->conv_owner_sys,
+    };
 
     /* Prepare format structure */
     aout_FormatPrint (obj, "input", infmt);
@@ -570,7 +787,8 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, vlc_clock_t *clock,
         if (!AOUT_FMTS_IDENTICAL(infmt, outfmt))
         {
             aout_FormatsPrint (obj, "pass-through:", infmt, outfmt);
-            filter_t *f = FindConverter(obj, infmt, outfmt);
+            filter_t *f = FindConverter(obj, &filters->conv_owner,
+                                        infmt, outfmt);
             if (f == NULL)
             {
                 msg_Err (obj, "cannot setup pass-through");
@@ -594,7 +812,8 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, vlc_clock_t *clock,
 
         /* convert to the output format (minus resampling) if necessary */
         output_format.i_rate = input_format.i_rate;
-        if (aout_FiltersPipelineCreate (obj, filters->tab, &filters->count,
+        if (aout_FiltersPipelineCreate (obj, &filters->conv_owner,
+                                        filters->tab, &filters->count,
                                   AOUT_MAX_FILTERS, &input_format, &output_format))
         {
             msg_Warn (obj, "cannot setup audio renderer pipeline");
@@ -617,7 +836,8 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, vlc_clock_t *clock,
         audio_sample_format_t input_phys_format = input_format;
         aout_SetWavePhysicalChannels(&input_phys_format);
 
-        filter_t *f = FindConverter (obj, &input_format, &input_phys_format);
+        filter_t *f = FindConverter (obj, &filters->conv_owner,
+                                     &input_format, &input_phys_format);
         if (f == NULL)
         {
             msg_Err (obj, "cannot find channel converter");
@@ -663,7 +883,8 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, vlc_clock_t *clock,
 
     /* convert to the output format (minus resampling) if necessary */
     output_format.i_rate = input_format.i_rate;
-    if (aout_FiltersPipelineCreate (obj, filters->tab, &filters->count,
+    if (aout_FiltersPipelineCreate (obj, &filters->conv_owner,
+                                    filters->tab, &filters->count,
                               AOUT_MAX_FILTERS, &input_format, &output_format))
     {
         msg_Err (obj, "cannot setup filtering pipeline");
@@ -674,8 +895,8 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, vlc_clock_t *clock,
     /* insert the resampler */
     output_format.i_rate = outfmt->i_rate;
     assert (AOUT_FMTS_IDENTICAL(&output_format, outfmt));
-    filters->resampler.f = FindResampler(obj, &input_format,
-                                         &output_format);
+    filters->resampler.f = FindResampler(obj, &filters->conv_owner,
+                                         &input_format, &output_format);
     if (filters->resampler.f == NULL && input_format.i_rate != outfmt->i_rate)
     {
         msg_Err (obj, "cannot setup a resampler");
@@ -689,6 +910,7 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, vlc_clock_t *clock,
 error:
     aout_FiltersPipelineDestroy (filters->tab, filters->count);
     var_DelCallback(obj, "visual", VisualizationCallback, NULL);
+    aout_BufferPoolRelease(obj, filters->pool);
     free (filters);
     return NULL;
 }
@@ -764,6 +986,7 @@ void aout_FiltersDelete (vlc_object_t *obj, aout_filters_t *filters)
         aout_FiltersPipelineDestroy(&filters->resampler, 1);
     aout_FiltersPipelineDestroy (filters->tab, filters->count);
     var_DelCallback(obj, "visual", VisualizationCallback, NULL);
+    aout_BufferPoolRelease(obj, filters->pool);
     free (filters);
 }
 
@@ -800,12 +1023,14 @@ block_t *aout_FiltersPlay(aout_filters_t *filters, block_t *block, float rate)
         rate_filter->fmt_in.audio.i_rate = lroundf(nominal_rate * rate);
     }
 
-    block = aout_FiltersPipelinePlay (filters->tab, filters->count, block);
+    block = aout_FiltersPipelinePlay (filters->tab, filters->count, block,
+                                      filters->pool);
     if (filters->resampler.f != NULL)
     {   /* NOTE: the resampler needs to run even if resampling is 0.
          * The decoder and output rates can still be different. */
         filters->resampler.f->fmt_in.audio.i_rate += filters->resampling;
-        block = aout_FiltersPipelinePlay (&filters->resampler, 1, block);
+        block = aout_FiltersPipelinePlay (&filters->resampler, 1, block,
+                                          filters->pool);
         filters->resampler.f->fmt_in.audio.i_rate -= filters->resampling;
     }
 
@@ -824,7 +1049,8 @@ drop:
 block_t *aout_FiltersDrain (aout_filters_t *filters)
 {
     /* Drain the filters pipeline */
-    block_t *block = aout_FiltersPipelineDrain (filters->tab, filters->count);
+    block_t *block = aout_FiltersPipelineDrain (filters->tab, filters->count,
+                                                filters->pool);
 
     if (filters->resampler.f != NULL)
     {
@@ -835,13 +1061,15 @@ block_t *aout_FiltersDrain (aout_filters_t *filters)
         if (block)
         {
             /* Resample the drained block from the filters pipeline */
-            block = aout_FiltersPipelinePlay (&filters->resampler, 1, block);
+            block = aout_FiltersPipelinePlay (&filters->resampler, 1, block,
+                                              filters->pool);
             if (block)
                 block_ChainAppend (&chain, block);
         }
 
         /* Drain the resampler filter */
-        block = aout_FiltersPipelineDrain (&filters->resampler, 1);
+        block = aout_FiltersPipelineDrain (&filters->resampler, 1,
+                                           filters->pool);
         if (block)
             block_ChainAppend (&chain, block);
 
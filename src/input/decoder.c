@@ -45,6 +45,7 @@
 #include <vlc_picture_pool.h>
 #include <vlc_tracer.h>
 #include <vlc_list.h>
+#include <vlc_membudget.h>
 
 #include "audio_output/aout_internal.h"
 #include "stream_output/stream_output.h"
@@ -53,6 +54,7 @@
 #include "decoder.h"
 #include "resource.h"
 #include "libvlc.h"
+#include "misc/spsc.h"
 
 #include "../video_output/vout_internal.h"
 
@@ -137,6 +139,27 @@ struct vlc_input_decoder_t
     es_format_t pktz_fmt_in;
     bool b_packetizer;
 
+    /* Optional decoding stage, fed with packetized frames by the
+     * DecoderThread */
+    struct
+    {
+        bool enabled;
+        vlc_thread_t thread;
+        vlc_mutex_t lock; /* Held while decoding a frame, or while the
+                             DecoderThread uses the decoder module */
+        vlc_cond_t idle;
+        vlc_cond_t resume; /* Waited with the fifo locked while paused */
+        bool locking; /* The DecoderThread waits for the decoding stage */
+        vlc_sem_t queued; /* Count of frames in the ring */
+        vlc_sem_t room; /* Count of free slots in the ring */
+        struct vlc_spsc ring;
+        atomic_uint pending; /* Frames queued or being decoded */
+        atomic_bool discard;
+        es_format_t fmt; /* Decoder input format, for the DecoderThread */
+        vlc_tick_t start;
+        vlc_tick_t busy; /* Time spent decoding, by the decoding stage */
+    } pipeline;
+
     /* Current format in use by the output */
     es_format_t    fmt;
     vlc_video_context *vctx;
@@ -148,6 +171,14 @@ struct vlc_input_decoder_t
 
     /* fifo */
     block_fifo_t *p_fifo;
+    /* Protected by the fifo lock */
+    size_t        fifo_budget; /* bytes reported to the memory budget */
+    bool          fifo_budget_waited; /* waited since the budget overflowed */
+    vlc_tick_t    fifo_ts_first; /* timestamp of the first queued frame
+                                    since the last discontinuity */
+    vlc_tick_t    fifo_ts_in;  /* timestamp of the last queued frame */
+    vlc_tick_t    fifo_ts_out; /* timestamp of the last dequeued frame */
+    vlc_tick_t    fifo_max_duration;
 
     /* Lock for communication with decoder thread */
     vlc_cond_t  wait_request;
@@ -250,6 +281,15 @@ struct vlc_input_decoder_t
 
 /* */
 #define DECODER_SPU_VOUT_WAIT_DURATION   VLC_TICK_FROM_MS(200)
+/* Hard limit of the fifo of live decoders, whatever its duration */
+#define DECODER_FIFO_MAX_BYTES           (400*1024*1024)
+/* Maximum time to wait for a decoder to make room, once each time the memory
+ * budget of the instance overflows */
+#define DECODER_FIFO_BUDGET_WAIT         VLC_TICK_FROM_MS(500)
+/* Larger timestamp gaps between queued frames are taken as discontinuities */
+#define DECODER_FIFO_MAX_GAP             VLC_TICK_FROM_SEC(5)
+/* Number of packetized frames queued towards the decoding stage */
+#define DECODER_PIPELINE_QUEUE_SIZE      16
 #define BLOCK_FLAG_CORE_PRIVATE_RELOADED (1 << BLOCK_FLAG_CORE_PRIVATE_SHIFT)
 
 #define decoder_Notify(decoder_priv, event, ...) \
@@ -630,6 +670,7 @@ static int ModuleThread_UpdateVideoFormat( decoder_t *p_dec, vlc_video_context *
     p_owner->vctx = vctx ? vlc_video_context_Hold(vctx) : NULL;
 
     // configure the new vout
+    unsigned pool_size = 0;
     vlc_fifo_Lock(p_owner->p_fifo);
     if ( p_owner->out_pool == NULL )
     {
@@ -656,14 +697,14 @@ static int ModuleThread_UpdateVideoFormat( decoder_t *p_dec, vlc_video_context *
             dpb_size = 2;
             break;
         }
+        pool_size = dpb_size + p_dec->i_extra_picture_buffers + 1;
         picture_pool_t *pool = picture_pool_NewFromFormat( &p_dec->fmt_out.video,
-                            dpb_size + p_dec->i_extra_picture_buffers + 1 );
+                                                           pool_size );
 
         if( pool == NULL)
         {
-            msg_Err(p_dec, "Failed to create a pool of %d %4.4s pictures",
-                           dpb_size + p_dec->i_extra_picture_buffers + 1,
-                           (char*)&p_dec->fmt_out.video.i_chroma);
+            msg_Err(p_dec, "Failed to create a pool of %u %4.4s pictures",
+                           pool_size, (char*)&p_dec->fmt_out.video.i_chroma);
             vlc_fifo_Unlock(p_owner->p_fifo);
             goto error;
         }
@@ -688,9 +729,22 @@ static int ModuleThread_UpdateVideoFormat( decoder_t *p_dec, vlc_video_context *
         assert(vout_state == INPUT_RESOURCE_VOUT_NOTCHANGED ||
                vout_state == INPUT_RESOURCE_VOUT_STARTED);
 
+        /* Render directly into the display pictures, if possible. No
+         * picture was taken from the pool allocated above yet. */
+        picture_pool_t *pool = NULL;
+        if (vout_state == INPUT_RESOURCE_VOUT_STARTED && pool_size > 0)
+            pool = vout_GetPool(p_vout, &p_dec->fmt_out.video, pool_size);
+
         vlc_fifo_Lock(p_owner->p_fifo);
         p_owner->vout_started = true;
 
+        if (pool != NULL)
+        {
+            msg_Dbg(p_dec, "rendering directly into display pictures");
+            picture_pool_Release(p_owner->out_pool);
+            p_owner->out_pool = pool;
+        }
+
         if (vout_state == INPUT_RESOURCE_VOUT_STARTED)
         {
             Decoder_UpdateOutState( p_owner );
@@ -1611,6 +1665,10 @@ static void ModuleThread_QueueSpu( decoder_t *p_dec, subpicture_t *p_spu )
 }
 
 static void DecoderThread_ProcessInput( vlc_input_decoder_t *p_owner, vlc_frame_t *frame );
+static void DecoderPipelineLock( vlc_input_decoder_t *p_owner );
+static void DecoderPipelineUnlock( vlc_input_decoder_t *p_owner );
+static void DecoderPipelineQueue( vlc_input_decoder_t *p_owner, vlc_frame_t *frame );
+
 static void DecoderThread_DecodeBlock( vlc_input_decoder_t *p_owner, vlc_frame_t *frame )
 {
     decoder_t *p_dec = &p_owner->dec;
@@ -1651,6 +1709,190 @@ static void DecoderThread_DecodeBlock( vlc_input_decoder_t *p_owner, vlc_frame_t
     }
 }
 
+/*
+ * Decoding stage
+ *
+ * When enabled, the DecoderThread only packetizes and hands the packetized
+ * frames over to a dedicated decoding thread through a lock-free ring, so that
+ * parsing the elementary stream does not delay decoding. Whenever the
+ * DecoderThread uses the decoder module itself (drain, reload, flush), it
+ * waits for the queued frames to be decoded (or discarded) first.
+ *
+ * Like the DecoderThread, the decoding stage holds its frames while paused,
+ * unless stepping frame by frame, or the DecoderThread waits for them.
+ */
+
+/* Must be called with the fifo locked */
+static bool DecoderPipelineIsPaused( vlc_input_decoder_t *p_owner )
+{
+    return p_owner->paused && p_owner->frames_countdown == 0
+        && !p_owner->error && !p_owner->pipeline.locking
+        && !atomic_load_explicit( &p_owner->pipeline.discard,
+                                  memory_order_relaxed );
+}
+
+/* Must be called with the fifo locked */
+static void DecoderPipelineSignal( vlc_input_decoder_t *p_owner )
+{
+    if( p_owner->pipeline.enabled )
+        vlc_cond_signal( &p_owner->pipeline.resume );
+}
+
+static void *DecoderPipelineThread( void *data )
+{
+    vlc_input_decoder_t *p_owner = data;
+
+    vlc_thread_set_name( "vlc-dec-stage" );
+
+    for( ;; )
+    {
+        void *item;
+
+        vlc_sem_wait( &p_owner->pipeline.queued );
+        bool popped = vlc_spsc_Pop( &p_owner->pipeline.ring, &item );
+        assert( popped ); (void) popped;
+        vlc_sem_post( &p_owner->pipeline.room );
+
+        vlc_frame_t *frame = item;
+        if( frame == NULL )
+            break; /* Terminating */
+
+        vlc_fifo_Lock( p_owner->p_fifo );
+        while( DecoderPipelineIsPaused( p_owner ) )
+            vlc_fifo_WaitCond( p_owner->p_fifo, &p_owner->pipeline.resume );
+        vlc_fifo_Unlock( p_owner->p_fifo );
+
+        vlc_mutex_lock( &p_owner->pipeline.lock );
+        vlc_fifo_Lock( p_owner->p_fifo );
+        if( p_owner->error
+         || atomic_load_explicit( &p_owner->pipeline.discard,
+                                  memory_order_relaxed ) )
+            block_Release( frame );
+        else
+        {
+            vlc_tick_t start = vlc_tick_now();
+            DecoderThread_DecodeBlock( p_owner, frame );
+            p_owner->pipeline.busy += vlc_tick_now() - start;
+        }
+
+        bool idle = atomic_fetch_sub_explicit( &p_owner->pipeline.pending, 1,
+                                               memory_order_release ) == 1;
+        if( idle ) /* for vlc_input_decoder_Wait() */
+            vlc_cond_signal( &p_owner->wait_acknowledge );
+        vlc_fifo_Unlock( p_owner->p_fifo );
+
+        if( idle )
+            vlc_cond_broadcast( &p_owner->pipeline.idle );
+        vlc_mutex_unlock( &p_owner->pipeline.lock );
+    }
+    return NULL;
+}
+
+static void DecoderPipelinePush( vlc_input_decoder_t *p_owner, vlc_frame_t *frame )
+{
+    /* Wait for room in the ring: this paces the packetizer */
+    vlc_sem_wait( &p_owner->pipeline.room );
+    bool pushed = vlc_spsc_Push( &p_owner->pipeline.ring, frame );
+    assert( pushed ); (void) pushed;
+    vlc_sem_post( &p_owner->pipeline.queued );
+}
+
+/* Must be called from the DecoderThread, with the fifo locked */
+static void DecoderPipelineQueue( vlc_input_decoder_t *p_owner, vlc_frame_t *frame )
+{
+    atomic_fetch_add_explicit( &p_owner->pipeline.pending, 1,
+                               memory_order_relaxed );
+
+    vlc_fifo_Unlock( p_owner->p_fifo );
+    DecoderPipelinePush( p_owner, frame );
+    vlc_fifo_Lock( p_owner->p_fifo );
+}
+
+/**
+ * Waits for all queued frames to be decoded and locks out the decoding stage.
+ *
+ * Must be called from the DecoderThread, with the fifo locked.
+ */
+static void DecoderPipelineLock( vlc_input_decoder_t *p_owner )
+{
+    /* The queued frames are decoded even if paused */
+    p_owner->pipeline.locking = true;
+    DecoderPipelineSignal( p_owner );
+
+    /* The decoding stage locks the fifo while holding its lock */
+    vlc_fifo_Unlock( p_owner->p_fifo );
+
+    vlc_mutex_lock( &p_owner->pipeline.lock );
+    while( atomic_load_explicit( &p_owner->pipeline.pending,
+                                 memory_order_acquire ) > 0 )
+        vlc_cond_wait( &p_owner->pipeline.idle, &p_owner->pipeline.lock );
+
+    vlc_fifo_Lock( p_owner->p_fifo );
+    p_owner->pipeline.locking = false;
+}
+
+static void DecoderPipelineUnlock( vlc_input_decoder_t *p_owner )
+{
+    vlc_mutex_unlock( &p_owner->pipeline.lock );
+}
+
+static bool DecoderPipelineIsEmpty( const vlc_input_decoder_t *p_owner )
+{
+    return !p_owner->pipeline.enabled
+        || atomic_load_explicit( &p_owner->pipeline.pending,
+                                 memory_order_acquire ) == 0;
+}
+
+static int DecoderPipelineStart( vlc_input_decoder_t *p_owner )
+{
+    if( vlc_spsc_Init( &p_owner->pipeline.ring, DECODER_PIPELINE_QUEUE_SIZE ) )
+        return VLC_ENOMEM;
+
+    vlc_mutex_init( &p_owner->pipeline.lock );
+    vlc_cond_init( &p_owner->pipeline.idle );
+    vlc_cond_init( &p_owner->pipeline.resume );
+    p_owner->pipeline.locking = false;
+    vlc_sem_init( &p_owner->pipeline.queued, 0 );
+    vlc_sem_init( &p_owner->pipeline.room, DECODER_PIPELINE_QUEUE_SIZE );
+    atomic_init( &p_owner->pipeline.pending, 0 );
+    atomic_init( &p_owner->pipeline.discard, false );
+    p_owner->pipeline.start = vlc_tick_now();
+    p_owner->pipeline.busy = 0;
+
+    if( es_format_Copy( &p_owner->pipeline.fmt, p_owner->dec.fmt_in ) )
+    {
+        vlc_spsc_Destroy( &p_owner->pipeline.ring );
+        return VLC_ENOMEM;
+    }
+
+    if( vlc_clone( &p_owner->pipeline.thread, DecoderPipelineThread, p_owner ) )
+    {
+        es_format_Clean( &p_owner->pipeline.fmt );
+        vlc_spsc_Destroy( &p_owner->pipeline.ring );
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static void DecoderPipelineStop( vlc_input_decoder_t *p_owner )
+{
+    /* Drop pending frames, then queue the termination marker */
+    atomic_store_explicit( &p_owner->pipeline.discard, true,
+                           memory_order_relaxed );
+    vlc_fifo_Lock( p_owner->p_fifo );
+    DecoderPipelineSignal( p_owner );
+    vlc_fifo_Unlock( p_owner->p_fifo );
+    DecoderPipelinePush( p_owner, NULL );
+    vlc_join( p_owner->pipeline.thread, NULL );
+    vlc_spsc_Destroy( &p_owner->pipeline.ring );
+    es_format_Clean( &p_owner->pipeline.fmt );
+
+    vlc_tick_t elapsed = vlc_tick_now() - p_owner->pipeline.start;
+    if( elapsed > 0 )
+        msg_Dbg( &p_owner->dec, "decoding stage busy %.1f%% of the time",
+                 100. * p_owner->pipeline.busy / elapsed );
+}
+
 /**
  * Decode a frame
  *
@@ -1664,6 +1906,12 @@ static void DecoderThread_ProcessInput( vlc_input_decoder_t *p_owner, vlc_frame_
     if( p_owner->error )
         goto error;
 
+    /* Frames reinjected by DecoderThread_DecodeBlock() have already been
+     * packetized, and come from the decoding stage, locked out already */
+    const bool reloaded = frame != NULL &&
+        unlikely( frame->i_flags & BLOCK_FLAG_CORE_PRIVATE_RELOADED );
+    const bool pipelined = p_owner->pipeline.enabled && !reloaded;
+
     /* Here, the atomic doesn't prevent to miss a reload request.
      * DecoderThread_ProcessInput() can still be called after the decoder module or the
      * audio output requested a reload. This will only result in a drop of an
@@ -1674,22 +1922,22 @@ static void DecoderThread_ProcessInput( vlc_input_decoder_t *p_owner, vlc_frame_
         msg_Warn( p_dec, "Reloading the decoder module%s",
                   reload == RELOAD_DECODER_AOUT ? " and the audio output" : "" );
 
-        if( DecoderThread_Reload( p_owner, p_dec->fmt_in, reload ) != VLC_SUCCESS )
+        if( pipelined )
+            DecoderPipelineLock( p_owner );
+        int ret = DecoderThread_Reload( p_owner, p_dec->fmt_in, reload );
+        if( pipelined )
+            DecoderPipelineUnlock( p_owner );
+        if( ret != VLC_SUCCESS )
             goto error;
     }
 
-    bool packetize = p_owner->p_packetizer != NULL;
+    bool packetize = p_owner->p_packetizer != NULL && !reloaded;
     if( frame )
     {
         if( frame->i_buffer <= 0 )
             goto error;
 
         DecoderUpdatePreroll( &p_owner->i_preroll_end, frame );
-        if( unlikely( frame->i_flags & BLOCK_FLAG_CORE_PRIVATE_RELOADED ) )
-        {
-            /* This frame has already been packetized */
-            packetize = false;
-        }
     }
 
     if( p_owner->p_sout != NULL )
@@ -1708,7 +1956,11 @@ static void DecoderThread_ProcessInput( vlc_input_decoder_t *p_owner, vlc_frame_
         while( (packetized_frame =
                 p_packetizer->pf_packetize( p_packetizer, ppframe ) ) )
         {
-            if( !es_format_IsSimilar( p_dec->fmt_in, &p_packetizer->fmt_out ) )
+            /* The decoding stage may reload the decoder concurrently, but
+             * then keeps its input format */
+            const es_format_t *dec_fmt_in = pipelined ? &p_owner->pipeline.fmt
+                                                      : p_dec->fmt_in;
+            if( !es_format_IsSimilar( dec_fmt_in, &p_packetizer->fmt_out ) )
             {
                 msg_Dbg( p_dec, "restarting module due to input format change");
                 es_format_LogDifferences( vlc_object_logger(p_dec),
@@ -1716,10 +1968,24 @@ static void DecoderThread_ProcessInput( vlc_input_decoder_t *p_owner, vlc_frame_
                                           "packetizer out", &p_packetizer->fmt_out );
 
                 /* Drain the decoder module */
+                if( pipelined )
+                    DecoderPipelineLock( p_owner );
                 DecoderThread_DecodeBlock( p_owner, NULL );
 
-                if( DecoderThread_Reload( p_owner, &p_packetizer->fmt_out,
-                                          RELOAD_DECODER ) != VLC_SUCCESS )
+                int ret = DecoderThread_Reload( p_owner, &p_packetizer->fmt_out,
+                                                RELOAD_DECODER );
+                if( pipelined )
+                {
+                    es_format_Clean( &p_owner->pipeline.fmt );
+                    if( es_format_Copy( &p_owner->pipeline.fmt,
+                                        &p_owner->dec_fmt_in ) != VLC_SUCCESS )
+                    {   /* It would not match the decoder input anymore */
+                        p_owner->error = true;
+                        ret = VLC_ENOMEM;
+                    }
+                    DecoderPipelineUnlock( p_owner );
+                }
+                if( ret != VLC_SUCCESS )
                 {
                     block_ChainRelease( packetized_frame );
                     return;
@@ -1734,7 +2000,10 @@ static void DecoderThread_ProcessInput( vlc_input_decoder_t *p_owner, vlc_frame_
                 vlc_frame_t *p_next = packetized_frame->p_next;
                 packetized_frame->p_next = NULL;
 
-                DecoderThread_DecodeBlock( p_owner, packetized_frame );
+                if( pipelined )
+                    DecoderPipelineQueue( p_owner, packetized_frame );
+                else
+                    DecoderThread_DecodeBlock( p_owner, packetized_frame );
 
                 if( p_owner->error )
                 {
@@ -1747,10 +2016,22 @@ static void DecoderThread_ProcessInput( vlc_input_decoder_t *p_owner, vlc_frame_
         }
         /* Drain the decoder after the packetizer is drained */
         if( !ppframe )
+        {
+            if( pipelined )
+                DecoderPipelineLock( p_owner );
             DecoderThread_DecodeBlock( p_owner, NULL );
+            if( pipelined )
+                DecoderPipelineUnlock( p_owner );
+        }
     }
     else
+    {
+        if( pipelined )
+            DecoderPipelineLock( p_owner );
         DecoderThread_DecodeBlock( p_owner, frame );
+        if( pipelined )
+            DecoderPipelineUnlock( p_owner );
+    }
     return;
 
 error:
@@ -1769,8 +2050,22 @@ static void DecoderThread_Flush( vlc_input_decoder_t *p_owner )
     if( p_packetizer != NULL && p_packetizer->pf_flush != NULL )
         p_packetizer->pf_flush( p_packetizer );
 
+    if( p_owner->pipeline.enabled )
+    {   /* Discard the frames queued before the flush */
+        atomic_store_explicit( &p_owner->pipeline.discard, true,
+                               memory_order_relaxed );
+        vlc_fifo_Lock( p_owner->p_fifo );
+        DecoderPipelineLock( p_owner );
+        vlc_fifo_Unlock( p_owner->p_fifo );
+        atomic_store_explicit( &p_owner->pipeline.discard, false,
+                               memory_order_relaxed );
+    }
+
     if ( p_dec->pf_flush != NULL )
         p_dec->pf_flush( p_dec );
+
+    if( p_owner->pipeline.enabled )
+        DecoderPipelineUnlock( p_owner );
 }
 
 /**
@@ -1778,6 +2073,44 @@ static void DecoderThread_Flush( vlc_input_decoder_t *p_owner )
  *
  * \param p_data the input decoder object
  */
+static vlc_tick_t DecoderFifoTimestamp( const vlc_frame_t *frame )
+{
+    return frame->i_dts != VLC_TICK_INVALID ? frame->i_dts : frame->i_pts;
+}
+
+/* Must be called with the fifo locked, after its content changed */
+static void DecoderFifoUpdate( vlc_input_decoder_t *p_owner )
+{
+    size_t bytes = vlc_fifo_GetBytes( p_owner->p_fifo );
+
+    if( bytes > p_owner->fifo_budget )
+        vlc_membudget_Add( &p_owner->dec, VLC_MEMBUDGET_DECODER,
+                           bytes - p_owner->fifo_budget );
+    else
+        vlc_membudget_Remove( &p_owner->dec, VLC_MEMBUDGET_DECODER,
+                              p_owner->fifo_budget - bytes );
+    p_owner->fifo_budget = bytes;
+
+    if( vlc_fifo_IsEmpty( p_owner->p_fifo ) )
+        p_owner->fifo_ts_first = p_owner->fifo_ts_in =
+        p_owner->fifo_ts_out = VLC_TICK_INVALID;
+}
+
+/* Duration of the data waiting in the fifo, 0 if unknown.
+ * Only the data queued since the last discontinuity is counted: timestamps
+ * on both sides of a jump cannot be compared. */
+static vlc_tick_t DecoderFifoDuration( const vlc_input_decoder_t *p_owner )
+{
+    vlc_tick_t start = p_owner->fifo_ts_first;
+
+    if( p_owner->fifo_ts_out != VLC_TICK_INVALID
+     && p_owner->fifo_ts_out > start )
+        start = p_owner->fifo_ts_out;
+    if( start == VLC_TICK_INVALID || p_owner->fifo_ts_in <= start )
+        return 0;
+    return p_owner->fifo_ts_in - start;
+}
+
 static void *DecoderThread( void *p_data )
 {
     vlc_input_decoder_t *p_owner = (vlc_input_decoder_t *)p_data;
@@ -1847,7 +2180,14 @@ static void *DecoderThread( void *p_data )
         vlc_cond_signal( &p_owner->wait_fifo );
 
         vlc_frame_t *frame = vlc_fifo_DequeueUnlocked( p_owner->p_fifo );
-        if( frame == NULL )
+        if( frame != NULL )
+        {
+            vlc_tick_t ts = DecoderFifoTimestamp( frame );
+            if( ts != VLC_TICK_INVALID )
+                p_owner->fifo_ts_out = ts;
+            DecoderFifoUpdate( p_owner );
+        }
+        else
         {
             if( likely(!p_owner->b_draining) )
             {   /* Wait for a block to decode (or a request to drain) */
@@ -1962,6 +2302,7 @@ CreateDecoder( vlc_object_t *p_parent, const struct vlc_input_decoder_cfg *cfg )
     p_owner->p_sout = cfg->sout;
     p_owner->p_sout_input = NULL;
     p_owner->p_packetizer = NULL;
+    p_owner->pipeline.enabled = false;
 
     p_owner->b_fmt_description = false;
     p_owner->p_description = NULL;
@@ -1995,6 +2336,12 @@ CreateDecoder( vlc_object_t *p_parent, const struct vlc_input_decoder_cfg *cfg )
         vlc_object_delete(p_dec);
         return NULL;
     }
+    p_owner->fifo_budget = 0;
+    p_owner->fifo_budget_waited = false;
+    p_owner->fifo_ts_first = p_owner->fifo_ts_in =
+    p_owner->fifo_ts_out = VLC_TICK_INVALID;
+    p_owner->fifo_max_duration =
+        VLC_TICK_FROM_MS( var_InheritInteger( p_dec, "decoder-fifo-duration" ) );
 
     vlc_mutex_init( &p_owner->mouse_lock );
     vlc_cond_init( &p_owner->wait_request );
@@ -2108,6 +2455,7 @@ static void DeleteDecoder( vlc_input_decoder_t *p_owner, enum es_format_category
 
     /* Free all packets still in the decoder fifo. */
     block_FifoEmpty( p_owner->p_fifo );
+    vlc_membudget_Remove( p_dec, VLC_MEMBUDGET_DECODER, p_owner->fifo_budget );
 
     /* Cleanup */
     if( p_owner->p_sout_input )
@@ -2240,10 +2588,21 @@ decoder_New( vlc_object_t *p_parent, const struct vlc_input_decoder_cfg *cfg )
 
     if( !vlc_input_decoder_IsSynchronous( p_owner ) )
     {
+        /* Decode on a separate thread from the packetizer, if requested */
+        if( p_owner->p_packetizer != NULL && p_owner->p_sout == NULL
+         && var_InheritBool( p_dec, "decoder-pipeline" ) )
+        {
+            p_owner->pipeline.enabled = DecoderPipelineStart( p_owner ) == VLC_SUCCESS;
+            if( !p_owner->pipeline.enabled )
+                msg_Warn( p_dec, "cannot start the decoding stage" );
+        }
+
         /* Spawn the decoder thread in asynchronous scenario. */
         if( vlc_clone( &p_owner->thread, DecoderThread, p_owner ) )
         {
             msg_Err( p_dec, "cannot spawn decoder thread" );
+            if( p_owner->pipeline.enabled )
+                DecoderPipelineStop( p_owner );
             DeleteDecoder( p_owner, p_dec->fmt_in->i_cat );
             return NULL;
         }
@@ -2317,6 +2676,9 @@ void vlc_input_decoder_Delete( vlc_input_decoder_t *p_owner )
     if( !vlc_input_decoder_IsSynchronous( p_owner ) )
         vlc_join( p_owner->thread, NULL );
 
+    if( p_owner->pipeline.enabled )
+        DecoderPipelineStop( p_owner );
+
 #ifndef NDEBUG
     vlc_mutex_lock(&p_owner->subdecs.lock);
     assert(vlc_list_is_empty(&p_owner->subdecs.list));
@@ -2436,14 +2798,47 @@ void vlc_input_decoder_DecodeWithStatus(vlc_input_decoder_t *p_owner, vlc_frame_
     vlc_fifo_Lock( p_owner->p_fifo );
     if( !b_do_pace )
     {
-        /* FIXME: ideally we would check the time amount of data
-         * in the FIFO instead of its size. */
-        /* 400 MiB, i.e. ~ 50mb/s for 60s */
-        if( vlc_fifo_GetBytes( p_owner->p_fifo ) > 400*1024*1024 )
+        bool b_stalled = false;
+
+        /* The instance buffers too much: give the decoder some time to catch
+         * up rather than growing its fifo further. Only this thread feeds
+         * the fifo, so it can only shrink while waiting. This is done once
+         * per overflow, not for every frame queued until it is over. */
+        if( !vlc_membudget_IsExceeded( &p_owner->dec ) )
+            p_owner->fifo_budget_waited = false;
+        else if( !p_owner->fifo_budget_waited
+              && !p_owner->b_waiting && !p_owner->paused )
+        {
+            p_owner->fifo_budget_waited = true;
+            const size_t i_count = vlc_fifo_GetCount( p_owner->p_fifo );
+            const vlc_tick_t deadline = vlc_tick_now() + DECODER_FIFO_BUDGET_WAIT;
+
+            while( !vlc_fifo_IsEmpty( p_owner->p_fifo )
+                && vlc_membudget_IsExceeded( &p_owner->dec ) )
+            {
+                if( vlc_cond_timedwait( &p_owner->wait_fifo,
+                                        &vlc_fifo_queue( p_owner->p_fifo )->lock,
+                                        deadline ) )
+                {
+                    b_stalled = vlc_fifo_GetCount( p_owner->p_fifo ) >= i_count;
+                    break;
+                }
+            }
+        }
+
+        const size_t i_bytes = vlc_fifo_GetBytes( p_owner->p_fifo );
+        const vlc_tick_t i_duration = DecoderFifoDuration( p_owner );
+
+        if( b_stalled || i_bytes > DECODER_FIFO_MAX_BYTES
+         || i_duration > p_owner->fifo_max_duration )
         {
             msg_Warn( &p_owner->dec, "decoder/packetizer fifo full (data not "
-                      "consumed quickly enough), resetting fifo!" );
+                      "consumed quickly enough, %zu KiB for %"PRId64" ms%s), "
+                      "resetting fifo!", i_bytes / 1024,
+                      MS_FROM_VLC_TICK( i_duration ),
+                      b_stalled ? ", decoder stalled" : "" );
             block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
+            DecoderFifoUpdate( p_owner );
             frame->i_flags |= BLOCK_FLAG_DISCONTINUITY;
         }
     }
@@ -2456,7 +2851,22 @@ void vlc_input_decoder_DecodeWithStatus(vlc_input_decoder_t *p_owner, vlc_frame_
             vlc_fifo_WaitCond( p_owner->p_fifo, &p_owner->wait_fifo );
     }
 
+    vlc_tick_t ts = DecoderFifoTimestamp( frame );
+    if( ts != VLC_TICK_INVALID )
+    {
+        /* Restart the span on discontinuities, flagged or not (e.g. PCR
+         * jumps of live streams), rather than counting the jump as data */
+        if( p_owner->fifo_ts_first == VLC_TICK_INVALID
+         || p_owner->fifo_ts_in == VLC_TICK_INVALID
+         || ( frame->i_flags & BLOCK_FLAG_DISCONTINUITY )
+         || ts < p_owner->fifo_ts_in - DECODER_FIFO_MAX_GAP
+         || ts > p_owner->fifo_ts_in + DECODER_FIFO_MAX_GAP )
+            p_owner->fifo_ts_first = ts;
+        p_owner->fifo_ts_in = ts;
+    }
+
     vlc_fifo_QueueUnlocked( p_owner->p_fifo, frame );
+    DecoderFifoUpdate( p_owner );
     if (status != NULL)
         GetStatusLocked(p_owner, status);
     vlc_fifo_Unlock( p_owner->p_fifo );
@@ -2473,7 +2883,8 @@ bool vlc_input_decoder_IsEmpty( vlc_input_decoder_t * p_owner )
     assert( !p_owner->b_waiting );
 
     vlc_fifo_Lock( p_owner->p_fifo );
-    if( !vlc_fifo_IsEmpty( p_owner->p_fifo ) || p_owner->b_draining )
+    if( !vlc_fifo_IsEmpty( p_owner->p_fifo ) || p_owner->b_draining
+     || !DecoderPipelineIsEmpty( p_owner ) )
     {
         vlc_fifo_Unlock( p_owner->p_fifo );
         return false;
@@ -2518,6 +2929,7 @@ void vlc_input_decoder_Flush( vlc_input_decoder_t *p_owner )
 
     /* Empty the fifo */
     block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
+    DecoderFifoUpdate( p_owner );
 
     /* Don't need to wait for the DecoderThread to flush. Indeed, if called a
      * second time, this function will clear the FIFO again before anything was
@@ -2628,6 +3040,7 @@ void vlc_input_decoder_ChangePause( vlc_input_decoder_t *p_owner,
     p_owner->pause_date = i_date;
     p_owner->frames_countdown = 0;
     vlc_fifo_Signal( p_owner->p_fifo );
+    DecoderPipelineSignal( p_owner );
     vlc_fifo_Unlock( p_owner->p_fifo );
 }
 
@@ -2691,7 +3104,8 @@ void vlc_input_decoder_Wait( vlc_input_decoder_t *p_owner )
          * owner */
         if( p_owner->paused )
             break;
-        if( p_owner->b_idle && vlc_fifo_IsEmpty( p_owner->p_fifo ) )
+        if( p_owner->b_idle && vlc_fifo_IsEmpty( p_owner->p_fifo )
+         && DecoderPipelineIsEmpty( p_owner ) )
         {
             msg_Err( &p_owner->dec, "buffer deadlock prevented" );
             break;
@@ -2708,6 +3122,7 @@ void vlc_input_decoder_FrameNext( vlc_input_decoder_t *p_owner )
     vlc_fifo_Lock( p_owner->p_fifo );
     p_owner->frames_countdown++;
     vlc_fifo_Signal( p_owner->p_fifo );
+    DecoderPipelineSignal( p_owner );
     vlc_fifo_Unlock( p_owner->p_fifo );
 
     vlc_fifo_Lock(p_owner->p_fifo);
@@ -57,6 +57,7 @@
 #include <vlc_stream_extractor.h>
 #include <vlc_renderer_discovery.h>
 #include <vlc_hash.h>
+#include <vlc_membudget.h>
 
 /*****************************************************************************
  * Local prototypes
@@ -619,6 +620,13 @@ static void MainLoopStatistics( input_thread_t *p_input )
         struct input_stats_t new_stats;
         input_stats_Compute(priv->stats, &new_stats);
 
+        new_stats.i_buffered_demux =
+            vlc_membudget_GetUsage(p_input, VLC_MEMBUDGET_DEMUX);
+        new_stats.i_buffered_decoder =
+            vlc_membudget_GetUsage(p_input, VLC_MEMBUDGET_DECODER);
+        new_stats.i_buffered_sout =
+            vlc_membudget_GetUsage(p_input, VLC_MEMBUDGET_SOUT);
+
         vlc_mutex_lock(&priv->p_item->lock);
         *priv->p_item->p_stats = new_stats;
         vlc_mutex_unlock(&priv->p_item->lock);
@@ -0,0 +1,126 @@
+/*****************************************************************************
+ * membudget.c: accounting of buffered media data
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_membudget.h>
+#include "../libvlc.h"
+
+struct vlc_membudget
+{
+    size_t limit; /* in bytes, 0 if unlimited */
+    atomic_size_t usage[VLC_MEMBUDGET_SOURCE_COUNT];
+    atomic_size_t total;
+};
+
+struct vlc_membudget *vlc_membudget_New(libvlc_int_t *libvlc)
+{
+    struct vlc_membudget *budget = malloc(sizeof (*budget));
+    if (unlikely(budget == NULL))
+        return NULL;
+
+    int64_t limit = var_InheritInteger(libvlc, "input-memory-budget");
+    budget->limit = limit > 0 ? (size_t)limit << 20 : 0;
+
+    for (size_t i = 0; i < ARRAY_SIZE(budget->usage); i++)
+        atomic_init(&budget->usage[i], 0);
+    atomic_init(&budget->total, 0);
+
+    if (budget->limit != 0)
+        msg_Dbg(libvlc, "buffered media data limited to %zu MiB",
+                budget->limit >> 20);
+    return budget;
+}
+
+void vlc_membudget_Delete(struct vlc_membudget *budget)
+{
+    /* Every buffer must have been reported as released */
+    for (size_t i = 0; i < ARRAY_SIZE(budget->usage); i++)
+        assert(atomic_load_explicit(&budget->usage[i],
+                                    memory_order_relaxed) == 0);
+    free(budget);
+}
+
+static struct vlc_membudget *vlc_membudget_Get(vlc_object_t *obj)
+{
+    return libvlc_priv(vlc_object_instance(obj))->membudget;
+}
+
+#undef vlc_membudget_Add
+void vlc_membudget_Add(vlc_object_t *obj, enum vlc_membudget_source source,
+                       size_t bytes)
+{
+    struct vlc_membudget *budget = vlc_membudget_Get(obj);
+
+    assert(source < VLC_MEMBUDGET_SOURCE_COUNT);
+    if (budget == NULL || bytes == 0)
+        return;
+
+    atomic_fetch_add_explicit(&budget->usage[source], bytes,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&budget->total, bytes, memory_order_relaxed);
+}
+
+#undef vlc_membudget_Remove
+void vlc_membudget_Remove(vlc_object_t *obj, enum vlc_membudget_source source,
+                          size_t bytes)
+{
+    struct vlc_membudget *budget = vlc_membudget_Get(obj);
+
+    assert(source < VLC_MEMBUDGET_SOURCE_COUNT);
+    if (budget == NULL || bytes == 0)
+        return;
+
+    size_t prev = atomic_fetch_sub_explicit(&budget->usage[source], bytes,
+                                            memory_order_relaxed);
+    assert(prev >= bytes);
+    (void) prev;
+    atomic_fetch_sub_explicit(&budget->total, bytes, memory_order_relaxed);
+}
+
+#undef vlc_membudget_GetUsage
+size_t vlc_membudget_GetUsage(vlc_object_t *obj,
+                              enum vlc_membudget_source source)
+{
+    struct vlc_membudget *budget = vlc_membudget_Get(obj);
+
+    assert(source < VLC_MEMBUDGET_SOURCE_COUNT);
+    if (budget == NULL)
+        return 0;
+    return atomic_load_explicit(&budget->usage[source], memory_order_relaxed);
+}
+
+#undef vlc_membudget_IsExceeded
+bool vlc_membudget_IsExceeded(vlc_object_t *obj)
+{
+    struct vlc_membudget *budget = vlc_membudget_Get(obj);
+
+    if (budget == NULL || budget->limit == 0)
+        return false;
+    return atomic_load_explicit(&budget->total, memory_order_relaxed)
+           > budget->limit;
+}
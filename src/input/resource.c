@@ -639,6 +639,23 @@ void input_resource_PutSout(input_resource_t *resource, sout_stream_t *sout)
     vlc_mutex_unlock(&resource->lock);
 }
 
+void input_resource_SetSout( input_resource_t *p_resource, sout_stream_t *sout,
+                             const char *psz_sout )
+{
+    char *psz_dup = strdup( psz_sout );
+
+    vlc_mutex_lock( &p_resource->lock );
+    DestroySout( p_resource );
+    if( likely(psz_dup != NULL) )
+    {
+        p_resource->p_sout = sout;
+        p_resource->psz_sout = psz_dup;
+    }
+    else
+        sout_StreamChainDelete( sout, NULL );
+    vlc_mutex_unlock( &p_resource->lock );
+}
+
 void input_resource_TerminateSout( input_resource_t *p_resource )
 {
     vlc_mutex_lock( &p_resource->lock );
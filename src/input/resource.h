@@ -61,6 +61,13 @@ void input_resource_PutAout( input_resource_t *, audio_output_t * );
 sout_stream_t *input_resource_RequestSout( input_resource_t *, const char * );
 void input_resource_PutSout(input_resource_t *, sout_stream_t *);
 
+/**
+ * This function provides the sout to use for the given chain description,
+ * instead of creating one. The resource owns it afterwards.
+ */
+void input_resource_SetSout( input_resource_t *, sout_stream_t *,
+                             const char *psz_sout );
+
 vout_thread_t *input_resource_RequestVout(input_resource_t *, vlc_video_context *,
                                          const vout_configuration_t *,
                                          enum vlc_vout_order *order,
@@ -49,12 +49,14 @@
 #include <vlc_url.h>
 #include "../misc/threads.h"
 #include "../libvlc.h"
+#include "../stream_output/stream_output.h"
 
 /*****************************************************************************
  * Local prototypes.
  *****************************************************************************/
 
 static void* Manage( void * );
+static bool vlm_MediaInstanceIsFinished( vlm_media_instance_sys_t * );
 
 static void player_on_state_changed(vlc_player_t *player,
                                     enum vlc_player_state new_state, void *data)
@@ -152,6 +154,8 @@ vlm_t *vlm_New( libvlc_int_t *libvlc, const char *psz_vlmconf )
     p_vlm->i_id = 1;
     TAB_INIT( p_vlm->i_media, p_vlm->media );
     TAB_INIT( p_vlm->i_schedule, p_vlm->schedule );
+    p_vlm->b_share_inputs = var_InheritBool( p_vlm, "vlm-share-inputs" );
+    TAB_INIT( p_vlm->i_source, p_vlm->source );
     var_Create( p_vlm, "intf-event", VLC_VAR_ADDRESS );
 
     if( vlc_clone( &p_vlm->thread, Manage, p_vlm ) )
@@ -213,6 +217,10 @@ void vlm_Delete( vlm_t *p_vlm )
 
     vlm_ControlInternal( p_vlm, VLM_CLEAR_SCHEDULES );
     TAB_CLEAN( p_vlm->i_schedule, p_vlm->schedule );
+
+    /* The sources went away with their last instance */
+    assert( p_vlm->i_source == 0 );
+    TAB_CLEAN( p_vlm->i_source, p_vlm->source );
     vlc_mutex_unlock( &p_vlm->lock );
 
     vlc_mutex_lock( &p_vlm->lock_manage );
@@ -270,7 +278,7 @@ static void* Manage( void* p_object )
             {
                 vlm_media_instance_sys_t *p_instance = p_media->instance[j];
 
-                if (p_instance->finished)
+                if( vlm_MediaInstanceIsFinished( p_instance ) )
                 {
                     int i_new_input_index;
 
@@ -591,6 +599,10 @@ static vlm_media_instance_sys_t *vlm_MediaInstanceNew( vlm_media_sys_t *p_media,
 
     p_instance->i_index = 0;
 
+    /* Fed by a shared source once started */
+    if( p_media->vlm->b_share_inputs )
+        return p_instance;
+
     p_instance->player = vlc_player_New(VLC_OBJECT(p_media->vlm),
                                         VLC_PLAYER_LOCK_NORMAL);
     if (!p_instance->player)
@@ -617,16 +629,33 @@ error:
     free(p_instance);
     return NULL;
 }
+static void vlm_MediaInstanceDetach( vlm_t *p_vlm, vlm_media_instance_sys_t *p_instance )
+{
+    vlm_SourceDetach( p_vlm, p_instance->source, p_instance->sout );
+    sout_StreamChainDelete( p_instance->sout, NULL );
+    p_instance->source = NULL;
+    p_instance->sout = NULL;
+}
 static void vlm_MediaInstanceDelete( vlm_t *p_vlm, int64_t id, vlm_media_instance_sys_t *p_instance, vlm_media_sys_t *p_media )
 {
     vlc_player_t *player = p_instance->player;
+    bool had_media;
 
-    vlc_player_Lock(player);
-    vlc_player_RemoveListener(player, p_instance->listener);
-    vlc_player_Stop(player);
-    bool had_media = vlc_player_GetCurrentMedia(player);
-    vlc_player_Unlock(player);
-    vlc_player_Delete(player);
+    if( player == NULL )
+    {
+        had_media = p_instance->source != NULL;
+        if( had_media )
+            vlm_MediaInstanceDetach( p_vlm, p_instance );
+    }
+    else
+    {
+        vlc_player_Lock(player);
+        vlc_player_RemoveListener(player, p_instance->listener);
+        vlc_player_Stop(player);
+        had_media = vlc_player_GetCurrentMedia(player);
+        vlc_player_Unlock(player);
+        vlc_player_Delete(player);
+    }
 
     if (had_media)
         vlm_SendEventMediaInstanceStopped( p_vlm, id, p_media->cfg.psz_name );
@@ -638,6 +667,63 @@ static void vlm_MediaInstanceDelete( vlm_t *p_vlm, int64_t id, vlm_media_instanc
 }
 
 
+static bool vlm_MediaInstanceIsFinished( vlm_media_instance_sys_t *p_instance )
+{
+    if( p_instance->source != NULL )
+        return vlm_SourceIsFinished( p_instance->source );
+    return p_instance->finished;
+}
+
+static int vlm_MediaInstanceStartShared( vlm_t *p_vlm, vlm_media_sys_t *p_media,
+                                         vlm_media_instance_sys_t *p_instance,
+                                         int i_input_index )
+{
+    vlm_media_t *p_cfg = &p_media->cfg;
+
+    /* Stop old instance */
+    if( p_instance->source != NULL )
+    {
+        if( p_instance->i_index == i_input_index &&
+            !vlm_SourceIsFinished( p_instance->source ) )
+            return VLC_SUCCESS;
+
+        vlm_MediaInstanceDetach( p_vlm, p_instance );
+        vlm_SendEventMediaInstanceStopped( p_vlm, p_cfg->id, p_cfg->psz_name );
+    }
+
+    /* Start new one */
+    p_instance->i_index = i_input_index;
+    const char *psz_input = p_cfg->ppsz_input[i_input_index];
+    char *psz_uri = strstr( psz_input, "://" ) == NULL
+                  ? vlc_path2uri( psz_input, NULL ) : strdup( psz_input );
+    if( psz_uri == NULL )
+        return VLC_ENOMEM;
+
+    /* Without output, the media is displayed as by the player */
+    p_instance->sout = sout_NewInstance( p_vlm,
+                            p_cfg->psz_output ? p_cfg->psz_output : "#display" );
+    if( p_instance->sout == NULL )
+    {
+        free( psz_uri );
+        return VLC_EGENERIC;
+    }
+
+    p_instance->source = vlm_SourceAttach( p_vlm, psz_uri, p_cfg->i_option,
+                                           p_cfg->ppsz_option, p_instance->sout );
+    free( psz_uri );
+    if( p_instance->source == NULL )
+    {
+        sout_StreamChainDelete( p_instance->sout, NULL );
+        p_instance->sout = NULL;
+        return VLC_EGENERIC;
+    }
+    p_instance->finished = false;
+
+    vlm_SendEventMediaInstanceStarted( p_vlm, p_cfg->id, p_cfg->psz_name );
+
+    return VLC_SUCCESS;
+}
+
 static int vlm_ControlMediaInstanceStart( vlm_t *p_vlm, int64_t id, const char *psz_id, int i_input_index )
 {
     vlm_media_sys_t *p_media = vlm_ControlMediaGetById( p_vlm, id );
@@ -673,6 +759,10 @@ static int vlm_ControlMediaInstanceStart( vlm_t *p_vlm, int64_t id, const char *
         TAB_APPEND( p_media->i_instance, p_media->instance, p_instance );
     }
 
+    if( p_instance->player == NULL )
+        return vlm_MediaInstanceStartShared( p_vlm, p_media, p_instance,
+                                             i_input_index );
+
     /* Stop old instance */
     vlc_player_t *player = p_instance->player;
     vlc_player_Lock(player);
@@ -740,6 +830,10 @@ static int vlm_ControlMediaInstancePause( vlm_t *p_vlm, int64_t id, const char *
     if( !p_instance )
         return VLC_EGENERIC;
 
+    /* A shared input would pause the other instances too */
+    if( p_instance->player == NULL )
+        return VLC_EGENERIC;
+
     vlc_player_Lock(p_instance->player);
     vlc_player_TogglePause(p_instance->player);
     vlc_player_Unlock(p_instance->player);
@@ -758,6 +852,19 @@ static int vlm_ControlMediaInstanceGetTimePosition( vlm_t *p_vlm, int64_t id, co
     if( !p_instance )
         return VLC_EGENERIC;
 
+    if( p_instance->player == NULL )
+    {
+        vlc_tick_t i_time = VLC_TICK_INVALID;
+        double d_position = 0.;
+        if( p_instance->source != NULL )
+            vlm_SourceGetTimes( p_instance->source, &i_time, NULL, &d_position );
+        if( pi_time )
+            *pi_time = US_FROM_VLC_TICK(i_time);
+        if( pd_position )
+            *pd_position = d_position;
+        return VLC_SUCCESS;
+    }
+
     vlc_player_Lock(p_instance->player);
     if( pi_time )
         *pi_time = US_FROM_VLC_TICK(vlc_player_GetTime(p_instance->player));
@@ -778,6 +885,10 @@ static int vlm_ControlMediaInstanceSetTimePosition( vlm_t *p_vlm, int64_t id, co
     if( !p_instance )
         return VLC_EGENERIC;
 
+    /* A shared input would seek the other instances too */
+    if( p_instance->player == NULL )
+        return VLC_EGENERIC;
+
     vlc_player_Lock(p_instance->player);
     if( i_time >= 0 )
         vlc_player_SetTime(p_instance->player, VLC_TICK_FROM_US(i_time));
@@ -803,13 +914,28 @@ static int vlm_ControlMediaInstanceGets( vlm_t *p_vlm, int64_t id, vlm_media_ins
         vlm_media_instance_t *p_idsc = vlm_media_instance_New();
         if( p_instance->psz_name )
             p_idsc->psz_name = strdup( p_instance->psz_name );
-        vlc_player_Lock(p_instance->player);
-        p_idsc->i_time = US_FROM_VLC_TICK(vlc_player_GetTime(p_instance->player));
-        p_idsc->i_length = US_FROM_VLC_TICK(vlc_player_GetLength(p_instance->player));
-        p_idsc->d_position = vlc_player_GetPosition(p_instance->player);
-        p_idsc->b_paused = vlc_player_IsPaused(p_instance->player);
-        p_idsc->f_rate = vlc_player_GetRate(p_instance->player);
-        vlc_player_Unlock(p_instance->player);
+        if( p_instance->player == NULL )
+        {
+            vlc_tick_t i_time = VLC_TICK_INVALID, i_length = VLC_TICK_INVALID;
+            p_idsc->d_position = 0.;
+            if( p_instance->source != NULL )
+                vlm_SourceGetTimes( p_instance->source, &i_time, &i_length,
+                                    &p_idsc->d_position );
+            p_idsc->i_time = US_FROM_VLC_TICK(i_time);
+            p_idsc->i_length = US_FROM_VLC_TICK(i_length);
+            p_idsc->b_paused = false;
+            p_idsc->f_rate = 1.f;
+        }
+        else
+        {
+            vlc_player_Lock(p_instance->player);
+            p_idsc->i_time = US_FROM_VLC_TICK(vlc_player_GetTime(p_instance->player));
+            p_idsc->i_length = US_FROM_VLC_TICK(vlc_player_GetLength(p_instance->player));
+            p_idsc->d_position = vlc_player_GetPosition(p_instance->player);
+            p_idsc->b_paused = vlc_player_IsPaused(p_instance->player);
+            p_idsc->f_rate = vlc_player_GetRate(p_instance->player);
+            vlc_player_Unlock(p_instance->player);
+        }
 
         TAB_APPEND( i_idsc, pp_idsc, p_idsc );
     }
@@ -27,6 +27,8 @@
 #include <vlc_player.h>
 
 /* Private */
+typedef struct vlm_source_t vlm_source_t;
+
 typedef struct
 {
     /* instance name */
@@ -39,6 +41,11 @@ typedef struct
     vlc_player_t *player;
     vlc_player_listener_id *listener;
     bool finished;
+
+    /* When inputs are shared, the instance has no player but an output
+     * chain fed by the input of its source */
+    vlm_source_t  *source;
+    sout_stream_t *sout;
 } vlm_media_instance_sys_t;
 
 
@@ -95,8 +102,34 @@ struct vlm_t
     /* Schedule list */
     int            i_schedule;
     vlm_schedule_sys_t **schedule;
+
+    /* Shared inputs */
+    bool           b_share_inputs;
+    int            i_source;
+    vlm_source_t   **source;
 };
 
+/**
+ * Feeds an output chain from the input of the given MRL and options, which is
+ * opened once for all the chains using it. The chain receives the elementary
+ * streams from the current position on. Must be called with the vlm lock.
+ *
+ * \return the source, or NULL on error
+ */
+vlm_source_t *vlm_SourceAttach( vlm_t *, const char *psz_mrl,
+                                int i_option, char *const *ppsz_option,
+                                sout_stream_t *p_sout );
+
+/**
+ * Stops feeding an output chain, without disturbing the other ones. The input
+ * is closed with the last chain. Must be called with the vlm lock.
+ */
+void vlm_SourceDetach( vlm_t *, vlm_source_t *, sout_stream_t *p_sout );
+
+bool vlm_SourceIsFinished( vlm_source_t * );
+void vlm_SourceGetTimes( vlm_source_t *, vlc_tick_t *pi_time,
+                         vlc_tick_t *pi_length, double *pd_position );
+
 int vlm_ControlInternal( vlm_t *p_vlm, int i_query, ... );
 int ExecuteCommand( vlm_t *, const char *, vlm_message_t ** );
 void vlm_ScheduleDelete( vlm_t *vlm, vlm_schedule_sys_t *sched );
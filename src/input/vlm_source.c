@@ -0,0 +1,602 @@
+/*****************************************************************************
+ * vlm_source.c: inputs shared by VLM broadcast instances
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_vlm.h>
+#include <vlc_sout.h>
+#include <vlc_decoder.h>
+#include <vlc_vector.h>
+#include <vlc_memstream.h>
+
+#include "vlm_internal.h"
+#include "input_internal.h"
+#include "resource.h"
+
+/*
+ * A source is one input thread, whose stream output is a hub forwarding each
+ * elementary stream to the output chains of the instances attached to it.
+ * Chains come and go while the input runs: an attached chain gets all the
+ * current elementary streams, a detached one is removed from the hub only.
+ *
+ * Frames are sent to the chains without the lock of the source, so that a
+ * slow chain does not hold back attaching and detaching the others: a chain
+ * is only detached once the frames being sent to it were delivered.
+ */
+
+/* Stream output chain of the input, handed to its resource beforehand */
+#define VLM_SOURCE_SOUT "#vlm-source"
+
+typedef struct
+{
+    es_format_t fmt;
+    char       *psz_es_id;
+} vlm_source_es_t;
+
+typedef struct
+{
+    const vlm_source_es_t *es;
+    void                  *id; /* in the output chain */
+} vlm_source_id_t;
+
+typedef struct
+{
+    sout_stream_t *sout;
+    struct VLC_VECTOR(vlm_source_id_t) ids;
+    bool           synchronous;
+    bool           substreams;
+    unsigned       sending; /* frames being sent to it */
+} vlm_source_output_t;
+
+typedef struct
+{
+    vlm_source_output_t *output;
+    void                *id;
+} vlm_source_target_t;
+
+struct vlm_source_t
+{
+    vlm_t            *vlm;
+    char             *psz_key; /* MRL and input options */
+    input_resource_t *resource;
+    input_thread_t   *input;
+
+    /* chains receiving the frame being sent, used by HubSend only, which
+     * the lock of the hub serializes */
+    struct VLC_VECTOR(vlm_source_target_t) targets;
+
+    vlc_mutex_t       lock;
+    vlc_cond_t        sent; /* signaled when an output has no frame in flight */
+    /* protected by lock */
+    struct VLC_VECTOR(vlm_source_es_t *) es;
+    struct VLC_VECTOR(vlm_source_output_t *) outputs;
+    bool              synchronous; /* of any output */
+    bool              substreams;  /* of any output */
+    bool              finished;
+    vlc_tick_t        time;
+    vlc_tick_t        length;
+    double            position;
+};
+
+/*****************************************************************************
+ * Outputs
+ *****************************************************************************/
+static void OutputAddEs( vlm_source_output_t *output, const vlm_source_es_t *es )
+{
+    void *id = sout_StreamIdAdd( output->sout, &es->fmt, es->psz_es_id );
+    if( id == NULL )
+        return;
+
+    vlm_source_id_t entry = { .es = es, .id = id };
+    if( !vlc_vector_push( &output->ids, entry ) )
+        sout_StreamIdDel( output->sout, id );
+}
+
+static void *OutputGetId( const vlm_source_output_t *output,
+                          const vlm_source_es_t *es )
+{
+    for( size_t i = 0; i < output->ids.size; i++ )
+        if( output->ids.data[i].es == es )
+            return output->ids.data[i].id;
+    return NULL;
+}
+
+/* Flags of the hub, from those of every output */
+static void SourceUpdateFlags( vlm_source_t *source )
+{
+    vlm_source_output_t *output;
+
+    source->synchronous = source->substreams = false;
+    vlc_vector_foreach( output, &source->outputs )
+    {
+        source->synchronous |= output->synchronous;
+        source->substreams |= output->substreams;
+    }
+}
+
+static void OutputDelEs( vlm_source_output_t *output, const vlm_source_es_t *es )
+{
+    for( size_t i = 0; i < output->ids.size; i++ )
+        if( output->ids.data[i].es == es )
+        {
+            sout_StreamIdDel( output->sout, output->ids.data[i].id );
+            vlc_vector_remove( &output->ids, i );
+            return;
+        }
+}
+
+/*****************************************************************************
+ * Hub, the stream output of the input
+ *****************************************************************************/
+static void *HubAdd( sout_stream_t *stream, const es_format_t *fmt,
+                     const char *es_id )
+{
+    vlm_source_t *source = stream->p_sys;
+
+    vlm_source_es_t *es = malloc( sizeof(*es) );
+    if( unlikely(es == NULL) )
+        return NULL;
+    es->psz_es_id = strdup( es_id );
+    if( unlikely(es->psz_es_id == NULL) ||
+        es_format_Copy( &es->fmt, fmt ) != VLC_SUCCESS )
+    {
+        free( es->psz_es_id );
+        free( es );
+        return NULL;
+    }
+
+    vlc_mutex_lock( &source->lock );
+    if( !vlc_vector_push( &source->es, es ) )
+    {
+        vlc_mutex_unlock( &source->lock );
+        es_format_Clean( &es->fmt );
+        free( es->psz_es_id );
+        free( es );
+        return NULL;
+    }
+
+    vlm_source_output_t *output;
+    vlc_vector_foreach( output, &source->outputs )
+        OutputAddEs( output, es );
+    vlc_mutex_unlock( &source->lock );
+    return es;
+}
+
+static void HubDel( sout_stream_t *stream, void *id )
+{
+    vlm_source_t *source = stream->p_sys;
+    vlm_source_es_t *es = id;
+
+    vlc_mutex_lock( &source->lock );
+    vlm_source_output_t *output;
+    vlc_vector_foreach( output, &source->outputs )
+        OutputDelEs( output, es );
+
+    ssize_t idx;
+    vlc_vector_index_of( &source->es, es, &idx );
+    assert( idx >= 0 );
+    vlc_vector_remove( &source->es, idx );
+    vlc_mutex_unlock( &source->lock );
+
+    es_format_Clean( &es->fmt );
+    free( es->psz_es_id );
+    free( es );
+}
+
+static int HubSend( sout_stream_t *stream, void *id, vlc_frame_t *frame )
+{
+    vlm_source_t *source = stream->p_sys;
+    vlm_source_target_t *target;
+
+    /* Keep the outputs until the frame is sent, they cannot be detached */
+    vlc_vector_clear( &source->targets );
+    vlc_mutex_lock( &source->lock );
+    vlm_source_output_t *output;
+    vlc_vector_foreach( output, &source->outputs )
+    {
+        vlm_source_target_t entry = {
+            .output = output,
+            .id = OutputGetId( output, id ),
+        };
+        if( entry.id != NULL && vlc_vector_push( &source->targets, entry ) )
+            output->sending++;
+    }
+    vlc_mutex_unlock( &source->lock );
+
+    /* Every output but the last one gets a copy */
+    for( size_t i = 0; i < source->targets.size; i++ )
+    {
+        target = &source->targets.data[i];
+        vlc_frame_t *out = i + 1 < source->targets.size
+                         ? vlc_frame_Duplicate( frame ) : frame;
+        if( likely(out != NULL) )
+            sout_StreamIdSend( target->output->sout, target->id, out );
+    }
+    if( source->targets.size == 0 )
+        vlc_frame_Release( frame );
+
+    vlc_mutex_lock( &source->lock );
+    vlc_vector_foreach_ref( target, &source->targets )
+        if( --target->output->sending == 0 )
+            vlc_cond_broadcast( &source->sent );
+    vlc_mutex_unlock( &source->lock );
+    return VLC_SUCCESS;
+}
+
+static void HubFlush( sout_stream_t *stream, void *id )
+{
+    vlm_source_t *source = stream->p_sys;
+
+    vlc_mutex_lock( &source->lock );
+    vlm_source_output_t *output;
+    vlc_vector_foreach( output, &source->outputs )
+    {
+        void *out_id = OutputGetId( output, id );
+        if( out_id != NULL )
+            sout_StreamFlush( output->sout, out_id );
+    }
+    vlc_mutex_unlock( &source->lock );
+}
+
+static void HubSetPCR( sout_stream_t *stream, vlc_tick_t pcr )
+{
+    vlm_source_t *source = stream->p_sys;
+
+    vlc_mutex_lock( &source->lock );
+    vlm_source_output_t *output;
+    vlc_vector_foreach( output, &source->outputs )
+        sout_StreamSetPCR( output->sout, pcr );
+    vlc_mutex_unlock( &source->lock );
+}
+
+static int HubControl( sout_stream_t *stream, int query, va_list args )
+{
+    vlm_source_t *source = stream->p_sys;
+    vlm_source_output_t *output;
+    int ret = VLC_SUCCESS;
+
+    vlc_mutex_lock( &source->lock );
+    switch( query )
+    {
+        /* True if any output wants it, the others have to cope. They are
+         * evaluated whenever an output is attached or detached. */
+        case SOUT_STREAM_IS_SYNCHRONOUS:
+            *va_arg( args, bool * ) = source->synchronous;
+            break;
+
+        case SOUT_STREAM_WANTS_SUBSTREAMS:
+            *va_arg( args, bool * ) = source->substreams;
+            break;
+
+        case SOUT_STREAM_ID_SPU_HIGHLIGHT:
+        {
+            void *id = va_arg( args, void * );
+            const vlc_spu_highlight_t *hl =
+                va_arg( args, const vlc_spu_highlight_t * );
+            vlc_vector_foreach( output, &source->outputs )
+            {
+                void *out_id = OutputGetId( output, id );
+                if( out_id != NULL )
+                    sout_StreamControl( output->sout, query, out_id, hl );
+            }
+            break;
+        }
+
+        default:
+            ret = VLC_EGENERIC;
+            break;
+    }
+    vlc_mutex_unlock( &source->lock );
+    return ret;
+}
+
+static const struct sout_stream_operations hub_ops = {
+    .add = HubAdd,
+    .del = HubDel,
+    .send = HubSend,
+    .flush = HubFlush,
+    .set_pcr = HubSetPCR,
+    .control = HubControl,
+};
+
+/*****************************************************************************
+ * Source
+ *****************************************************************************/
+static void InputEvent( input_thread_t *input,
+                        const struct vlc_input_event *event, void *data )
+{
+    vlm_source_t *source = data;
+    vlm_t *vlm = source->vlm;
+    (void) input;
+
+    switch( event->type )
+    {
+        case INPUT_EVENT_TIMES:
+            vlc_mutex_lock( &source->lock );
+            source->time = event->times.time;
+            source->length = event->times.length;
+            source->position = event->times.position;
+            vlc_mutex_unlock( &source->lock );
+            return;
+
+        case INPUT_EVENT_STATE:
+            if( event->state.value != END_S && event->state.value != ERROR_S )
+                return;
+            break;
+
+        case INPUT_EVENT_DEAD:
+            break;
+
+        default:
+            return;
+    }
+
+    vlc_mutex_lock( &source->lock );
+    source->finished = true;
+    vlc_mutex_unlock( &source->lock );
+
+    /* The manage thread moves the instances on */
+    vlc_mutex_lock( &vlm->lock_manage );
+    vlm->input_state_changed = true;
+    vlc_cond_signal( &vlm->wait_manage );
+    vlc_mutex_unlock( &vlm->lock_manage );
+}
+
+static char *SourceKey( const char *psz_mrl,
+                        int i_option, char *const *ppsz_option )
+{
+    struct vlc_memstream ms;
+
+    if( vlc_memstream_open( &ms ) )
+        return NULL;
+    vlc_memstream_puts( &ms, psz_mrl );
+    for( int i = 0; i < i_option; i++ )
+    {
+        vlc_memstream_putc( &ms, '\n' );
+        vlc_memstream_puts( &ms, ppsz_option[i] );
+    }
+    if( vlc_memstream_close( &ms ) )
+        return NULL;
+    return ms.ptr;
+}
+
+static void SourceDelete( vlm_source_t *source )
+{
+    if( source->input != NULL )
+    {
+        input_Stop( source->input );
+        input_Close( source->input );
+    }
+    /* This destroys the hub */
+    if( source->resource != NULL )
+        input_resource_Release( source->resource );
+
+    assert( source->outputs.size == 0 );
+    vlc_vector_destroy( &source->targets );
+    vlm_source_es_t *es;
+    vlc_vector_foreach( es, &source->es )
+    {
+        es_format_Clean( &es->fmt );
+        free( es->psz_es_id );
+        free( es );
+    }
+    vlc_vector_destroy( &source->es );
+    vlc_vector_destroy( &source->outputs );
+    free( source->psz_key );
+    free( source );
+}
+
+static vlm_source_t *SourceNew( vlm_t *vlm, const char *psz_mrl,
+                                int i_option, char *const *ppsz_option,
+                                char *psz_key )
+{
+    vlm_source_t *source = malloc( sizeof(*source) );
+    if( unlikely(source == NULL) )
+        return NULL;
+
+    source->vlm = vlm;
+    source->psz_key = psz_key;
+    source->resource = NULL;
+    source->input = NULL;
+    vlc_vector_init( &source->targets );
+    vlc_mutex_init( &source->lock );
+    vlc_cond_init( &source->sent );
+    vlc_vector_init( &source->es );
+    vlc_vector_init( &source->outputs );
+    source->synchronous = false;
+    source->substreams = false;
+    source->finished = false;
+    source->time = VLC_TICK_INVALID;
+    source->length = VLC_TICK_INVALID;
+    source->position = 0.;
+
+    input_item_t *item = input_item_New( psz_mrl, NULL );
+    if( unlikely(item == NULL) )
+        goto error;
+    for( int i = 0; i < i_option; i++ )
+        input_item_AddOption( item, ppsz_option[i], VLC_INPUT_OPTION_TRUSTED );
+    input_item_AddOption( item, "sout=" VLM_SOURCE_SOUT,
+                          VLC_INPUT_OPTION_TRUSTED );
+
+    source->resource = input_resource_New( VLC_OBJECT(vlm) );
+    sout_stream_t *hub = sout_StreamNew( VLC_OBJECT(vlm), "vlm-source" );
+    if( unlikely(source->resource == NULL || hub == NULL) )
+    {
+        if( hub != NULL )
+            sout_StreamChainDelete( hub, NULL );
+        input_item_Release( item );
+        goto error;
+    }
+    hub->ops = &hub_ops;
+    hub->p_sys = source;
+    input_resource_SetSout( source->resource, hub, VLM_SOURCE_SOUT );
+
+    source->input = input_Create( vlm, InputEvent, source, item,
+                                  INPUT_TYPE_NONE, source->resource, NULL );
+    input_item_Release( item );
+    if( source->input == NULL )
+        goto error;
+    return source;
+
+error:
+    source->psz_key = NULL;
+    SourceDelete( source );
+    return NULL;
+}
+
+vlm_source_t *vlm_SourceAttach( vlm_t *vlm, const char *psz_mrl,
+                                int i_option, char *const *ppsz_option,
+                                sout_stream_t *p_sout )
+{
+    char *psz_key = SourceKey( psz_mrl, i_option, ppsz_option );
+    if( unlikely(psz_key == NULL) )
+        return NULL;
+
+    /* A finished source is not restarted: its instances move on */
+    vlm_source_t *source = NULL;
+    for( int i = 0; i < vlm->i_source && source == NULL; i++ )
+    {
+        if( !strcmp( vlm->source[i]->psz_key, psz_key ) &&
+            !vlm_SourceIsFinished( vlm->source[i] ) )
+            source = vlm->source[i];
+    }
+
+    const bool b_new = source == NULL;
+    if( b_new )
+    {
+        source = SourceNew( vlm, psz_mrl, i_option, ppsz_option, psz_key );
+        if( source == NULL )
+        {
+            free( psz_key );
+            return NULL;
+        }
+        TAB_APPEND( vlm->i_source, vlm->source, source );
+    }
+    else
+        free( psz_key );
+
+    vlm_source_output_t *output = malloc( sizeof(*output) );
+    if( unlikely(output == NULL) )
+        goto error;
+    output->sout = p_sout;
+    vlc_vector_init( &output->ids );
+    output->sending = 0;
+    if( sout_StreamControl( p_sout, SOUT_STREAM_IS_SYNCHRONOUS,
+                            &output->synchronous ) != VLC_SUCCESS )
+        output->synchronous = false;
+    if( sout_StreamControl( p_sout, SOUT_STREAM_WANTS_SUBSTREAMS,
+                            &output->substreams ) != VLC_SUCCESS )
+        output->substreams = false;
+
+    vlc_mutex_lock( &source->lock );
+    if( !vlc_vector_push( &source->outputs, output ) )
+    {
+        vlc_mutex_unlock( &source->lock );
+        free( output );
+        goto error;
+    }
+    SourceUpdateFlags( source );
+    vlm_source_es_t *es;
+    vlc_vector_foreach( es, &source->es )
+        OutputAddEs( output, es );
+    const size_t i_outputs = source->outputs.size;
+    vlc_mutex_unlock( &source->lock );
+
+    /* Started once it has an output, so that it gets all the streams */
+    if( b_new && input_Start( source->input ) != VLC_SUCCESS )
+    {
+        vlm_SourceDetach( vlm, source, p_sout );
+        return NULL;
+    }
+
+    msg_Dbg( vlm, "%s input %s (%zu outputs)", b_new ? "opened" : "shared",
+             psz_mrl, i_outputs );
+    return source;
+
+error:
+    if( b_new )
+    {
+        TAB_REMOVE( vlm->i_source, vlm->source, source );
+        SourceDelete( source );
+    }
+    return NULL;
+}
+
+void vlm_SourceDetach( vlm_t *vlm, vlm_source_t *source, sout_stream_t *p_sout )
+{
+    vlc_mutex_lock( &source->lock );
+    for( size_t i = 0; i < source->outputs.size; i++ )
+    {
+        vlm_source_output_t *output = source->outputs.data[i];
+        if( output->sout != p_sout )
+            continue;
+
+        /* No new frame is sent to it, wait for those in flight */
+        vlc_vector_remove( &source->outputs, i );
+        SourceUpdateFlags( source );
+        while( output->sending > 0 )
+            vlc_cond_wait( &source->sent, &source->lock );
+
+        vlm_source_id_t *entry;
+        vlc_vector_foreach_ref( entry, &output->ids )
+            sout_StreamIdDel( p_sout, entry->id );
+        vlc_vector_destroy( &output->ids );
+        free( output );
+        break;
+    }
+    const bool b_last = source->outputs.size == 0;
+    vlc_mutex_unlock( &source->lock );
+
+    if( !b_last )
+        return;
+
+    msg_Dbg( vlm, "closing shared input" );
+    TAB_REMOVE( vlm->i_source, vlm->source, source );
+    SourceDelete( source );
+}
+
+bool vlm_SourceIsFinished( vlm_source_t *source )
+{
+    vlc_mutex_lock( &source->lock );
+    bool finished = source->finished;
+    vlc_mutex_unlock( &source->lock );
+    return finished;
+}
+
+void vlm_SourceGetTimes( vlm_source_t *source, vlc_tick_t *pi_time,
+                         vlc_tick_t *pi_length, double *pd_position )
+{
+    vlc_mutex_lock( &source->lock );
+    if( pi_time != NULL )
+        *pi_time = source->time;
+    if( pi_length != NULL )
+        *pi_length = source->length;
+    if( pd_position != NULL )
+        *pd_position = source->position;
+    vlc_mutex_unlock( &source->lock );
+}
@@ -1311,16 +1311,44 @@ static vlm_message_t *vlm_ShowMedia( vlm_media_sys_t *p_media )
         vlm_media_instance_sys_t *p_instance = p_media->instance[i];
         vlm_message_t *p_msg_instance;
 
-        vlc_player_Lock(p_instance->player);
-        enum vlc_player_state state = vlc_player_GetState(p_instance->player);
-        float position = vlc_player_GetPosition(p_instance->player);
-        vlc_tick_t time = vlc_player_GetTime(p_instance->player);
-        vlc_tick_t length = vlc_player_GetLength(p_instance->player);
-        float rate = vlc_player_GetRate(p_instance->player);
-        ssize_t title = vlc_player_GetSelectedTitleIdx(p_instance->player);
-        ssize_t chapter = vlc_player_GetSelectedChapterIdx(p_instance->player);
-        bool can_seek = vlc_player_CanSeek(p_instance->player);
-        vlc_player_Unlock(p_instance->player);
+        enum vlc_player_state state;
+        float position, rate;
+        vlc_tick_t time, length;
+        ssize_t title, chapter;
+        bool can_seek;
+
+        if( p_instance->player == NULL )
+        {
+            /* Fed by a shared input, which is not controllable */
+            double d_position = 0.;
+            time = length = VLC_TICK_INVALID;
+            if( p_instance->source != NULL )
+            {
+                vlm_SourceGetTimes( p_instance->source, &time, &length,
+                                    &d_position );
+                state = vlm_SourceIsFinished( p_instance->source )
+                      ? VLC_PLAYER_STATE_STOPPED : VLC_PLAYER_STATE_PLAYING;
+            }
+            else
+                state = VLC_PLAYER_STATE_STOPPED;
+            position = d_position;
+            rate = 1.f;
+            title = chapter = -1;
+            can_seek = false;
+        }
+        else
+        {
+            vlc_player_Lock(p_instance->player);
+            state = vlc_player_GetState(p_instance->player);
+            position = vlc_player_GetPosition(p_instance->player);
+            time = vlc_player_GetTime(p_instance->player);
+            length = vlc_player_GetLength(p_instance->player);
+            rate = vlc_player_GetRate(p_instance->player);
+            title = vlc_player_GetSelectedTitleIdx(p_instance->player);
+            chapter = vlc_player_GetSelectedChapterIdx(p_instance->player);
+            can_seek = vlc_player_CanSeek(p_instance->player);
+            vlc_player_Unlock(p_instance->player);
+        }
 
         p_msg_instance = vlm_MessageAdd( p_msg_sub, vlm_MessageSimpleNew( "instance" ) );
 
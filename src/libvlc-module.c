@@ -99,6 +99,12 @@ static const char *const ppsz_snap_formats[] =
     "This is the verbosity level (0=only errors and " \
     "standard messages, 1=warnings, 2=debug).")
 
+#define LOG_ASYNC_TEXT N_("Asynchronous logging")
+#define LOG_ASYNC_LONGTEXT N_( \
+    "Messages are written to the log from a background thread, so that " \
+    "logging does not slow down the other threads. Messages may be lost " \
+    "if they are issued faster than they can be written.")
+
 #define OPEN_TEXT N_("Default stream")
 #define OPEN_LONGTEXT N_( \
     "This stream will always be opened at VLC startup." )
@@ -251,6 +257,13 @@ static const char *const ppsz_mix_mode_texts[] = {
     "This allows playing audio at lower or higher speed without " \
     "affecting the audio pitch" )
 
+#define AUDIO_THREAD_TEXT N_( \
+    "Dedicated audio processing thread" )
+#define AUDIO_THREAD_LONGTEXT N_( \
+    "Run the audio filters and output on a separate thread from the " \
+    "decoder. This helps with heavy audio filters at the cost of slightly " \
+    "more latency." )
+
 
 static const char *const ppsz_replay_gain_mode[] = {
     "none", "track", "album" };
@@ -770,6 +783,24 @@ static const char* const ppsz_restore_playback_desc[] = {
     "This is the maximum size in bytes of the temporary files " \
     "that will be used to store the timeshifted streams." )
 
+#define INPUT_MEMORY_BUDGET_TEXT N_("Buffered data limit (MiB)")
+#define INPUT_MEMORY_BUDGET_LONGTEXT N_( \
+    "Maximum amount of media data buffered by all the inputs together, " \
+    "in stream caches, decoder queues and stream output queues. Inputs " \
+    "wait for their decoders to catch up when it is exceeded. " \
+    "0 means no limit." )
+
+#define DECODER_FIFO_DURATION_TEXT N_("Decoder queue duration (ms)")
+#define DECODER_FIFO_DURATION_LONGTEXT N_( \
+    "Maximum duration of the data waiting to be decoded for a live " \
+    "stream. Older data is discarded when a decoder lags further behind." )
+
+#define DECODER_PIPELINE_TEXT N_("Pipeline packetizing and decoding")
+#define DECODER_PIPELINE_LONGTEXT N_( \
+    "Decode on a separate thread from the packetizer, so that parsing the " \
+    "elementary streams does not delay decoding. This helps with high " \
+    "bitrate software decoding, at the cost of slightly more latency." )
+
 #define INPUT_TITLE_FORMAT_TEXT N_( "Change title according to current media" )
 #define INPUT_TITLE_FORMAT_LONGTEXT N_( "This option allows you to set the title according to what's being played<br>"  \
     "$a: Artist<br>$b: Album<br>$c: Copyright<br>$t: Title<br>$g: Genre<br>"  \
@@ -1108,6 +1139,12 @@ static const char* const ppsz_restore_playback_desc[] = {
 #define VLM_CONF_LONGTEXT N_( \
     "Read a VLM configuration file as soon as VLM is started." )
 
+#define VLM_SHARE_INPUTS_TEXT N_("Share VLM inputs")
+#define VLM_SHARE_INPUTS_LONGTEXT N_( \
+    "Open the input of broadcast media only once for all the instances " \
+    "playing the same input with the same options. The instances can then " \
+    "neither be paused nor seeked." )
+
 #define PLUGINS_CACHE_TEXT N_("Use a plugins cache")
 #define PLUGINS_CACHE_LONGTEXT N_( \
     "Use a plugins cache which will greatly improve the startup time of VLC.")
@@ -1624,6 +1661,8 @@ vlc_module_begin ()
 
     add_bool( "audio-time-stretch", true,
               AUDIO_TIME_STRETCH_TEXT, AUDIO_TIME_STRETCH_LONGTEXT )
+    add_bool( "audio-thread", false,
+              AUDIO_THREAD_TEXT, AUDIO_THREAD_LONGTEXT )
 
     set_subcategory( SUBCAT_AUDIO_AOUT )
     add_module("aout", "audio output", "any", AOUT_TEXT, AOUT_LONGTEXT)
@@ -2013,6 +2052,15 @@ vlc_module_begin ()
     add_integer( "input-timeshift-granularity", -1, INPUT_TIMESHIFT_GRANULARITY_TEXT,
                  INPUT_TIMESHIFT_GRANULARITY_LONGTEXT )
 
+    add_integer( "input-memory-budget", 0, INPUT_MEMORY_BUDGET_TEXT,
+                 INPUT_MEMORY_BUDGET_LONGTEXT )
+        change_integer_range( 0, INT_MAX )
+    add_integer( "decoder-fifo-duration", 60000, DECODER_FIFO_DURATION_TEXT,
+                 DECODER_FIFO_DURATION_LONGTEXT )
+        change_integer_range( 100, 3600000 )
+    add_bool( "decoder-pipeline", false, DECODER_PIPELINE_TEXT,
+              DECODER_PIPELINE_LONGTEXT )
+
     add_string( "input-title-format", "$Z", INPUT_TITLE_FORMAT_TEXT, INPUT_TITLE_FORMAT_LONGTEXT )
 
 /* Decoder options */
@@ -2062,6 +2110,8 @@ vlc_module_begin ()
 
     set_section( N_("VLM"), NULL )
     add_loadfile("vlm-conf", NULL, VLM_CONF_TEXT, VLM_CONF_LONGTEXT)
+    add_bool( "vlm-share-inputs", false, VLM_SHARE_INPUTS_TEXT,
+              VLM_SHARE_INPUTS_LONGTEXT )
 
 
     set_subcategory( SUBCAT_SOUT_STREAM )
@@ -2220,6 +2270,7 @@ vlc_module_begin ()
     add_integer( "verbose", 0, VERBOSE_TEXT, VERBOSE_LONGTEXT )
         change_short('v')
         change_volatile ()
+    add_bool( "log-async", false, LOG_ASYNC_TEXT, LOG_ASYNC_LONGTEXT )
 #if !defined(_WIN32) && !defined(__OS2__)
     add_obsolete_bool( "daemon" ) /* since 4.0.0 */
         change_short('d')
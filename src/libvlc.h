@@ -172,6 +172,12 @@ typedef struct vlc_playlist vlc_playlist_t;
 typedef struct vlc_media_source_provider_t vlc_media_source_provider_t;
 typedef struct intf_thread_t intf_thread_t;
 
+/*
+ * Memory budget, see vlc_membudget.h
+ */
+struct vlc_membudget *vlc_membudget_New(libvlc_int_t *);
+void vlc_membudget_Delete(struct vlc_membudget *);
+
 typedef struct libvlc_priv_t
 {
     libvlc_int_t       public_data;
@@ -189,6 +195,7 @@ typedef struct libvlc_priv_t
     struct vlc_medialibrary_t *p_media_library; ///< Media library instance
     struct vlc_thumbnailer_t *p_thumbnailer; ///< Lazily instantiated media thumbnailer
     struct vlc_tracer *tracer; ///< Tracer callbacks
+    struct vlc_membudget *membudget; ///< Buffered media data accounting
 
     /* Exit callback */
     vlc_exit_t       exit;
@@ -504,17 +504,136 @@ static picture_t *FilterSingleChainedFilter( chained_filter_t *f, picture_t *p_p
     return p_pic;
 }
 
-picture_t *filter_chain_VideoFilter( filter_chain_t *p_chain, picture_t *p_pic )
+/* Whether a filter can be run as lookup tables on pictures of format fmt */
+static bool IsPointOp( const chained_filter_t *f, const video_format_t *fmt )
 {
-    if( p_pic )
+    const filter_t *p_filter = &f->filter;
+
+    return p_filter->ops->video_point_op != NULL
+        && p_filter->vctx_in == NULL
+        && p_filter->fmt_in.video.i_chroma == fmt->i_chroma
+        && p_filter->fmt_in.video.i_width == fmt->i_width
+        && p_filter->fmt_in.video.i_height == fmt->i_height
+        && p_filter->fmt_out.video.i_chroma == fmt->i_chroma
+        && p_filter->fmt_out.video.i_width == fmt->i_width
+        && p_filter->fmt_out.video.i_height == fmt->i_height;
+}
+
+/**
+ * Composes the lookup tables of the filters following f, as long as they
+ * can be described so.
+ *
+ * \return the last filter of the run, or NULL if there is no run of at
+ * least two filters, which would not save any pass
+ */
+static chained_filter_t *ComposePointOps( filter_chain_t *p_chain,
+                                          chained_filter_t *f,
+                                          uint8_t lut[][256] )
+{
+    const video_format_t *fmt = &f->filter.fmt_in.video;
+    const vlc_chroma_description_t *dsc =
+        vlc_fourcc_GetChromaDescription( fmt->i_chroma );
+
+    if( dsc == NULL || dsc->plane_count == 0
+     || dsc->pixel_size * 8 != dsc->pixel_bits
+     || !IsPointOp( f, fmt ) )
+        return NULL;
+
+    chained_filter_t *next = vlc_list_next_entry_or_null( &p_chain->filter_list,
+                                                          f, chained_filter_t,
+                                                          node );
+    if( next == NULL || !IsPointOp( next, fmt )
+     || f->filter.ops->video_point_op( &f->filter, lut ) != VLC_SUCCESS )
+        return NULL;
+
+    chained_filter_t *last = NULL;
+    for( chained_filter_t *g = next; g != NULL && IsPointOp( g, fmt );
+         g = vlc_list_next_entry_or_null( &p_chain->filter_list, g,
+                                          chained_filter_t, node ) )
+    {
+        uint8_t step[PICTURE_PLANE_MAX][256];
+
+        if( g->filter.ops->video_point_op( &g->filter, step ) != VLC_SUCCESS )
+            break;
+
+        for( unsigned i = 0; i < dsc->plane_count; i++ )
+            for( unsigned j = 0; j < 256; j++ )
+                lut[i][j] = step[i][lut[i][j]];
+        last = g;
+    }
+    return last;
+}
+
+static void ApplyPointOps( picture_t *p_outpic, const picture_t *p_pic,
+                           uint8_t lut[][256] )
+{
+    for( int i = 0; i < p_pic->i_planes; i++ )
+    {
+        const plane_t *in = &p_pic->p[i];
+        plane_t *out = &p_outpic->p[i];
+        const uint8_t *table = lut[i];
+
+        bool identity = true;
+        for( unsigned j = 0; j < 256 && identity; j++ )
+            identity = table[j] == j;
+
+        for( int y = 0; y < in->i_visible_lines; y++ )
+        {
+            const uint8_t *src = &in->p_pixels[y * in->i_pitch];
+            uint8_t *dst = &out->p_pixels[y * out->i_pitch];
+
+            if( identity )
+            {
+                memcpy( dst, src, in->i_visible_pitch );
+                continue;
+            }
+            for( int x = 0; x < in->i_visible_pitch; x++ )
+                dst[x] = table[src[x]];
+        }
+    }
+}
+
+/* Filters a picture from the given node to the end of the chain */
+static picture_t *FilterChainedFilters( filter_chain_t *p_chain,
+                                        struct vlc_list *node,
+                                        picture_t *p_pic )
+{
+    while( node != &p_chain->filter_list )
     {
-        chained_filter_t *f;
-        vlc_list_foreach( f, &p_chain->filter_list, node )
+        chained_filter_t *f = container_of( node, chained_filter_t, node );
+        uint8_t lut[PICTURE_PLANE_MAX][256];
+        chained_filter_t *last = ComposePointOps( p_chain, f, lut );
+
+        if( last != NULL )
         {
-            p_pic = FilterSingleChainedFilter( f, p_pic );
-            if( !p_pic )
-                break;
+            /* Run the whole sequence in a single pass, into a picture of
+             * the last filter */
+            picture_t *p_outpic = filter_NewPicture( &last->filter );
+            if( p_outpic != NULL )
+            {
+                ApplyPointOps( p_outpic, p_pic, lut );
+                picture_CopyProperties( p_outpic, p_pic );
+            }
+            picture_Release( p_pic );
+            p_pic = p_outpic;
+            f = last;
         }
+        else
+            p_pic = FilterSingleChainedFilter( f, p_pic );
+
+        if( !p_pic )
+            break;
+        node = f->node.next;
+    }
+    return p_pic;
+}
+
+picture_t *filter_chain_VideoFilter( filter_chain_t *p_chain, picture_t *p_pic )
+{
+    if( p_pic )
+    {
+        p_pic = FilterChainedFilters( p_chain, p_chain->filter_list.next,
+                                      p_pic );
         if( p_pic )
             return p_pic;
     }
@@ -528,16 +647,7 @@ picture_t *filter_chain_VideoFilter( filter_chain_t *p_chain, picture_t *p_pic )
             continue;
 
         // iterate forward through the next filters
-        struct vlc_list_it f_it = vlc_list_it_b;
-        vlc_list_it_next(&f_it);
-        for ( ; vlc_list_it_continue(&f_it); vlc_list_it_next(&f_it) )
-        {
-            chained_filter_t *f =
-                container_of(f_it.current, chained_filter_t, node);
-            p_pic = FilterSingleChainedFilter( f, p_pic );
-            if( !p_pic )
-                break;
-        }
+        p_pic = FilterChainedFilters( p_chain, b->node.next, p_pic );
         if( p_pic )
             return p_pic;
     }
@@ -86,6 +86,13 @@ struct vlc_logger {
     const struct vlc_logger_operations *ops;
 };
 
+static int vlc_LogVerbosity(struct vlc_logger *logger)
+{
+    const struct vlc_logger_operations *ops = logger->ops;
+
+    return (ops->verbosity != NULL) ? ops->verbosity(logger) : VLC_MSG_DBG;
+}
+
 static void vlc_vaLogCallback(vlc_logger_t *logger, int type,
                               const vlc_log_t *item, const char *format,
                               va_list ap)
@@ -126,6 +133,10 @@ void vlc_vaLog(struct vlc_logger *const *loggerp, int type,
         // nothing to do
         return;
 
+    /* Discard filtered messages before any formatting */
+    if (type > vlc_LogVerbosity(logger))
+        return;
+
     /* Get basename from the module filename */
     char *p = strrchr(module, '/');
     if (p != NULL)
@@ -247,6 +258,7 @@ static void vlc_LogEarlyClose(void *d)
 static const struct vlc_logger_operations early_ops = {
     vlc_vaLogEarly,
     vlc_LogEarlyClose,
+    NULL,
 };
 
 static struct vlc_logger *vlc_LogEarlyOpen(struct vlc_logger *logger)
@@ -274,9 +286,16 @@ static void vlc_LogDiscardClose(void *d)
     (void) d;
 }
 
+static int vlc_LogDiscardVerbosity(void *d)
+{
+    (void) d;
+    return -1;
+}
+
 static const struct vlc_logger_operations discard_ops = {
     vlc_vaLogDiscard,
     vlc_LogDiscardClose,
+    vlc_LogDiscardVerbosity,
 };
 
 static struct vlc_logger discard_log = { &discard_ops };
@@ -288,6 +307,7 @@ static struct vlc_logger discard_log = { &discard_ops };
  */
 struct vlc_logger_switch {
     struct vlc_logger *_Atomic backend;
+    _Atomic int verbosity; /* of the backend */
     struct vlc_logger frontend;
 };
 
@@ -318,9 +338,19 @@ static void vlc_LogSwitchClose(void *d)
     free(logswitch);
 }
 
+static int vlc_LogSwitchVerbosity(void *d)
+{
+    struct vlc_logger *logger = d;
+    struct vlc_logger_switch *logswitch =
+        container_of(logger, struct vlc_logger_switch, frontend);
+
+    return atomic_load_explicit(&logswitch->verbosity, memory_order_relaxed);
+}
+
 static const struct vlc_logger_operations switch_ops = {
     vlc_vaLogSwitch,
     vlc_LogSwitchClose,
+    vlc_LogSwitchVerbosity,
 };
 
 static void vlc_LogSwitch(vlc_logger_t *logger, vlc_logger_t *new_logger)
@@ -336,6 +366,8 @@ static void vlc_LogSwitch(vlc_logger_t *logger, vlc_logger_t *new_logger)
 
     old_logger = atomic_exchange_explicit(&logswitch->backend, new_logger,
                                           memory_order_acq_rel);
+    atomic_store_explicit(&logswitch->verbosity, vlc_LogVerbosity(new_logger),
+                          memory_order_relaxed);
     vlc_rcu_synchronize();
     old_logger->ops->destroy(old_logger);
 }
@@ -348,6 +380,7 @@ static struct vlc_logger *vlc_LogSwitchCreate(void)
 
     logswitch->frontend.ops = &switch_ops;
     atomic_init(&logswitch->backend, &discard_log);
+    atomic_init(&logswitch->verbosity, -1);
     return &logswitch->frontend;
 }
 
@@ -359,6 +392,7 @@ struct vlc_logger_module {
     struct vlc_logger frontend;
     const struct vlc_logger_operations *ops;
     void *opaque;
+    int verbosity;
 };
 
 static int vlc_logger_load(void *func, bool forced, va_list ap)
@@ -394,9 +428,19 @@ static void vlc_LogModuleClose(void *d)
     vlc_object_delete(VLC_OBJECT(module));
 }
 
+static int vlc_LogModuleVerbosity(void *d)
+{
+    struct vlc_logger *logger = d;
+    struct vlc_logger_module *module =
+        container_of(logger, struct vlc_logger_module, frontend);
+
+    return module->verbosity;
+}
+
 static const struct vlc_logger_operations module_ops = {
     vlc_vaLogModule,
     vlc_LogModuleClose,
+    vlc_LogModuleVerbosity,
 };
 
 static struct vlc_logger *vlc_LogModuleCreate(vlc_object_t *parent)
@@ -415,9 +459,233 @@ static struct vlc_logger *vlc_LogModuleCreate(vlc_object_t *parent)
     }
 
     module->frontend.ops = &module_ops;
+    module->verbosity = (module->ops->verbosity != NULL)
+                      ? module->ops->verbosity(module->opaque) : VLC_MSG_DBG;
     return &module->frontend;
 }
 
+/**
+ * Asynchronous message log.
+ *
+ * A message log that formats messages on the calling thread, queues them in a
+ * lock-free ring, and passes them to another log from a background thread.
+ * Messages are dropped (and counted) if the ring is full.
+ */
+#define VLC_LOG_ASYNC_SIZE 1024 /* must be a power of two */
+
+struct vlc_log_async_record {
+    _Atomic size_t seq;
+    int type;
+    vlc_log_t meta;
+    char module[32];
+    char *header; /* local copy */
+    char *msg; /* text, or a heap copy if too long */
+    char text[256];
+};
+
+struct vlc_logger_async {
+    struct vlc_logger logger;
+    struct vlc_logger *backend;
+    int verbosity; /* of the backend */
+    vlc_thread_t thread;
+    vlc_sem_t wait;
+    atomic_bool sleeping;
+    atomic_bool stop;
+    _Atomic unsigned long dropped;
+    _Atomic size_t tail; /* next record to write */
+    size_t head; /* next record to read (owned by the thread) */
+    struct vlc_log_async_record records[VLC_LOG_ASYNC_SIZE];
+};
+
+static void vlc_vaLogAsync(void *d, int type, const vlc_log_t *item,
+                           const char *format, va_list ap)
+{
+    struct vlc_logger *logger = d;
+    struct vlc_logger_async *async =
+        container_of(logger, struct vlc_logger_async, logger);
+    struct vlc_log_async_record *rec;
+    size_t pos = atomic_load_explicit(&async->tail, memory_order_relaxed);
+
+    /* Reserve a record (multiple producers) */
+    for (;;) {
+        rec = &async->records[pos & (VLC_LOG_ASYNC_SIZE - 1)];
+
+        size_t seq = atomic_load_explicit(&rec->seq, memory_order_acquire);
+        ptrdiff_t diff = (ptrdiff_t)(seq - pos);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&async->tail, &pos,
+                                                      pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            /* Full: do not wait for the background thread */
+            atomic_fetch_add_explicit(&async->dropped, 1,
+                                      memory_order_relaxed);
+            return;
+        } else
+            pos = atomic_load_explicit(&async->tail, memory_order_relaxed);
+    }
+
+    rec->type = type;
+    rec->meta = *item;
+    /* The module name may be on the stack of the caller */
+    strlcpy(rec->module, item->psz_module, sizeof (rec->module));
+    rec->meta.psz_module = rec->module;
+    rec->header = (item->psz_header != NULL) ? strdup(item->psz_header)
+                                             : NULL;
+    rec->meta.psz_header = rec->header;
+
+    va_list aq;
+    va_copy(aq, ap);
+    int len = vsnprintf(rec->text, sizeof (rec->text), format, ap);
+    rec->msg = rec->text;
+    if (unlikely(len < 0))
+        strcpy(rec->text, "message lost");
+    else if ((size_t)len >= sizeof (rec->text)
+          && vasprintf(&rec->msg, format, aq) == -1)
+        rec->msg = rec->text; /* truncated */
+    va_end(aq);
+
+    atomic_store_explicit(&rec->seq, pos + 1, memory_order_release);
+
+    if (atomic_exchange(&async->sleeping, false))
+        vlc_sem_post(&async->wait);
+}
+
+static void vlc_LogAsyncForward(struct vlc_logger *backend, int type,
+                                const vlc_log_t *item, const char *format, ...)
+{
+    va_list ap;
+
+    va_start(ap, format);
+    backend->ops->log(backend, type, item, format, ap);
+    va_end(ap);
+}
+
+static bool vlc_LogAsyncPending(struct vlc_logger_async *async)
+{
+    const struct vlc_log_async_record *rec =
+        &async->records[async->head & (VLC_LOG_ASYNC_SIZE - 1)];
+
+    return atomic_load_explicit(&rec->seq, memory_order_acquire)
+           == async->head + 1;
+}
+
+static void vlc_LogAsyncDrain(struct vlc_logger_async *async)
+{
+    while (vlc_LogAsyncPending(async)) {
+        struct vlc_log_async_record *rec =
+            &async->records[async->head & (VLC_LOG_ASYNC_SIZE - 1)];
+
+        vlc_LogAsyncForward(async->backend, rec->type, &rec->meta, "%s",
+                            rec->msg);
+        if (rec->msg != rec->text)
+            free(rec->msg);
+        free(rec->header);
+
+        atomic_store_explicit(&rec->seq, async->head + VLC_LOG_ASYNC_SIZE,
+                              memory_order_release);
+        async->head++;
+    }
+
+    unsigned long dropped = atomic_exchange_explicit(&async->dropped, 0,
+                                                     memory_order_relaxed);
+    if (dropped > 0) {
+        const vlc_log_t meta = {
+            .i_object_id = (uintptr_t)(void *)async,
+            .psz_object_type = "logger",
+            .psz_module = "main",
+            .file = __FILE__,
+            .line = __LINE__,
+            .func = __func__,
+            .tid = vlc_thread_id(),
+        };
+
+        vlc_LogAsyncForward(async->backend, VLC_MSG_WARN, &meta,
+                            "%lu message(s) dropped", dropped);
+    }
+}
+
+static void *vlc_LogAsyncThread(void *data)
+{
+    struct vlc_logger_async *async = data;
+
+    vlc_thread_set_name("vlc-log");
+
+    for (;;) {
+        vlc_LogAsyncDrain(async);
+
+        if (atomic_load(&async->stop))
+            break;
+
+        atomic_store(&async->sleeping, true);
+        if (vlc_LogAsyncPending(async)
+         && atomic_exchange(&async->sleeping, false))
+            continue; /* no producers will wake us up */
+        vlc_sem_wait(&async->wait);
+    }
+
+    vlc_LogAsyncDrain(async);
+    return NULL;
+}
+
+static void vlc_LogAsyncClose(void *d)
+{
+    struct vlc_logger *logger = d;
+    struct vlc_logger_async *async =
+        container_of(logger, struct vlc_logger_async, logger);
+    struct vlc_logger *backend = async->backend;
+
+    atomic_store(&async->stop, true);
+    vlc_sem_post(&async->wait);
+    vlc_join(async->thread, NULL);
+
+    backend->ops->destroy(backend);
+    free(async);
+}
+
+static int vlc_LogAsyncVerbosity(void *d)
+{
+    struct vlc_logger *logger = d;
+    struct vlc_logger_async *async =
+        container_of(logger, struct vlc_logger_async, logger);
+
+    return async->verbosity;
+}
+
+static const struct vlc_logger_operations async_ops = {
+    vlc_vaLogAsync,
+    vlc_LogAsyncClose,
+    vlc_LogAsyncVerbosity,
+};
+
+static struct vlc_logger *vlc_LogAsyncCreate(struct vlc_logger *backend)
+{
+    struct vlc_logger_async *async = malloc(sizeof (*async));
+    if (unlikely(async == NULL))
+        return NULL;
+
+    async->logger.ops = &async_ops;
+    async->backend = backend;
+    async->verbosity = vlc_LogVerbosity(backend);
+    vlc_sem_init(&async->wait, 0);
+    atomic_init(&async->sleeping, false);
+    atomic_init(&async->stop, false);
+    atomic_init(&async->dropped, 0);
+    atomic_init(&async->tail, 0);
+    async->head = 0;
+    for (size_t i = 0; i < VLC_LOG_ASYNC_SIZE; i++)
+        atomic_init(&async->records[i].seq, i);
+
+    if (vlc_clone(&async->thread, vlc_LogAsyncThread, async)) {
+        free(async);
+        return NULL;
+    }
+    return &async->logger;
+}
+
 /**
  * Initializes the messages logging subsystem and drain the early messages to
  * the configured log.
@@ -427,6 +695,11 @@ void vlc_LogInit(libvlc_int_t *vlc)
     struct vlc_logger *logger = vlc_LogModuleCreate(VLC_OBJECT(vlc));
     if (logger == NULL)
         logger = &discard_log;
+    else if (var_InheritBool(vlc, "log-async")) {
+        struct vlc_logger *async = vlc_LogAsyncCreate(logger);
+        if (async != NULL)
+            logger = async;
+    }
 
     vlc_LogSwitch(vlc->obj.logger, logger);
 }
@@ -477,9 +750,19 @@ static void vlc_vaLogHeader(void *d, int type, const vlc_log_t *item,
     parent->ops->log(parent, type, &hitem, format, ap);
 }
 
+static int vlc_LogHeaderVerbosity(void *d)
+{
+    struct vlc_logger *logger = d;
+    struct vlc_logger_header *header =
+        container_of(logger, struct vlc_logger_header, logger);
+
+    return vlc_LogVerbosity(header->parent);
+}
+
 static const struct vlc_logger_operations header_ops = {
     vlc_vaLogHeader,
     free,
+    vlc_LogHeaderVerbosity,
 };
 
 struct vlc_logger *vlc_LogHeaderCreate(struct vlc_logger *parent,
@@ -525,9 +808,19 @@ static void vlc_LogExternalClose(void *d)
     free(ext);
 }
 
+static int vlc_LogExternalVerbosity(void *d)
+{
+    struct vlc_logger_external *ext = d;
+
+    if (ext->ops->verbosity == NULL)
+        return VLC_MSG_DBG;
+    return ext->ops->verbosity(ext->opaque);
+}
+
 static const struct vlc_logger_operations external_ops = {
     vlc_vaLogExternal,
     vlc_LogExternalClose,
+    vlc_LogExternalVerbosity,
 };
 
 static struct vlc_logger *
@@ -0,0 +1,135 @@
+/**
+ * \file spsc.h Single-producer single-consumer lock-free ring
+ * \ingroup spsc
+ */
+/*****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_SPSC_H_
+#define VLC_SPSC_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/**
+ * \defgroup spsc Single-producer single-consumer ring
+ * \ingroup threads
+ *
+ * Bounded, lock-free and wait-free queue of pointers between exactly one
+ * producer thread and exactly one consumer thread.
+ *
+ * The ring does not block: callers needing to wait for data or for free space
+ * should pair it with semaphores (see \ref vlc_sem_t).
+ * @{
+ */
+
+struct vlc_spsc
+{
+    _Atomic size_t head; /**< Next slot to read (owned by the consumer) */
+    char pad[64 - sizeof (size_t)]; /**< Avoids false sharing */
+    _Atomic size_t tail; /**< Next slot to write (owned by the producer) */
+    size_t mask;
+    void **slots;
+};
+
+/**
+ * Initializes a ring.
+ *
+ * \param size number of slots (must be a power of two)
+ * \retval 0 on success
+ * \retval -1 on memory error
+ */
+static inline int vlc_spsc_Init(struct vlc_spsc *ring, size_t size)
+{
+    if (size == 0 || (size & (size - 1)) != 0)
+        return -1;
+
+    ring->slots = malloc(size * sizeof (*ring->slots));
+    if (ring->slots == NULL)
+        return -1;
+
+    ring->mask = size - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    return 0;
+}
+
+/**
+ * Deinitializes a ring.
+ *
+ * Items left in the ring, if any, are not released.
+ */
+static inline void vlc_spsc_Destroy(struct vlc_spsc *ring)
+{
+    free(ring->slots);
+}
+
+/**
+ * Enqueues an item (producer side).
+ *
+ * \return false if the ring is full, true otherwise
+ */
+static inline bool vlc_spsc_Push(struct vlc_spsc *ring, void *item)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (tail - head > ring->mask)
+        return false;
+
+    ring->slots[tail & ring->mask] = item;
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * Dequeues an item (consumer side).
+ *
+ * \param itemp storage for the dequeued item [OUT]
+ * \return false if the ring is empty, true otherwise
+ */
+static inline bool vlc_spsc_Pop(struct vlc_spsc *ring, void **itemp)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (head == tail)
+        return false;
+
+    *itemp = ring->slots[head & ring->mask];
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * Counts the queued items.
+ *
+ * The result is only an approximation if called from neither the producer
+ * nor the consumer thread.
+ */
+static inline size_t vlc_spsc_Count(struct vlc_spsc *ring)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    return tail - head;
+}
+
+/** @} */
+#endif /* !VLC_SPSC_H_ */
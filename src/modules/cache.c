@@ -36,6 +36,9 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <assert.h>
+#ifdef HAVE_SEARCH_H
+# include <search.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_block.h>
@@ -57,13 +60,27 @@
 #ifdef HAVE_DYNAMIC_PLUGINS
 /* Sub-version number
  * (only used to avoid breakage in dev version when cache structure changes) */
-#define CACHE_SUBVERSION_NUM 36
+#define CACHE_SUBVERSION_NUM 37
 
 /* Cache filename */
 #define CACHE_NAME "plugins.dat"
 /* Magic for the cache filename */
 #define CACHE_STRING "cache "PACKAGE_NAME" "PACKAGE_VERSION
+/* String table offset denoting a NULL string */
+#define CACHE_NULL_STRING UINT32_MAX
 
+/**
+ * Plugins cache string table.
+ *
+ * All strings of the cache are stored once, nul-terminated, in a single table
+ * at the end of the file. Records refer to them by offset, so that strings
+ * can be used in place from the file mapping without any parsing.
+ */
+struct vlc_cache_strtab
+{
+    const char *base;
+    size_t size;
+};
 
 static int vlc_cache_load_immediate(void *out, block_t *in, size_t size)
 {
@@ -110,27 +127,25 @@ static int vlc_cache_load_array(const void **p, size_t size, size_t n,
     return 0;
 }
 
-static int vlc_cache_load_string(const char **restrict p, block_t *file)
+static int vlc_cache_load_string(const char **restrict p, block_t *file,
+                                 const struct vlc_cache_strtab *strtab)
 {
-    uint16_t size;
+    uint32_t offset;
 
-    if (vlc_cache_load_immediate(&size, file, sizeof (size)) || size > 16384)
+    if (vlc_cache_load_immediate(&offset, file, sizeof (offset)))
         return -1;
 
-    if (size == 0)
+    if (offset == CACHE_NULL_STRING)
     {
         *p = NULL;
         return 0;
     }
 
-    const char *str = (char *)file->p_buffer;
-
-    if (file->i_buffer < size || str[size - 1] != '\0')
+    /* The table is nul-terminated: any offset within it is a valid string */
+    if (offset >= strtab->size)
         return -1;
 
-    file->p_buffer += size;
-    file->i_buffer -= size;
-    *p = str;
+    *p = strtab->base + offset;
     return 0;
 }
 
@@ -173,13 +188,14 @@ static int vlc_cache_load_align(size_t align, block_t *file)
         (a) = base; \
     } while (0)
 #define LOAD_STRING(a) \
-    if (vlc_cache_load_string(&(a), file)) \
+    if (vlc_cache_load_string(&(a), file, strtab)) \
         goto error
 #define LOAD_ALIGNOF(t) \
     if (vlc_cache_load_align(alignof(t), file)) \
         goto error
 
-static int vlc_cache_load_config(struct vlc_param *param, block_t *file)
+static int vlc_cache_load_config(struct vlc_param *param, block_t *file,
+                                 const struct vlc_cache_strtab *strtab)
 {
     module_config_t *cfg = &param->item;
 
@@ -208,9 +224,6 @@ static int vlc_cache_load_config(struct vlc_param *param, block_t *file)
         for (unsigned i = 0; i < cfg->list_count; i++)
         {
             LOAD_STRING (cfg->list.psz[i]);
-            if (cfg->list.psz[i] == NULL /* NULL -> empty string */
-             && (cfg->list.psz[i] = calloc (1, 1)) == NULL)
-                goto error;
         }
     }
     else
@@ -238,9 +251,6 @@ static int vlc_cache_load_config(struct vlc_param *param, block_t *file)
     for (unsigned i = 0; i < cfg->list_count; i++)
     {
         LOAD_STRING (cfg->list_text[i]);
-        if (cfg->list_text[i] == NULL /* NULL -> empty string */
-         && (cfg->list_text[i] = calloc (1, 1)) == NULL)
-            goto error;
     }
 
     return 0;
@@ -248,7 +258,8 @@ error:
     return -1; /* FIXME: leaks */
 }
 
-static int vlc_cache_load_plugin_config(vlc_plugin_t *plugin, block_t *file)
+static int vlc_cache_load_plugin_config(vlc_plugin_t *plugin, block_t *file,
+                                        const struct vlc_cache_strtab *strtab)
 {
     uint16_t lines;
 
@@ -276,7 +287,7 @@ static int vlc_cache_load_plugin_config(vlc_plugin_t *plugin, block_t *file)
         struct vlc_param *param = plugin->conf.params + i;
         module_config_t *item = &param->item;
 
-        if (vlc_cache_load_config(param, file))
+        if (vlc_cache_load_config(param, file, strtab))
             return -1;
 
         if (CONFIG_ITEM(item->i_type))
@@ -293,7 +304,8 @@ error:
     return -1; /* FIXME: leaks */
 }
 
-static int vlc_cache_load_module(vlc_plugin_t *plugin, block_t *file)
+static int vlc_cache_load_module(vlc_plugin_t *plugin, block_t *file,
+                                 const struct vlc_cache_strtab *strtab)
 {
     module_t *module = vlc_module_create(plugin);
     if (unlikely(module == NULL))
@@ -324,7 +336,8 @@ error:
     return -1;
 }
 
-static vlc_plugin_t *vlc_cache_load_plugin(block_t *file)
+static vlc_plugin_t *vlc_cache_load_plugin(block_t *file,
+                                           const struct vlc_cache_strtab *strtab)
 {
     vlc_plugin_t *plugin = vlc_plugin_create();
     if (unlikely(plugin == NULL))
@@ -334,10 +347,10 @@ static vlc_plugin_t *vlc_cache_load_plugin(block_t *file)
     LOAD_IMMEDIATE(modules);
 
     for (size_t i = 0; i < modules; i++)
-        if (vlc_cache_load_module(plugin, file))
+        if (vlc_cache_load_module(plugin, file, strtab))
             goto error;
 
-    if (vlc_cache_load_plugin_config(plugin, file))
+    if (vlc_cache_load_plugin_config(plugin, file, strtab))
         goto error;
 
     LOAD_STRING(plugin->textdomain);
@@ -444,11 +457,43 @@ vlc_plugin_t *vlc_cache_load(libvlc_int_t *p_this, const char *dir,
         return NULL;
     }
 
+    /* Locate the string table */
+    uint32_t strtab_offset, strtab_size;
+    size_t header_size = marker + sizeof (marker) + 2 * sizeof (uint32_t);
+
+    if (vlc_cache_load_immediate(&strtab_offset, file, sizeof (strtab_offset))
+     || vlc_cache_load_immediate(&strtab_size, file, sizeof (strtab_size))
+     || strtab_size == 0 || strtab_offset < header_size
+     || strtab_offset - header_size > file->i_buffer
+     || strtab_size != file->i_buffer - (strtab_offset - header_size))
+    {
+        msg_Warn( p_this, "This doesn't look like a valid plugins cache "
+                  "(corrupted string table)" );
+        block_Release(file);
+        return NULL;
+    }
+
+    const struct vlc_cache_strtab strtab = {
+        .base = (const char *)file->p_buffer + (strtab_offset - header_size),
+        .size = strtab_size,
+    };
+
+    if (strtab.base[strtab.size - 1] != '\0')
+    {
+        msg_Warn( p_this, "This doesn't look like a valid plugins cache "
+                  "(corrupted string table)" );
+        block_Release(file);
+        return NULL;
+    }
+
+    /* Only parse the plugin records that precede the string table */
+    file->i_buffer = strtab_offset - header_size;
+
     vlc_plugin_t *cache = NULL;
 
     while (file->i_buffer > 0)
     {
-        vlc_plugin_t *plugin = vlc_cache_load_plugin(file);
+        vlc_plugin_t *plugin = vlc_cache_load_plugin(file, &strtab);
         if (plugin == NULL)
             goto error;
 
@@ -485,21 +530,93 @@ error:
         SAVE_IMMEDIATE(b); \
     } while (0)
 
-static int CacheSaveString (FILE *file, const char *str)
+/** String table under construction */
+struct vlc_cache_strtab_writer
+{
+    void *root; /**< Tree of already stored strings */
+    char *data;
+    size_t size;
+    size_t capacity;
+};
+
+struct vlc_cache_strtab_entry
+{
+    uint32_t offset;
+    const char *str;
+};
+
+static int CacheStrtabCompare(const void *a, const void *b)
+{
+    const struct vlc_cache_strtab_entry *ea = a, *eb = b;
+    return strcmp(ea->str, eb->str);
+}
+
+/**
+ * Adds a string to the string table (unless already present).
+ * @return the offset of the string within the table, or UINT32_MAX on error.
+ */
+static uint32_t CacheStrtabAdd(struct vlc_cache_strtab_writer *strtab,
+                               const char *str)
 {
-    uint16_t size = (str != NULL) ? (strlen (str) + 1) : 0;
+    struct vlc_cache_strtab_entry key = { .str = str };
+    void **node = tfind(&key, &strtab->root, CacheStrtabCompare);
+    if (node != NULL)
+        return (*(const struct vlc_cache_strtab_entry **)node)->offset;
 
-    SAVE_IMMEDIATE (size);
-    if (size != 0 && fwrite(str, 1, size, file) != size)
+    size_t len = strlen(str) + 1;
+    if (strtab->size + len >= CACHE_NULL_STRING)
+        return CACHE_NULL_STRING;
+
+    if (strtab->size + len > strtab->capacity)
     {
-error:
-        return -1;
+        size_t capacity = strtab->capacity ? strtab->capacity : 65536;
+        while (capacity < strtab->size + len)
+            capacity *= 2;
+
+        char *data = realloc(strtab->data, capacity);
+        if (unlikely(data == NULL))
+            return CACHE_NULL_STRING;
+        strtab->data = data;
+        strtab->capacity = capacity;
+    }
+
+    struct vlc_cache_strtab_entry *ent = malloc(sizeof (*ent));
+    if (unlikely(ent == NULL))
+        return CACHE_NULL_STRING;
+
+    ent->offset = strtab->size;
+    ent->str = str;
+    if (unlikely(tsearch(ent, &strtab->root, CacheStrtabCompare) == NULL))
+    {
+        free(ent);
+        return CACHE_NULL_STRING;
+    }
+
+    memcpy(strtab->data + strtab->size, str, len);
+    strtab->size += len;
+    return ent->offset;
+}
+
+static int CacheSaveString (FILE *file, const char *str,
+                            struct vlc_cache_strtab_writer *strtab)
+{
+    uint32_t offset = CACHE_NULL_STRING;
+
+    if (str != NULL)
+    {
+        offset = CacheStrtabAdd(strtab, str);
+        if (offset == CACHE_NULL_STRING)
+            goto error;
     }
+
+    SAVE_IMMEDIATE (offset);
     return 0;
+error:
+    return -1;
 }
 
 #define SAVE_STRING( a ) \
-    if (CacheSaveString (file, (a))) \
+    if (CacheSaveString (file, (a), strtab)) \
         goto error
 
 static int CacheSaveAlign(FILE *file, size_t align)
@@ -518,7 +635,8 @@ static int CacheSaveAlign(FILE *file, size_t align)
     if (CacheSaveAlign(file, alignof (t))) \
         goto error
 
-static int CacheSaveConfig(FILE *file, const struct vlc_param *param)
+static int CacheSaveConfig(FILE *file, const struct vlc_param *param,
+                           struct vlc_cache_strtab_writer *strtab)
 {
     const module_config_t *cfg = &param->item;
 
@@ -538,8 +656,8 @@ static int CacheSaveConfig(FILE *file, const struct vlc_param *param)
     {
         SAVE_STRING (cfg->orig.psz);
 
-        for (unsigned i = 0; i < cfg->list_count; i++)
-            SAVE_STRING (cfg->list.psz[i]);
+        for (unsigned i = 0; i < cfg->list_count; i++) /* NULL -> empty */
+            SAVE_STRING (cfg->list.psz[i] != NULL ? cfg->list.psz[i] : "");
     }
     else
     {
@@ -555,22 +673,23 @@ static int CacheSaveConfig(FILE *file, const struct vlc_param *param)
         for (unsigned i = 0; i < cfg->list_count; i++)
              SAVE_IMMEDIATE (cfg->list.i[i]);
     }
-    for (unsigned i = 0; i < cfg->list_count; i++)
-        SAVE_STRING (cfg->list_text[i]);
+    for (unsigned i = 0; i < cfg->list_count; i++) /* NULL -> empty */
+        SAVE_STRING (cfg->list_text[i] != NULL ? cfg->list_text[i] : "");
 
     return 0;
 error:
     return -1;
 }
 
-static int CacheSaveModuleConfig(FILE *file, const vlc_plugin_t *plugin)
+static int CacheSaveModuleConfig(FILE *file, const vlc_plugin_t *plugin,
+                                 struct vlc_cache_strtab_writer *strtab)
 {
     uint16_t lines = plugin->conf.size;
 
     SAVE_IMMEDIATE (lines);
 
     for (size_t i = 0; i < lines; i++)
-        if (CacheSaveConfig(file, plugin->conf.params + i))
+        if (CacheSaveConfig(file, plugin->conf.params + i, strtab))
            goto error;
 
     return 0;
@@ -578,7 +697,8 @@ error:
     return -1;
 }
 
-static int CacheSaveModule(FILE *file, const module_t *module)
+static int CacheSaveModule(FILE *file, const module_t *module,
+                           struct vlc_cache_strtab_writer *strtab)
 {
     SAVE_STRING(module->psz_shortname);
     SAVE_STRING(module->psz_longname);
@@ -598,9 +718,12 @@ error:
     return -1;
 }
 
-static int CacheSaveBank(FILE *file, vlc_plugin_t *const *cache, size_t n)
+static int CacheSaveBank(FILE *file, vlc_plugin_t *const *cache, size_t n,
+                         struct vlc_cache_strtab_writer *strtab)
 {
     uint32_t i_file_size = 0;
+    uint32_t strtab_pos[2] = { 0, 0 };
+    long strtab_header;
 
     /* Contains version number */
     if (fputs (CACHE_STRING, file) == EOF)
@@ -621,6 +744,10 @@ static int CacheSaveBank(FILE *file, vlc_plugin_t *const *cache, size_t n)
     if (fwrite (&i_file_size, sizeof (i_file_size), 1, file) != 1)
         goto error;
 
+    /* String table offset and size (filled in once known) */
+    strtab_header = ftell(file);
+    SAVE_IMMEDIATE(strtab_pos);
+
     for (size_t i = 0; i < n; i++)
     {
         const vlc_plugin_t *plugin = cache[i];
@@ -631,11 +758,11 @@ static int CacheSaveBank(FILE *file, vlc_plugin_t *const *cache, size_t n)
         for (module_t *module = plugin->module;
              module != NULL;
              module = module->next)
-            if (CacheSaveModule(file, module))
+            if (CacheSaveModule(file, module, strtab))
                 goto error;
 
         /* Config stuff */
-        if (CacheSaveModuleConfig(file, plugin))
+        if (CacheSaveModuleConfig(file, plugin, strtab))
             goto error;
 
         /* Save common info */
@@ -646,6 +773,22 @@ static int CacheSaveBank(FILE *file, vlc_plugin_t *const *cache, size_t n)
         SAVE_IMMEDIATE(plugin->size);
     }
 
+    /* String table */
+    long offset = ftell(file);
+    if (offset < 0 || (unsigned long)offset > UINT32_MAX - strtab->size)
+        goto error;
+
+    if (strtab->size == 0 && CacheStrtabAdd(strtab, "") == CACHE_NULL_STRING)
+        goto error;
+    if (fwrite(strtab->data, 1, strtab->size, file) != strtab->size)
+        goto error;
+
+    strtab_pos[0] = offset;
+    strtab_pos[1] = strtab->size;
+    if (fseek(file, strtab_header, SEEK_SET))
+        goto error;
+    SAVE_IMMEDIATE(strtab_pos);
+
     if (fflush (file)) /* flush libc buffers */
         goto error;
     return 0; /* success! */
@@ -681,7 +824,15 @@ void CacheSave(libvlc_int_t *p_this, const char *dir,
         goto out;
     }
 
-    if (CacheSaveBank(file, entries, n))
+    struct vlc_cache_strtab_writer strtab = {
+        .root = NULL, .data = NULL, .size = 0, .capacity = 0,
+    };
+    int ret = CacheSaveBank(file, entries, n, &strtab);
+
+    tdestroy(strtab.root, free);
+    free(strtab.data);
+
+    if (ret)
     {
         msg_Warn (p_this, "cannot write %s: %s", tmpname,
                   vlc_strerror_c(errno));
@@ -48,6 +48,7 @@
 #include <vlc_block.h>
 #include <vlc_frame.h>
 #include <vlc_codec.h>
+#include <vlc_membudget.h>
 #include <vlc_modules.h>
 
 #include "input/input_interface.h"
@@ -393,11 +394,20 @@ void sout_MuxDelete( sout_mux_t *p_mux )
     vlc_object_delete(p_mux);
 }
 
+struct sout_input_private {
+    sout_input_t input;
+    size_t i_budget; /* bytes of the fifo reported to the memory budget */
+};
+
+#define sout_input_priv(i) \
+        container_of(i, struct sout_input_private, input)
+
 /*****************************************************************************
  * sout_MuxAddStream:
  *****************************************************************************/
 sout_input_t *sout_MuxAddStream( sout_mux_t *p_mux, const es_format_t *p_fmt )
 {
+    struct sout_input_private *p_priv;
     sout_input_t *p_input;
 
     if( !p_mux->b_add_stream_any_time && !p_mux->b_waiting_stream )
@@ -410,9 +420,10 @@ sout_input_t *sout_MuxAddStream( sout_mux_t *p_mux, const es_format_t *p_fmt )
     msg_Dbg( p_mux, "adding a new input" );
 
     /* create a new sout input */
-    p_input = malloc( sizeof( sout_input_t ) );
-    if( !p_input )
+    p_priv = malloc( sizeof( *p_priv ) );
+    if( !p_priv )
         return NULL;
+    p_input = &p_priv->input;
 
     // FIXME: remove either fmt or p_fmt...
     es_format_Copy( &p_input->fmt, p_fmt );
@@ -420,6 +431,7 @@ sout_input_t *sout_MuxAddStream( sout_mux_t *p_mux, const es_format_t *p_fmt )
 
     p_input->p_fifo = block_FifoNew();
     p_input->p_sys  = NULL;
+    p_priv->i_budget = 0;
 
     TAB_APPEND( p_mux->i_nb_inputs, p_mux->pp_inputs, p_input );
     if( p_mux->pf_addstream( p_mux, p_input ) < 0 )
@@ -428,7 +440,7 @@ sout_input_t *sout_MuxAddStream( sout_mux_t *p_mux, const es_format_t *p_fmt )
         TAB_REMOVE( p_mux->i_nb_inputs, p_mux->pp_inputs, p_input );
         block_FifoRelease( p_input->p_fifo );
         es_format_Clean( &p_input->fmt );
-        free( p_input );
+        free( p_priv );
         return NULL;
     }
 
@@ -463,12 +475,30 @@ void sout_MuxDeleteStream( sout_mux_t *p_mux, sout_input_t *p_input )
             msg_Warn( p_mux, "no more input streams for this mux" );
         }
 
+        struct sout_input_private *p_priv = sout_input_priv( p_input );
+
+        vlc_membudget_Remove( p_mux, VLC_MEMBUDGET_SOUT, p_priv->i_budget );
         block_FifoRelease( p_input->p_fifo );
         es_format_Clean( &p_input->fmt );
-        free( p_input );
+        free( p_priv );
     }
 }
 
+/* Reports the data waiting in an input of a muxer to the memory budget */
+static void InputUpdateBudget( sout_mux_t *p_mux, sout_input_t *p_input,
+                               size_t i_bytes )
+{
+    struct sout_input_private *p_priv = sout_input_priv( p_input );
+
+    if( i_bytes > p_priv->i_budget )
+        vlc_membudget_Add( p_mux, VLC_MEMBUDGET_SOUT,
+                           i_bytes - p_priv->i_budget );
+    else
+        vlc_membudget_Remove( p_mux, VLC_MEMBUDGET_SOUT,
+                              p_priv->i_budget - i_bytes );
+    p_priv->i_budget = i_bytes;
+}
+
 /*****************************************************************************
  * sout_MuxSendBuffer:
  *****************************************************************************/
@@ -476,7 +506,14 @@ int sout_MuxSendBuffer( sout_mux_t *p_mux, sout_input_t *p_input,
                          block_t *p_buffer )
 {
     vlc_tick_t i_dts = p_buffer->i_dts;
-    block_FifoPut( p_input->p_fifo, p_buffer );
+
+    /* What the muxer left of the previous buffers is what actually waits.
+     * It is measured while queueing, rather than locking every input. */
+    vlc_fifo_Lock( p_input->p_fifo );
+    size_t i_bytes = vlc_fifo_GetBytes( p_input->p_fifo );
+    vlc_fifo_QueueUnlocked( p_input->p_fifo, p_buffer );
+    vlc_fifo_Unlock( p_input->p_fifo );
+    InputUpdateBudget( p_mux, p_input, i_bytes );
 
     if( i_dts == VLC_TICK_INVALID )
         i_dts = p_buffer->i_pts;
@@ -498,8 +535,8 @@ int sout_MuxSendBuffer( sout_mux_t *p_mux, sout_input_t *p_input,
 
 void sout_MuxFlush( sout_mux_t *p_mux, sout_input_t *p_input )
 {
-    VLC_UNUSED(p_mux);
     block_FifoEmpty( p_input->p_fifo );
+    InputUpdateBudget( p_mux, p_input, 0 );
 }
 
 /*****************************************************************************
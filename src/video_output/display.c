@@ -267,9 +267,6 @@ static bool PlaceVideoInDisplay(vout_display_priv_t *osys)
     return !vout_display_PlaceEquals(&prev_place, &osys->src_place);
 }
 
-/*****************************************************************************
- * FIXME/TODO see how to have direct rendering here (interact with vout.c)
- *****************************************************************************/
 static picture_t *SourceConverterBuffer(filter_t *filter)
 {
     vout_display_t *vd = filter->owner.sys;
@@ -305,14 +302,19 @@ static struct pooled_filter_chain *VoutSetupConverter(vlc_object_t *o,
                               filter_owner_t *owner,
                               const video_format_t *fmt_in,
                               vlc_video_context *vctx_in,
-                              const video_format_t *fmt_out)
+                              const video_format_t *fmt_out,
+                              picture_pool_t *pool)
 {
     struct pooled_filter_chain *conv = malloc(sizeof(*conv));
     if (unlikely(conv == NULL))
+    {
+        if (pool != NULL)
+            picture_pool_Release(pool);
         return NULL;
+    }
 
     // 1 for current converter + 1 for previously displayed
-    conv->pool = picture_pool_NewFromFormat(fmt_out, 1+1);
+    conv->pool = pool ? pool : picture_pool_NewFromFormat(fmt_out, 1+1);
     if (unlikely(conv->pool == NULL))
     {
         msg_Err(o, "Failed to allocate converter pool");
@@ -375,8 +377,14 @@ static int VoutDisplayCreateRender(vout_display_t *vd)
     msg_Dbg(vd, "A filter to adapt decoder %4.4s to display %4.4s is needed",
             (const char *)&v_src.i_chroma, (const char *)&v_dst.i_chroma);
 
+    /* Convert directly into the display pictures, if possible */
+    picture_pool_t *pool = NULL;
+    if (vd->ops->pool != NULL)
+        pool = vd->ops->pool(vd, 1+1);
+
     osys->converter = VoutSetupConverter(VLC_OBJECT(vd), &owner,
-                                 &v_src, osys->src_vctx, &osys->display_fmt);
+                                 &v_src, osys->src_vctx, &osys->display_fmt,
+                                 pool);
     if (osys->converter == NULL) {
         msg_Err(vd, "Failed to adapt decoder format to display");
         return VLC_ENOTSUP;
@@ -409,6 +417,52 @@ static void VoutDisplayCropRatio(unsigned *left, unsigned *top, unsigned *right,
     }
 }
 
+picture_pool_t *vout_GetDisplayPool(vout_display_t *vd,
+                                    const video_format_t *fmt, unsigned count)
+{
+    vout_display_priv_t *osys = container_of(vd, vout_display_priv_t, display);
+
+    /* The pictures are rendered into, not converted */
+    if (vd->ops->pool == NULL || osys->converter != NULL)
+        return NULL;
+    if (!video_format_IsSameChroma(fmt, vd->fmt)
+     || fmt->i_width != vd->fmt->i_width || fmt->i_height != vd->fmt->i_height)
+        return NULL;
+
+    const vlc_chroma_description_t *dsc =
+        vlc_fourcc_GetChromaDescription(fmt->i_chroma);
+    if (dsc == NULL || dsc->plane_count == 0)
+        return NULL;
+
+    picture_pool_t *pool = vd->ops->pool(vd, count);
+    if (pool == NULL)
+        return NULL;
+
+    /* Each plane must hold the whole picture */
+    picture_t *pic = picture_pool_Get(pool);
+    bool fits = pic != NULL && (unsigned)pic->i_planes == dsc->plane_count;
+    for (unsigned i = 0; fits && i < dsc->plane_count; i++)
+    {
+        uint64_t pitch = (uint64_t)fmt->i_width * dsc->p[i].w.num
+                         / dsc->p[i].w.den * dsc->pixel_size;
+        uint64_t lines = (uint64_t)fmt->i_height * dsc->p[i].h.num
+                         / dsc->p[i].h.den;
+
+        fits = (uint64_t)pic->p[i].i_pitch >= pitch
+            && (uint64_t)pic->p[i].i_lines >= lines;
+    }
+    if (pic != NULL)
+        picture_Release(pic);
+
+    if (!fits)
+    {
+        msg_Dbg(vd, "display pictures planes too small to render into");
+        picture_pool_Release(pool);
+        return NULL;
+    }
+    return pool;
+}
+
 picture_t *vout_ConvertForDisplay(vout_display_t *vd, picture_t *picture)
 {
     vout_display_priv_t *osys = container_of(vd, vout_display_priv_t, display);
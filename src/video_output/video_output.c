@@ -2386,3 +2386,16 @@ vlc_decoder_device *vout_GetDevice(vout_thread_t *vout)
     vlc_mutex_unlock(&sys->window_lock);
     return dec_device;
 }
+
+picture_pool_t *vout_GetPool(vout_thread_t *vout, const video_format_t *fmt,
+                             unsigned count)
+{
+    vout_thread_sys_t *sys = VOUT_THREAD_TO_SYS(vout);
+    picture_pool_t *pool = NULL;
+
+    vlc_queuedmutex_lock(&sys->display_lock);
+    if (sys->display != NULL)
+        pool = vout_GetDisplayPool(sys->display, fmt, count);
+    vlc_queuedmutex_unlock(&sys->display_lock);
+    return pool;
+}
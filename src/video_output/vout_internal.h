@@ -57,6 +57,20 @@ vout_thread_t *vout_CreateDummy(vlc_object_t *obj) VLC_USED;
  */
 vlc_decoder_device *vout_GetDevice(vout_thread_t *vout);
 
+/**
+ * Gets a pool of pictures the decoder can render directly into.
+ *
+ * This succeeds only if the display can provide pictures in the decoder
+ * output format, so that no conversion nor copy is needed.
+ *
+ * \param fmt the decoder output format
+ * \param count minimum number of pictures
+ * \return a picture pool, or NULL to use a pool allocated by the caller
+ */
+struct picture_pool_t *vout_GetPool(vout_thread_t *vout,
+                                    const video_format_t *fmt,
+                                    unsigned count);
+
 /**
  * Returns a suitable vout or release the given one.
  *
@@ -57,6 +57,7 @@ typedef struct {
     vlc_tick_t orgstop;
     vlc_tick_t start; /* current entry rendering time, */
     vlc_tick_t stop;  /* set to subpicture at rendering time */
+    uint64_t seq; /* enqueue order within the channel */
     bool is_late;
     enum vlc_vout_order channel_order;
 } spu_render_entry_t;
@@ -64,7 +65,8 @@ typedef struct {
 typedef struct VLC_VECTOR(spu_render_entry_t) spu_render_vector;
 
 struct spu_channel {
-    spu_render_vector entries;
+    spu_render_vector entries; /* sorted by original start time */
+    uint64_t next_seq;
     size_t id;
     enum vlc_vout_order order;
     vlc_clock_t *clock;
@@ -155,6 +157,7 @@ static void spu_channel_Init(struct spu_channel *channel, size_t id,
     channel->delay = 0;
     channel->rate = 1.f;
     channel->order = order;
+    channel->next_seq = 0;
 
     vlc_vector_init(&channel->entries);
 }
@@ -168,8 +171,18 @@ static int spu_channel_Push(struct spu_channel *channel, subpicture_t *subpic,
         .orgstop = orgstop,
         .start = subpic->i_start,
         .stop = subpic->i_stop,
+        .seq = channel->next_seq++,
     };
-    return vlc_vector_push(&channel->entries, entry) ? VLC_SUCCESS : VLC_EGENERIC;
+
+    /* Keep the entries sorted by start time, so that the selection can stop
+     * at the first entry that is not yet displayable. Subpictures are mostly
+     * received in order, so look for the insertion point from the end. */
+    size_t index = channel->entries.size;
+    while (index > 0 && channel->entries.data[index - 1].orgstart > orgstart)
+        index--;
+
+    return vlc_vector_insert(&channel->entries, index, entry) ? VLC_SUCCESS
+                                                              : VLC_EGENERIC;
 }
 
 static void spu_Channel_CleanEntry(spu_private_t *sys, spu_render_entry_t *entry)
@@ -209,12 +222,19 @@ static void spu_channel_EarlyRemoveLate(spu_private_t *sys,
     /* Find first display time that will expire ephemer SPU and store it's enqueue
      * order. Ephemer really expires on next SPU activation, or if it has a valid
      * stop time */
-    const spu_render_entry_t *last = &channel->entries.data[channel->entries.size-1];
+    size_t last_index = 0;
+    for (size_t i = 1; i < channel->entries.size; i++)
+        if (channel->entries.data[i].seq > channel->entries.data[last_index].seq)
+            last_index = i;
+
+    const spu_render_entry_t *last = &channel->entries.data[last_index];
     vlc_tick_t minactivespu = last->start;
     int64_t minactivespuorder = last->subpic->i_order;
-    for (size_t i = 0; i < channel->entries.size - 1; i++)
+    for (size_t i = 0; i < channel->entries.size; i++)
     {
         const spu_render_entry_t *entry = &channel->entries.data[i];
+        if (i == last_index)
+            continue;
         if(!entry->subpic->b_ephemer &&
            spu_HasAlreadyExpired(entry->start, entry->stop, system_now))
             continue;
@@ -750,7 +770,9 @@ static int SpuRenderCmp(const void *s0, const void *s1)
     subpicture_t *subpic1 = render_entry1->subpic;
     int r;
 
-    r = IntegerCmp(subpic0->i_start, subpic1->i_start);
+    /* The subpicture start date is only set to the converted entry start date
+     * before rendering, after the selection sorted them */
+    r = IntegerCmp(render_entry0->start, render_entry1->start);
     if (!r)
         r = SSizeCmp(subpic0->i_channel, subpic1->i_channel);
     if (!r)
@@ -758,22 +780,37 @@ static int SpuRenderCmp(const void *s0, const void *s1)
     return r;
 }
 
+/**
+ * Converts the entries timestamps to system time.
+ *
+ * As the entries are sorted by start time, the conversion stops after the
+ * first entry starting later than the given date. The following entries are
+ * not displayable yet and keep their previous dates.
+ *
+ * \return the number of entries with up to date timestamps
+ */
 static size_t spu_channel_UpdateDates(struct spu_channel *channel,
-                                       vlc_tick_t system_now)
+                                       vlc_tick_t system_now,
+                                       vlc_tick_t until)
 {
-    /* Put every spu start and stop ts into the same array to convert them in
-     * one shot */
     if (channel->entries.size == 0)
         return 0;
 
     if (!channel->clock)
-        goto end;
+    {
+        /* No conversion, only count the entries already started */
+        size_t count = 0;
+        while (count < channel->entries.size
+            && channel->entries.data[count].start <= until)
+            count++;
+        return count;
+    }
 
+    size_t count = 0;
     vlc_clock_Lock(channel->clock);
-    spu_render_entry_t *entry;
-    vlc_vector_foreach_ref(entry, &channel->entries)
+    while (count < channel->entries.size)
     {
-        assert(entry);
+        spu_render_entry_t *entry = &channel->entries.data[count];
 
         entry->start = vlc_clock_ConvertToSystem(channel->clock, system_now,
                                                  entry->orgstart, channel->rate,
@@ -783,11 +820,48 @@ static size_t spu_channel_UpdateDates(struct spu_channel *channel,
             vlc_clock_ConvertToSystem(channel->clock, system_now,
                                       entry->orgstop, channel->rate,
                                       NULL);
+        if (entry->start > until)
+            break;
+        count++;
     }
     vlc_clock_Unlock(channel->clock);
 
-end:
-    return channel->entries.size;
+    return count;
+}
+
+/**
+ * Merges the sorted run array[middle..count) into the sorted run
+ * array[0..middle), using tmp as scratch space.
+ */
+static void spu_render_entries_Merge(spu_render_entry_t *array, size_t middle,
+                                     size_t count, spu_render_entry_t *tmp)
+{
+    size_t run_size = count - middle;
+
+    /* Channel entries are sorted by start time, but a tie can still be
+     * broken in reverse creation order */
+    for (size_t i = middle + 1; i < count; i++)
+        if (SpuRenderCmp(&array[i - 1], &array[i]) > 0)
+        {
+            qsort(&array[middle], run_size, sizeof (*array), SpuRenderCmp);
+            break;
+        }
+
+    if (middle == 0
+     || SpuRenderCmp(&array[middle - 1], &array[middle]) <= 0)
+        return; /* already in order */
+
+    /* Merge backward, the head of the array is left in place */
+    memcpy(tmp, &array[middle], run_size * sizeof (*array));
+
+    size_t i = middle, j = run_size, k = count;
+    while (j > 0)
+    {
+        if (i > 0 && SpuRenderCmp(&array[i - 1], &tmp[j - 1]) > 0)
+            array[--k] = array[--i];
+        else
+            array[--k] = tmp[--j];
+    }
 }
 
 static bool
@@ -835,11 +909,15 @@ spu_SelectSubpictures(spu_t *spu, vlc_tick_t system_now,
     if (total_size == 0)
         return NULL;
 
+    /* The second half is used as scratch space to merge the channels */
     spu_render_entry_t *subpicture_array =
-        vlc_alloc(total_size, sizeof(spu_render_entry_t));
+        vlc_alloc(total_size, 2 * sizeof(spu_render_entry_t));
     if (!subpicture_array)
         return NULL;
 
+    /* Entries starting after this date cannot be selected */
+    const vlc_tick_t max_render_date = __MAX(render_subtitle_date, system_now);
+
     /* Fill up the subpicture_array arrays with relevant pictures */
     for (size_t i = 0; i < sys->channels.size; i++)
     {
@@ -850,12 +928,14 @@ spu_SelectSubpictures(spu_t *spu, vlc_tick_t system_now,
         vlc_tick_t   ephemer_osd_date = 0;
         int64_t      selected_max_order = INT64_MIN;
 
-        if (spu_channel_UpdateDates(channel, system_now) == 0)
+        size_t started = spu_channel_UpdateDates(channel, system_now,
+                                                 max_render_date);
+        if (started == 0)
             continue;
 
         /* Select available pictures */
-        spu_render_entry_t *render_entry;
-        vlc_vector_foreach_ref(render_entry, &channel->entries) {
+        for (size_t index = 0; index < started; index++) {
+            spu_render_entry_t *render_entry = &channel->entries.data[index];
             subpicture_t *current = render_entry->subpic;
             const vlc_tick_t render_date = current->b_subtitle ? render_subtitle_date : system_now;
 
@@ -891,8 +971,9 @@ spu_SelectSubpictures(spu_t *spu, vlc_tick_t system_now,
             start_date = VLC_TICK_MAX;
 
         /* Select pictures to be displayed */
-        for (size_t index = 0; index < channel->entries.size; ) {
-            render_entry = &channel->entries.data[index];
+        const size_t run_start = *subpicture_count;
+        for (size_t index = 0; index < started; ) {
+            spu_render_entry_t *render_entry = &channel->entries.data[index];
             subpicture_t *current = render_entry->subpic;
             const vlc_tick_t render_date = current->b_subtitle ? render_subtitle_date : system_now;
 
@@ -920,6 +1001,7 @@ spu_SelectSubpictures(spu_t *spu, vlc_tick_t system_now,
             {
                 spu_Channel_CleanEntry(sys, render_entry);
                 vlc_vector_remove(&channel->entries, index);
+                started--;
             }
             else
             {
@@ -928,6 +1010,11 @@ spu_SelectSubpictures(spu_t *spu, vlc_tick_t system_now,
                 index++;
             }
         }
+
+        /* Channels are visited in registration order, not by identifier */
+        spu_render_entries_Merge(subpicture_array, run_start,
+                                 *subpicture_count,
+                                 &subpicture_array[total_size]);
     }
 
     sys->last_sort_date = render_subtitle_date;
@@ -2133,6 +2220,7 @@ void spu_PutSubpicture(spu_t *spu, subpicture_t *subpic)
                                       orgstop, channel->rate, NULL);
         vlc_clock_Unlock(channel->clock);
 
+        spu_channel_UpdateDates(channel, system_now, VLC_TICK_MAX);
         spu_channel_EarlyRemoveLate(sys, channel, system_now);
 
         /* Maybe the new one is also already expired */
@@ -2295,9 +2383,8 @@ vlc_render_subpicture *spu_Render(spu_t *spu,
                           subpic->b_subtitle ? render_subtitle_date : system_now);
     }
 
-    /* Now order the subpicture array
+    /* The subpicture array is already sorted by spu_SelectSubpictures()
      * XXX The order is *really* important for overlap subtitles positioning */
-    qsort(subpicture_array, subpicture_count, sizeof(*subpicture_array), SpuRenderCmp);
 
     /* Render the subpictures */
     vlc_render_subpicture *render = SpuRenderSubpictures(spu,
@@ -29,6 +29,9 @@
 struct vout_crop;
 
 picture_t * vout_ConvertForDisplay(vout_display_t *, picture_t *);
+struct picture_pool_t *vout_GetDisplayPool(vout_display_t *,
+                                           const video_format_t *,
+                                           unsigned count);
 void vout_FilterFlush(vout_display_t *);
 
 void vout_SetDisplayFitting(vout_display_t *, enum vlc_video_fitting);
@@ -631,6 +631,143 @@ static void test_media_player_programs(const char** argv, int argc)
     libvlc_release (vlc);
 }
 
+#define BUFFER_COUNT  8
+#define BUFFER_WIDTH  640
+#define BUFFER_HEIGHT 480
+
+struct buffers_ctx
+{
+    uint8_t *buffers[BUFFER_COUNT];
+    uint8_t *locked;
+    unsigned direct;
+    unsigned copied;
+    bool cleaned;
+    vlc_sem_t sem_direct;
+};
+
+static const size_t buffer_size = BUFFER_WIDTH * BUFFER_HEIGHT * 3 / 2;
+
+static void buffers_planes(uint8_t *buffer, void **planes)
+{
+    planes[0] = buffer;
+    planes[1] = buffer + BUFFER_WIDTH * BUFFER_HEIGHT;
+    planes[2] = buffer + BUFFER_WIDTH * BUFFER_HEIGHT * 5 / 4;
+}
+
+static unsigned buffers_format(void **opaque, char *chroma,
+                               unsigned *width, unsigned *height,
+                               unsigned *pitches, unsigned *lines)
+{
+    (void) opaque;
+    /* Same as the mock video, so that nothing needs converting */
+    assert(!strcmp(chroma, "I420"));
+    assert(width[0] == BUFFER_WIDTH && height[0] == BUFFER_HEIGHT);
+
+    pitches[0] = BUFFER_WIDTH;
+    pitches[1] = pitches[2] = BUFFER_WIDTH / 2;
+    lines[0] = BUFFER_HEIGHT;
+    lines[1] = lines[2] = BUFFER_HEIGHT / 2;
+    return BUFFER_COUNT;
+}
+
+static void *buffers_get(void *opaque, unsigned index, void **planes)
+{
+    struct buffers_ctx *ctx = opaque;
+
+    assert(index < BUFFER_COUNT);
+    buffers_planes(ctx->buffers[index], planes);
+    return ctx->buffers[index];
+}
+
+static void *buffers_lock(void *opaque, void **planes)
+{
+    struct buffers_ctx *ctx = opaque;
+
+    buffers_planes(ctx->locked, planes);
+    return ctx->locked;
+}
+
+static void buffers_display(void *opaque, void *id)
+{
+    struct buffers_ctx *ctx = opaque;
+
+    if (id == ctx->locked)
+    {
+        ctx->copied++;
+        return;
+    }
+
+    bool found = false;
+    for (unsigned i = 0; i < BUFFER_COUNT; i++)
+        found |= id == ctx->buffers[i];
+    assert(found);
+
+    if (ctx->direct++ == 0)
+        vlc_sem_post(&ctx->sem_direct);
+}
+
+static void buffers_cleanup(void *opaque)
+{
+    struct buffers_ctx *ctx = opaque;
+
+    assert(!ctx->cleaned);
+    ctx->cleaned = true;
+}
+
+static void test_media_player_buffers(const char** argv, int argc)
+{
+    test_log ("Testing rendering into application buffers\n");
+
+    const char file[] = "mock://video_track_count=1;length=100000000";
+
+    /* The mock video is raw, so that it is decoded into the buffers */
+    const char *new_argv[argc+1];
+    for (int i = 0; i < argc; ++i)
+        new_argv[i] = argv[i];
+    new_argv[argc++] = "--codec=rawvideo,none";
+
+    struct buffers_ctx ctx = { .cleaned = false };
+    for (unsigned i = 0; i < BUFFER_COUNT; i++)
+    {
+        ctx.buffers[i] = malloc(buffer_size);
+        assert(ctx.buffers[i] != NULL);
+    }
+    ctx.locked = malloc(buffer_size);
+    assert(ctx.locked != NULL);
+    vlc_sem_init(&ctx.sem_direct, 0);
+
+    libvlc_instance_t *vlc = libvlc_new (argc, new_argv);
+    assert (vlc != NULL);
+    libvlc_media_t *md = libvlc_media_new_location(file);
+    assert (md != NULL);
+    libvlc_media_player_t *mp = libvlc_media_player_new_from_media (vlc, md);
+    assert (mp != NULL);
+    libvlc_media_release (md);
+
+    libvlc_video_set_callbacks(mp, buffers_lock, NULL, buffers_display, &ctx);
+    libvlc_video_set_format_callbacks(mp, buffers_format, buffers_cleanup);
+    libvlc_video_set_buffer_callback(mp, buffers_get);
+
+    play_and_wait(mp);
+
+    /* Pictures are displayed from the application buffers */
+    vlc_sem_wait(&ctx.sem_direct);
+
+    libvlc_media_player_stop_async (mp);
+    libvlc_media_player_release (mp);
+    libvlc_release (vlc);
+
+    test_log("%u pictures rendered directly, %u copied\n", ctx.direct,
+             ctx.copied);
+    assert(ctx.direct > 0);
+    /* The buffers are released once no picture refers to them */
+    assert(ctx.cleaned);
+
+    free(ctx.locked);
+    for (unsigned i = 0; i < BUFFER_COUNT; i++)
+        free(ctx.buffers[i]);
+}
+
 /* Regression test when having multiple libvlc instances */
 static void test_media_player_multiple_instance(const char** argv, int argc)
 {
@@ -668,6 +805,7 @@ int main (void)
     test_media_player_pause_stop (test_defaults_args, test_defaults_nargs);
     test_media_player_tracks (test_defaults_args, test_defaults_nargs);
     test_media_player_programs (test_defaults_args, test_defaults_nargs);
+    test_media_player_buffers (test_defaults_args, test_defaults_nargs);
     test_media_player_multiple_instance (test_defaults_args, test_defaults_nargs);
 
     return 0;
@@ -63,6 +63,13 @@ static const char test_default_sample[] = "mock://";
 
 #define test_log( ... ) printf( "testapi: " __VA_ARGS__ );
 
+/* Reproducible pseudo-random numbers, for generated test data */
+static inline uint32_t test_rand(uint32_t *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 8;
+}
+
 static inline void test_setup(void)
 {
     setenv("VLC_PLUGIN_PATH", TOP_BUILDDIR"/modules", 1);
@@ -0,0 +1,157 @@
+/*****************************************************************************
+ * file.c: file access output data move test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+#include "../../../lib/libvlc_internal.h"
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_fs.h>
+#include <vlc_sout.h>
+
+/* Size of the synthetic recording in MiB. Set VLC_TEST_MOVE_SIZE (and
+ * VLC_TEST_TIMEOUT) to benchmark multi-GB files. */
+#define DEFAULT_SIZE_MB 32
+#define HEADER_SIZE 4096
+#define BLOCK_SIZE (1 << 20)
+#define SLOW_CHUNK_SIZE 32768
+
+static uint8_t Pattern(uint64_t offset)
+{
+    return (offset * 2654435761u) >> 13;
+}
+
+static void WriteRecording(sout_access_out_t *out, uint64_t size)
+{
+    block_t *header = block_Alloc(HEADER_SIZE);
+    assert(header != NULL);
+    memset(header->p_buffer, 0xAA, HEADER_SIZE);
+    assert(sout_AccessOutWrite(out, header) == HEADER_SIZE);
+
+    for (uint64_t offset = 0; offset < size; offset += BLOCK_SIZE)
+    {
+        size_t len = __MIN(size - offset, BLOCK_SIZE);
+        block_t *block = block_Alloc(len);
+        assert(block != NULL);
+        for (size_t i = 0; i < len; i++)
+            block->p_buffer[i] = Pattern(offset + i);
+        assert(sout_AccessOutWrite(out, block) == (ssize_t)len);
+    }
+}
+
+static void CheckRecording(sout_access_out_t *out, uint64_t pos, uint64_t size)
+{
+    for (uint64_t offset = 0; offset < size; offset += BLOCK_SIZE)
+    {
+        size_t len = __MIN(size - offset, BLOCK_SIZE);
+        block_t *block = block_Alloc(len);
+        assert(block != NULL);
+        sout_AccessOutSeek(out, pos + offset);
+        assert(sout_AccessOutRead(out, block) == (ssize_t)len);
+        for (size_t i = 0; i < len; i++)
+            assert(block->p_buffer[i] == Pattern(offset + i));
+        block_Release(block);
+    }
+}
+
+/* What the MP4 muxer used to do: small chunks, from the end */
+static void SlowMove(sout_access_out_t *out, uint64_t src, uint64_t dst,
+                     uint64_t size)
+{
+    assert(dst > src);
+    while (size > 0)
+    {
+        size_t chunk = __MIN(SLOW_CHUNK_SIZE, size);
+        block_t *block = block_Alloc(chunk);
+        assert(block != NULL);
+        sout_AccessOutSeek(out, src + size - chunk);
+        assert(sout_AccessOutRead(out, block) == (ssize_t)chunk);
+        sout_AccessOutSeek(out, dst + size - chunk);
+        assert(sout_AccessOutWrite(out, block) == (ssize_t)chunk);
+        size -= chunk;
+    }
+}
+
+static void test_move(vlc_object_t *root, const char *path, uint64_t size)
+{
+    sout_access_out_t *out = sout_AccessOutNew(root, "file", path);
+    assert(out != NULL);
+
+    WriteRecording(out, size);
+
+    /* Typical moov sizes, then back and forth by more than the chunk sizes */
+    static const int64_t shifts[] = {
+        8, 100000, -3, -100000, 5 << 20, -(5 << 20), 70 << 20, -(70 << 20),
+    };
+    uint64_t pos = HEADER_SIZE;
+    for (size_t i = 0; i < ARRAY_SIZE(shifts); i++)
+    {
+        if (shifts[i] < 0 && (uint64_t)-shifts[i] > pos)
+            continue;
+
+        vlc_tick_t start = vlc_tick_now();
+        assert(sout_AccessOutMoveRange(out, pos, pos + shifts[i], size)
+               == VLC_SUCCESS);
+        test_log("moved %"PRIu64" MiB by %"PRId64" bytes in %"PRId64" ms\n",
+                 size >> 20, shifts[i],
+                 MS_FROM_VLC_TICK(vlc_tick_now() - start));
+
+        pos += shifts[i];
+        CheckRecording(out, pos, size);
+    }
+
+    vlc_tick_t start = vlc_tick_now();
+    SlowMove(out, pos, pos + 100000, size);
+    test_log("moved %"PRIu64" MiB by 100000 bytes in %"PRId64" ms "
+             "with %d bytes chunks\n", size >> 20,
+             MS_FROM_VLC_TICK(vlc_tick_now() - start), SLOW_CHUNK_SIZE);
+    CheckRecording(out, pos + 100000, size);
+
+    sout_AccessOutDelete(out);
+}
+
+int main(void)
+{
+    test_init();
+
+    const char *env = getenv("VLC_TEST_MOVE_SIZE");
+    uint64_t size = (uint64_t)(env != NULL ? atoi(env) : DEFAULT_SIZE_MB) << 20;
+
+    const char * const vlc_argv[] = {
+        "-vvv",
+    };
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(vlc_argv), vlc_argv);
+    assert(vlc != NULL);
+
+    char path[] = "/tmp/libvlc_XXXXXX";
+    int fd = vlc_mkstemp(path);
+    assert(fd != -1);
+    vlc_close(fd);
+
+    test_move(&vlc->p_libvlc_int->obj, path, size);
+
+    unlink(path);
+    libvlc_release(vlc);
+    return 0;
+}
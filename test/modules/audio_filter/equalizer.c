@@ -0,0 +1,280 @@
+/*****************************************************************************
+ * equalizer.c: equalizer IIR filters test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_tick.h>
+
+#include "../../../modules/audio_filter/eq_iir.h"
+
+#include "../../libvlc/test.h"
+
+#define RATE      48000
+#define FRAMES    1024   /* per buffer */
+#define BUFFERS   (10 * RATE / FRAMES)
+#define BANDS     10
+#define BIQUADS   5      /* as param_eq */
+#define IN_FACTOR 0.25f
+
+static const float frequencies[BANDS] = {
+    60, 170, 310, 600, 1000, 3000, 6000, 12000, 14000, 16000
+};
+
+/* Former equalizer filter, as reference */
+struct bank_ref
+{
+    float x[2];
+    float y[BANDS][2];
+};
+
+static void bank_filter_ref(const eq_iir_bank_t *bank, struct bank_ref *st,
+                            float *out, const float *in, unsigned channels,
+                            unsigned frames, float gain)
+{
+    for (unsigned i = 0; i < frames; i++)
+        for (unsigned ch = 0; ch < channels; ch++)
+        {
+            const float x = in[i * channels + ch];
+            float o = 0.f;
+
+            for (unsigned j = 0; j < BANDS; j++)
+            {
+                float y = bank->alpha[j] * (x - st[ch].x[1]) +
+                          bank->gamma[j] * st[ch].y[j][0] -
+                          bank->beta[j]  * st[ch].y[j][1];
+
+                st[ch].y[j][1] = st[ch].y[j][0];
+                st[ch].y[j][0] = y;
+                o += y * bank->amp[j];
+            }
+            st[ch].x[1] = st[ch].x[0];
+            st[ch].x[0] = x;
+
+            out[i * channels + ch] = gain * (IN_FACTOR * x + o);
+        }
+}
+
+/* Former parametric equalizer filter, as reference */
+static void cascade_ref(const float *src, float *dest, float *state,
+                        unsigned channels, unsigned frames,
+                        const float *coeffs, unsigned count)
+{
+    for (unsigned i = 0; i < frames; i++)
+    {
+        float *s = state;
+        for (unsigned ch = 0; ch < channels; ch++)
+        {
+            const float *c = coeffs;
+            float x = *src++, y = 0;
+
+            for (unsigned eq = 0; eq < count; eq++)
+            {
+                y = x*c[0] + s[0]*c[1] + s[1]*c[2] - s[2]*c[3] - s[3]*c[4];
+                s[1] = s[0];
+                s[0] = x;
+                s[3] = s[2];
+                s[2] = y;
+                x = y;
+                c += 5;
+                s += 4;
+            }
+            *dest++ = y;
+        }
+    }
+}
+
+static void bank_init(eq_iir_bank_t *bank)
+{
+    memset(bank, 0, sizeof (*bank));
+
+    /* as EqzCoeffs() for one octave */
+    const float factor = powf(2.f, .5f);
+    for (unsigned i = 0; i < BANDS; i++)
+    {
+        float theta_1 = 2.f * (float)M_PI * frequencies[i] / RATE;
+        float theta_2 = theta_1 / factor;
+        float sin_prd = sinf(theta_2 * .5f * (factor + 1.f))
+                      * sinf(theta_2 * .5f * (factor - 1.f));
+        float sin_hlf = sinf(theta_2) * .5f;
+        float den = sin_hlf + sin_prd;
+
+        bank->alpha[i] = sin_prd / den;
+        bank->beta[i] = (sin_hlf - sin_prd) / den;
+        bank->gamma[i] = sinf(theta_2) * cosf(theta_1) / den;
+        bank->amp[i] = IN_FACTOR * (powf(10.f, (i % 5 * 4.f - 8.f) / 20.f) - 1.f);
+    }
+}
+
+/* Peaking filters, as CalcPeakEQCoeffs() */
+static void cascade_init(float *coeffs, unsigned count)
+{
+    for (unsigned i = 0; i < count; i++)
+    {
+        float A = powf(10.f, (i % 5 * 3.f - 6.f) / 40.f);
+        float w0 = 2.f * (float)M_PI * frequencies[2 * i % BANDS] / RATE;
+        float alpha = sinf(w0) / (2.f * 3.f);
+        float a0 = 1.f + alpha / A;
+
+        coeffs[5 * i + 0] = (1.f + alpha * A) / a0;
+        coeffs[5 * i + 1] = -2.f * cosf(w0) / a0;
+        coeffs[5 * i + 2] = (1.f - alpha * A) / a0;
+        coeffs[5 * i + 3] = -2.f * cosf(w0) / a0;
+        coeffs[5 * i + 4] = (1.f - alpha / A) / a0;
+    }
+}
+
+/* Music-like signal: a few tones and some noise */
+static void fill_signal(float *buf, unsigned frames, unsigned channels,
+                        unsigned offset, uint32_t *seed)
+{
+    for (unsigned i = 0; i < frames; i++)
+        for (unsigned c = 0; c < channels; c++)
+        {
+            float t = (float)(offset + i) / RATE;
+            buf[i * channels + c] = .4f * sinf(2.f * (float)M_PI * 110.f * t + c)
+                                  + .2f * sinf(2.f * (float)M_PI * 2500.f * t)
+                                  + .1f * ((test_rand(seed) % 2001) / 1000.f - 1.f);
+        }
+}
+
+static void check(const float *ref, const float *out, unsigned n,
+                  float tolerance, bool *exact)
+{
+    for (unsigned i = 0; i < n; i++)
+    {
+        if (ref[i] != out[i])
+            *exact = false;
+        assert(fabsf(ref[i] - out[i]) <= tolerance * fmaxf(1.f, fabsf(ref[i])));
+    }
+}
+
+static void test_bank(unsigned channels)
+{
+    eq_iir_bank_t bank;
+    bank_init(&bank);
+
+    struct bank_ref *st_ref = calloc(channels, sizeof (*st_ref));
+    eq_iir_bank_state_t *st = calloc(channels, sizeof (*st));
+    float *in = malloc(FRAMES * channels * sizeof (float));
+    float *ref = malloc(FRAMES * channels * sizeof (float));
+    float *out = malloc(FRAMES * channels * sizeof (float));
+    assert(st_ref != NULL && st != NULL && in != NULL && ref != NULL && out != NULL);
+
+    uint32_t seed = channels;
+    vlc_tick_t ref_time = 0, simd_time = 0;
+    bool exact = true;
+
+    for (unsigned b = 0; b < BUFFERS; b++)
+    {
+        fill_signal(in, FRAMES, channels, b * FRAMES, &seed);
+
+        vlc_tick_t start = vlc_tick_now();
+        bank_filter_ref(&bank, st_ref, ref, in, channels, FRAMES, 2.f);
+        vlc_tick_t mid = vlc_tick_now();
+        for (unsigned ch = 0; ch < channels; ch++)
+            eq_iir_bank_filter(&bank, &st[ch], &out[ch], &in[ch], channels,
+                               FRAMES, IN_FACTOR, 2.f);
+        vlc_tick_t end = vlc_tick_now();
+
+        ref_time += mid - start;
+        simd_time += end - mid;
+
+        /* The bands are summed in another order */
+        check(ref, out, FRAMES * channels, 1e-5f, &exact);
+    }
+
+    test_log("equalizer, %u channel(s): %"PRId64" us instead of %"PRId64
+             " us per second of audio%s\n", channels,
+             US_FROM_VLC_TICK(simd_time) * RATE / (BUFFERS * FRAMES),
+             US_FROM_VLC_TICK(ref_time) * RATE / (BUFFERS * FRAMES),
+             exact ? ", bit-exact" : "");
+
+    free(out);
+    free(ref);
+    free(in);
+    free(st);
+    free(st_ref);
+}
+
+static void test_cascade(unsigned channels, unsigned count)
+{
+    float coeffs[5 * (EQ_IIR_CASCADE_MAX + 1)];
+    assert(count <= EQ_IIR_CASCADE_MAX + 1);
+    cascade_init(coeffs, count);
+
+    float *st_ref = calloc(channels * count * 4, sizeof (float));
+    float *st = calloc(channels * count * 4, sizeof (float));
+    float *in = malloc(FRAMES * channels * sizeof (float));
+    float *ref = malloc(FRAMES * channels * sizeof (float));
+    assert(st_ref != NULL && st != NULL && in != NULL && ref != NULL);
+
+    uint32_t seed = channels;
+    vlc_tick_t ref_time = 0, simd_time = 0;
+    bool exact = true;
+
+    for (unsigned b = 0; b < BUFFERS; b++)
+    {
+        fill_signal(in, FRAMES, channels, b * FRAMES, &seed);
+
+        vlc_tick_t start = vlc_tick_now();
+        cascade_ref(in, ref, st_ref, channels, FRAMES, coeffs, count);
+        vlc_tick_t mid = vlc_tick_now();
+        /* in place, as the filter does */
+        eq_iir_cascade(in, in, st, channels, FRAMES, coeffs, count);
+        vlc_tick_t end = vlc_tick_now();
+
+        ref_time += mid - start;
+        simd_time += end - mid;
+
+        /* Same operations in each lane, only contractions may differ */
+        check(ref, in, FRAMES * channels, 1e-5f, &exact);
+    }
+
+    test_log("parametric equalizer, %u channel(s), %u biquads: %"PRId64
+             " us instead of %"PRId64" us per second of audio%s\n",
+             channels, count,
+             US_FROM_VLC_TICK(simd_time) * RATE / (BUFFERS * FRAMES),
+             US_FROM_VLC_TICK(ref_time) * RATE / (BUFFERS * FRAMES),
+             exact ? ", bit-exact" : "");
+
+    free(ref);
+    free(in);
+    free(st);
+    free(st_ref);
+}
+
+int main(void)
+{
+    test_init();
+
+    static const unsigned channels[] = { 1, 2, 6, 8 };
+    for (size_t i = 0; i < ARRAY_SIZE(channels); i++)
+    {
+        test_bank(channels[i]);
+        test_cascade(channels[i], BIQUADS);
+    }
+    /* Too long to be vectorized, the cascade falls back to the scalar code */
+    test_cascade(8, EQ_IIR_CASCADE_MAX + 1);
+    return 0;
+}
@@ -0,0 +1,157 @@
+/*****************************************************************************
+ * scaletempo.c: scaletempo overlap search test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_tick.h>
+
+#include "../../../modules/audio_filter/scaletempo_corr.h"
+
+#include "../../libvlc/test.h"
+
+/* scaletempo defaults: 30 ms stride, 20% overlap, 14 ms search */
+#define RATE     48000
+#define STRIDE   (30 * RATE / 1000)
+#define OVERLAP  (STRIDE / 5)
+#define SEARCH   (14 * RATE / 1000)
+#define SEARCHES 2000
+
+/* Former brute force search, as reference */
+static unsigned best_offset_ref(const float *pre_corr, const float *search,
+                                unsigned channels, unsigned n,
+                                unsigned frames_search)
+{
+    float best_corr = -HUGE_VALF;
+    unsigned best_off = 0;
+
+    for (unsigned off = 0; off < frames_search; off++)
+    {
+        float corr = 0;
+        for (unsigned i = 0; i < n; i++)
+            corr += pre_corr[i] * search[off * channels + i];
+        if (corr > best_corr)
+        {
+            best_corr = corr;
+            best_off = off;
+        }
+    }
+    return best_off;
+}
+
+static double correlation(const float *pre_corr, const float *search,
+                          unsigned channels, unsigned n, unsigned off)
+{
+    double corr = 0;
+    for (unsigned i = 0; i < n; i++)
+        corr += (double)pre_corr[i] * search[off * channels + i];
+    return corr;
+}
+
+/* Harmonic signal with some noise, like voice */
+static void fill_signal(float *buf, unsigned frames, unsigned channels,
+                        uint32_t *seed)
+{
+    for (unsigned i = 0; i < frames; i++)
+        for (unsigned c = 0; c < channels; c++)
+            buf[i * channels + c] = sinf(i * 0.031f + c)
+                                  + 0.5f * sinf(i * 0.093f)
+                                  + 0.2f * ((test_rand(seed) % 2001) / 1000.f - 1.f);
+}
+
+static void fill_window(float *pre_corr, const float *overlap,
+                        unsigned channels)
+{
+    for (unsigned i = 1; i < OVERLAP; i++)
+        for (unsigned c = 0; c < channels; c++)
+        {
+            float w = i * (OVERLAP - i);
+            pre_corr[(i - 1) * channels + c] = w * overlap[i * channels + c];
+        }
+}
+
+static void test_channels(unsigned channels)
+{
+    const unsigned n = (OVERLAP - 1) * channels;
+    float *pre_corr = malloc(n * sizeof (float));
+    float *overlap = malloc(OVERLAP * channels * sizeof (float));
+    float *queue = malloc((SEARCH + OVERLAP) * channels * sizeof (float));
+    assert(pre_corr != NULL && overlap != NULL && queue != NULL);
+
+    uint32_t seed = channels;
+    vlc_tick_t ref_time = 0, simd_time = 0;
+
+    for (unsigned s = 0; s < SEARCHES; s++)
+    {
+        fill_signal(overlap, OVERLAP, channels, &seed);
+        fill_signal(queue, SEARCH + OVERLAP, channels, &seed);
+        fill_window(pre_corr, overlap, channels);
+
+        /* all the lengths, including those not multiple of the vectors */
+        unsigned frames_search = SEARCH - s % 8;
+
+        vlc_tick_t start = vlc_tick_now();
+        unsigned ref = best_offset_ref(pre_corr, queue + channels, channels,
+                                       n, frames_search);
+        vlc_tick_t mid = vlc_tick_now();
+        unsigned off = scaletempo_best_offset(pre_corr, queue + channels,
+                                              channels, n, frames_search);
+        vlc_tick_t end = vlc_tick_now();
+
+        ref_time += mid - start;
+        simd_time += end - mid;
+
+        assert(off < frames_search);
+        if (off != ref)
+        {   /* Only rounding may pick another candidate, of equal quality */
+            double a = correlation(pre_corr, queue + channels, channels, n, ref);
+            double b = correlation(pre_corr, queue + channels, channels, n, off);
+            assert(fabs(a - b) <= 1e-4 * fabs(a));
+        }
+    }
+
+    /* Report only: timings depend too much on the machine to be checked.
+     * One search per output stride, i.e. per rate * stride of input. */
+    static const float rates[] = { 1.f, 1.5f, 2.f, 3.f };
+    for (size_t i = 0; i < ARRAY_SIZE(rates); i++)
+    {
+        double searches_per_sec = (double)RATE / (STRIDE * rates[i]);
+
+        test_log("%u channel(s), rate %.1f: %.0f us instead of %.0f us "
+                 "per second of audio\n", channels, rates[i],
+                 searches_per_sec * US_FROM_VLC_TICK(simd_time) / SEARCHES,
+                 searches_per_sec * US_FROM_VLC_TICK(ref_time) / SEARCHES);
+    }
+
+    free(queue);
+    free(overlap);
+    free(pre_corr);
+}
+
+int main(void)
+{
+    test_init();
+
+    test_channels(1);
+    test_channels(2);
+    test_channels(6);
+    return 0;
+}
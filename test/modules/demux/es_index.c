@@ -0,0 +1,238 @@
+/*****************************************************************************
+ * es_index.c: audio elementary stream frame index tests
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_es.h>
+#include <vlc_tick.h>
+
+#include "../../../modules/packetizer/adts.h"
+#include "../../../modules/packetizer/mpegaudio.h"
+#include "../../../modules/demux/mpeg/es_index.h"
+
+#include <unistd.h>
+
+const char vlc_module_name[] = "test_modules_demux_es_index";
+
+/* More frames than index entries, so that the interval grows */
+#define FRAME_COUNT  10000
+#define MAX_STEP     4     /* frames between entries after that */
+#define TAG_SIZE     1000  /* skipped by the demuxer before indexing */
+#define LOOKUP_COUNT 1000
+
+#define MPGA_RATE    44100
+#define MPGA_SAMPLES 1152
+#define ADTS_RATE    44100
+#define ADTS_SAMPLES 1024
+
+/* Same parsers as the es demuxer */
+static int MpgaFrameParse(const uint8_t *p, unsigned *samples, unsigned *rate)
+{
+    struct mpga_frameheader_s h;
+
+    if (p[0] != 0xff || (p[1] & 0xe0) != 0xe0 ||
+        mpga_decode_frameheader(GetDWBE(p), &h) || h.i_bit_rate == 0)
+        return -1;
+    *samples = h.i_samples_per_frame;
+    *rate = h.i_sample_rate;
+    return h.i_frame_size;
+}
+
+static int AdtsFrameParse(const uint8_t *p, unsigned *samples, unsigned *rate)
+{
+    vlc_adts_header_t h;
+
+    if (vlc_adts_header_Parse(&h, p) != VLC_SUCCESS)
+        return -1;
+    *samples = ADTS_SAMPLES * h.i_raw_blocks;
+    *rate = h.i_rate;
+    return h.i_frame_size;
+}
+
+struct stream
+{
+    const char *name;
+    unsigned rate;
+    unsigned samples;
+    unsigned header_size;
+    es_index_parse_cb parse;
+    /* writes a frame of about any size, returns its actual size */
+    size_t (*write_frame)(uint8_t *, uint32_t *seed);
+};
+
+/* MPEG-1 layer III, 44.1 kHz, mono, a random bitrate per frame */
+static size_t write_mpga(uint8_t *p, uint32_t *seed)
+{
+    static const unsigned bitrates[] = {
+        32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320
+    };
+    const unsigned index = test_rand(seed) % ARRAY_SIZE(bitrates);
+    const unsigned padding = test_rand(seed) % 2;
+    const size_t size = 144000 * bitrates[index] / MPGA_RATE + padding;
+
+    memset(p, 0, size);
+    p[0] = 0xff;
+    p[1] = 0xfb; /* MPEG-1, layer III, no CRC */
+    p[2] = (index + 1) << 4 | padding << 1;
+    p[3] = 0xc0; /* mono */
+    return size;
+}
+
+/* AAC LC, 44.1 kHz, stereo, one raw data block of random size */
+static size_t write_adts(uint8_t *p, uint32_t *seed)
+{
+    const size_t size = 100 + test_rand(seed) % 700;
+
+    memset(p, 0, size);
+    p[0] = 0xff;
+    p[1] = 0xf1; /* MPEG-4, no CRC */
+    p[2] = 1 << 6 | 4 << 2; /* LC, 44.1 kHz */
+    p[3] = 2 << 6 | size >> 11; /* stereo */
+    p[4] = size >> 3;
+    p[5] = (size & 7) << 5 | 0x1f;
+    p[6] = 0xfc; /* VBR, one block */
+    return size;
+}
+
+/* Writes the stream, and the offset and time of every frame */
+static void write_stream(const struct stream *stream, const char *path,
+                         uint64_t *pos, vlc_tick_t *time)
+{
+    FILE *file = fopen(path, "wb");
+    assert(file != NULL);
+
+    uint8_t frame[2048];
+    memset(frame, 0, TAG_SIZE);
+    size_t ret = fwrite(frame, 1, TAG_SIZE, file);
+    assert(ret == TAG_SIZE);
+
+    uint32_t seed = stream->rate;
+    uint64_t offset = 0;
+    for (unsigned i = 0; i < FRAME_COUNT; i++)
+    {
+        size_t size = stream->write_frame(frame, &seed);
+        assert(size <= sizeof(frame));
+        ret = fwrite(frame, 1, size, file);
+        assert(ret == size);
+
+        pos[i] = offset;
+        time[i] = vlc_tick_from_samples((uint64_t)i * stream->samples,
+                                        stream->rate);
+        offset += size;
+    }
+    int val = fclose(file);
+    assert(val == 0);
+}
+
+static void test_stream(vlc_object_t *obj, const struct stream *stream,
+                        const char *tempdir)
+{
+    char *path, *url;
+    int ret = asprintf(&path, "%s/test.%s", tempdir, stream->name);
+    assert(ret >= 0);
+    ret = asprintf(&url, "file://%s", path);
+    assert(ret >= 0);
+
+    uint64_t *pos = malloc(FRAME_COUNT * sizeof(*pos));
+    vlc_tick_t *time = malloc(FRAME_COUNT * sizeof(*time));
+    assert(pos != NULL && time != NULL);
+    write_stream(stream, path, pos, time);
+
+    es_index_t *index = es_index_New(obj, url, TAG_SIZE, stream->header_size,
+                                     stream->parse);
+    assert(index != NULL);
+
+    /* The duration is exact once the whole file was read */
+    vlc_tick_t length;
+    while (es_index_GetLength(index, &length) != VLC_SUCCESS)
+        (vlc_tick_sleep)(VLC_TICK_FROM_MS(10));
+    test_log("%s: %u frames, length %"PRId64" us\n", stream->name,
+             FRAME_COUNT, US_FROM_VLC_TICK(length));
+    assert(length == vlc_tick_from_samples((uint64_t)FRAME_COUNT *
+                                           stream->samples, stream->rate));
+
+    /* Every time maps to the start of a preceding frame, close to it */
+    uint32_t seed = FRAME_COUNT;
+    for (unsigned i = 0; i < LOOKUP_COUNT; i++)
+    {
+        const uint64_t r = (uint64_t)test_rand(&seed) << 24 | test_rand(&seed);
+        const vlc_tick_t target = i == 0 ? 0 : (vlc_tick_t)(r % length);
+        vlc_tick_t found_time;
+        uint64_t found_pos;
+
+        ret = es_index_Lookup(index, target, &found_time, &found_pos);
+        assert(ret == VLC_SUCCESS);
+
+        size_t low = 0, high = FRAME_COUNT;
+        while (high - low > 1)
+        {
+            size_t mid = low + (high - low) / 2;
+            if (pos[mid] <= found_pos)
+                low = mid;
+            else
+                high = mid;
+        }
+        assert(pos[low] == found_pos);
+        assert(time[low] == found_time);
+        assert(found_time <= target);
+        assert(low + MAX_STEP >= FRAME_COUNT || time[low + MAX_STEP] > target);
+    }
+
+    es_index_Delete(index);
+
+    ret = unlink(path);
+    assert(ret == 0);
+    free(time);
+    free(pos);
+    free(url);
+    free(path);
+}
+
+int main(void)
+{
+    char template[] = "/tmp/vlc.test.es_index.XXXXXX";
+    const char *tempdir = mkdtemp(template);
+    assert(tempdir != NULL);
+
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    assert(vlc != NULL);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    static const struct stream streams[] = {
+        { "mp3", MPGA_RATE, MPGA_SAMPLES, 4, MpgaFrameParse, write_mpga },
+        { "aac", ADTS_RATE, ADTS_SAMPLES, VLC_ADTS_MIN_HEADER_SIZE,
+          AdtsFrameParse, write_adts },
+    };
+    for (size_t i = 0; i < ARRAY_SIZE(streams); i++)
+        test_stream(obj, &streams[i], tempdir);
+
+    libvlc_release(vlc);
+    rmdir(tempdir);
+    return 0;
+}
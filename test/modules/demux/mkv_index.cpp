@@ -0,0 +1,377 @@
+/*****************************************************************************
+ * mkv_index.cpp: Matroska seek index, index cache and cluster scanner tests
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+#include "../../../lib/libvlc_internal.h"
+
+#include "../../../modules/demux/mkv/matroska_segment_index.hpp"
+
+#include <ftw.h>
+
+using namespace mkv;
+
+const char vlc_module_name[] = MODULE_STRING;
+
+#define TIMESCALE 1000000 /* ns, i.e. timestamps in ms */
+#define TRACK     1
+
+/*****************************************************************************
+ * SegmentSeeker (de)serialization
+ *****************************************************************************/
+static void fill_seeker( SegmentSeeker & seeker )
+{
+    const SegmentSeeker::Cluster clusters[] = {
+        { 1000, VLC_TICK_FROM_SEC(0), VLC_TICK_FROM_SEC(1), 500 },
+        { 1500, VLC_TICK_FROM_SEC(1), VLC_TICK_FROM_SEC(1), 700 },
+        { 4000, VLC_TICK_FROM_SEC(5), vlc_tick_t(-1), UINT64_MAX },
+    };
+    for( size_t i = 0; i < ARRAY_SIZE(clusters); ++i )
+        seeker.add_cluster( clusters[i] );
+
+    seeker.add_seekpoint( 1, SegmentSeeker::Seekpoint( 1010, VLC_TICK_FROM_SEC(0) ) );
+    seeker.add_seekpoint( 1, SegmentSeeker::Seekpoint( 1600, VLC_TICK_FROM_MS(1500),
+                          SegmentSeeker::Seekpoint::QUESTIONABLE ) );
+    seeker.add_seekpoint( 2, SegmentSeeker::Seekpoint( 4010, VLC_TICK_FROM_SEC(5),
+                          SegmentSeeker::Seekpoint::DISABLED ) );
+
+    seeker.mark_range_as_searched( SegmentSeeker::Range( 1000, 2200 ) );
+    seeker.mark_range_as_searched( SegmentSeeker::Range( 4000, 4100 ) );
+}
+
+static bool knows_nothing( SegmentSeeker const& seeker )
+{
+    return seeker._ranges_searched.empty() && seeker._tracks_seekpoints.empty() &&
+           seeker._cluster_positions.empty() && seeker._clusters.empty();
+}
+
+static std::vector<uint8_t> serialize( SegmentSeeker const& seeker )
+{
+    std::vector<uint8_t> buf;
+    seeker.serialize( buf );
+    return buf;
+}
+
+static void test_seeker_roundtrip( void )
+{
+    SegmentSeeker seeker;
+    fill_seeker( seeker );
+    const std::vector<uint8_t> buf = serialize( seeker );
+
+    SegmentSeeker loaded;
+    assert( loaded.deserialize( buf ) );
+    assert( serialize( loaded ) == buf );
+
+    assert( loaded._clusters.size() == 3 );
+    SegmentSeeker::Cluster const& last = loaded._clusters.rbegin()->second;
+    assert( last.fpos == 4000 && last.pts == VLC_TICK_FROM_SEC(5) &&
+            last.size == UINT64_MAX );
+    assert( loaded._cluster_positions.size() == 3 );
+    assert( loaded._ranges_searched.size() == 2 );
+    assert( loaded._tracks_seekpoints[1].size() == 2 );
+    assert( loaded._tracks_seekpoints[1][1].trust_level ==
+            SegmentSeeker::Seekpoint::QUESTIONABLE );
+    assert( loaded._tracks_seekpoints[2][0].trust_level ==
+            SegmentSeeker::Seekpoint::DISABLED );
+
+    /* Loading merges with what is already known */
+    SegmentSeeker merged;
+    const SegmentSeeker::Cluster cluster = { 6000, VLC_TICK_FROM_SEC(9), vlc_tick_t(-1), 100 };
+    merged.add_cluster( cluster );
+    merged.add_seekpoint( 1, SegmentSeeker::Seekpoint( 6010, VLC_TICK_FROM_SEC(9) ) );
+    assert( merged.deserialize( buf ) );
+    assert( merged._clusters.size() == 4 && merged._cluster_positions.size() == 4 );
+    assert( merged._tracks_seekpoints[1].size() == 3 );
+
+    /* Loading the same data twice adds nothing */
+    assert( loaded.deserialize( buf ) );
+    assert( serialize( loaded ) == buf );
+
+    test_log( "seeker round trip of %zu bytes\n", buf.size() );
+}
+
+static void test_seeker_corrupt( void )
+{
+    SegmentSeeker seeker;
+    fill_seeker( seeker );
+    const std::vector<uint8_t> buf = serialize( seeker );
+
+    /* Truncated anywhere, nothing is merged */
+    for( size_t i = 0; i < buf.size(); ++i )
+    {
+        SegmentSeeker loaded;
+        assert( !loaded.deserialize( std::vector<uint8_t>( buf.begin(), buf.begin() + i ) ) );
+        assert( knows_nothing( loaded ) );
+    }
+
+    /* Other file format */
+    std::vector<uint8_t> bad = buf;
+    bad[0] ^= 0xff;
+    SegmentSeeker loaded;
+    assert( !loaded.deserialize( bad ) );
+    assert( knows_nothing( loaded ) );
+
+    /* More ranges than there is data for */
+    bad = buf;
+    SetDWLE( &bad[8], UINT32_MAX );
+    assert( !loaded.deserialize( bad ) );
+    assert( knows_nothing( loaded ) );
+}
+
+/*****************************************************************************
+ * Cluster scanner
+ *****************************************************************************/
+struct test_file
+{
+    std::vector<uint8_t> data;
+    std::vector<SegmentSeeker::Cluster> clusters;
+    std::vector<SegmentSeeker::Seekpoint> keyframes; /* of TRACK */
+    size_t garbage; /* where to break the file */
+};
+
+static void put( std::vector<uint8_t> & buf, std::initializer_list<uint8_t> bytes )
+{
+    buf.insert( buf.end(), bytes );
+}
+
+/* Element with a one byte size */
+static void put_element( std::vector<uint8_t> & buf, std::initializer_list<uint8_t> id,
+                         std::vector<uint8_t> const& payload )
+{
+    assert( payload.size() < 0x7f );
+    put( buf, id );
+    buf.push_back( 0x80 | payload.size() );
+    buf.insert( buf.end(), payload.begin(), payload.end() );
+}
+
+static std::vector<uint8_t> block( unsigned track, int16_t rel, uint8_t flags )
+{
+    return { uint8_t( 0x80 | track ), uint8_t( rel >> 8 ), uint8_t( rel ), flags, 0xAA };
+}
+
+static void put_cluster( test_file & file, std::vector<uint8_t> const& payload,
+                         vlc_tick_t pts, bool b_unknown_size )
+{
+    const size_t pos = file.data.size();
+
+    if( b_unknown_size )
+    {
+        put( file.data, { 0x1F, 0x43, 0xB6, 0x75, 0xFF } );
+        file.data.insert( file.data.end(), payload.begin(), payload.end() );
+    }
+    else
+        put_element( file.data, { 0x1F, 0x43, 0xB6, 0x75 }, payload );
+
+    const SegmentSeeker::Cluster cluster = {
+        pos, pts, vlc_tick_t(-1),
+        b_unknown_size ? UINT64_MAX : file.data.size() - pos
+    };
+    file.clusters.push_back( cluster );
+}
+
+/* A segment payload with a cluster of unknown size between two others,
+ * key frames in SimpleBlock and BlockGroup */
+static test_file make_file( void )
+{
+    test_file file;
+    std::vector<uint8_t> cluster;
+
+    put_element( file.data, { 0x15, 0x49, 0xA9, 0x66 }, { 0, 0 } ); /* Info */
+
+    /* key frame, non key frame, key frame of another track */
+    put_element( cluster, { 0xE7 }, { 0x00 } );
+    size_t pos = file.data.size() + 5 + cluster.size();
+    file.keyframes.push_back( SegmentSeeker::Seekpoint( pos, VLC_TICK_FROM_SEC(0) ) );
+    put_element( cluster, { 0xA3 }, block( TRACK, 0, 0x80 ) );
+    put_element( cluster, { 0xA3 }, block( TRACK, 40, 0x00 ) );
+    put_element( cluster, { 0xA3 }, block( TRACK + 1, 0, 0x80 ) );
+    put_cluster( file, cluster, VLC_TICK_FROM_SEC(0), false );
+
+    /* block without reference, then a block with one */
+    cluster.clear();
+    put_element( cluster, { 0xE7 }, { 0x03, 0xE8 } );
+    pos = file.data.size() + 5 + cluster.size() + 2;
+    file.keyframes.push_back( SegmentSeeker::Seekpoint( pos, VLC_TICK_FROM_SEC(1) ) );
+    std::vector<uint8_t> group;
+    put_element( group, { 0xA1 }, block( TRACK, 0, 0x00 ) );
+    put_element( cluster, { 0xA0 }, group );
+    group.clear();
+    put_element( group, { 0xA1 }, block( TRACK, 40, 0x00 ) );
+    put_element( group, { 0xFB }, { 0xD8 } );
+    put_element( cluster, { 0xA0 }, group );
+    put_cluster( file, cluster, VLC_TICK_FROM_SEC(1), true );
+
+    file.garbage = file.data.size();
+    cluster.clear();
+    put_element( cluster, { 0xE7 }, { 0x07, 0xD0 } );
+    pos = file.data.size() + 5 + cluster.size();
+    file.keyframes.push_back( SegmentSeeker::Seekpoint( pos, VLC_TICK_FROM_SEC(2) ) );
+    put_element( cluster, { 0xA3 }, block( TRACK, 0, 0x80 ) );
+    put_cluster( file, cluster, VLC_TICK_FROM_SEC(2), false );
+
+    return file;
+}
+
+static void write_file( const char *path, std::vector<uint8_t> const& data, size_t size )
+{
+    FILE *file = fopen( path, "wb" );
+    assert( file != NULL );
+    size_t written = fwrite( data.data(), 1, size, file );
+    assert( written == size );
+    int ret = fclose( file );
+    assert( ret == 0 );
+}
+
+static SegmentSeeker scan( vlc_object_t *obj, std::string const& url, size_t end )
+{
+    SegmentIndexer indexer( obj, url, 0, end, TIMESCALE,
+                            SegmentSeeker::track_ids_t( 1, TRACK ) );
+    bool ret = indexer.Start();
+    assert( ret );
+    while( !indexer.IsDone() )
+        (vlc_tick_sleep)( VLC_TICK_FROM_MS(10) );
+
+    SegmentSeeker seeker;
+    indexer.Merge( seeker );
+    return seeker;
+}
+
+/* Only clusters and key frames of the file, each at most once */
+static size_t check_scan( SegmentSeeker & seeker, test_file const& file )
+{
+    for( SegmentSeeker::cluster_map_t::const_iterator it = seeker._clusters.begin();
+         it != seeker._clusters.end(); ++it )
+    {
+        bool b_found = false;
+        for( size_t i = 0; i < file.clusters.size(); ++i )
+            b_found |= file.clusters[i].fpos == it->second.fpos &&
+                       file.clusters[i].pts == it->second.pts &&
+                       file.clusters[i].size == it->second.size;
+        assert( b_found );
+    }
+
+    SegmentSeeker::seekpoints_t const& seekpoints = seeker._tracks_seekpoints[TRACK];
+    assert( seeker._tracks_seekpoints.size() <= 1 );
+    for( size_t i = 0; i < seekpoints.size(); ++i )
+    {
+        assert( i < file.keyframes.size() );
+        assert( seekpoints[i].fpos == file.keyframes[i].fpos &&
+                seekpoints[i].pts == file.keyframes[i].pts );
+    }
+    return seekpoints.size();
+}
+
+static void test_scan( vlc_object_t *obj, const char *path )
+{
+    const test_file file = make_file();
+    const std::string url = std::string( "file://" ) + path;
+
+    write_file( path, file.data, file.data.size() );
+    SegmentSeeker seeker = scan( obj, url, file.data.size() );
+    assert( seeker._clusters.size() == file.clusters.size() );
+    assert( check_scan( seeker, file ) == file.keyframes.size() );
+    assert( seeker._ranges_searched.size() == 1 &&
+            seeker._ranges_searched[0].start == 0 &&
+            seeker._ranges_searched[0].end == file.data.size() );
+
+    /* Truncated anywhere, what is found is still right */
+    for( size_t i = 0; i < file.data.size(); ++i )
+    {
+        write_file( path, file.data, i );
+        seeker = scan( obj, url, file.data.size() );
+        check_scan( seeker, file );
+    }
+
+    /* Garbage ends the scan, what is before it is kept */
+    std::vector<uint8_t> bad = file.data;
+    memset( &bad[file.garbage], 0, 4 );
+    write_file( path, bad, bad.size() );
+    seeker = scan( obj, url, bad.size() );
+    assert( seeker._clusters.size() == file.clusters.size() - 1 );
+    assert( check_scan( seeker, file ) == file.keyframes.size() - 1 );
+
+    test_log( "scanned %zu clusters\n", file.clusters.size() );
+}
+
+/*****************************************************************************
+ * Index cache
+ *****************************************************************************/
+static void test_cache( vlc_object_t *obj )
+{
+    const std::string path = SegmentIndexCache::GetPath( obj, "file:///test.mkv",
+                                                         1000000, 40, NULL );
+    assert( !path.empty() );
+
+    SegmentSeeker seeker;
+    fill_seeker( seeker );
+    const std::vector<uint8_t> buf = serialize( seeker );
+    assert( SegmentIndexCache::Save( obj, path, seeker, 0 ) );
+
+    SegmentSeeker loaded;
+    assert( SegmentIndexCache::Load( obj, path, loaded ) == buf.size() );
+    assert( serialize( loaded ) == buf );
+
+    /* A truncated cache is ignored */
+    write_file( path.c_str(), buf, buf.size() - 1 );
+    SegmentSeeker truncated;
+    assert( SegmentIndexCache::Load( obj, path, truncated ) == 0 );
+    assert( knows_nothing( truncated ) );
+}
+
+static int cleanup_tmpdir( const char *dirpath, const struct stat *sb,
+                           int typeflag, struct FTW *ftwbuf )
+{
+    (void)sb; (void)typeflag; (void)ftwbuf;
+    return remove( dirpath );
+}
+
+int main( void )
+{
+    test_seeker_roundtrip();
+    test_seeker_corrupt();
+
+#if defined(_WIN32) || defined(__APPLE__)
+    /* The cache directory is only redirected through XDG_CACHE_HOME */
+    return 0;
+#else
+    char tmpl[] = "/tmp/vlc.test.mkv_index.XXXXXX";
+    const char *tempdir = mkdtemp( tmpl );
+    assert( tempdir != NULL );
+    setenv( "XDG_CACHE_HOME", tempdir, 1 );
+
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new( 0, NULL );
+    assert( vlc != NULL );
+    vlc_object_t *obj = VLC_OBJECT( vlc->p_libvlc_int );
+
+    const std::string path = std::string( tempdir ) + "/test.mkv";
+    test_scan( obj, path.c_str() );
+    test_cache( obj );
+
+    libvlc_release( vlc );
+
+    nftw( tempdir, cleanup_tmpdir, FOPEN_MAX, FTW_DEPTH | FTW_MOUNT | FTW_PHYS );
+    return 0;
+#endif
+}
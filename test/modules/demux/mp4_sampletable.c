@@ -0,0 +1,175 @@
+/*****************************************************************************
+ * mp4_sampletable.c: MP4 compact sample table test
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_tick.h>
+
+#include "../../../modules/demux/mp4/sampletable.h"
+
+#include "../../libvlc/test.h"
+
+/* 24 hours of 30 fps video, and of 48 kHz AAC */
+#define VIDEO_SAMPLES (24 * 3600 * 30)
+#define AUDIO_SAMPLES (UINT32_C(24 * 3600) * 48000 / 1024)
+#define AUDIO_CHUNK 1024
+#define LOOKUPS 100000
+
+static void FillVideo( uint32_t *sizes, uint32_t count )
+{
+    uint32_t seed = 1;
+
+    for( uint32_t i = 0; i < count; i++ )
+    {
+        if( i % 60 == 0 ) /* key frame */
+            sizes[i] = 100000 + test_rand( &seed ) % 100000;
+        else
+            sizes[i] = 5000 + test_rand( &seed ) % 35000;
+    }
+}
+
+static void FillAudio( uint32_t *sizes, uint32_t count )
+{
+    uint32_t seed = 2;
+
+    for( uint32_t i = 0; i < count; i++ )
+        sizes[i] = 250 + test_rand( &seed ) % 200;
+}
+
+static void FillConstant( uint32_t *sizes, uint32_t count )
+{
+    /* constant sizes written as a full table, with a few odd ones */
+    for( uint32_t i = 0; i < count; i++ )
+        sizes[i] = (i % 100000) ? 4096 : 17;
+}
+
+/* Random position lookups, as done when seeking, only reported: the timings
+ * depend too much on the machine to be checked */
+static void bench_lookups( const char *name, const mp4_sample_sizes_t *table,
+                           const uint32_t *sizes, uint32_t count )
+{
+    uint32_t seed = 4;
+    uint64_t dummy = 0;
+
+    vlc_tick_t start = vlc_tick_now();
+    for( unsigned i = 0; i < LOOKUPS; i++ )
+    {
+        uint32_t first = test_rand( &seed ) % count;
+        uint32_t last = __MIN( first + AUDIO_CHUNK, count );
+
+        dummy += MP4_SampleSizes_Sum( table, first, last );
+    }
+    vlc_tick_t packed = vlc_tick_now() - start;
+
+    start = vlc_tick_now();
+    for( unsigned i = 0; i < LOOKUPS; i++ )
+    {
+        uint32_t first = test_rand( &seed ) % count;
+        uint32_t last = __MIN( first + AUDIO_CHUNK, count );
+
+        for( uint32_t j = first; j < last; j++ )
+            dummy += sizes[j];
+    }
+    vlc_tick_t expanded = vlc_tick_now() - start;
+
+    test_log( "%s: %u lookups in %"PRId64" us instead of %"PRId64" us "
+              "(%"PRIu64")\n", name, LOOKUPS, US_FROM_VLC_TICK(packed),
+              US_FROM_VLC_TICK(expanded), dummy & 1 );
+}
+
+static void check_table( const char *name, const uint32_t *sizes, uint32_t count )
+{
+    mp4_sample_sizes_t table;
+
+    assert( MP4_SampleSizes_Init( &table, sizes, count ) == VLC_SUCCESS );
+
+    uint64_t i_total = 0;
+    for( uint32_t i = 0; i < count; i++ )
+    {
+        assert( MP4_SampleSizes_Get( &table, i ) == sizes[i] );
+        i_total += sizes[i];
+    }
+    assert( MP4_SampleSizes_Sum( &table, 0, count ) == i_total );
+    assert( MP4_SampleSizes_Sum( &table, count, 0 ) == 0 );
+
+    /* sums across block boundaries, as done for chunks */
+    uint32_t seed = 3;
+    for( unsigned i = 0; i < 1000; i++ )
+    {
+        uint32_t first = test_rand( &seed ) % count;
+        uint32_t last = first + test_rand( &seed ) % __MIN( 1000, count - first + 1 );
+        uint64_t sum = 0;
+
+        for( uint32_t j = first; j < last; j++ )
+            sum += sizes[j];
+        assert( MP4_SampleSizes_Sum( &table, first, last ) == sum );
+    }
+
+    test_log( "%s: %"PRIu32" samples, %zu kB packed instead of %zu kB\n",
+              name, count, MP4_SampleSizes_Memory( &table ) / 1024,
+              (size_t)count * sizeof (*sizes) / 1024 );
+    bench_lookups( name, &table, sizes, count );
+
+    assert( MP4_SampleSizes_Memory( &table ) < (size_t)count * sizeof (*sizes) );
+    MP4_SampleSizes_Clean( &table );
+}
+
+static void test_edges( void )
+{
+    static const uint32_t sizes[] = {
+        0, UINT32_MAX, 0, 1, UINT32_MAX - 1, 42,
+    };
+    mp4_sample_sizes_t table;
+
+    for( uint32_t count = 0; count <= ARRAY_SIZE(sizes); count++ )
+    {
+        assert( MP4_SampleSizes_Init( &table, sizes, count ) == VLC_SUCCESS );
+        uint64_t sum = 0;
+        for( uint32_t i = 0; i < count; i++ )
+        {
+            assert( MP4_SampleSizes_Get( &table, i ) == sizes[i] );
+            sum += sizes[i];
+        }
+        assert( MP4_SampleSizes_Sum( &table, 0, count ) == sum );
+        MP4_SampleSizes_Clean( &table );
+    }
+}
+
+int main( void )
+{
+    test_init();
+
+    test_edges();
+
+    uint32_t *sizes = malloc( AUDIO_SAMPLES * sizeof (*sizes) );
+    assert( sizes != NULL );
+
+    FillVideo( sizes, VIDEO_SAMPLES );
+    check_table( "video", sizes, VIDEO_SAMPLES );
+    FillAudio( sizes, AUDIO_SAMPLES );
+    check_table( "audio", sizes, AUDIO_SAMPLES );
+    FillConstant( sizes, AUDIO_SAMPLES );
+    check_table( "constant", sizes, AUDIO_SAMPLES );
+
+    free( sizes );
+    return 0;
+}
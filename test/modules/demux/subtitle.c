@@ -0,0 +1,208 @@
+/*****************************************************************************
+ * subtitle.c: test and benchmark of the indexed text subtitles
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_memstream.h>
+#include <vlc_input_item.h>
+
+#ifndef _WIN32
+# include <sys/resource.h>
+#endif
+
+/* A few hours of live captions */
+#define CUE_COUNT    100000
+#define CUE_INTERVAL 2 /* seconds */
+
+struct test_es_out
+{
+    es_out_t out;
+    unsigned sent;
+    int      first_cue; /* number in the text of the first cue sent */
+};
+
+static es_out_id_t *EsOutAdd(es_out_t *out, input_source_t *in,
+                             const es_format_t *fmt)
+{
+    (void)out; (void)in;
+    assert(fmt->i_cat == SPU_ES);
+    return (es_out_id_t *)out;
+}
+
+static int EsOutSend(es_out_t *out, es_out_id_t *id, block_t *block)
+{
+    struct test_es_out *test = container_of(out, struct test_es_out, out);
+    (void)id;
+
+    int cue;
+    assert(block->p_buffer[block->i_buffer - 1] == '\0');
+    assert(sscanf((const char *)block->p_buffer, "Cue %d\n", &cue) == 1);
+    assert(strstr((const char *)block->p_buffer, "\nsecond line\n") != NULL);
+    assert(block->i_length == VLC_TICK_FROM_SEC(1));
+
+    if (test->sent++ == 0)
+        test->first_cue = cue;
+    block_Release(block);
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel(es_out_t *out, es_out_id_t *id)
+{
+    (void)out; (void)id;
+}
+
+static int EsOutControl(es_out_t *out, input_source_t *in, int query,
+                        va_list args)
+{
+    (void)out; (void)in; (void)query; (void)args;
+    return VLC_EGENERIC;
+}
+
+static void EsOutDestroy(es_out_t *out)
+{
+    (void)out;
+}
+
+static const struct es_out_callbacks es_out_cbs =
+{
+    .add = EsOutAdd,
+    .send = EsOutSend,
+    .del = EsOutDel,
+    .control = EsOutControl,
+    .destroy = EsOutDestroy,
+};
+
+static long max_rss_kb(void)
+{
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        return usage.ru_maxrss;
+#endif
+    return 0;
+}
+
+static char *make_srt(size_t *size)
+{
+    struct vlc_memstream ms;
+    vlc_memstream_open(&ms);
+
+    for (unsigned i = 0; i < CUE_COUNT; i++)
+    {
+        unsigned start = i * CUE_INTERVAL;
+        unsigned stop = start + 1;
+        vlc_memstream_printf(&ms, "%u\n%02u:%02u:%02u,000 --> "
+                             "%02u:%02u:%02u,000\nCue %u\nsecond line\n\n",
+                             i + 1, start / 3600, start / 60 % 60, start % 60,
+                             stop / 3600, stop / 60 % 60, stop % 60, i);
+    }
+
+    int ret = vlc_memstream_close(&ms);
+    assert(ret == 0);
+    *size = ms.length;
+    return ms.ptr;
+}
+
+/* Seeks within a cue, which must be the first one sent again */
+static void seek_and_check(demux_t *demux, struct test_es_out *out,
+                           unsigned cue)
+{
+    /* Halfway through the cue */
+    vlc_tick_t time = vlc_tick_from_sec(cue * CUE_INTERVAL) +
+                      VLC_TICK_FROM_MS(500);
+
+    int ret = demux_Control(demux, DEMUX_SET_TIME, time, false);
+    assert(ret == VLC_SUCCESS);
+
+    out->sent = 0;
+    while (out->sent == 0)
+    {
+        /* The last cue ends the file */
+        ret = demux_Demux(demux);
+        assert(ret == VLC_DEMUXER_SUCCESS || out->sent > 0);
+    }
+    assert(out->first_cue == (int)cue);
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    assert(vlc != NULL);
+
+    size_t size;
+    char *srt = make_srt(&size);
+    assert(srt != NULL);
+
+    struct test_es_out out = { .out = { .cbs = &es_out_cbs } };
+
+    stream_t *s = vlc_stream_MemoryNew(vlc->p_libvlc_int, (uint8_t *)srt,
+                                       size, true);
+    assert(s != NULL);
+
+    const long rss = max_rss_kb();
+    vlc_tick_t start = vlc_tick_now();
+    demux_t *demux = demux_New(VLC_OBJECT(vlc->p_libvlc_int), "subtitle",
+                               INPUT_ITEM_URI_NOP, s, &out.out);
+    assert(demux != NULL);
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+
+    test_log("opened %d cues (%zu KiB) in %"PRId64" ms, "
+             "peak memory grew by %ld KiB\n", CUE_COUNT, size / 1024,
+             MS_FROM_VLC_TICK(elapsed), max_rss_kb() - rss);
+
+    vlc_tick_t length;
+    int ret = demux_Control(demux, DEMUX_GET_LENGTH, &length);
+    assert(ret == VLC_SUCCESS);
+    assert(length == VLC_TICK_0 +
+           vlc_tick_from_sec((CUE_COUNT - 1) * CUE_INTERVAL + 1));
+
+    /* Playback from the start */
+    while (out.sent < 10)
+        assert(demux_Demux(demux) == VLC_DEMUXER_SUCCESS);
+    assert(out.first_cue == 0);
+
+    /* Forwards, backwards, then to the last cue */
+    start = vlc_tick_now();
+    seek_and_check(demux, &out, CUE_COUNT / 2);
+    seek_and_check(demux, &out, CUE_COUNT / 3);
+    seek_and_check(demux, &out, 1);
+    seek_and_check(demux, &out, CUE_COUNT - 1);
+    test_log("seeked 4 times in %"PRId64" us\n",
+             US_FROM_VLC_TICK(vlc_tick_now() - start));
+
+    while (demux_Demux(demux) == VLC_DEMUXER_SUCCESS);
+    assert(out.sent == 1);
+
+    demux_Delete(demux);
+    free(srt);
+    libvlc_release(vlc);
+    return 0;
+}
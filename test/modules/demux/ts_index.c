@@ -0,0 +1,382 @@
+/*****************************************************************************
+ * ts_index.c: MPEG TS seek index and index cache tests
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_tick.h>
+
+#include "../../../modules/demux/mpeg/ts_index.h"
+
+#include <dirent.h>
+#include <ftw.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <utime.h>
+
+const char vlc_module_name[] = "test_modules_demux_ts_index";
+
+#define PACKET_SIZE  188
+#define PCR_PID      0x100
+#define VIDEO_PID    0x101
+#define FRAME_COUNT  250 /* 10s */
+#define FRAME_PCR    3600 /* 25 fps in 90 kHz units */
+#define GOP_SIZE     25
+#define LOOKUP_STEP  9000
+#define LAST_RAP     ((FRAME_COUNT - 1) / GOP_SIZE * GOP_SIZE * FRAME_PCR)
+
+/* Limits of the cache directory */
+#define CACHE_MAX_SIZE     (32 << 20)
+#define CACHE_MAX_AGE      (90 * 24 * 3600)
+
+/* Offsets in the cache file */
+#define CACHE_COUNT_OFFSET 252
+#define CACHE_ENTRIES      256
+#define CACHE_ENTRY_SIZE   25
+
+static void write_packet(FILE *file, uint16_t pid, int64_t pcr, bool rap)
+{
+    uint8_t p[PACKET_SIZE];
+
+    memset(p, 0xff, sizeof(p));
+    p[0] = 0x47;
+    p[1] = pid >> 8;
+    p[2] = pid & 0xff;
+    p[3] = 0x20; /* adaptation field only */
+    p[4] = PACKET_SIZE - 5;
+    p[5] = rap ? 0x40 : 0x00;
+    if (pcr >= 0)
+    {
+        p[5] |= 0x10;
+        p[6] = pcr >> 25;
+        p[7] = pcr >> 17;
+        p[8] = pcr >> 9;
+        p[9] = pcr >> 1;
+        p[10] = (pcr << 7) | 0x7e;
+        p[11] = 0;
+    }
+    size_t ret = fwrite(p, 1, sizeof(p), file);
+    assert(ret == sizeof(p));
+}
+
+/* A PCR packet then a video packet per frame, a keyframe every GOP_SIZE */
+static void write_ts(const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    assert(file != NULL);
+
+    for (unsigned i = 0; i < FRAME_COUNT; i++)
+    {
+        write_packet(file, PCR_PID, (int64_t)i * FRAME_PCR, false);
+        write_packet(file, VIDEO_PID, -1, i % GOP_SIZE == 0);
+    }
+    int ret = fclose(file);
+    assert(ret == 0);
+}
+
+static ts_index_t *open_index(vlc_object_t *obj, const char *url)
+{
+    const uint16_t pid = VIDEO_PID;
+    ts_index_t *index = ts_index_New(obj, url, PACKET_SIZE, 0, 1, PCR_PID,
+                                     &pid, 1);
+    assert(index != NULL);
+    return index;
+}
+
+/* Past the last entry, lookups only succeed once the whole file is read */
+static void wait_done(ts_index_t *index)
+{
+    uint64_t pos;
+    stime_t pcr;
+
+    while (ts_index_Lookup(index, FRAME_COUNT * FRAME_PCR, &pos, &pcr)
+           != VLC_SUCCESS)
+        (vlc_tick_sleep)(VLC_TICK_FROM_MS(10));
+}
+
+struct lookup
+{
+    uint64_t pos;
+    stime_t  pcr;
+};
+
+#define LOOKUP_COUNT (LAST_RAP / LOOKUP_STEP + 1)
+
+static void check_lookups(ts_index_t *index, struct lookup *lookups)
+{
+    for (unsigned i = 0; i < LOOKUP_COUNT; i++)
+    {
+        const stime_t time = i * LOOKUP_STEP;
+        uint64_t pos;
+        stime_t pcr;
+
+        int ret = ts_index_Lookup(index, time, &pos, &pcr);
+        assert(ret == VLC_SUCCESS);
+
+        /* the video packet of the last keyframe not after that time */
+        assert(pos % PACKET_SIZE == 0);
+        const uint64_t frame = (pos / PACKET_SIZE - 1) / 2;
+        assert(pos / PACKET_SIZE == frame * 2 + 1);
+        assert(frame % GOP_SIZE == 0);
+        assert((stime_t)frame * FRAME_PCR <= time);
+        assert(time - (stime_t)frame * FRAME_PCR < GOP_SIZE * FRAME_PCR);
+        assert(pcr == time);
+
+        if (lookups[i].pcr >= 0)
+            assert(pos == lookups[i].pos && pcr == lookups[i].pcr);
+        lookups[i].pos = pos;
+        lookups[i].pcr = pcr;
+    }
+}
+
+static uint8_t *read_file(const char *path, size_t *size)
+{
+    FILE *file = fopen(path, "rb");
+    assert(file != NULL);
+    int ret = fseek(file, 0, SEEK_END);
+    assert(ret == 0);
+    long len = ftell(file);
+    assert(len > 0);
+    rewind(file);
+
+    uint8_t *data = malloc(len);
+    assert(data != NULL);
+    size_t read = fread(data, 1, len, file);
+    assert(read == (size_t)len);
+    fclose(file);
+    *size = len;
+    return data;
+}
+
+static void write_file(const char *path, const uint8_t *data, size_t size)
+{
+    FILE *file = fopen(path, "wb");
+    assert(file != NULL);
+    size_t written = fwrite(data, 1, size, file);
+    assert(written == size);
+    int ret = fclose(file);
+    assert(ret == 0);
+}
+
+/* The cache is the only file of its directory */
+static char *find_cache(const char *tempdir)
+{
+    char *dirpath;
+    int ret = asprintf(&dirpath, "%s/vlc/ts-index", tempdir);
+    assert(ret >= 0);
+
+    DIR *dir = opendir(dirpath);
+    assert(dir != NULL);
+
+    char *path = NULL;
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL)
+    {
+        if (ent->d_name[0] == '.')
+            continue;
+        assert(path == NULL);
+        ret = asprintf(&path, "%s/%s", dirpath, ent->d_name);
+        assert(ret >= 0);
+    }
+    closedir(dir);
+    free(dirpath);
+    assert(path != NULL);
+    return path;
+}
+
+/* The file itself is gone, so anything indexed was read from the cache */
+static bool cache_accepted(vlc_object_t *obj, const char *url,
+                           const char *cache, const uint8_t *data, size_t size)
+{
+    uint64_t pos;
+    stime_t pcr;
+
+    write_file(cache, data, size);
+    ts_index_t *index = open_index(obj, url);
+    bool accepted = ts_index_Lookup(index, 0, &pos, &pcr) == VLC_SUCCESS;
+    ts_index_Delete(index);
+    return accepted;
+}
+
+/* Another cached index, of the given size, last written age seconds ago */
+static char *add_cache(const char *tempdir, const char *name, off_t size,
+                       time_t age)
+{
+    char *path;
+    int ret = asprintf(&path, "%s/vlc/ts-index/%s", tempdir, name);
+    assert(ret >= 0);
+
+    FILE *file = fopen(path, "wb");
+    assert(file != NULL);
+    ret = ftruncate(fileno(file), size); /* sparse */
+    assert(ret == 0);
+    ret = fclose(file);
+    assert(ret == 0);
+
+    const time_t now = time(NULL);
+    struct utimbuf times = { .actime = now - age, .modtime = now - age };
+    ret = utime(path, &times);
+    assert(ret == 0);
+    return path;
+}
+
+static void add_cache_dir(const char *tempdir)
+{
+    char *dirpath;
+    int ret = asprintf(&dirpath, "%s/vlc", tempdir);
+    assert(ret >= 0);
+    ret = mkdir(dirpath, 0700);
+    assert(ret == 0);
+    free(dirpath);
+    ret = asprintf(&dirpath, "%s/vlc/ts-index", tempdir);
+    assert(ret >= 0);
+    ret = mkdir(dirpath, 0700);
+    assert(ret == 0);
+    free(dirpath);
+}
+
+static int cleanup_tmpdir(const char *dirpath, const struct stat *sb,
+                          int typeflag, struct FTW *ftwbuf)
+{
+    (void)sb; (void)typeflag; (void)ftwbuf;
+    return remove(dirpath);
+}
+
+int main(void)
+{
+#if defined(_WIN32) || defined(__APPLE__)
+    /* The cache directory is only redirected through XDG_CACHE_HOME */
+    return 77;
+#else
+    char template[] = "/tmp/vlc.test.ts_index.XXXXXX";
+    const char *tempdir = mkdtemp(template);
+    assert(tempdir != NULL);
+    setenv("XDG_CACHE_HOME", tempdir, 1);
+
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    assert(vlc != NULL);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    char *path, *url;
+    int ret = asprintf(&path, "%s/test.ts", tempdir);
+    assert(ret >= 0);
+    ret = asprintf(&url, "file://%s", path);
+    assert(ret >= 0);
+    write_ts(path);
+
+    struct lookup lookups[LOOKUP_COUNT];
+    for (unsigned i = 0; i < LOOKUP_COUNT; i++)
+        lookups[i].pcr = -1;
+
+    /* Indexes of other files: too old, the oldest beyond the size limit,
+     * and one to keep */
+    add_cache_dir(tempdir);
+    char *old = add_cache(tempdir, "old.idx", 1024, CACHE_MAX_AGE + 3600);
+    char *big = add_cache(tempdir, "big.idx", CACHE_MAX_SIZE, 3600);
+    char *kept = add_cache(tempdir, "kept.idx", 1024, 60);
+
+    /* Index the file, which is cached when deleted */
+    ts_index_t *index = open_index(obj, url);
+    wait_done(index);
+    check_lookups(index, lookups);
+    ts_index_Delete(index);
+
+    /* Saving it evicted the others but the last one */
+    struct stat st;
+    assert(stat(old, &st) != 0 && stat(big, &st) != 0);
+    ret = unlink(kept);
+    assert(ret == 0);
+    free(kept);
+    free(big);
+    free(old);
+
+    char *cache = find_cache(tempdir);
+    size_t size;
+    uint8_t *data = read_file(cache, &size);
+    test_log("cache of %zu bytes\n", size);
+    assert(size > CACHE_ENTRIES &&
+           (size - CACHE_ENTRIES) % CACHE_ENTRY_SIZE == 0);
+    const size_t count = (size - CACHE_ENTRIES) / CACHE_ENTRY_SIZE;
+    assert(GetDWBE(&data[CACHE_COUNT_OFFSET]) == count && count >= 3);
+
+    /* Read it back without the file: it gives the same answers */
+    ret = unlink(path);
+    assert(ret == 0);
+    index = open_index(obj, url);
+    check_lookups(index, lookups);
+    ts_index_Delete(index);
+
+    /* Nothing was learned, so the cache was not rewritten */
+    size_t size2;
+    uint8_t *data2 = read_file(cache, &size2);
+    assert(size2 == size && !memcmp(data, data2, size));
+    free(data2);
+
+    /* Truncated anywhere */
+    for (size_t i = 0; i < size; i++)
+        assert(!cache_accepted(obj, url, cache, data, i));
+
+    uint8_t *bad = malloc(size);
+    assert(bad != NULL);
+
+    /* Other file format */
+    memcpy(bad, data, size);
+    bad[0] ^= 0xff;
+    assert(!cache_accepted(obj, url, cache, bad, size));
+
+    /* More entries than packets */
+    memcpy(bad, data, size);
+    SetDWBE(&bad[CACHE_COUNT_OFFSET], UINT32_MAX);
+    assert(!cache_accepted(obj, url, cache, bad, size));
+
+    /* Entry past the indexed part */
+    memcpy(bad, data, size);
+    SetQWBE(&bad[CACHE_ENTRIES + (count - 1) * CACHE_ENTRY_SIZE + 16],
+            UINT64_MAX);
+    assert(!cache_accepted(obj, url, cache, bad, size));
+
+    /* Entries out of order */
+    memcpy(bad, data, size);
+    SetQWBE(&bad[CACHE_ENTRIES + (count - 1) * CACHE_ENTRY_SIZE], 0);
+    assert(!cache_accepted(obj, url, cache, bad, size));
+
+    /* And the original still loads */
+    assert(cache_accepted(obj, url, cache, data, size));
+
+    free(bad);
+    free(data);
+    free(cache);
+    free(url);
+    free(path);
+    libvlc_release(vlc);
+
+    nftw(tempdir, cleanup_tmpdir, FOPEN_MAX, FTW_DEPTH | FTW_MOUNT | FTW_PHYS);
+    return 0;
+#endif
+}
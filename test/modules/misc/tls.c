@@ -33,6 +33,7 @@
 #include <sys/socket.h>
 #endif
 #include <poll.h>
+#include <stdatomic.h>
 
 #include "../../libvlc/test.h"
 
@@ -46,6 +47,15 @@
 
 static vlc_tls_server_t *server_creds;
 static vlc_tls_client_t *client_creds;
+static atomic_uint resumed;
+
+static void log_resumed(void *data, int level, const libvlc_log_t *ctx,
+                        const char *fmt, va_list ap)
+{
+    if (strcmp(fmt, " - session resumed") == 0)
+        atomic_fetch_add(&resumed, 1);
+    (void) data; (void) level; (void) ctx; (void) ap;
+}
 
 static void *tls_echo(void *data)
 {
@@ -177,6 +187,8 @@ int main(void)
         return 77;
     }
     obj = VLC_OBJECT(vlc->p_libvlc_int);
+    atomic_init(&resumed, 0);
+    libvlc_log_set(vlc, log_resumed, NULL);
 
     server_creds = vlc_tls_ServerCreate(obj, CERTFILE, NULL);
     assert(server_creds != NULL);
@@ -186,6 +198,7 @@ int main(void)
     /* Test known certificate */
     tls = securepair(&th, alpn, alpn, &alp);
     assert(tls != NULL);
+    assert(atomic_load(&resumed) == 0);
     assert(alp != NULL);
     assert(strcmp(alp, alpn[0]) == 0);
     free(alp);
@@ -216,9 +229,10 @@ int main(void)
     assert(val == 0);
     vlc_tls_Close(tls);
 
-    /* Test known certificate, ignore ALPN result */
+    /* Test known certificate, ignore ALPN result, and session resumption */
     tls = securepair(&th, alpn, alpn, NULL);
     assert(tls != NULL);
+    assert(atomic_load(&resumed) > 0);
 
     /* Do a lot of I/O, test congestion handling */
     static unsigned char data[16184];
@@ -0,0 +1,143 @@
+/*****************************************************************************
+ * csa.c: CSA (de)scrambling test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+#include "../../../lib/libvlc_internal.h"
+#include <vlc_common.h>
+
+#include "../../../modules/mux/mpeg/csa.h"
+
+#define PACKET_COUNT 20000 /* about 3.7 MB, a few tenths of a transponder second */
+#define PACKET_SIZE 188
+
+static void FillPackets(uint8_t *packets)
+{
+    for (size_t i = 0; i < PACKET_COUNT; i++)
+    {
+        uint8_t *pkt = &packets[i * PACKET_SIZE];
+
+        pkt[0] = 0x47;
+        pkt[1] = 0x01;
+        pkt[2] = 0x00;
+        pkt[3] = 0x10 | (i & 0x0f); /* payload only */
+        if (i % 10 == 0)
+        {
+            /* adaptation field, of variable size */
+            pkt[3] |= 0x20;
+            pkt[4] = i % 183;
+            memset(&pkt[5], 0xff, pkt[4]);
+            for (size_t j = 5 + pkt[4]; j < PACKET_SIZE; j++)
+                pkt[j] = i + j;
+        }
+        else
+        {
+            for (size_t j = 4; j < PACKET_SIZE; j++)
+                pkt[j] = i * 7 + j;
+        }
+    }
+}
+
+static void test_csa(vlc_object_t *obj)
+{
+    csa_t *csa = csa_New();
+    if (csa == NULL)
+    {
+        test_log("CSA not supported, skipping\n");
+        return;
+    }
+
+    char even[] = "0x0123456789abcdef", odd[] = "0xfedcba9876543210";
+    assert(csa_SetCW(obj, csa, even, false) == VLC_SUCCESS);
+    assert(csa_SetCW(obj, csa, odd, true) == VLC_SUCCESS);
+
+    uint8_t *clear = malloc(PACKET_COUNT * PACKET_SIZE);
+    uint8_t *single = malloc(PACKET_COUNT * PACKET_SIZE);
+    uint8_t *batched = malloc(PACKET_COUNT * PACKET_SIZE);
+    uint8_t **pkts = malloc(PACKET_COUNT * sizeof (*pkts));
+    assert(clear && single && batched && pkts);
+    FillPackets(clear);
+
+    /* Scramble with both keys, the key changing every 1000 packets */
+    memcpy(single, clear, PACKET_COUNT * PACKET_SIZE);
+    for (size_t i = 0; i < PACKET_COUNT; i++)
+    {
+        if (i % 1000 == 0)
+            csa_UseKey(obj, csa, (i / 1000) & 1);
+        csa_Encrypt(csa, &single[i * PACKET_SIZE], PACKET_SIZE);
+    }
+
+    memcpy(batched, clear, PACKET_COUNT * PACKET_SIZE);
+    vlc_tick_t start = vlc_tick_now();
+    for (size_t i = 0; i < PACKET_COUNT; i += 1000)
+    {
+        csa_UseKey(obj, csa, (i / 1000) & 1);
+        for (size_t j = 0; j < 1000; j++)
+            pkts[j] = &batched[(i + j) * PACKET_SIZE];
+        csa_EncryptBatch(csa, pkts, 1000, PACKET_SIZE);
+    }
+    test_log("scrambled %d packets by batches of %u in %"PRId64" us\n",
+             PACKET_COUNT, csa_GetBatchSize(csa),
+             US_FROM_VLC_TICK(vlc_tick_now() - start));
+    assert(!memcmp(single, batched, PACKET_COUNT * PACKET_SIZE));
+    assert(memcmp(single, clear, PACKET_COUNT * PACKET_SIZE));
+
+    /* Descramble packet per packet, then by batches mixing both keys */
+    start = vlc_tick_now();
+    for (size_t i = 0; i < PACKET_COUNT; i++)
+        csa_Decrypt(csa, &single[i * PACKET_SIZE], PACKET_SIZE);
+    test_log("descrambled %d packets one by one in %"PRId64" us\n",
+             PACKET_COUNT, US_FROM_VLC_TICK(vlc_tick_now() - start));
+    assert(!memcmp(single, clear, PACKET_COUNT * PACKET_SIZE));
+
+    for (size_t i = 0; i < PACKET_COUNT; i++)
+        pkts[i] = &batched[i * PACKET_SIZE];
+    start = vlc_tick_now();
+    csa_DecryptBatch(csa, pkts, PACKET_COUNT, PACKET_SIZE);
+    test_log("descrambled %d packets by batches in %"PRId64" us\n",
+             PACKET_COUNT, US_FROM_VLC_TICK(vlc_tick_now() - start));
+    assert(!memcmp(batched, clear, PACKET_COUNT * PACKET_SIZE));
+
+    free(pkts);
+    free(batched);
+    free(single);
+    free(clear);
+    csa_Delete(csa);
+}
+
+int main(void)
+{
+    test_init();
+
+    const char * const vlc_argv[] = {
+        "-vvv",
+    };
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(vlc_argv), vlc_argv);
+    assert(vlc != NULL);
+
+    test_csa(&vlc->p_libvlc_int->obj);
+
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,155 @@
+/*****************************************************************************
+ * freetype.c: FreeType text renderer test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+#include "../../../lib/libvlc_internal.h"
+#include <vlc_common.h>
+#include <vlc_filter.h>
+#include <vlc_subpicture.h>
+#include <vlc_text_style.h>
+
+#define WIDTH 1280
+#define HEIGHT 720
+#define FRAME_COUNT 500
+
+/* Subtitles usually stay on screen over many frames, and lines come back */
+static const char *const lines[] = {
+    "The quick brown fox jumps over the lazy dog",
+    "Pack my box with five dozen liquor jugs.\nHow vexingly quick daft zebras jump!",
+    "Sphinx of black quartz, judge my vow",
+    "Voix ambiguë d'un cœur qui, au zéphyr, préfère les jattes de kiwis",
+};
+
+static filter_t *CreateRenderer(vlc_object_t *root)
+{
+    filter_t *text = vlc_object_create(root, sizeof(*text));
+    assert(text != NULL);
+
+    es_format_Init(&text->fmt_in, VIDEO_ES, 0);
+    es_format_Init(&text->fmt_out, VIDEO_ES, 0);
+    text->fmt_out.video.i_width =
+    text->fmt_out.video.i_visible_width = WIDTH;
+    text->fmt_out.video.i_height =
+    text->fmt_out.video.i_visible_height = HEIGHT;
+
+    text->p_module = vlc_filter_LoadModule(text, "text renderer",
+                                           "freetype", true);
+    if (text->p_module == NULL)
+    {
+        vlc_object_delete(text);
+        return NULL;
+    }
+    return text;
+}
+
+static subpicture_region_t *NewTextRegion(const char *psz_text, bool b_outline)
+{
+    subpicture_region_t *region = subpicture_region_NewText();
+    assert(region != NULL);
+
+    region->p_text = text_segment_New(psz_text);
+    assert(region->p_text != NULL);
+
+    text_style_t *style = text_style_Create(STYLE_NO_DEFAULTS);
+    assert(style != NULL);
+    if (b_outline)
+    {
+        style->i_style_flags = STYLE_OUTLINE | STYLE_SHADOW;
+        style->i_features |= STYLE_HAS_FLAGS;
+    }
+    region->p_text->style = style;
+
+    region->i_x = 0;
+    region->i_y = 0;
+    region->i_align = SUBPICTURE_ALIGN_BOTTOM;
+    return region;
+}
+
+static int test_render(vlc_object_t *root)
+{
+    filter_t *text = CreateRenderer(root);
+    if (text == NULL)
+        return 77;
+
+    subpicture_region_t *regions[ARRAY_SIZE(lines) * 2];
+    for (size_t i = 0; i < ARRAY_SIZE(regions); i++)
+        regions[i] = NewTextRegion(lines[i / 2], i % 2);
+
+    /* First pass: every line is shaped and rasterized */
+    vlc_tick_t start = vlc_tick_now();
+    for (size_t i = 0; i < ARRAY_SIZE(regions); i++)
+    {
+        subpicture_region_t *rendered =
+            text->ops->render(text, regions[i], NULL);
+        if (rendered == NULL)
+        {
+            /* No usable font on this system */
+            for (size_t j = 0; j < ARRAY_SIZE(regions); j++)
+                subpicture_region_Delete(regions[j]);
+            vlc_filter_Delete(text);
+            return 77;
+        }
+        assert(!subpicture_region_IsText(rendered));
+        assert(rendered->fmt.i_visible_width > 0);
+        assert(rendered->fmt.i_visible_height > 0);
+        subpicture_region_Delete(rendered);
+    }
+    test_log("%zu regions rendered (cold) in %"PRId64" us\n",
+             ARRAY_SIZE(regions), US_FROM_VLC_TICK(vlc_tick_now() - start));
+
+    /* Then render the same lines over and over, as for displayed subtitles */
+    start = vlc_tick_now();
+    for (size_t i = 0; i < FRAME_COUNT; i++)
+    {
+        const subpicture_region_t *region =
+            regions[(i / 25) % ARRAY_SIZE(regions)];
+        subpicture_region_t *rendered = text->ops->render(text, region, NULL);
+        assert(rendered != NULL);
+        subpicture_region_Delete(rendered);
+    }
+    test_log("%d regions rendered (warm) in %"PRId64" us\n", FRAME_COUNT,
+             US_FROM_VLC_TICK(vlc_tick_now() - start));
+
+    for (size_t i = 0; i < ARRAY_SIZE(regions); i++)
+        subpicture_region_Delete(regions[i]);
+    vlc_filter_Delete(text);
+    return 0;
+}
+
+int main(void)
+{
+    test_init();
+
+    const char * const vlc_argv[] = {
+        "-vvv",
+    };
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(vlc_argv), vlc_argv);
+    assert(vlc != NULL);
+
+    int ret = test_render(&vlc->p_libvlc_int->obj);
+
+    libvlc_release(vlc);
+    return ret;
+}
@@ -0,0 +1,82 @@
+/*****************************************************************************
+ * chain_cost.c: test of the middle chroma ranking of the chroma chain
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <limits.h>
+
+#include <vlc_common.h>
+#include <vlc_fourcc.h>
+
+#include "../../../modules/video_chroma/chain_cost.h"
+
+#include "../../libvlc/test.h"
+
+/* Checks that the middle chromas are ranked in the given order */
+static void CheckOrder( vlc_fourcc_t i_in, vlc_fourcc_t i_out,
+                        const vlc_fourcc_t *pi_mids )
+{
+    unsigned i_prev = 0;
+
+    for( size_t i = 0; pi_mids[i] != 0; i++ )
+    {
+        unsigned i_cost = EstimateChromaCost( i_in, pi_mids[i], i_out );
+
+        test_log( "%4.4s -> %4.4s -> %4.4s: %u\n", (const char *)&i_in,
+                  (const char *)&pi_mids[i], (const char *)&i_out, i_cost );
+        assert( i_cost > i_prev || i == 0 );
+        i_prev = i_cost;
+    }
+}
+
+int main( void )
+{
+    /* Less data first */
+    CheckOrder( VLC_CODEC_I420, VLC_CODEC_RGBX, (const vlc_fourcc_t[]) {
+        VLC_CODEC_NV12, VLC_CODEC_I422, VLC_CODEC_I444, 0 } );
+
+    /* YUV to YUV through YUV rather than RGB of the same size */
+    CheckOrder( VLC_CODEC_I420, VLC_CODEC_I422, (const vlc_fourcc_t[]) {
+        VLC_CODEC_I444, VLC_CODEC_RGB24, 0 } );
+
+    /* Precision is not lost in the middle */
+    CheckOrder( VLC_CODEC_I420_10L, VLC_CODEC_I444_10L, (const vlc_fourcc_t[]) {
+        VLC_CODEC_I444_16L, VLC_CODEC_I420, VLC_CODEC_I444, 0 } );
+
+    /* Nor chroma resolution */
+    CheckOrder( VLC_CODEC_I444, VLC_CODEC_RGBX, (const vlc_fourcc_t[]) {
+        VLC_CODEC_I444, VLC_CODEC_RGBA, VLC_CODEC_I422, 0 } );
+
+    /* Packed 4:2:2 has 8 bits per component and half chroma resolution */
+    CheckOrder( VLC_CODEC_YUYV, VLC_CODEC_RGBX, (const vlc_fourcc_t[]) {
+        VLC_CODEC_I422, VLC_CODEC_RGBA, VLC_CODEC_I420, VLC_CODEC_RGB565LE,
+        0 } );
+    CheckOrder( VLC_CODEC_I444, VLC_CODEC_UYVY, (const vlc_fourcc_t[]) {
+        VLC_CODEC_YUYV, VLC_CODEC_I420, 0 } );
+
+    /* Hardware surfaces cannot be a middle chroma, but can be the ends */
+    assert( EstimateChromaCost( VLC_CODEC_I420, VLC_CODEC_VAAPI_420,
+                                VLC_CODEC_RGBX ) == UINT_MAX );
+    CheckOrder( VLC_CODEC_VAAPI_420, VLC_CODEC_RGBX, (const vlc_fourcc_t[]) {
+        VLC_CODEC_RGBA, VLC_CODEC_I420, 0 } );
+    return 0;
+}
@@ -0,0 +1,234 @@
+/*****************************************************************************
+ * point_ops.c: test and benchmark of the fused per-pixel video filters
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+/* Define a builtin module for mocked parts */
+#define MODULE_NAME test_modules_video_filter_point_ops
+#undef VLC_DYNAMIC_PLUGIN
+
+#include "../../libvlc/test.h"
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+#include <vlc_atomic.h>
+
+#define WIDTH  1920
+#define HEIGHT 1080
+#define FRAMES 50
+
+/* Adds one to every byte, counting the passes it makes itself */
+static atomic_uint lut_passes;
+
+VIDEO_FILTER_WRAPPER_POINT_OP(LutFilter, LutPointOp)
+
+static void LutFilter(filter_t *filter, picture_t *in, picture_t *out)
+{
+    (void)filter;
+    for (int i = 0; i < in->i_planes; i++)
+        for (int y = 0; y < in->p[i].i_visible_lines; y++)
+            for (int x = 0; x < in->p[i].i_visible_pitch; x++)
+                out->p[i].p_pixels[y * out->p[i].i_pitch + x] =
+                    in->p[i].p_pixels[y * in->p[i].i_pitch + x] + 1;
+    atomic_fetch_add(&lut_passes, 1);
+}
+
+static int LutPointOp(filter_t *filter, uint8_t lut[][256])
+{
+    const vlc_chroma_description_t *dsc =
+        vlc_fourcc_GetChromaDescription(filter->fmt_in.video.i_chroma);
+
+    for (unsigned i = 0; i < dsc->plane_count; i++)
+        for (unsigned j = 0; j < 256; j++)
+            lut[i][j] = j + 1;
+    return VLC_SUCCESS;
+}
+
+static int OpenLut(filter_t *filter)
+{
+    const vlc_chroma_description_t *dsc =
+        vlc_fourcc_GetChromaDescription(filter->fmt_in.video.i_chroma);
+
+    if (dsc == NULL || dsc->plane_count == 0 || dsc->pixel_size != 1)
+        return VLC_EGENERIC;
+    filter->ops = &LutFilter_ops;
+    return VLC_SUCCESS;
+}
+
+vlc_module_begin()
+    set_callback_video_filter(OpenLut)
+    add_shortcut("testlut")
+vlc_module_end()
+
+VLC_EXPORT const vlc_plugin_cb vlc_static_modules[] = {
+    VLC_SYMBOL(vlc_entry),
+    NULL
+};
+
+static picture_t *make_picture(vlc_fourcc_t chroma)
+{
+    video_format_t fmt;
+    video_format_Setup(&fmt, chroma, WIDTH, HEIGHT, WIDTH, HEIGHT, 1, 1);
+
+    picture_t *pic = picture_NewFromFormat(&fmt);
+    assert(pic != NULL);
+
+    uint32_t seed = chroma;
+    for (int i = 0; i < pic->i_planes; i++)
+        for (int j = 0; j < pic->p[i].i_lines * pic->p[i].i_pitch; j++)
+            pic->p[i].p_pixels[j] = test_rand(&seed);
+    return pic;
+}
+
+static bool same_picture(const picture_t *a, const picture_t *b)
+{
+    for (int i = 0; i < a->i_planes; i++)
+        for (int y = 0; y < a->p[i].i_visible_lines; y++)
+            if (memcmp(&a->p[i].p_pixels[y * a->p[i].i_pitch],
+                       &b->p[i].p_pixels[y * b->p[i].i_pitch],
+                       a->p[i].i_visible_pitch))
+                return false;
+    return true;
+}
+
+static filter_chain_t *new_chain(libvlc_instance_t *vlc, vlc_fourcc_t chroma,
+                                 const char *filters)
+{
+    es_format_t fmt;
+    es_format_Init(&fmt, VIDEO_ES, chroma);
+    video_format_Setup(&fmt.video, chroma, WIDTH, HEIGHT, WIDTH, HEIGHT, 1, 1);
+
+    filter_chain_t *chain = filter_chain_NewVideo(vlc->p_libvlc_int, false,
+                                                  NULL);
+    assert(chain != NULL);
+    filter_chain_Reset(chain, &fmt, NULL, &fmt);
+    int ret = filter_chain_AppendFromString(chain, filters);
+    assert(ret > 0);
+    es_format_Clean(&fmt);
+    return chain;
+}
+
+/* Runs the filters in one chain, then each in its own chain, which cannot
+ * fuse anything, and checks that they agree */
+static void test_recipe(libvlc_instance_t *vlc, vlc_fourcc_t chroma,
+                        const char *recipe)
+{
+    filter_chain_t *fused = new_chain(vlc, chroma, recipe);
+
+    filter_chain_t *separate[8];
+    size_t count = 0;
+    char *dup = strdup(recipe), *saveptr;
+    assert(dup != NULL);
+    for (char *name = strtok_r(dup, ":", &saveptr); name != NULL;
+         name = strtok_r(NULL, ":", &saveptr))
+    {
+        assert(count < ARRAY_SIZE(separate));
+        separate[count++] = new_chain(vlc, chroma, name);
+    }
+    free(dup);
+
+    picture_t *src = make_picture(chroma);
+    vlc_tick_t fused_time = 0, separate_time = 0;
+
+    for (unsigned i = 0; i < FRAMES; i++)
+    {
+        vlc_tick_t start = vlc_tick_now();
+        picture_t *out = filter_chain_VideoFilter(fused, picture_Hold(src));
+        vlc_tick_t mid = vlc_tick_now();
+        picture_t *ref = picture_Hold(src);
+        for (size_t j = 0; j < count; j++)
+            ref = filter_chain_VideoFilter(separate[j], ref);
+        vlc_tick_t end = vlc_tick_now();
+
+        assert(out != NULL && ref != NULL);
+        assert(same_picture(out, ref));
+        picture_Release(out);
+        picture_Release(ref);
+
+        fused_time += mid - start;
+        separate_time += end - mid;
+    }
+
+    test_log("%4.4s %s: %"PRId64" us instead of %"PRId64" us per frame\n",
+             (const char *)&chroma, recipe,
+             US_FROM_VLC_TICK(fused_time) / FRAMES,
+             US_FROM_VLC_TICK(separate_time) / FRAMES);
+
+    picture_Release(src);
+    for (size_t j = 0; j < count; j++)
+        filter_chain_Delete(separate[j]);
+    filter_chain_Delete(fused);
+}
+
+/* Checks how many passes a chain makes */
+static void test_passes(libvlc_instance_t *vlc, const char *filters,
+                        unsigned expected_lut_passes, int offset)
+{
+    filter_chain_t *chain = new_chain(vlc, VLC_CODEC_I420, filters);
+    picture_t *src = make_picture(VLC_CODEC_I420);
+
+    atomic_store(&lut_passes, 0);
+    picture_t *out = filter_chain_VideoFilter(chain, picture_Hold(src));
+    assert(out != NULL);
+
+    test_log("%s: %u pass(es) of testlut\n", filters,
+             atomic_load(&lut_passes));
+    assert(atomic_load(&lut_passes) == expected_lut_passes);
+
+    if (offset != 0)
+        for (int i = 0; i < src->i_planes; i++)
+            for (int x = 0; x < src->p[i].i_visible_pitch; x++)
+                assert(out->p[i].p_pixels[x] ==
+                       (uint8_t)(src->p[i].p_pixels[x] + offset));
+
+    picture_Release(out);
+    picture_Release(src);
+    filter_chain_Delete(chain);
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    assert(vlc != NULL);
+
+    /* A single filter runs as usual */
+    test_passes(vlc, "testlut", 1, 1);
+    /* Consecutive point operations run in a single pass */
+    test_passes(vlc, "testlut:testlut:testlut", 0, 3);
+    test_passes(vlc, "testlut:invert:testlut", 0, 0);
+    /* Hue rotation mixes the chroma planes, so it splits the sequence */
+    test_passes(vlc, "testlut:adjust{hue=30}:testlut", 2, 0);
+
+    test_recipe(vlc, VLC_CODEC_I420,
+                "adjust{contrast=1.3,brightness=1.1,saturation=1.4}:"
+                "invert:adjust{gamma=1.5,saturation=0.8}");
+    test_recipe(vlc, VLC_CODEC_I420, "adjust{hue=30}:invert");
+    test_recipe(vlc, VLC_CODEC_XRGB, "invert:posterize{level=4}:invert");
+
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,290 @@
+/*****************************************************************************
+ * decoder_pipeline.c: test and benchmark of the pipelined decoders
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+/* Define a builtin module for mocked parts */
+#define MODULE_NAME test_src_input_decoder_pipeline
+#undef VLC_DYNAMIC_PLUGIN
+
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_demux.h>
+#include <vlc_codec.h>
+#include <vlc_atomic.h>
+
+#include "mock_frames.h"
+
+#include <limits.h>
+
+#define TEST_CODEC     VLC_FOURCC('p','i','p','e')
+#define FRAME_COUNT    200
+#define FRAME_SIZE     1024
+/* Simulated work per frame of each stage */
+#define PACKETIZE_COST VLC_TICK_FROM_MS(1)
+#define DECODE_COST    VLC_TICK_FROM_MS(1)
+/* Fails a test rather than hanging it */
+#define WAIT_TIMEOUT   VLC_TICK_FROM_SEC(10)
+
+static atomic_uint frames_decoded;
+/* Frames decoded on another thread than the packetizer */
+static atomic_uint frames_staged;
+static atomic_ulong packetizer_thread;
+static _Atomic vlc_tick_t decode_busy;
+/* Frames decoded since the last flush when the decoder was drained */
+static atomic_uint frames_drained;
+static atomic_uint flushes;
+static bool can_seek;
+
+#define NOT_DRAINED UINT_MAX
+
+static void WaitAtLeast(atomic_uint *value, unsigned min)
+{
+    vlc_tick_t deadline = vlc_tick_now() + WAIT_TIMEOUT;
+    while (atomic_load(value) < min)
+    {
+        assert(vlc_tick_now() < deadline);
+        vlc_tick_sleep(VLC_TICK_FROM_MS(1));
+    }
+}
+
+static unsigned WaitDrained(void)
+{
+    vlc_tick_t deadline = vlc_tick_now() + WAIT_TIMEOUT;
+    unsigned drained;
+    while ((drained = atomic_load(&frames_drained)) == NOT_DRAINED)
+    {
+        assert(vlc_tick_now() < deadline);
+        vlc_tick_sleep(VLC_TICK_FROM_MS(1));
+    }
+    return drained;
+}
+
+static int OpenDemux(vlc_object_t *obj)
+{
+    /* Not packetized, so that the core loads a packetizer */
+    es_format_t fmt;
+    es_format_Init(&fmt, AUDIO_ES, TEST_CODEC);
+    fmt.audio.i_rate = 48000;
+    fmt.audio.i_channels = 2;
+
+    struct mock_frames *frames = mock_frames_Open((demux_t *)obj, &fmt,
+                                                  FRAME_COUNT, FRAME_SIZE);
+    frames->can_pace = true;
+    frames->can_seek = can_seek;
+    return VLC_SUCCESS;
+}
+
+static block_t *PacketizerPacketize(decoder_t *dec, block_t **in)
+{
+    block_t *ret = mock_frames_Packetize(dec, in);
+    if (ret != NULL)
+    {
+        atomic_store(&packetizer_thread, vlc_thread_id());
+        vlc_tick_sleep(PACKETIZE_COST);
+    }
+    return ret;
+}
+
+static int OpenPacketizer(vlc_object_t *obj)
+{
+    decoder_t *dec = (decoder_t *)obj;
+    if (dec->fmt_in->i_codec != TEST_CODEC)
+        return VLC_EGENERIC;
+
+    mock_frames_OpenPacketizer(dec);
+    dec->pf_packetize = PacketizerPacketize;
+    return VLC_SUCCESS;
+}
+
+struct decoder_sys
+{
+    unsigned next;
+};
+
+static int DecoderDecode(decoder_t *dec, block_t *block)
+{
+    struct decoder_sys *sys = dec->p_sys;
+
+    if (block == NULL) /* drain */
+    {
+        atomic_store(&frames_drained, sys->next);
+        return VLCDEC_SUCCESS;
+    }
+
+    vlc_tick_t start = vlc_tick_now();
+    vlc_tick_sleep(DECODE_COST);
+
+    /* Frames reach the decoder once and in order */
+    assert(block->p_buffer[0] == (uint8_t)sys->next);
+    sys->next++;
+    block_Release(block);
+
+    if (vlc_thread_id() != atomic_load(&packetizer_thread))
+        atomic_fetch_add(&frames_staged, 1);
+
+    atomic_fetch_add(&decode_busy, vlc_tick_now() - start);
+    atomic_fetch_add(&frames_decoded, 1);
+    return VLCDEC_SUCCESS;
+}
+
+static void DecoderFlush(decoder_t *dec)
+{
+    struct decoder_sys *sys = dec->p_sys;
+
+    /* Frames queued before the flush must not reach the decoder after it */
+    sys->next = 0;
+    atomic_store(&frames_drained, NOT_DRAINED);
+    atomic_fetch_add(&flushes, 1);
+}
+
+static int OpenDecoder(vlc_object_t *obj)
+{
+    decoder_t *dec = (decoder_t *)obj;
+    if (dec->fmt_in->i_codec != TEST_CODEC)
+        return VLC_EGENERIC;
+
+    struct decoder_sys *sys = vlc_obj_malloc(obj, sizeof(*sys));
+    assert(sys != NULL);
+    sys->next = 0;
+
+    dec->p_sys = sys;
+    dec->pf_decode = DecoderDecode;
+    dec->pf_flush = DecoderFlush;
+    return VLC_SUCCESS;
+}
+
+vlc_module_begin()
+    set_callback(OpenDemux)
+    set_capability("access", INT_MAX)
+    add_shortcut("pipetest")
+
+    add_submodule()
+        set_callback(OpenPacketizer)
+        set_capability("packetizer", INT_MAX)
+
+    add_submodule()
+        set_callback(OpenDecoder)
+        set_capability("audio decoder", INT_MAX)
+vlc_module_end()
+
+VLC_EXPORT const vlc_plugin_cb vlc_static_modules[] = {
+    VLC_SYMBOL(vlc_entry),
+    NULL
+};
+
+static libvlc_media_player_t *Create(libvlc_instance_t **vlcp, bool pipeline,
+                                     bool seekable)
+{
+    const char *args[] = {
+        "-v", "--vout=vdummy", "--aout=adummy", "--text-renderer=tdummy",
+        pipeline ? "--decoder-pipeline" : "--no-decoder-pipeline",
+    };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(args), args);
+    assert(vlc != NULL);
+
+    libvlc_media_t *media = libvlc_media_new_location("pipetest://");
+    assert(media != NULL);
+    libvlc_media_player_t *mp = libvlc_media_player_new_from_media(vlc, media);
+    assert(mp != NULL);
+    libvlc_media_release(media);
+
+    atomic_store(&frames_decoded, 0);
+    atomic_store(&frames_staged, 0);
+    atomic_store(&frames_drained, NOT_DRAINED);
+    atomic_store(&flushes, 0);
+    atomic_store(&decode_busy, 0);
+    can_seek = seekable;
+
+    *vlcp = vlc;
+    return mp;
+}
+
+static void Stop(libvlc_instance_t *vlc, libvlc_media_player_t *mp)
+{
+    libvlc_media_player_stop_async(mp);
+    libvlc_media_player_release(mp);
+    libvlc_release(vlc);
+}
+
+static void test_pipeline(bool pipeline)
+{
+    libvlc_instance_t *vlc;
+    libvlc_media_player_t *mp = Create(&vlc, pipeline, false);
+
+    vlc_tick_t start = vlc_tick_now();
+    int ret = libvlc_media_player_play(mp);
+    assert(ret == 0);
+
+    WaitAtLeast(&frames_decoded, FRAME_COUNT);
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+
+    test_log("%s: %d frames in %"PRId64" ms, decoder busy %.1f%% of the time\n",
+             pipeline ? "pipelined" : "serial", FRAME_COUNT,
+             MS_FROM_VLC_TICK(elapsed),
+             100. * atomic_load(&decode_busy) / elapsed);
+
+    /* Frames go through the decoding stage only when it is enabled */
+    assert(atomic_load(&frames_staged) == (pipeline ? FRAME_COUNT : 0));
+
+    /* The end of stream drains the decoder after its last frame */
+    assert(WaitDrained() == FRAME_COUNT);
+    assert(atomic_load(&flushes) == 0);
+
+    Stop(vlc, mp);
+}
+
+static void test_seek(bool pipeline)
+{
+    libvlc_instance_t *vlc;
+    libvlc_media_player_t *mp = Create(&vlc, pipeline, true);
+
+    int ret = libvlc_media_player_play(mp);
+    assert(ret == 0);
+
+    /* Seek back while frames are still queued in both stages */
+    WaitAtLeast(&frames_decoded, FRAME_COUNT / 8);
+    ret = libvlc_media_player_set_time(mp, 0, false);
+    assert(ret == 0);
+
+    /* The flush discarded them, and the decoder then got every frame again
+     * in order, from the first one, before the drain */
+    assert(WaitDrained() == FRAME_COUNT);
+    assert(atomic_load(&flushes) >= 1);
+    test_log("%s: seek, %u frames decoded\n",
+             pipeline ? "pipelined" : "serial", atomic_load(&frames_decoded));
+
+    Stop(vlc, mp);
+}
+
+int main(void)
+{
+    test_init();
+
+    test_pipeline(false);
+    test_pipeline(true);
+    test_seek(false);
+    test_seek(true);
+    return 0;
+}
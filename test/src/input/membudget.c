@@ -0,0 +1,87 @@
+/*****************************************************************************
+ * membudget.c: test for the memory budget of buffered media data
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_membudget.h>
+
+#define MiB ((size_t)1024 * 1024)
+
+static void test_unlimited(void)
+{
+    libvlc_instance_t *vlc = libvlc_new(test_defaults_nargs,
+                                        test_defaults_args);
+    assert(vlc != NULL);
+    libvlc_int_t *obj = vlc->p_libvlc_int;
+
+    vlc_membudget_Add(obj, VLC_MEMBUDGET_DECODER, 1024 * MiB);
+    assert(vlc_membudget_GetUsage(obj, VLC_MEMBUDGET_DECODER) == 1024 * MiB);
+    assert(!vlc_membudget_IsExceeded(obj));
+    vlc_membudget_Remove(obj, VLC_MEMBUDGET_DECODER, 1024 * MiB);
+
+    libvlc_release(vlc);
+}
+
+static void test_limited(void)
+{
+    const char *args[] = {
+        "-v", "--vout=vdummy", "--aout=adummy", "--text-renderer=tdummy",
+        "--input-memory-budget=8",
+    };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(args), args);
+    assert(vlc != NULL);
+    libvlc_int_t *obj = vlc->p_libvlc_int;
+
+    for (int i = 0; i < VLC_MEMBUDGET_SOURCE_COUNT; i++)
+        assert(vlc_membudget_GetUsage(obj, i) == 0);
+
+    /* The budget covers all the sources together */
+    vlc_membudget_Add(obj, VLC_MEMBUDGET_DEMUX, 3 * MiB);
+    vlc_membudget_Add(obj, VLC_MEMBUDGET_DECODER, 3 * MiB);
+    vlc_membudget_Add(obj, VLC_MEMBUDGET_SOUT, 2 * MiB);
+    assert(!vlc_membudget_IsExceeded(obj));
+
+    vlc_membudget_Add(obj, VLC_MEMBUDGET_DECODER, 1);
+    assert(vlc_membudget_IsExceeded(obj));
+    assert(vlc_membudget_GetUsage(obj, VLC_MEMBUDGET_DECODER) == 3 * MiB + 1);
+
+    vlc_membudget_Remove(obj, VLC_MEMBUDGET_SOUT, 1);
+    assert(!vlc_membudget_IsExceeded(obj));
+    assert(vlc_membudget_GetUsage(obj, VLC_MEMBUDGET_SOUT) == 2 * MiB - 1);
+
+    vlc_membudget_Remove(obj, VLC_MEMBUDGET_DEMUX, 3 * MiB);
+    vlc_membudget_Remove(obj, VLC_MEMBUDGET_DECODER, 3 * MiB + 1);
+    vlc_membudget_Remove(obj, VLC_MEMBUDGET_SOUT, 2 * MiB - 1);
+
+    for (int i = 0; i < VLC_MEMBUDGET_SOURCE_COUNT; i++)
+        assert(vlc_membudget_GetUsage(obj, i) == 0);
+
+    libvlc_release(vlc);
+}
+
+int main(void)
+{
+    test_init();
+
+    test_unlimited();
+    test_limited();
+    return 0;
+}
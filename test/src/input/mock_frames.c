@@ -0,0 +1,143 @@
+/*****************************************************************************
+ * mock_frames.c: mocked frame source for the input tests
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#define MODULE_STRING "test_mock_frames"
+
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_codec.h>
+
+#include "mock_frames.h"
+
+#define FRAME_DURATION VLC_TICK_FROM_MS(10)
+
+static int Demux(demux_t *demux)
+{
+    struct mock_frames *sys = demux->p_sys;
+
+    if (sys->gate != NULL && !atomic_load(sys->gate))
+    {
+        vlc_tick_sleep(VLC_TICK_FROM_MS(1));
+        return VLC_DEMUXER_SUCCESS;
+    }
+    if (sys->sent == sys->count)
+        return VLC_DEMUXER_EOF;
+
+    block_t *block = block_Alloc(sys->size);
+    assert(block != NULL);
+    memset(block->p_buffer, sys->sent, sys->size);
+    block->i_pts = block->i_dts = VLC_TICK_0 + sys->sent * FRAME_DURATION;
+    block->i_length = FRAME_DURATION;
+    es_out_SetPCR(demux->out, block->i_dts);
+    es_out_Send(demux->out, sys->es, block);
+    if (sys->read != NULL)
+        atomic_fetch_add(sys->read, sys->size);
+    sys->sent++;
+    return VLC_DEMUXER_SUCCESS;
+}
+
+static int Control(demux_t *demux, int query, va_list args)
+{
+    struct mock_frames *sys = demux->p_sys;
+
+    switch (query)
+    {
+        case DEMUX_GET_PTS_DELAY:
+            *va_arg(args, vlc_tick_t *) = 0;
+            return VLC_SUCCESS;
+        case DEMUX_CAN_SEEK:
+            *va_arg(args, bool *) = sys->can_seek;
+            return VLC_SUCCESS;
+        case DEMUX_CAN_PAUSE:
+            *va_arg(args, bool *) = false;
+            return VLC_SUCCESS;
+        case DEMUX_GET_LENGTH:
+            *va_arg(args, vlc_tick_t *) = sys->count * FRAME_DURATION;
+            return VLC_SUCCESS;
+        case DEMUX_GET_TIME:
+            *va_arg(args, vlc_tick_t *) = VLC_TICK_0 + sys->sent * FRAME_DURATION;
+            return VLC_SUCCESS;
+        case DEMUX_SET_TIME:
+        {
+            if (!sys->can_seek)
+                return VLC_EGENERIC;
+            /* From the frame starting at that time */
+            vlc_tick_t time = va_arg(args, vlc_tick_t);
+            unsigned frame = time > VLC_TICK_0
+                           ? (time - VLC_TICK_0) / FRAME_DURATION : 0;
+            sys->sent = __MIN(frame, sys->count);
+            return VLC_SUCCESS;
+        }
+        case DEMUX_CAN_CONTROL_PACE:
+            *va_arg(args, bool *) = sys->can_pace;
+            return VLC_SUCCESS;
+        default:
+            return VLC_EGENERIC;
+    }
+}
+
+struct mock_frames *mock_frames_Open(demux_t *demux, const es_format_t *fmt,
+                                     unsigned count, size_t size)
+{
+    struct mock_frames *sys = vlc_obj_malloc(VLC_OBJECT(demux), sizeof(*sys));
+    assert(sys != NULL);
+
+    sys->es = es_out_Add(demux->out, fmt);
+    assert(sys->es != NULL);
+    sys->count = count;
+    sys->size = size;
+    sys->can_pace = false;
+    sys->can_seek = false;
+    sys->gate = NULL;
+    sys->read = NULL;
+    sys->sent = 0;
+
+    demux->p_sys = sys;
+    demux->pf_demux = Demux;
+    demux->pf_control = Control;
+    return sys;
+}
+
+block_t *mock_frames_Packetize(decoder_t *dec, block_t **in)
+{
+    (void)dec;
+    if (in == NULL || *in == NULL)
+        return NULL;
+
+    block_t *ret = *in;
+    *in = NULL;
+    return ret;
+}
+
+void mock_frames_OpenPacketizer(decoder_t *dec)
+{
+    dec->pf_packetize = mock_frames_Packetize;
+    dec->pf_get_cc = NULL;
+    dec->pf_flush = NULL;
+    es_format_Clean(&dec->fmt_out);
+    es_format_Copy(&dec->fmt_out, dec->fmt_in);
+}
@@ -0,0 +1,59 @@
+/*****************************************************************************
+ * mock_frames.h: mocked frame source for the input tests
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef TEST_MOCK_FRAMES_H
+#define TEST_MOCK_FRAMES_H
+
+#include <vlc_common.h>
+#include <vlc_atomic.h>
+#include <vlc_demux.h>
+#include <vlc_codec.h>
+
+/* Demuxer sending numbered frames on a single ES: frame n is filled with the
+ * byte n, and lasts 10 ms */
+struct mock_frames
+{
+    es_out_id_t *es;
+    unsigned     count; /* frames to send */
+    size_t       size; /* of each frame */
+    bool         can_pace; /* reported to DEMUX_CAN_CONTROL_PACE */
+    bool         can_seek; /* reported to DEMUX_CAN_SEEK, seeks by time */
+    atomic_bool *gate; /* if not NULL, frames are held until it is set */
+    atomic_size_t *read; /* if not NULL, counts the bytes sent */
+    unsigned     sent;
+};
+
+/**
+ * Sets up a demuxer sending count frames of the given size on one ES.
+ *
+ * The frame source is allocated with the demuxer and can be adjusted until
+ * the first call to pf_demux.
+ */
+struct mock_frames *mock_frames_Open(demux_t *demux, const es_format_t *fmt,
+                                     unsigned count, size_t size);
+
+/**
+ * Sets up a packetizer passing the frames through, with mock_frames_Packetize.
+ */
+void mock_frames_OpenPacketizer(decoder_t *dec);
+
+block_t *mock_frames_Packetize(decoder_t *dec, block_t **in);
+
+#endif
@@ -0,0 +1,244 @@
+/*****************************************************************************
+ * vlm.c: test for VLM broadcasts sharing their input
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+/* Define a builtin module for mocked parts */
+#define MODULE_NAME test_src_input_vlm
+#undef VLC_DYNAMIC_PLUGIN
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_demux.h>
+#include <vlc_codec.h>
+#include <vlc_sout.h>
+#include <vlc_vlm.h>
+#include <vlc_atomic.h>
+
+#include "mock_frames.h"
+
+#include <limits.h>
+#include <time.h>
+
+#define FRAME_COUNT 200
+#define FRAME_SIZE  4096
+#define MEDIA_COUNT 3
+
+/* Frames are sent once every instance is started */
+static atomic_bool gate;
+static atomic_uint source_opens;
+static atomic_uint chains_closed;
+static atomic_uint frames_received;
+static atomic_size_t bytes_read;
+
+static int OpenDemux(vlc_object_t *obj)
+{
+    es_format_t fmt;
+    es_format_Init(&fmt, AUDIO_ES, VLC_CODEC_S16L);
+    fmt.audio.i_rate = 48000;
+    fmt.audio.i_channels = 2;
+    fmt.b_packetized = true;
+
+    struct mock_frames *frames = mock_frames_Open((demux_t *)obj, &fmt,
+                                                  FRAME_COUNT, FRAME_SIZE);
+    frames->gate = &gate;
+    frames->read = &bytes_read;
+    atomic_fetch_add(&source_opens, 1);
+    return VLC_SUCCESS;
+}
+
+static int OpenPacketizer(vlc_object_t *obj)
+{
+    mock_frames_OpenPacketizer((decoder_t *)obj);
+    return VLC_SUCCESS;
+}
+
+struct count_sys
+{
+    unsigned frames;
+};
+
+static void *CountAdd(sout_stream_t *stream, const es_format_t *fmt,
+                      const char *es_id)
+{
+    (void)fmt; (void)es_id;
+    return stream->p_sys;
+}
+
+static void CountDel(sout_stream_t *stream, void *id)
+{
+    (void)stream; (void)id;
+}
+
+static int CountSend(sout_stream_t *stream, void *id, block_t *block)
+{
+    struct count_sys *sys = stream->p_sys;
+    (void)id;
+
+    /* Every output gets the frames intact */
+    assert(block->i_buffer == FRAME_SIZE);
+    assert(block->p_buffer[0] == (uint8_t)sys->frames);
+    sys->frames++;
+    block_Release(block);
+    return VLC_SUCCESS;
+}
+
+static void CloseCount(sout_stream_t *stream)
+{
+    struct count_sys *sys = stream->p_sys;
+
+    /* Stopped before the gate opened, or fed everything */
+    assert(sys->frames == 0 || sys->frames == FRAME_COUNT);
+    atomic_fetch_add(&frames_received, sys->frames);
+    atomic_fetch_add(&chains_closed, 1);
+    free(sys);
+}
+
+static int OpenCount(vlc_object_t *obj)
+{
+    sout_stream_t *stream = (sout_stream_t *)obj;
+    static const struct sout_stream_operations ops = {
+        .add = CountAdd,
+        .del = CountDel,
+        .send = CountSend,
+        .close = CloseCount,
+    };
+    struct count_sys *sys = malloc(sizeof(*sys));
+    assert(sys != NULL);
+    sys->frames = 0;
+    stream->p_sys = sys;
+    stream->ops = &ops;
+    return VLC_SUCCESS;
+}
+
+vlc_module_begin()
+    set_callback(OpenDemux)
+    set_capability("access", INT_MAX)
+    add_shortcut("vlmtest")
+
+    add_submodule()
+        set_callback(OpenPacketizer)
+        set_capability("packetizer", INT_MAX)
+
+    add_submodule()
+        set_callback(OpenCount)
+        set_capability("sout output", 0)
+        add_shortcut("vlmcount")
+vlc_module_end()
+
+VLC_EXPORT const vlc_plugin_cb vlc_static_modules[] = {
+    VLC_SYMBOL(vlc_entry),
+    NULL
+};
+
+static void execute(vlm_t *vlm, const char *fmt, ...)
+{
+    char *cmd;
+    va_list ap;
+
+    va_start(ap, fmt);
+    int len = vasprintf(&cmd, fmt, ap);
+    va_end(ap);
+    assert(len >= 0);
+
+    vlm_message_t *msg;
+    int ret = vlm_ExecuteCommand(vlm, cmd, &msg);
+    if (ret != VLC_SUCCESS)
+        test_log("%s: %s\n", cmd, msg->psz_value);
+    assert(ret == VLC_SUCCESS);
+    vlm_MessageDelete(msg);
+    free(cmd);
+}
+
+static double cpu_time(void)
+{
+    struct timespec ts;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts))
+        return 0.;
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void test_broadcasts(bool share)
+{
+    const char *args[] = {
+        "-v", "--vout=vdummy", "--aout=adummy", "--text-renderer=tdummy",
+        share ? "--vlm-share-inputs" : "--no-vlm-share-inputs",
+    };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(args), args);
+    assert(vlc != NULL);
+
+    vlm_t *vlm = vlm_New(vlc->p_libvlc_int, NULL);
+    assert(vlm != NULL);
+
+    atomic_store(&gate, false);
+    atomic_store(&source_opens, 0);
+    atomic_store(&chains_closed, 0);
+    atomic_store(&frames_received, 0);
+    atomic_store(&bytes_read, 0);
+
+    for (int i = 0; i < MEDIA_COUNT; i++)
+    {
+        execute(vlm, "new ch%d broadcast enabled", i);
+        execute(vlm, "setup ch%d input vlmtest://", i);
+        execute(vlm, "setup ch%d output #vlmcount", i);
+        execute(vlm, "control ch%d play", i);
+    }
+
+    while (atomic_load(&source_opens) < (share ? 1 : MEDIA_COUNT))
+        vlc_tick_sleep(VLC_TICK_FROM_MS(10));
+
+    /* An instance leaving does not disturb the others */
+    execute(vlm, "control ch1 stop");
+
+    const double start = cpu_time();
+    atomic_store(&gate, true);
+    while (atomic_load(&chains_closed) < MEDIA_COUNT)
+        vlc_tick_sleep(VLC_TICK_FROM_MS(10));
+
+    /* Report only, the CPU time depends on the machine */
+    test_log("%s inputs: %u opened, %zu bytes read, %.3f s of CPU time\n",
+             share ? "shared" : "separate", atomic_load(&source_opens),
+             atomic_load(&bytes_read), cpu_time() - start);
+
+    /* The stopped instance read nothing, the others read the source once
+     * each, or once for all */
+    const size_t source_size = (size_t)FRAME_COUNT * FRAME_SIZE;
+    assert(atomic_load(&source_opens) == (share ? 1 : MEDIA_COUNT));
+    assert(atomic_load(&bytes_read) ==
+           (share ? 1 : MEDIA_COUNT - 1) * source_size);
+    assert(atomic_load(&frames_received) == (MEDIA_COUNT - 1) * FRAME_COUNT);
+
+    vlm_Delete(vlm);
+    libvlc_release(vlc);
+}
+
+int main(void)
+{
+    test_init();
+
+    test_broadcasts(false);
+    test_broadcasts(true);
+    return 0;
+}
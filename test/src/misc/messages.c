@@ -0,0 +1,329 @@
+/*****************************************************************************
+ * messages.c: test for the message logging
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Define a builtin module for mocked parts */
+#define MODULE_NAME test_src_misc_messages
+#undef VLC_DYNAMIC_PLUGIN
+
+#include "../../libvlc/test.h"
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_interface.h>
+
+struct log_sys
+{
+    int verbosity;
+    unsigned count[VLC_MSG_DBG + 1];
+    char last[64];
+};
+
+static void Log(void *opaque, int type, const vlc_log_t *item,
+                const char *format, va_list ap)
+{
+    struct log_sys *sys = opaque;
+
+    assert(type <= sys->verbosity);
+    sys->count[type]++;
+    vsnprintf(sys->last, sizeof (sys->last), format, ap);
+    (void) item;
+}
+
+static int Verbosity(void *opaque)
+{
+    struct log_sys *sys = opaque;
+
+    return sys->verbosity;
+}
+
+static const struct vlc_logger_operations ops = { Log, NULL, Verbosity };
+
+static void log_all(vlc_object_t *obj)
+{
+    msg_Info(obj, "info %d", VLC_MSG_INFO);
+    msg_Err(obj, "error %d", VLC_MSG_ERR);
+    msg_Warn(obj, "warning %d", VLC_MSG_WARN);
+    msg_Dbg(obj, "debug %d", VLC_MSG_DBG);
+}
+
+static void test_verbosity(libvlc_int_t *vlc)
+{
+    vlc_object_t *obj = VLC_OBJECT(vlc);
+    struct log_sys sys;
+
+    for (int verbosity = -1; verbosity <= VLC_MSG_DBG; verbosity++)
+    {
+        memset(&sys, 0, sizeof (sys));
+        sys.verbosity = verbosity;
+        vlc_LogSet(vlc, &ops, &sys);
+        memset(sys.count, 0, sizeof (sys.count)); /* startup messages */
+
+        log_all(obj);
+
+        /* Through a prefixed log */
+        struct vlc_logger *header = vlc_LogHeaderCreate(obj->logger, "test");
+        assert(header != NULL);
+        vlc_warning(header, "prefixed %s", "warning");
+        vlc_LogDestroy(header);
+
+        for (int type = VLC_MSG_INFO; type <= VLC_MSG_DBG; type++)
+        {
+            unsigned expected = (type <= verbosity) ? 1 : 0;
+            if (type == VLC_MSG_WARN && verbosity >= VLC_MSG_WARN)
+                expected++;
+            assert(sys.count[type] == expected);
+        }
+        if (verbosity >= VLC_MSG_WARN)
+            assert(!strcmp(sys.last, "prefixed warning"));
+    }
+
+    vlc_LogSet(vlc, NULL, NULL);
+}
+
+/* Ring size of the asynchronous log, as in src/misc/messages.c */
+#define ASYNC_RING    1024
+#define ASYNC_THREADS 4
+#define ASYNC_COUNT   200
+
+struct async_sys
+{
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    bool blocked;
+    bool closed;
+    unsigned next[ASYNC_THREADS];
+    unsigned received;
+    unsigned long dropped;
+};
+
+static struct async_sys async_sys = {
+    .lock = VLC_STATIC_MUTEX,
+    .wait = VLC_STATIC_COND,
+};
+
+static void AsyncLog(void *opaque, int type, const vlc_log_t *item,
+                     const char *format, va_list ap)
+{
+    struct async_sys *sys = opaque;
+    char msg[64];
+    unsigned thread, seq;
+    unsigned long dropped;
+
+    vsnprintf(msg, sizeof (msg), format, ap);
+    (void) item;
+
+    vlc_mutex_lock(&sys->lock);
+    assert(!sys->closed);
+    if (!strcmp(msg, "async block"))
+    {
+        /* Hold the background thread until the test releases it */
+        sys->blocked = true;
+        vlc_cond_broadcast(&sys->wait);
+        while (sys->blocked)
+            vlc_cond_wait(&sys->wait, &sys->lock);
+    }
+    else if (sscanf(msg, "async %u %u", &thread, &seq) == 2)
+    {
+        /* Messages from one thread are passed on in order */
+        assert(thread < ASYNC_THREADS);
+        assert(seq >= sys->next[thread]);
+        sys->next[thread] = seq + 1;
+        sys->received++;
+    }
+    else if (type == VLC_MSG_WARN && strstr(msg, " message(s) dropped")
+          && sscanf(msg, "%lu", &dropped) == 1)
+        sys->dropped += dropped;
+    vlc_cond_broadcast(&sys->wait);
+    vlc_mutex_unlock(&sys->lock);
+}
+
+static void AsyncClose(void *opaque)
+{
+    struct async_sys *sys = opaque;
+
+    vlc_mutex_lock(&sys->lock);
+    sys->closed = true;
+    vlc_mutex_unlock(&sys->lock);
+}
+
+static int AsyncVerbosity(void *opaque)
+{
+    (void) opaque;
+    return VLC_MSG_DBG;
+}
+
+static const struct vlc_logger_operations async_ops = {
+    AsyncLog, AsyncClose, AsyncVerbosity
+};
+
+static const struct vlc_logger_operations *OpenLogger(vlc_object_t *obj,
+                                                      void **sysp)
+{
+    /* Only stand in for the console when testing the asynchronous log */
+    if (!var_InheritBool(obj, "log-async"))
+        return NULL;
+
+    *sysp = &async_sys;
+    return &async_ops;
+}
+
+vlc_module_begin()
+    set_capability("logger", 1000)
+    set_callback(OpenLogger)
+vlc_module_end()
+
+VLC_EXPORT const vlc_plugin_cb vlc_static_modules[] = {
+    VLC_SYMBOL(vlc_entry),
+    NULL
+};
+
+struct async_thread
+{
+    vlc_object_t *obj;
+    unsigned id;
+};
+
+static void *AsyncThread(void *data)
+{
+    struct async_thread *th = data;
+
+    for (unsigned i = 0; i < ASYNC_COUNT; i++)
+        msg_Dbg(th->obj, "async %u %u", th->id, i);
+    return NULL;
+}
+
+static void async_reset(struct async_sys *sys)
+{
+    vlc_mutex_lock(&sys->lock);
+    memset(sys->next, 0, sizeof (sys->next));
+    sys->received = 0;
+    sys->dropped = 0;
+    vlc_mutex_unlock(&sys->lock);
+}
+
+static void async_block(vlc_object_t *obj, struct async_sys *sys)
+{
+    msg_Dbg(obj, "async block");
+
+    vlc_mutex_lock(&sys->lock);
+    while (!sys->blocked)
+        vlc_cond_wait(&sys->wait, &sys->lock);
+    vlc_mutex_unlock(&sys->lock);
+}
+
+static void async_unblock(struct async_sys *sys)
+{
+    vlc_mutex_lock(&sys->lock);
+    sys->blocked = false;
+    vlc_cond_broadcast(&sys->wait);
+    vlc_mutex_unlock(&sys->lock);
+}
+
+static void test_async_order(vlc_object_t *obj, struct async_sys *sys)
+{
+    struct async_thread threads[ASYNC_THREADS];
+    vlc_thread_t handles[ASYNC_THREADS];
+
+    async_reset(sys);
+
+    /* Fewer messages than the ring holds: none are lost */
+    for (unsigned i = 0; i < ASYNC_THREADS; i++)
+    {
+        threads[i].obj = obj;
+        threads[i].id = i;
+        int ret = vlc_clone(&handles[i], AsyncThread, &threads[i]);
+        assert(ret == 0);
+    }
+    for (unsigned i = 0; i < ASYNC_THREADS; i++)
+        vlc_join(handles[i], NULL);
+
+    vlc_mutex_lock(&sys->lock);
+    while (sys->received < ASYNC_THREADS * ASYNC_COUNT)
+        vlc_cond_wait(&sys->wait, &sys->lock);
+    for (unsigned i = 0; i < ASYNC_THREADS; i++)
+        assert(sys->next[i] == ASYNC_COUNT);
+    assert(sys->dropped == 0);
+    vlc_mutex_unlock(&sys->lock);
+}
+
+static void test_async_overflow(vlc_object_t *obj, struct async_sys *sys)
+{
+    const unsigned total = 2 * ASYNC_RING;
+
+    async_reset(sys);
+    async_block(obj, sys);
+
+    /* The ring fills up while the background thread is held */
+    for (unsigned i = 0; i < total; i++)
+        msg_Dbg(obj, "async 0 %u", i);
+
+    async_unblock(sys);
+
+    /* The drop count is reported once the ring is drained */
+    vlc_mutex_lock(&sys->lock);
+    while (sys->dropped == 0)
+        vlc_cond_wait(&sys->wait, &sys->lock);
+    test_log("%u of %u messages passed, %lu dropped\n", sys->received, total,
+             sys->dropped);
+    assert(sys->received > 0 && sys->received < ASYNC_RING);
+    assert(sys->dropped >= total - sys->received);
+    vlc_mutex_unlock(&sys->lock);
+}
+
+static void test_async_close(libvlc_instance_t *vlc, struct async_sys *sys)
+{
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    async_reset(sys);
+    async_block(obj, sys);
+
+    for (unsigned i = 0; i < ASYNC_COUNT; i++)
+        msg_Dbg(obj, "async 0 %u", i);
+
+    /* Pending messages are passed on before the log is closed */
+    async_unblock(sys);
+    libvlc_release(vlc);
+
+    assert(sys->closed);
+    assert(sys->received == ASYNC_COUNT);
+    assert(sys->next[0] == ASYNC_COUNT);
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    assert(vlc != NULL);
+
+    test_verbosity(vlc->p_libvlc_int);
+
+    libvlc_release(vlc);
+
+    const char *args[] = { "--log-async" };
+    vlc = libvlc_new(ARRAY_SIZE(args), args);
+    assert(vlc != NULL);
+
+    test_async_order(VLC_OBJECT(vlc->p_libvlc_int), &async_sys);
+    test_async_overflow(VLC_OBJECT(vlc->p_libvlc_int), &async_sys);
+    test_async_close(vlc, &async_sys);
+    return 0;
+}
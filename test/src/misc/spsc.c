@@ -0,0 +1,110 @@
+/*****************************************************************************
+ * spsc.c: test for the single-producer single-consumer ring
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#include "../../../src/misc/spsc.h"
+
+#define RING_SIZE 16
+#define ITEM_COUNT 100000
+
+static void test_single_thread(void)
+{
+    struct vlc_spsc ring;
+    void *item;
+
+    assert(vlc_spsc_Init(&ring, 3) != 0);
+    assert(vlc_spsc_Init(&ring, RING_SIZE) == 0);
+    assert(!vlc_spsc_Pop(&ring, &item));
+
+    for (uintptr_t i = 0; i < RING_SIZE; i++)
+        assert(vlc_spsc_Push(&ring, (void *)(i + 1)));
+    assert(vlc_spsc_Count(&ring) == RING_SIZE);
+    assert(!vlc_spsc_Push(&ring, NULL));
+
+    for (uintptr_t i = 0; i < RING_SIZE; i++)
+    {
+        assert(vlc_spsc_Pop(&ring, &item));
+        assert(item == (void *)(i + 1));
+    }
+    assert(!vlc_spsc_Pop(&ring, &item));
+    assert(vlc_spsc_Count(&ring) == 0);
+
+    vlc_spsc_Destroy(&ring);
+}
+
+struct ctx
+{
+    struct vlc_spsc ring;
+    vlc_sem_t queued;
+    vlc_sem_t room;
+};
+
+static void *consumer(void *data)
+{
+    struct ctx *ctx = data;
+
+    for (uintptr_t i = 0; i < ITEM_COUNT; i++)
+    {
+        void *item;
+
+        vlc_sem_wait(&ctx->queued);
+        assert(vlc_spsc_Pop(&ctx->ring, &item));
+        vlc_sem_post(&ctx->room);
+        assert(item == (void *)i);
+    }
+    return NULL;
+}
+
+static void test_two_threads(void)
+{
+    struct ctx ctx;
+    vlc_thread_t th;
+
+    assert(vlc_spsc_Init(&ctx.ring, RING_SIZE) == 0);
+    vlc_sem_init(&ctx.queued, 0);
+    vlc_sem_init(&ctx.room, RING_SIZE);
+
+    assert(vlc_clone(&th, consumer, &ctx) == 0);
+
+    vlc_tick_t start = vlc_tick_now();
+    for (uintptr_t i = 0; i < ITEM_COUNT; i++)
+    {
+        vlc_sem_wait(&ctx.room);
+        assert(vlc_spsc_Push(&ctx.ring, (void *)i));
+        vlc_sem_post(&ctx.queued);
+    }
+    vlc_join(th, NULL);
+
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+    test_log("%d items handed over in %"PRId64" us\n", ITEM_COUNT,
+             US_FROM_VLC_TICK(elapsed));
+
+    assert(vlc_spsc_Count(&ctx.ring) == 0);
+    vlc_spsc_Destroy(&ctx.ring);
+}
+
+int main(void)
+{
+    test_init();
+
+    test_single_thread();
+    test_two_threads();
+    return 0;
+}
@@ -0,0 +1,213 @@
+/*****************************************************************************
+ * spu.c: subpicture unit selection test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../libvlc/test.h"
+#include "../../../lib/libvlc_internal.h"
+#include <vlc_common.h>
+#include <vlc_spu.h>
+#include <vlc_subpicture.h>
+
+#define WIDTH 640
+#define HEIGHT 480
+
+#define SUBPICTURE_COUNT 4000
+#define CHANNEL_COUNT 2
+#define STEP VLC_TICK_FROM_MS(40)
+#define DURATION (3 * STEP) /* 3 subpictures visible per channel */
+#define FRAME_COUNT 2000
+
+static subpicture_t *NewSubpicture(ssize_t channel, vlc_tick_t start,
+                                   int64_t order)
+{
+    subpicture_t *subpic = subpicture_New(NULL);
+    assert(subpic != NULL);
+
+    video_format_t fmt;
+    video_format_Init(&fmt, VLC_CODEC_RGBA);
+    fmt.i_width = fmt.i_visible_width = 16;
+    fmt.i_height = fmt.i_visible_height = 16;
+    fmt.i_sar_num = fmt.i_sar_den = 1;
+
+    subpicture_region_t *region = subpicture_region_New(&fmt);
+    assert(region != NULL);
+    vlc_spu_regions_push(&subpic->regions, region);
+
+    subpic->i_channel = channel;
+    subpic->i_start = start;
+    subpic->i_stop = start + DURATION;
+    subpic->i_order = order;
+    subpic->b_subtitle = true;
+    subpic->b_ephemer = false;
+    subpic->i_original_picture_width = WIDTH;
+    subpic->i_original_picture_height = HEIGHT;
+    return subpic;
+}
+
+static size_t CountVisible(vlc_tick_t base, vlc_tick_t date)
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i < SUBPICTURE_COUNT; i++)
+    {
+        vlc_tick_t start = base + i * STEP;
+        if (start <= date && date < start + DURATION)
+            count++;
+    }
+    return count * CHANNEL_COUNT;
+}
+
+static void test_spu_select(vlc_object_t *root)
+{
+    spu_t *spu = spu_Create(root, NULL);
+    assert(spu != NULL);
+
+    ssize_t channels[CHANNEL_COUNT];
+    for (size_t i = 0; i < CHANNEL_COUNT; i++)
+    {
+        channels[i] = spu_RegisterChannel(spu);
+        assert(channels[i] != VOUT_SPU_CHANNEL_INVALID);
+    }
+
+    /* Leave time to queue everything before the first subpicture starts */
+    const vlc_tick_t base = vlc_tick_now() + VLC_TICK_FROM_SEC(10);
+
+    /* Queue the subpictures, mostly in order but with some swapped pairs */
+    vlc_tick_t start = vlc_tick_now();
+    int64_t order = 0;
+    for (size_t i = 0; i < SUBPICTURE_COUNT; i += 2)
+    {
+        for (size_t c = 0; c < CHANNEL_COUNT; c++)
+        {
+            bool swap = (i % 16) == 0;
+            vlc_tick_t first = base + (i + swap) * STEP;
+            vlc_tick_t second = base + (i + !swap) * STEP;
+
+            spu_PutSubpicture(spu, NewSubpicture(channels[c], first, order++));
+            spu_PutSubpicture(spu, NewSubpicture(channels[c], second, order++));
+        }
+    }
+    test_log("%d subpictures queued in %"PRId64" us\n",
+             SUBPICTURE_COUNT * CHANNEL_COUNT,
+             US_FROM_VLC_TICK(vlc_tick_now() - start));
+
+    video_format_t fmt;
+    video_format_Init(&fmt, VLC_CODEC_RGBA);
+    fmt.i_width = fmt.i_visible_width = WIDTH;
+    fmt.i_height = fmt.i_visible_height = HEIGHT;
+    fmt.i_sar_num = fmt.i_sar_den = 1;
+
+    /* Render at twice the subpicture rate, the dates being provided by the
+     * test, which selects through the whole set once */
+    vlc_tick_t elapsed = 0;
+    for (size_t i = 0; i < FRAME_COUNT; i++)
+    {
+        vlc_tick_t date = base + i * STEP / 2;
+
+        start = vlc_tick_now();
+        vlc_render_subpicture *render =
+            spu_Render(spu, NULL, &fmt, &fmt, false, NULL, date, date, false);
+        elapsed += vlc_tick_now() - start;
+
+        size_t expected = CountVisible(base, date);
+        size_t count = render != NULL ? render->regions.size : 0;
+        assert(count == expected);
+
+        if (render != NULL)
+            vlc_render_subpicture_Delete(render);
+    }
+    test_log("%d frames rendered in %"PRId64" us\n", FRAME_COUNT,
+             US_FROM_VLC_TICK(elapsed));
+
+    for (size_t i = 0; i < CHANNEL_COUNT; i++)
+        spu_UnregisterChannel(spu, channels[i]);
+    spu_Destroy(spu);
+}
+
+static void PutOrdered(spu_t *spu, ssize_t channel, vlc_tick_t start,
+                       int64_t order, int alpha)
+{
+    subpicture_t *subpic = NewSubpicture(channel, start, order);
+    vlc_spu_regions_first_or_null(&subpic->regions)->i_alpha = alpha;
+    spu_PutSubpicture(spu, subpic);
+}
+
+/* Regions are rendered by start date, then by channel, whatever the order
+ * they were queued in */
+static void test_spu_order(vlc_object_t *root)
+{
+    spu_t *spu = spu_Create(root, NULL);
+    assert(spu != NULL);
+
+    ssize_t first = spu_RegisterChannel(spu);
+    ssize_t second = spu_RegisterChannel(spu);
+    assert(first != VOUT_SPU_CHANNEL_INVALID);
+    assert(second != VOUT_SPU_CHANNEL_INVALID);
+    assert(first < second);
+
+    const vlc_tick_t base = vlc_tick_now() + VLC_TICK_FROM_SEC(10);
+
+    PutOrdered(spu, first, base + 2 * STEP, 0, 0x30);
+    PutOrdered(spu, second, base + STEP, 1, 0x20);
+    PutOrdered(spu, second, base, 2, 0x10);
+    PutOrdered(spu, first, base + STEP, 3, 0x18);
+
+    video_format_t fmt;
+    video_format_Init(&fmt, VLC_CODEC_RGBA);
+    fmt.i_width = fmt.i_visible_width = WIDTH;
+    fmt.i_height = fmt.i_visible_height = HEIGHT;
+    fmt.i_sar_num = fmt.i_sar_den = 1;
+
+    const vlc_tick_t date = base + 2 * STEP;
+    vlc_render_subpicture *render =
+        spu_Render(spu, NULL, &fmt, &fmt, false, NULL, date, date, false);
+    assert(render != NULL);
+
+    static const int expected[] = { 0x10, 0x18, 0x20, 0x30 };
+    assert(render->regions.size == ARRAY_SIZE(expected));
+    for (size_t i = 0; i < ARRAY_SIZE(expected); i++)
+        assert(render->regions.data[i]->i_alpha == expected[i]);
+    vlc_render_subpicture_Delete(render);
+
+    spu_UnregisterChannel(spu, second);
+    spu_UnregisterChannel(spu, first);
+    spu_Destroy(spu);
+}
+
+int main(void)
+{
+    test_init();
+
+    const char * const vlc_argv[] = {
+        "-vvv", "--text-renderer=tdummy",
+    };
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(vlc_argv), vlc_argv);
+    assert(vlc != NULL);
+
+    test_spu_order(&vlc->p_libvlc_int->obj);
+    test_spu_select(&vlc->p_libvlc_int->obj);
+
+    libvlc_release(vlc);
+    return 0;
+}